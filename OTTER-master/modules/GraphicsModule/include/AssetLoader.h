@@ -0,0 +1,151 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <GLM/glm.hpp>
+
+#include "LodMesh.h"
+#include "MeshOptimizer.h"
+#include "Texture2D.h"
+#include "VertexArrayObject.h"
+#include "VertexTypes.h"
+
+/// <summary>
+/// Decodes images and parses meshes on a pool of worker threads, then performs the OpenGL uploads on the main
+/// thread when Pump is called, limited to a per-frame budget. The load functions return placeholder objects
+/// straight away, which are filled in once their data has been uploaded, so the scene can start rendering
+/// before all of its assets are ready
+/// </summary>
+class AssetLoader
+{
+public:
+	/// <summary>
+	/// The work to perform on the main thread once a background job has finished, along with the number of
+	/// bytes it will upload to the GPU
+	/// </summary>
+	struct Upload {
+		std::function<void()> Apply;
+		size_t                Bytes;
+
+		Upload() : Apply(nullptr), Bytes(0) {}
+		Upload(const std::function<void()>& apply, size_t bytes) : Apply(apply), Bytes(bytes) {}
+	};
+
+	/// <summary>
+	/// The maximum number of bytes that a single call to Pump will upload, at least one upload will always be
+	/// performed per call so that large assets are not starved
+	/// </summary>
+	inline static size_t UploadByteBudget = 16 * 1024 * 1024;
+	/// <summary>
+	/// The maximum time in milliseconds that a single call to Pump will spend uploading
+	/// </summary>
+	inline static float UploadTimeBudget = 4.0f;
+	/// <summary>
+	/// When true, meshes loaded by LoadObj are run through MeshBuilder::Optimize on the worker thread before
+	/// being uploaded, and their vertex cache statistics are logged
+	/// </summary>
+	inline static bool OptimizeMeshes = false;
+	/// <summary>
+	/// The passes to run on meshes when OptimizeMeshes is enabled
+	/// </summary>
+	inline static MeshOptimizer::Settings OptimizeSettings = MeshOptimizer::Settings();
+
+	/// <summary>
+	/// Starts the worker threads, this will be called automatically on the first load if needed
+	/// </summary>
+	/// <param name="threadCount">The number of workers to start, or 0 to use one less than the number of hardware threads</param>
+	static void Init(size_t threadCount = 0);
+	/// <summary>
+	/// Stops the worker threads, discarding any work that has not yet completed
+	/// </summary>
+	static void Shutdown();
+
+	/// <summary>
+	/// Queues a job to run on a worker thread. The upload it returns will be applied on the main thread
+	/// during a later call to Pump
+	/// </summary>
+	/// <param name="job">The job to run in the background, must not touch any OpenGL state</param>
+	/// <returns>A future that becomes ready once the upload has been applied</returns>
+	static std::shared_future<void> Submit(const std::function<Upload()>& job);
+
+	/// <summary>
+	/// Loads an image in the background, returning a 1x1 white texture that will receive the image data once it
+	/// has been uploaded
+	/// </summary>
+	/// <param name="path">The path to load the image from</param>
+	/// <param name="description">
+	/// The description to create the texture with, the width and height are ignored. If no format is given, it is
+	/// chosen from the channel count in the image header, or RGBA8 if the header can't be read
+	/// </param>
+	/// <returns>The placeholder texture, which becomes the real texture once loaded</returns>
+	static Texture2D::sptr LoadTexture(const std::string& path, const Texture2DDescription& description = Texture2DDescription());
+
+	/// <summary>
+	/// Parses an OBJ file in the background (or reads it from the MeshCache), returning an empty VAO that will receive
+	/// the mesh data once it has been uploaded. The result is shared through the MeshRegistry, the same as MeshRegistry::LoadObj
+	/// </summary>
+	/// <param name="filename">The path of the OBJ file to load</param>
+	/// <param name="inColor">The color to apply to all vertices in the mesh</param>
+	/// <param name="format">The vertex type to store the mesh with</param>
+	/// <returns>The placeholder mesh, which becomes the real mesh once loaded</returns>
+	static VertexArrayObject::sptr LoadObj(const std::string& filename, const glm::vec4& inColor = glm::vec4(1.0f), VertexFormat format = VertexFormat::Full);
+	/// <summary>
+	/// Parses an OBJ file and generates its levels of detail in the background, returning an empty LOD mesh that will
+	/// receive the data once it has been uploaded. The mesh is always optimized first using OptimizeSettings (with
+	/// welding forced on), so that the simplifier is not blocked by vertices that the OBJ file split up
+	/// </summary>
+	/// <param name="filename">The path of the OBJ file to load</param>
+	/// <param name="inColor">The color to apply to all vertices in the mesh</param>
+	/// <param name="format">The vertex type to store the mesh with</param>
+	/// <param name="settings">Controls the number of levels and how much each one is simplified</param>
+	/// <returns>The placeholder mesh, which becomes the real mesh once loaded</returns>
+	static LodMesh::sptr LoadObjLods(const std::string& filename, const glm::vec4& inColor = glm::vec4(1.0f), VertexFormat format = VertexFormat::Full,
+		const LodMesh::Settings& settings = LodMesh::Settings());
+
+	/// <summary>
+	/// Applies finished uploads on the main thread until either UploadByteBudget or UploadTimeBudget is hit,
+	/// should be called once per frame
+	/// </summary>
+	static void Pump();
+	/// <summary>
+	/// Blocks the main thread until all queued jobs have been finished and uploaded
+	/// </summary>
+	static void WaitAll();
+
+	/// <summary>
+	/// Gets the number of jobs that have been submitted but not yet uploaded
+	/// </summary>
+	static size_t GetPendingCount();
+
+protected:
+	AssetLoader() = default;
+	~AssetLoader() = default;
+
+	// A job that has been submitted to the workers, along with the promise to fulfill once it is uploaded
+	struct Job {
+		std::function<Upload()>             Work;
+		std::shared_ptr<std::promise<void>> Done;
+	};
+	// A job that has finished in the background and is waiting for the main thread
+	struct FinishedJob {
+		Upload                              Result;
+		std::shared_ptr<std::promise<void>> Done;
+	};
+
+	static void _WorkerMain();
+	static InternalFormat _GuessTextureFormat(const std::string& path);
+
+	inline static std::vector<std::thread> _workers;
+	inline static std::deque<Job>          _jobs;
+	inline static std::deque<FinishedJob>  _finished;
+	inline static std::mutex               _lock;
+	inline static std::condition_variable  _jobAdded;
+	inline static std::condition_variable  _jobFinished;
+	inline static size_t                   _pending = 0;
+	inline static bool                     _running = false;
+};
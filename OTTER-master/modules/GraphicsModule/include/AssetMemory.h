@@ -0,0 +1,80 @@
+#pragma once
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "EnumToString.h"
+
+class Texture2D;
+class VertexArrayObject;
+class LodMesh;
+
+/// <summary>
+/// Controls what an asset keeps in CPU memory once it's data has been uploaded to the GPU
+/// </summary>
+ENUM(ResidencyPolicy, int,
+	Keep            = 0, // Keep a copy of the data, for assets that need to be read back on the CPU
+	DropAfterUpload = 1, // Free the data once uploaded, it can be restreamed from the source file if needed
+	MetadataOnly    = 2  // Free the data once uploaded and only keep the size and format, the data can not be restreamed
+);
+
+/// <summary>
+/// Keeps track of the loaded assets so that we can report how much CPU and GPU memory each of them is using.
+/// Only weak references are held, so assets are dropped from the report once they are freed
+/// </summary>
+class AssetMemory
+{
+public:
+	/// <summary>
+	/// The memory used by a single asset
+	/// </summary>
+	struct Entry {
+		std::string Name;     // The name the asset was tracked with, usually it's source path
+		std::string Type;     // The kind of asset, ex: Texture2D
+		size_t      CpuBytes; // The number of bytes the asset holds in CPU memory
+		size_t      GpuBytes; // The number of bytes the asset uses in GPU memory
+
+		Entry() : Name(""), Type(""), CpuBytes(0), GpuBytes(0) {}
+		Entry(const std::string& name, const std::string& type, size_t cpuBytes, size_t gpuBytes) :
+			Name(name), Type(type), CpuBytes(cpuBytes), GpuBytes(gpuBytes) {}
+	};
+
+	/// <summary>
+	/// Adds a texture to the memory report
+	/// </summary>
+	/// <param name="name">The name to show for the texture, ex: the path it was loaded from</param>
+	/// <param name="texture">The texture to track</param>
+	static void Track(const std::string& name, const std::shared_ptr<Texture2D>& texture);
+	/// <summary>
+	/// Adds a mesh to the memory report
+	/// </summary>
+	/// <param name="name">The name to show for the mesh, ex: it's key in the MeshRegistry</param>
+	/// <param name="mesh">The mesh to track</param>
+	static void Track(const std::string& name, const std::shared_ptr<VertexArrayObject>& mesh);
+	/// <summary>
+	/// Adds a LOD mesh to the memory report
+	/// </summary>
+	/// <param name="name">The name to show for the mesh, ex: it's key in the MeshRegistry</param>
+	/// <param name="mesh">The mesh to track</param>
+	static void Track(const std::string& name, const std::shared_ptr<LodMesh>& mesh);
+
+	/// <summary>
+	/// Gets the memory used by each of the tracked assets that are still alive, sorted by GPU memory
+	/// </summary>
+	static std::vector<Entry> GetReport();
+	/// <summary>
+	/// Logs the memory used by each tracked asset, along with the totals
+	/// </summary>
+	static void LogReport();
+
+protected:
+	AssetMemory() = default;
+	~AssetMemory() = default;
+
+	inline static std::vector<std::pair<std::string, std::weak_ptr<Texture2D>>>         _textures;
+	inline static std::vector<std::pair<std::string, std::weak_ptr<VertexArrayObject>>> _meshes;
+	inline static std::vector<std::pair<std::string, std::weak_ptr<LodMesh>>>           _lodMeshes;
+	inline static std::mutex _lock;
+};
@@ -0,0 +1,51 @@
+#pragma once
+#include <cstdint>
+
+#include "TextureEnums.h"
+
+/// <summary>
+/// CPU encoders for the BCn block compressed texture formats. Each function takes a 4x4 block of RGBA8 texels
+/// in row-major order (64 bytes) and writes a single compressed block. None of these touch any OpenGL state,
+/// so they are safe to call from any thread
+/// </summary>
+class BlockEncoder
+{
+public:
+	/// <summary>
+	/// Encodes a block of texels into the given compressed format
+	/// </summary>
+	/// <param name="format">The format to encode to, must be one of the formats where IsCompressedFormat is true</param>
+	/// <param name="rgba">The 16 RGBA8 texels to encode</param>
+	/// <param name="result">The location to write the block to, must have room for GetCompressedBlockSize(format) bytes</param>
+	static void EncodeBlock(InternalFormat format, const uint8_t* rgba, uint8_t* result);
+
+	/// <summary>
+	/// Encodes the RGB channels of a block as BC1, ignoring alpha (8 bytes)
+	/// </summary>
+	static void EncodeBC1(const uint8_t* rgba, uint8_t* result);
+	/// <summary>
+	/// Encodes a block as BC3, with BC4 compressed alpha followed by BC1 compressed color (16 bytes)
+	/// </summary>
+	static void EncodeBC3(const uint8_t* rgba, uint8_t* result);
+	/// <summary>
+	/// Encodes the red and green channels of a block as two BC4 blocks (16 bytes)
+	/// </summary>
+	static void EncodeBC5(const uint8_t* rgba, uint8_t* result);
+	/// <summary>
+	/// Encodes a block as BC7. We only use mode 6 (a single RGBA line with 4 bit indices), which is much faster
+	/// to search than the full set of modes and still beats BC3 in quality for most images (16 bytes)
+	/// </summary>
+	static void EncodeBC7(const uint8_t* rgba, uint8_t* result);
+
+	/// <summary>
+	/// Encodes a single channel of a block as BC4 (8 bytes)
+	/// </summary>
+	/// <param name="rgba">The 16 RGBA8 texels to encode</param>
+	/// <param name="channel">The channel to encode, 0-3 for R, G, B or A</param>
+	/// <param name="result">The location to write the 8 byte block to</param>
+	static void EncodeBC4(const uint8_t* rgba, int channel, uint8_t* result);
+
+protected:
+	BlockEncoder() = default;
+	~BlockEncoder() = default;
+};
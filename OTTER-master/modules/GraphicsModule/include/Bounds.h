@@ -0,0 +1,113 @@
+#pragma once
+#include <cfloat>
+#include <cstddef>
+#include <GLM/glm.hpp>
+
+/// <summary>
+/// An axis aligned bounding box. A default constructed box is empty (invalid) until it has been given a size
+/// </summary>
+struct BoundingBox
+{
+	glm::vec3 Min;
+	glm::vec3 Max;
+
+	BoundingBox() : Min(glm::vec3(FLT_MAX)), Max(glm::vec3(-FLT_MAX)) {}
+	BoundingBox(const glm::vec3& min, const glm::vec3& max) : Min(min), Max(max) {}
+
+	/// <summary>
+	/// Returns true if the box contains any points
+	/// </summary>
+	bool IsValid() const { return Min.x <= Max.x && Min.y <= Max.y && Min.z <= Max.z; }
+	glm::vec3 GetCenter() const { return (Min + Max) * 0.5f; }
+	/// <summary>
+	/// Gets half the size of the box along each axis
+	/// </summary>
+	glm::vec3 GetExtents() const { return (Max - Min) * 0.5f; }
+
+	/// <summary>
+	/// Gets the axis aligned box that contains this box after it has been transformed
+	/// </summary>
+	BoundingBox Transform(const glm::mat4& transform) const;
+};
+
+/// <summary>
+/// A bounding sphere, a negative radius means the sphere is empty
+/// </summary>
+struct BoundingSphere
+{
+	glm::vec3 Center;
+	float     Radius;
+
+	BoundingSphere() : Center(glm::vec3(0.0f)), Radius(-1.0f) {}
+	BoundingSphere(const glm::vec3& center, float radius) : Center(center), Radius(radius) {}
+
+	bool IsValid() const { return Radius >= 0.0f; }
+
+	/// <summary>
+	/// Gets a sphere that contains this sphere after it has been transformed, using the largest scale of the transform
+	/// </summary>
+	BoundingSphere Transform(const glm::mat4& transform) const;
+};
+
+/// <summary>
+/// The bounding box and sphere of a mesh, which are calculated when it is baked
+/// </summary>
+struct MeshBounds
+{
+	BoundingBox    Box;
+	BoundingSphere Sphere;
+
+	/// <summary>
+	/// Returns false if the bounds have not been calculated, ex: for meshes that are still loading
+	/// </summary>
+	bool IsValid() const { return Box.IsValid(); }
+
+	/// <summary>
+	/// Transforms the bounds into another space, ex: into world space with Transform::WorldTransform()
+	/// </summary>
+	MeshBounds Transform(const glm::mat4& transform) const;
+
+	/// <summary>
+	/// Calculates the bounds of a set of vertices. The box is found with SSE when it is available
+	/// </summary>
+	/// <param name="positions">A pointer to the position of the first vertex, positions must be 3 floats</param>
+	/// <param name="count">The number of vertices</param>
+	/// <param name="stride">The number of bytes between the positions of each vertex</param>
+	static MeshBounds Compute(const void* positions, size_t count, size_t stride);
+};
+
+/// <summary>
+/// The 6 planes of a camera's view volume, used to skip drawing objects that are off screen
+/// </summary>
+class Frustum
+{
+public:
+	Frustum();
+	/// <summary>
+	/// Extracts the planes of the frustum from a camera's view projection matrix
+	/// </summary>
+	explicit Frustum(const glm::mat4& viewProjection);
+
+	/// <summary>
+	/// Re-extracts the planes of the frustum from a camera's view projection matrix
+	/// </summary>
+	void Update(const glm::mat4& viewProjection);
+
+	/// <summary>
+	/// Returns true if the sphere is at least partially inside the frustum
+	/// </summary>
+	bool Intersects(const BoundingSphere& sphere) const;
+	/// <summary>
+	/// Returns true if the box is at least partially inside the frustum. This is conservative, boxes near the
+	/// corners of the frustum may be reported as visible when they are not
+	/// </summary>
+	bool Intersects(const BoundingBox& box) const;
+	/// <summary>
+	/// Tests the sphere first since it's cheaper, and only tests the tighter box if the sphere is visible
+	/// </summary>
+	bool Intersects(const MeshBounds& bounds) const;
+
+protected:
+	// The planes face inwards, with the normal in xyz and the distance in w. Ordered left, right, bottom, top, near, far
+	glm::vec4 _planes[6];
+};
@@ -81,6 +81,14 @@ public:
 	const glm::vec3& GetUp() const { return _up; }
 
 	float GetFovDegrees() const { return glm::degrees(_fovRadians); }
+	/// <summary>
+	/// Gets the distance to the near clipping plane
+	/// </summary>
+	float GetNearPlane() const { return _nearPlane; }
+	/// <summary>
+	/// Gets the distance to the far clipping plane
+	/// </summary>
+	float GetFarPlane() const { return _farPlane; }
 	
 	/// <summary>
 	/// Gets the view matrix for this camera
@@ -0,0 +1,121 @@
+#pragma once
+#include <memory>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "TextureEnums.h"
+#include "Texture2DData.h"
+
+/// <summary>
+/// Stores block compressed (BCn) texture data, along with its mip chain, ready to be uploaded into OpenGL
+/// via glCompressedTextureSubImage2D. Encoding and caching never touch OpenGL, so this can be used without a context
+/// </summary>
+class CompressedTextureData final
+{
+public:
+	CompressedTextureData(const CompressedTextureData& other) = delete;
+	CompressedTextureData(CompressedTextureData&& other) = delete;
+	CompressedTextureData& operator=(const CompressedTextureData& other) = delete;
+	CompressedTextureData& operator=(CompressedTextureData&& other) = delete;
+	typedef std::shared_ptr<CompressedTextureData> sptr;
+
+	/// <summary>
+	/// A single level in the mip chain
+	/// </summary>
+	struct MipLevel {
+		uint32_t             Width;
+		uint32_t             Height;
+		std::vector<uint8_t> Data;
+	};
+
+	std::string DebugName;
+
+	/// <summary>
+	/// Whether LoadFromFile should read and write encoded textures from the cache directory
+	/// </summary>
+	inline static bool CacheEnabled = true;
+	/// <summary>
+	/// The directory that encoded textures are cached in, relative to the working directory
+	/// </summary>
+	inline static std::string CacheDirectory = "cache";
+
+	// Bump whenever the encoder output changes, so that stale cache entries are ignored
+	inline static const uint32_t VERSION = 1;
+
+	/// <summary>
+	/// Creates a new, empty compressed texture data object
+	/// </summary>
+	/// <param name="width">The width of the top level, in pixels</param>
+	/// <param name="height">The height of the top level, in pixels</param>
+	/// <param name="format">The block compressed format of the data</param>
+	CompressedTextureData(uint32_t width, uint32_t height, InternalFormat format);
+	~CompressedTextureData() = default;
+
+	/// <summary>
+	/// Encodes uncompressed texture data into a block compressed format, spreading the work across all cores
+	/// </summary>
+	/// <param name="source">The data to encode, must use unsigned byte components</param>
+	/// <param name="format">The block compressed format to encode to</param>
+	/// <param name="generateMipMaps">True to generate and encode the full mip chain</param>
+	/// <returns>The encoded texture data</returns>
+	static CompressedTextureData::sptr Encode(const Texture2DData::sptr& source, InternalFormat format, bool generateMipMaps = true);
+
+	/// <summary>
+	/// Loads an image and encodes it into a block compressed format. If the cache is enabled, the encoded result
+	/// is stored as a DDS file in CacheDirectory and re-used for as long as the source image does not change
+	/// </summary>
+	/// <param name="file">The path of the image to load</param>
+	/// <param name="format">The block compressed format to encode to</param>
+	/// <param name="generateMipMaps">True to generate and encode the full mip chain</param>
+	/// <returns>The encoded texture data, or nullptr if the image failed to load</returns>
+	static CompressedTextureData::sptr LoadFromFile(const std::string& file, InternalFormat format, bool generateMipMaps = true);
+
+	/// <summary>
+	/// Loads block compressed data from a DDS file. Only the DX10 header with the BC1, BC3, BC5 and BC7 formats is supported
+	/// </summary>
+	/// <param name="file">The path of the DDS file to load</param>
+	/// <returns>The loaded texture data, or nullptr if the file could not be read</returns>
+	static CompressedTextureData::sptr LoadFromDDS(const std::string& file);
+	/// <summary>
+	/// Saves this texture data to a DDS file, using the DX10 header
+	/// </summary>
+	/// <param name="file">The path to write the file to</param>
+	/// <returns>True if the file was written successfully</returns>
+	bool SaveToDDS(const std::string& file) const;
+
+	/// <summary>
+	/// Gets the number of bytes needed to store a single level of a block compressed texture
+	/// </summary>
+	static size_t GetLevelDataSize(InternalFormat format, uint32_t width, uint32_t height);
+
+	/// <summary>
+	/// Gets the width of the top level, in pixels
+	/// </summary>
+	uint32_t GetWidth() const { return _width; }
+	/// <summary>
+	/// Gets the height of the top level, in pixels
+	/// </summary>
+	uint32_t GetHeight() const { return _height; }
+	/// <summary>
+	/// Gets the block compressed format of the data
+	/// </summary>
+	InternalFormat GetFormat() const { return _format; }
+	/// <summary>
+	/// Gets the number of mip levels stored in this object
+	/// </summary>
+	uint32_t GetLevelCount() const { return static_cast<uint32_t>(_levels.size()); }
+	/// <summary>
+	/// Gets a single level of the mip chain, where 0 is the full size image
+	/// </summary>
+	const MipLevel& GetLevel(uint32_t level) const { return _levels[level]; }
+	/// <summary>
+	/// Gets the total size of all the levels, in bytes
+	/// </summary>
+	size_t GetDataSize() const;
+
+private:
+	uint32_t       _width, _height;
+	InternalFormat _format;
+	std::vector<MipLevel> _levels;
+};
@@ -0,0 +1,227 @@
+#pragma once
+#include <glad/glad.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "IndexBuffer.h"
+#include "VertexBuffer.h"
+#include "VertexArrayObject.h"
+
+class GeometryArena;
+
+/// <summary>
+/// A block of vertices and indices within a GeometryArena, which is returned to the arena once the last reference
+/// to it is released. The offsets can move when the arena is compacted, so they should be read every time the
+/// allocation is drawn rather than being stored
+/// </summary>
+class GeometryAllocation final
+{
+public:
+	typedef std::shared_ptr<GeometryAllocation> sptr;
+	// We'll disallow moving and copying, since the arena keeps track of us by address
+	GeometryAllocation(const GeometryAllocation& other) = delete;
+	GeometryAllocation(GeometryAllocation&& other) = delete;
+	GeometryAllocation& operator=(const GeometryAllocation& other) = delete;
+	GeometryAllocation& operator=(GeometryAllocation&& other) = delete;
+
+	/// <summary>
+	/// Creates an empty allocation, use GeometryArena::Allocate instead of calling this directly
+	/// </summary>
+	GeometryAllocation(const std::shared_ptr<GeometryArena>& arena);
+	~GeometryAllocation();
+
+	/// <summary>
+	/// Gets the arena that this allocation belongs to
+	/// </summary>
+	const std::shared_ptr<GeometryArena>& GetArena() const { return _arena; }
+	/// <summary>
+	/// Gets the index of our first vertex in the arena, which is added to each index when drawing
+	/// </summary>
+	size_t GetBaseVertex() const { return _baseVertex; }
+	/// <summary>
+	/// Gets the number of vertices in this allocation
+	/// </summary>
+	size_t GetVertexCount() const { return _vertexCount; }
+	/// <summary>
+	/// Gets the number of indices in this allocation
+	/// </summary>
+	size_t GetIndexCount() const { return _indexCount; }
+	/// <summary>
+	/// Gets the type of our indices (GL_UNSIGNED_SHORT or GL_UNSIGNED_INT), small meshes use 16 bit indices
+	/// </summary>
+	GLenum GetIndexType() const { return _indexType; }
+	/// <summary>
+	/// Gets the number of bytes this allocation uses in the arena's buffers
+	/// </summary>
+	size_t GetTotalSize() const;
+
+	/// <summary>
+	/// Draws all the triangles in this allocation, binding the arena's VAO if it is not already bound
+	/// </summary>
+	void Draw() const;
+	/// <summary>
+	/// Draws a range of the triangles in this allocation, binding the arena's VAO if it is not already bound
+	/// </summary>
+	/// <param name="firstIndex">The first index to draw, relative to the start of this allocation</param>
+	/// <param name="indexCount">The number of indices to draw</param>
+	void Draw(uint32_t firstIndex, uint32_t indexCount) const;
+	/// <summary>
+	/// Draws several copies of a range of the triangles in this allocation, see VertexArrayObject::RenderInstanced
+	/// </summary>
+	/// <param name="firstIndex">The first index to draw, relative to the start of this allocation</param>
+	/// <param name="indexCount">The number of indices to draw</param>
+	/// <param name="instances">The buffer holding the instance data, which must already be uploaded</param>
+	/// <param name="baseInstance">The index of the first instance in the buffer to draw</param>
+	/// <param name="instanceCount">The number of instances to draw</param>
+	void DrawInstanced(uint32_t firstIndex, uint32_t indexCount, const InstanceBuffer& instances, uint32_t baseInstance, uint32_t instanceCount) const;
+
+protected:
+	friend class GeometryArena;
+
+	std::shared_ptr<GeometryArena> _arena;
+	size_t _baseVertex;
+	size_t _vertexCount;
+	// The offset and size of our indices in the index buffer, in bytes
+	size_t _indexOffset;
+	size_t _indexBytes;
+	size_t _indexCount;
+	GLenum _indexType;
+};
+
+/// <summary>
+/// Stores the meshes for one vertex format in a single large vertex buffer, index buffer and VAO. Meshes get a
+/// block of each buffer and are drawn with glDrawElementsBaseVertex, so drawing many meshes of the same format
+/// never needs to switch VAOs. Freed blocks go on a free list, and when the free space is too fragmented to fit
+/// a new mesh the arena is compacted before it considers growing. All functions must be called on the main thread
+/// </summary>
+class GeometryArena final : public std::enable_shared_from_this<GeometryArena>
+{
+public:
+	typedef std::shared_ptr<GeometryArena> sptr;
+	// We'll disallow moving and copying, since allocations refer back to us
+	GeometryArena(const GeometryArena& other) = delete;
+	GeometryArena(GeometryArena&& other) = delete;
+	GeometryArena& operator=(const GeometryArena& other) = delete;
+	GeometryArena& operator=(GeometryArena&& other) = delete;
+
+	/// <summary>
+	/// Tracks how much of an arena is in use
+	/// </summary>
+	struct Stats {
+		size_t Allocations;      // The number of live allocations
+		size_t VerticesUsed;     // The number of vertices in live allocations
+		size_t VertexCapacity;   // The number of vertices the vertex buffer can hold
+		size_t IndexBytesUsed;   // The number of bytes in the index buffer used by live allocations
+		size_t IndexCapacity;    // The size of the index buffer in bytes
+		size_t IndexBytesSaved;  // The number of bytes saved by storing small meshes with 16 bit indices
+		size_t Grows;            // The number of times the buffers have been re-allocated to be larger
+		size_t Compactions;      // The number of times the buffers have been compacted
+
+		Stats() : Allocations(0), VerticesUsed(0), VertexCapacity(0), IndexBytesUsed(0), IndexCapacity(0), IndexBytesSaved(0), Grows(0), Compactions(0) {}
+	};
+
+	/// <summary>
+	/// When true, MeshBuilder::Bake and the mesh cache put indexed meshes in a shared arena instead of giving each
+	/// one it's own buffers and VAO
+	/// </summary>
+	inline static bool Enabled = true;
+	/// <summary>
+	/// The number of vertices a new arena has room for
+	/// </summary>
+	inline static size_t InitialVertexCapacity = 64 * 1024;
+	/// <summary>
+	/// The size in bytes of the index buffer for a new arena
+	/// </summary>
+	inline static size_t InitialIndexCapacity = 1024 * 1024;
+
+	/// <summary>
+	/// Creates a new empty arena, use Get to share arenas between meshes of the same format
+	/// </summary>
+	/// <param name="attributes">The attributes of the vertex format, ex: VertexPosNormTexCol::V_DECL</param>
+	/// <param name="vertexStride">The size of a single vertex, in bytes</param>
+	GeometryArena(const std::vector<BufferAttribute>& attributes, size_t vertexStride);
+	~GeometryArena();
+
+	/// <summary>
+	/// Gets the arena for the given vertex format, creating it if needed. Arenas are freed once all of their allocations are released
+	/// </summary>
+	/// <param name="attributes">The attributes of the vertex format, ex: VertexPosNormTexCol::V_DECL</param>
+	/// <param name="vertexStride">The size of a single vertex, in bytes</param>
+	static sptr Get(const std::vector<BufferAttribute>& attributes, size_t vertexStride);
+	/// <summary>
+	/// Gets the arena for a vertex type, creating it if needed
+	/// </summary>
+	template <typename VertType>
+	static sptr Get() { return Get(VertType::V_DECL, sizeof(VertType)); }
+
+	/// <summary>
+	/// Gets the combined statistics of all the arenas that are alive
+	/// </summary>
+	static Stats GetTotalStats();
+
+	/// <summary>
+	/// Copies a mesh into this arena
+	/// </summary>
+	/// <param name="vertices">The vertex data, in this arena's format</param>
+	/// <param name="vertexCount">The number of vertices</param>
+	/// <param name="indices">The indices of the mesh, relative to the first vertex</param>
+	/// <param name="indexCount">The number of indices</param>
+	/// <returns>The allocation holding the mesh, which is freed once released</returns>
+	GeometryAllocation::sptr Allocate(const void* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount);
+
+	/// <summary>
+	/// Moves all the allocations to the start of the buffers, so that the free space is in one piece
+	/// </summary>
+	void Compact();
+
+	/// <summary>
+	/// Gets the usage statistics for this arena
+	/// </summary>
+	Stats GetStats() const;
+	/// <summary>
+	/// Gets the handle of the VAO that all our allocations are drawn with
+	/// </summary>
+	GLuint GetVaoHandle() const { return _vao; }
+	/// <summary>
+	/// Gets the size of a single vertex in this arena, in bytes
+	/// </summary>
+	size_t GetVertexStride() const { return _vertexStride; }
+
+protected:
+	friend class GeometryAllocation;
+
+	// A free block within one of the buffers
+	struct Range {
+		size_t Offset;
+		size_t Size;
+	};
+
+	std::vector<BufferAttribute> _attributes;
+	size_t                       _vertexStride;
+	GLuint                       _vao;
+	VertexBuffer::sptr           _vertexBuffer;
+	IndexBuffer::sptr            _indexBuffer;
+	// The capacity of the vertex buffer in vertices, and of the index buffer in bytes
+	size_t                       _vertexCapacity;
+	size_t                       _indexCapacity;
+	// The free blocks in each buffer, sorted by offset and never adjacent to each other
+	std::vector<Range>           _freeVertices;
+	std::vector<Range>           _freeIndices;
+	std::vector<GeometryAllocation*> _allocations;
+	Stats                        _stats;
+
+	inline static std::unordered_map<std::string, std::weak_ptr<GeometryArena>> _arenas;
+
+	static std::string _GetFormatKey(const std::vector<BufferAttribute>& attributes, size_t vertexStride);
+	static bool _AllocateRange(std::vector<Range>& freeList, size_t size, size_t& offset);
+	static void _FreeRange(std::vector<Range>& freeList, size_t offset, size_t size);
+	static size_t _GetFreeSize(const std::vector<Range>& freeList);
+
+	bool _TryAllocate(size_t vertexCount, size_t indexBytes, size_t& vertexOffset, size_t& indexOffset);
+	void _Free(GeometryAllocation* allocation);
+	void _Resize(size_t vertexCapacity, size_t indexCapacity);
+	void _SetBuffers(const VertexBuffer::sptr& vertexBuffer, const IndexBuffer::sptr& indexBuffer);
+};
@@ -0,0 +1,23 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// The 64 bit FNV-1a offset basis, the seed to use when starting a new hash
+static constexpr uint64_t FNV1A_SEED = 14695981039346656037ull;
+
+/// <summary>
+/// Computes a 64 bit FNV-1a hash of some data. This is used for the keys of our on-disk caches, so it must stay
+/// stable between runs and builds
+/// </summary>
+/// <param name="data">The data to hash</param>
+/// <param name="size">The size of the data, in bytes</param>
+/// <param name="seed">The hash to continue from, allows chaining multiple hashes together</param>
+static inline uint64_t HashFnv1a(const void* data, size_t size, uint64_t seed = FNV1A_SEED) {
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	uint64_t result = seed;
+	for (size_t ix = 0; ix < size; ix++) {
+		result ^= bytes[ix];
+		result *= 1099511628211ull;
+	}
+	return result;
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include "IBuffer.h"
+#include <atomic>
 #include <cstdint>
 #include <stdexcept>
 #include <memory>
@@ -21,7 +22,8 @@ public:
 	/// </summary>
 	/// <param name="usage">The usage hint for the buffer, default is GL_STATIC_DRAW</param>
 	IndexBuffer(GLenum usage = GL_STATIC_DRAW) : 
-		IBuffer(GL_ELEMENT_ARRAY_BUFFER, usage), _elementType(GL_NONE) { }
+		IBuffer(GL_ELEMENT_ARRAY_BUFFER, usage), _elementType(GL_NONE), _bytesSaved(0) { }
+	virtual ~IndexBuffer();
 
 	// We'll override the LoadData to force users to use our overload that takes in the element type as well
 	inline void LoadData(const void* data, size_t elementSize, size_t elementCount) override {
@@ -37,8 +39,17 @@ public:
 	inline void LoadData(const void* data, size_t elementSize, size_t elementCount, GLenum elementType) {
 		IBuffer::LoadData(data, elementSize, elementCount);
 		_elementType = elementType;
+		_SetBytesSaved(0);
 	}
 	/// <summary>
+	/// Loads 32 bit indices into this buffer, storing them as 16 bit indices instead if they all fit. This halves
+	/// the size of the buffer for meshes with up to 65,536 vertices, GetElementType will tell us which one was used
+	/// </summary>
+	/// <param name="data">The indices to load</param>
+	/// <param name="count">The number of indices to load</param>
+	/// <param name="maxIndex">The largest index in the data (ex: the vertex count - 1), or UINT32_MAX to find it by scanning the data</param>
+	void LoadCompactData(const uint32_t* data, size_t count, uint32_t maxIndex = UINT32_MAX);
+	/// <summary>
 	/// Loads data of a known type into this index buffer
 	/// </summary>
 	/// <typeparam name="T">The type of data to load, must be uint8_t, uint16_t or uint32_t</typeparam>
@@ -57,8 +68,23 @@ public:
 	/// </summary>
 	static void UnBind() { IBuffer::UnBind(GL_ELEMENT_ARRAY_BUFFER); }
 
+	/// <summary>
+	/// Gets the number of bytes that LoadCompactData has saved across all the index buffers that currently exist,
+	/// compared to storing them with 32 bit indices
+	/// </summary>
+	static size_t GetTotalBytesSaved() { return _totalBytesSaved; }
+
 protected:
 	GLenum _elementType;
+	size_t _bytesSaved;
+
+	inline static std::atomic<size_t> _totalBytesSaved{ 0 };
+
+	void _SetBytesSaved(size_t bytesSaved) {
+		_totalBytesSaved -= _bytesSaved;
+		_totalBytesSaved += bytesSaved;
+		_bytesSaved = bytesSaved;
+	}
 };
 
 // These are all template specializations for LoadData, they are in the .h file cause templates are weird
@@ -69,14 +95,17 @@ template<>
 inline void IndexBuffer::LoadData<uint8_t>(const uint8_t* data, size_t count) {
 	IBuffer::LoadData<uint8_t>(data, count);
 	_elementType = GL_UNSIGNED_BYTE;
+	_SetBytesSaved(0);
 }
 template<>
 inline void IndexBuffer::LoadData<uint16_t>(const uint16_t* data, size_t count) {
 	IBuffer::LoadData<uint16_t>(data, count);
 	_elementType = GL_UNSIGNED_SHORT;
+	_SetBytesSaved(0);
 }
 template<>
 inline void IndexBuffer::LoadData<uint32_t>(const uint32_t* data, size_t count) {
 	IBuffer::LoadData<uint32_t>(data, count);
 	_elementType = GL_UNSIGNED_INT;
+	_SetBytesSaved(0);
 }
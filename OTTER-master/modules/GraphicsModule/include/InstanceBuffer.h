@@ -0,0 +1,87 @@
+#pragma once
+#include <glad/glad.h>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <GLM/glm.hpp>
+
+#include "VertexBuffer.h"
+
+/// <summary>
+/// The per-instance data that is passed to shaders that support instancing
+/// </summary>
+struct InstanceData
+{
+	glm::mat4 Model;
+	glm::mat3 NormalMatrix;
+
+	InstanceData() : Model(glm::mat4(1.0f)), NormalMatrix(glm::mat3(1.0f)) {}
+	InstanceData(const glm::mat4& model, const glm::mat3& normalMatrix) : Model(model), NormalMatrix(normalMatrix) {}
+};
+
+/// <summary>
+/// Collects the transforms of every instance that will be drawn in a frame, and uploads them all at once so that
+/// draws which share a mesh and material can be combined into a single instanced draw. Each draw picks it's range
+/// of instances with a base instance, so the buffer only needs to be attached to a VAO once per draw
+/// </summary>
+class InstanceBuffer final
+{
+public:
+	typedef std::shared_ptr<InstanceBuffer> sptr;
+	static inline sptr Create() {
+		return std::make_shared<InstanceBuffer>();
+	}
+
+	// We'll disallow moving and copying, since we want to manually control when the destructor is called
+	// We'll use these classes via pointers
+	InstanceBuffer(const InstanceBuffer& other) = delete;
+	InstanceBuffer(InstanceBuffer&& other) = delete;
+	InstanceBuffer& operator=(const InstanceBuffer& other) = delete;
+	InstanceBuffer& operator=(InstanceBuffer&& other) = delete;
+
+	// The vertex shader inputs that receive the instance data. The model matrix uses slots 4-7, and the normal
+	// matrix uses slots 8-10, ex: layout(location = 4) in mat4 inInstanceModel;
+	static const GLuint MODEL_SLOT = 4;
+	static const GLuint NORMAL_MATRIX_SLOT = 8;
+
+public:
+	InstanceBuffer();
+	~InstanceBuffer() = default;
+
+	/// <summary>
+	/// Removes all the instances, call this at the start of each frame
+	/// </summary>
+	void Clear() { _instances.clear(); }
+	/// <summary>
+	/// Adds an instance to the buffer
+	/// </summary>
+	/// <returns>The index of the instance, which is the base instance of a draw that starts with it</returns>
+	uint32_t Add(const glm::mat4& model, const glm::mat3& normalMatrix);
+	/// <summary>
+	/// Returns the number of instances that have been added since the last call to Clear
+	/// </summary>
+	uint32_t GetCount() const { return static_cast<uint32_t>(_instances.size()); }
+
+	/// <summary>
+	/// Uploads all the instances to the GPU, this must be done after the last call to Add and before drawing. Does
+	/// nothing if there are no instances
+	/// </summary>
+	void Upload();
+	/// <summary>
+	/// Points the instanced attributes of a VAO at this buffer. VertexArrayObject::RenderInstanced will call
+	/// this for you. Does nothing if there are no instances
+	/// </summary>
+	/// <param name="vao">The OpenGL handle of the VAO that will be drawn</param>
+	void AttachTo(GLuint vao) const;
+	/// <summary>
+	/// Disables the instanced attributes of a VAO and releases it's binding to the instance buffer, so that
+	/// later non-instanced draws with the VAO don't read from it. VertexArrayObject::RenderInstanced will call
+	/// this for you after drawing
+	/// </summary>
+	/// <param name="vao">The OpenGL handle of the VAO that was drawn</param>
+	static void DetachFrom(GLuint vao);
+
+protected:
+	std::vector<InstanceData> _instances;
+	VertexBuffer::sptr        _buffer;
+};
@@ -0,0 +1,145 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include <GLM/glm.hpp>
+
+#include "VertexArrayObject.h"
+
+/// <summary>
+/// A mesh with several levels of detail that all share a single vertex and index buffer. Each level is a range
+/// of the index buffer, with level 0 being the full detail mesh and each level after it having fewer triangles.
+/// See MeshBuilder::BakeLods for creating one
+/// </summary>
+class LodMesh final
+{
+public:
+	typedef std::shared_ptr<LodMesh> sptr;
+	template <typename ... TArgs>
+	static inline sptr Create(TArgs&&... args) {
+		return std::make_shared<LodMesh>(std::forward<TArgs>(args)...);
+	}
+	// We'll disallow moving and copying, since renderers hold on to our VAO
+	LodMesh(const LodMesh& other) = delete;
+	LodMesh(LodMesh&& other) = delete;
+	LodMesh& operator=(const LodMesh& other) = delete;
+	LodMesh& operator=(LodMesh&& other) = delete;
+
+	/// <summary>
+	/// A single level of detail within the index buffer
+	/// </summary>
+	struct Level
+	{
+		// The first index of this level within the index buffer
+		uint32_t FirstIndex;
+		// The number of indices in this level
+		uint32_t IndexCount;
+		// The largest distance between this level and the full detail mesh, as a fraction of the bounding radius
+		float    Error;
+
+		Level() : FirstIndex(0), IndexCount(0), Error(0.0f) {}
+		Level(uint32_t firstIndex, uint32_t indexCount, float error) : FirstIndex(firstIndex), IndexCount(indexCount), Error(error) {}
+	};
+
+	/// <summary>
+	/// The levels and bounds of a mesh, as produced by MeshBuilder::GenerateLods
+	/// </summary>
+	struct Description
+	{
+		std::vector<Level> Levels;
+		// The center of the bounding sphere, in object space
+		glm::vec3          Center;
+		// The radius of the bounding sphere, in object space
+		float              Radius;
+
+		Description() : Levels(std::vector<Level>()), Center(glm::vec3(0.0f)), Radius(0.0f) {}
+	};
+
+	/// <summary>
+	/// Controls how MeshBuilder::GenerateLods builds the levels
+	/// </summary>
+	struct Settings
+	{
+		// The most levels to generate, including the full detail level
+		int   LevelCount;
+		// The fraction of the triangles to keep from one level to the next
+		float Reduction;
+		// The largest error any level may have, as a fraction of the mesh's largest dimension. Generation stops
+		// early once a level would need more error than this to hit its triangle count
+		float MaxError;
+
+		Settings() : LevelCount(4), Reduction(0.5f), MaxError(0.05f) {}
+	};
+
+	/// <summary>
+	/// The largest error that SelectLevel will allow on screen, as a fraction of half the screen height.
+	/// The default is about 1 pixel at 1080p
+	/// </summary>
+	inline static float MaxScreenError = 0.002f;
+	/// <summary>
+	/// How far past MaxScreenError the error needs to move before SelectLevel switches away from the current
+	/// level, so that objects sitting right at a threshold don't pop back and forth every frame
+	/// </summary>
+	inline static float Hysteresis = 0.15f;
+
+	/// <summary>
+	/// Creates a new LOD mesh with an empty VAO, which will draw nothing until it's data has been loaded
+	/// </summary>
+	LodMesh();
+	~LodMesh() = default;
+
+	/// <summary>
+	/// Sets the levels and bounds of this mesh, the VAO should already hold the buffers that they refer to
+	/// </summary>
+	void SetDescription(const Description& description) { _description = description; }
+	/// <summary>
+	/// Gets the levels and bounds of this mesh
+	/// </summary>
+	const Description& GetDescription() const { return _description; }
+
+	/// <summary>
+	/// Gets the VAO that holds the buffers for all the levels
+	/// </summary>
+	const VertexArrayObject::sptr& GetVao() const { return _vao; }
+	/// <summary>
+	/// Gets the number of levels in this mesh, this will be 0 until it has been loaded
+	/// </summary>
+	int GetLevelCount() const { return static_cast<int>(_description.Levels.size()); }
+	/// <summary>
+	/// Gets the number of triangles in the given level
+	/// </summary>
+	size_t GetTriangleCount(int level) const;
+
+	/// <summary>
+	/// Gets how big the bounding sphere of this mesh appears on screen, as a fraction of half the screen height
+	/// </summary>
+	/// <param name="world">The world transform of the object</param>
+	/// <param name="cameraPosition">The position of the camera in world space</param>
+	/// <param name="projection">The camera's projection matrix</param>
+	float GetScreenSize(const glm::mat4& world, const glm::vec3& cameraPosition, const glm::mat4& projection) const;
+
+	/// <summary>
+	/// Selects the lowest detail level whose error on screen stays below MaxScreenError
+	/// </summary>
+	/// <param name="screenSize">The size of the object on screen, see GetScreenSize</param>
+	/// <param name="currentLevel">The level the object used last frame, for hysteresis</param>
+	/// <returns>The level to draw</returns>
+	int SelectLevel(float screenSize, int currentLevel) const;
+
+	/// <summary>
+	/// Draws one of the levels of this mesh
+	/// </summary>
+	/// <param name="level">The level to draw, will be clamped to the available levels</param>
+	void Render(int level) const;
+	/// <summary>
+	/// Draws several copies of one of the levels of this mesh, see VertexArrayObject::RenderInstanced
+	/// </summary>
+	/// <param name="level">The level to draw, will be clamped to the available levels</param>
+	/// <param name="instances">The buffer holding the instance data, which must already be uploaded</param>
+	/// <param name="baseInstance">The index of the first instance in the buffer to draw</param>
+	/// <param name="instanceCount">The number of instances to draw</param>
+	void RenderInstanced(int level, const InstanceBuffer& instances, uint32_t baseInstance, uint32_t instanceCount) const;
+
+protected:
+	VertexArrayObject::sptr _vao;
+	Description             _description;
+};
@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+/// <summary>
+/// Wraps a read-only memory mapping of a file on disk. The contents of the file can be read
+/// directly from the mapping without copying them into our own buffers
+/// </summary>
+class MappedFile final
+{
+public:
+	// We'll disallow moving and copying, since we want to manually control when the mapping is released
+	MappedFile(const MappedFile& other) = delete;
+	MappedFile(MappedFile&& other) = delete;
+	MappedFile& operator=(const MappedFile& other) = delete;
+	MappedFile& operator=(MappedFile&& other) = delete;
+
+	/// <summary>
+	/// Maps the given file into memory for reading, throws a runtime_error if the file could not be opened
+	/// </summary>
+	/// <param name="filename">The path to the file to map</param>
+	MappedFile(const std::string& filename);
+	~MappedFile();
+
+	/// <summary>
+	/// Gets a pointer to the first byte of the file, may be nullptr if the file is empty
+	/// </summary>
+	const char* GetData() const { return _data; }
+	/// <summary>
+	/// Gets the size of the mapped file, in bytes
+	/// </summary>
+	size_t GetSize() const { return _size; }
+
+private:
+	const char* _data;
+	size_t      _size;
+
+	// Platform specific handles for the file and mapping objects
+	void* _fileHandle;
+	void* _mapHandle;
+};
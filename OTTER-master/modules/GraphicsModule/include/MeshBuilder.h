@@ -1,6 +1,13 @@
 #pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <numeric>
 #include <vector>
 #include <VertexArrayObject.h>
+#include <GeometryArena.h>
+#include <LodMesh.h>
+#include <MeshOptimizer.h>
 
 template <typename VertType>
 class MeshBuilder
@@ -55,7 +62,7 @@ public:
 	/// </summary>
 	/// <param name="extendAmount">The number of vertices to reserve space for</param>
 	void ReserveVertexSpace(size_t extendAmount) {
-		_vertices.reserve(_vertices.size() + extendAmount);
+		_ReserveGeometric(_vertices, extendAmount);
 	}
 	/// <summary>
 	/// Resizes the internal vector to allocate space for new indices, can improve
@@ -63,7 +70,7 @@ public:
 	/// </summary>
 	/// <param name="extendAmount">The number of indices to reserve space for</param>
 	void ReserveIndexSpace(size_t extendAmount) {
-		_indices.reserve(_indices.size() + extendAmount);
+		_ReserveGeometric(_indices, extendAmount);
 	}
 
 	/// <summary>
@@ -81,17 +88,171 @@ public:
 	/// </summary>
 	size_t GetTriangleCount() const { return _indices.size() > 0 ? _indices.size() / 3 : _vertices.size() / 3; }
 
-	VertexArrayObject::sptr Bake() {
+	/// <summary>
+	/// Runs the MeshOptimizer passes selected in settings over this mesh, to reduce the number of vertices that get
+	/// transformed and the amount of overdraw. Call this before Bake. If the mesh has no indices, they will be generated
+	/// </summary>
+	/// <param name="settings">The passes to run</param>
+	/// <returns>The vertex counts and vertex cache statistics before and after optimizing</returns>
+	MeshOptimizer::Stats Optimize(const MeshOptimizer::Settings& settings = MeshOptimizer::Settings()) {
+		static_assert(offsetof(VertType, Position) == 0, "Optimize expects the position to be the first member of the vertex");
+		MeshOptimizer::Stats result;
+		if (_vertices.empty()) {
+			return result;
+		}
+		_GenerateIndices();
+
+		result.VerticesBefore = _vertices.size();
+		result.Before = MeshOptimizer::AnalyzeVertexCache(_indices.data(), _indices.size(), _vertices.size());
+
+		std::vector<uint32_t> remap(_vertices.size());
+		if (settings.Weld) {
+			MeshOptimizer::GenerateWeldRemap(remap.data(), _vertices.data(), _vertices.size(), sizeof(VertType), settings.WeldEpsilon);
+			MeshOptimizer::RemapIndices(_indices.data(), _indices.size(), remap.data());
+		}
+		if (settings.VertexCache) {
+			MeshOptimizer::OptimizeVertexCache(_indices.data(), _indices.size(), _vertices.size());
+		}
+		if (settings.Overdraw) {
+			MeshOptimizer::OptimizeOverdraw(_indices.data(), _indices.size(), &_vertices[0].Position.x, _vertices.size(), sizeof(VertType), settings.OverdrawThreshold);
+		}
+
+		// Welding leaves vertices that are no longer referenced, so we always compact the vertices after welding
+		if (settings.VertexFetch || settings.Weld) {
+			size_t uniqueCount = 0;
+			if (settings.VertexFetch) {
+				uniqueCount = MeshOptimizer::GenerateFetchRemap(remap.data(), _indices.data(), _indices.size(), _vertices.size());
+			} else {
+				// Keep the original order, only dropping the unused vertices
+				std::vector<bool> used(_vertices.size(), false);
+				for (uint32_t index : _indices) {
+					used[index] = true;
+				}
+				for (size_t ix = 0; ix < _vertices.size(); ix++) {
+					remap[ix] = used[ix] ? static_cast<uint32_t>(uniqueCount++) : UINT32_MAX;
+				}
+			}
+			MeshOptimizer::RemapIndices(_indices.data(), _indices.size(), remap.data());
+			MeshOptimizer::RemapVertices(_vertices, remap.data(), uniqueCount);
+		}
+
+		result.VerticesAfter = _vertices.size();
+		result.After = MeshOptimizer::AnalyzeVertexCache(_indices.data(), _indices.size(), _vertices.size());
+		return result;
+	}
+
+	/// <summary>
+	/// Creates a copy of this mesh with a different vertex type, ex: to convert to one of the packed vertex types.
+	/// The target type must have a constructor that takes our vertex type
+	/// </summary>
+	/// <typeparam name="OutType">The vertex type to convert to</typeparam>
+	/// <returns>A new mesh builder with the converted vertices, and the same indices</returns>
+	template <typename OutType>
+	MeshBuilder<OutType> Convert() const {
+		MeshBuilder<OutType> result;
+		result._vertices.reserve(_vertices.size());
+		for (const VertType& vertex : _vertices) {
+			result._vertices.emplace_back(vertex);
+		}
+		result._indices = _indices;
+		return result;
+	}
+
+	/// <summary>
+	/// Generates a chain of simplified versions of this mesh with MeshOptimizer::Simplify, and appends their indices
+	/// after the existing ones so that all the levels share the same vertex and index buffers. Run Optimize first,
+	/// since vertices that are split for no reason look like attribute seams, which the simplifier will not move
+	/// </summary>
+	/// <param name="settings">Controls the number of levels and how much each one is simplified</param>
+	/// <returns>The index ranges of each level, and the bounds of the mesh</returns>
+	LodMesh::Description GenerateLods(const LodMesh::Settings& settings = LodMesh::Settings()) {
+		static_assert(offsetof(VertType, Position) == 0, "GenerateLods expects the position to be the first member of the vertex");
+		LodMesh::Description result;
+		if (_vertices.empty()) {
+			return result;
+		}
+		_GenerateIndices();
+
+		// The simplifier measures error relative to the largest dimension, but we select levels by the bounding sphere
+		glm::vec3 minBounds = _vertices[0].Position;
+		glm::vec3 maxBounds = minBounds;
+		for (const VertType& vertex : _vertices) {
+			minBounds = glm::min(minBounds, vertex.Position);
+			maxBounds = glm::max(maxBounds, vertex.Position);
+		}
+		result.Center = (minBounds + maxBounds) * 0.5f;
+		for (const VertType& vertex : _vertices) {
+			result.Radius = std::max(result.Radius, glm::length(vertex.Position - result.Center));
+		}
+		const glm::vec3 size = maxBounds - minBounds;
+		const float extent = std::max(size.x, std::max(size.y, size.z));
+		const float errorScale = result.Radius > 0.0f ? extent / result.Radius : 0.0f;
+
+		const size_t sourceCount = _indices.size() - _indices.size() % 3;
+		result.Levels.push_back(LodMesh::Level(0, static_cast<uint32_t>(sourceCount), 0.0f));
+		std::vector<uint32_t> simplified(sourceCount);
+		for (int level = 1; level < settings.LevelCount; level++) {
+			// Always simplify from the full detail mesh, so each level's error is measured against the original
+			const size_t target = static_cast<size_t>(sourceCount * powf(settings.Reduction, static_cast<float>(level))) / 3 * 3;
+			float error = 0.0f;
+			const size_t count = MeshOptimizer::Simplify(simplified.data(), _indices.data(), sourceCount, &_vertices[0].Position.x,
+				_vertices.size(), sizeof(VertType), target, settings.MaxError, &error);
+
+			// Stop once the error limit keeps the simplifier from making real progress, levels that barely differ from the last one only cost memory
+			const LodMesh::Level& previous = result.Levels.back();
+			if (count == 0 || count > previous.IndexCount - previous.IndexCount / 4) {
+				break;
+			}
+			MeshOptimizer::OptimizeVertexCache(simplified.data(), count, _vertices.size());
+			result.Levels.push_back(LodMesh::Level(static_cast<uint32_t>(_indices.size()), static_cast<uint32_t>(count), std::max(error * errorScale, previous.Error)));
+			_indices.insert(_indices.end(), simplified.begin(), simplified.begin() + count);
+		}
+		return result;
+	}
+
+	/// <summary>
+	/// Uploads this mesh into a new VAO
+	/// </summary>
+	VertexArrayObject::sptr Bake() const {
+		VertexArrayObject::sptr result = VertexArrayObject::Create();
+		BakeInto(result);
+		return result;
+	}
+
+	/// <summary>
+	/// Uploads this mesh into an existing VAO that has no buffers yet, ex: a placeholder that renderers are already using.
+	/// Indexed meshes are placed in the shared GeometryArena for our vertex type when GeometryArena::Enabled is set
+	/// </summary>
+	/// <param name="target">The VAO to add our vertex and index buffers to</param>
+	void BakeInto(const VertexArrayObject::sptr& target) const {
+		if (!_vertices.empty()) {
+			target->SetBounds(MeshBounds::Compute(&_vertices[0].Position, _vertices.size(), sizeof(VertType)));
+		}
+
+		if (GeometryArena::Enabled && !_vertices.empty() && !_indices.empty()) {
+			target->SetAllocation(GeometryArena::Get<VertType>()->Allocate(GetVertexDataPtr(), _vertices.size(), GetIndexDataPtr(), _indices.size()));
+			return;
+		}
+
 		VertexBuffer::sptr vbo = VertexBuffer::Create();
 		vbo->LoadData(GetVertexDataPtr(), _vertices.size());
 
 		IndexBuffer::sptr ebo = IndexBuffer::Create();
-		ebo->LoadData(GetIndexDataPtr(), _indices.size());
+		ebo->LoadCompactData(GetIndexDataPtr(), _indices.size(), _vertices.empty() ? 0 : static_cast<uint32_t>(_vertices.size() - 1));
 
-		VertexArrayObject::sptr result = VertexArrayObject::Create();
-		result->AddVertexBuffer(vbo, VertType::V_DECL);
-		result->SetIndexBuffer(ebo);
+		target->AddVertexBuffer(vbo, VertType::V_DECL);
+		target->SetIndexBuffer(ebo);
+	}
 
+	/// <summary>
+	/// Generates the levels of detail for this mesh with GenerateLods, and uploads all of them into a new LodMesh
+	/// </summary>
+	/// <param name="settings">Controls the number of levels and how much each one is simplified</param>
+	LodMesh::sptr BakeLods(const LodMesh::Settings& settings = LodMesh::Settings()) {
+		LodMesh::Description description = GenerateLods(settings);
+		LodMesh::sptr result = LodMesh::Create();
+		BakeInto(result->GetVao());
+		result->SetDescription(description);
 		return result;
 	}
 	
@@ -112,7 +273,32 @@ public:
 	
 protected:
 	friend class MeshFactory;
+	friend class MeshCache;
+	template <typename OtherType>
+	friend class MeshBuilder;
 	
 	std::vector<VertType> _vertices;
 	std::vector<uint32_t> _indices;
+
+	/// <summary>
+	/// Fills in the index buffer with one index per vertex if the mesh doesn't have any
+	/// </summary>
+	void _GenerateIndices() {
+		if (_indices.empty()) {
+			_indices.resize(_vertices.size() - _vertices.size() % 3);
+			std::iota(_indices.begin(), _indices.end(), 0);
+		}
+	}
+
+	/// <summary>
+	/// Makes room for extendAmount more elements, growing the capacity geometrically. std::vector::reserve allocates
+	/// exactly what is requested, so reserving a few elements at a time would re-allocate on every call
+	/// </summary>
+	template <typename T>
+	static void _ReserveGeometric(std::vector<T>& vec, size_t extendAmount) {
+		size_t required = vec.size() + extendAmount;
+		if (required > vec.capacity()) {
+			vec.reserve(required > vec.capacity() * 2 ? required : vec.capacity() * 2);
+		}
+	}
 };
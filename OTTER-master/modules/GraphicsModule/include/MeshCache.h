@@ -0,0 +1,105 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "MeshBuilder.h"
+#include "VertexArrayObject.h"
+
+/// <summary>
+/// The header at the start of every baked mesh cache file, followed directly by the raw vertex data and
+/// then the raw uint32_t index data
+/// </summary>
+struct MeshCacheHeader
+{
+	char     Magic[4];     // Always "OTMC"
+	uint32_t Version;      // Must match MeshCache::VERSION, bump whenever the layout or loader output changes
+	uint64_t Key;          // The hash of the source file contents and the loader options
+	uint32_t VertexStride; // The size of a single vertex, in bytes
+	uint32_t VertexCount;
+	uint32_t IndexCount;
+	uint32_t Reserved;
+};
+
+/// <summary>
+/// Stores the results of our mesh loaders in a binary format, so that later loads can skip parsing and
+/// de-duplication and upload straight from a memory mapping of the cache file
+/// </summary>
+class MeshCache
+{
+public:
+	/// <summary>
+	/// Whether the loaders should read and write cache files
+	/// </summary>
+	inline static bool Enabled = true;
+	/// <summary>
+	/// The directory that cache files are stored in, relative to the working directory
+	/// </summary>
+	inline static std::string Directory = "cache";
+
+	inline static const uint32_t VERSION = 1;
+
+	/// <summary>
+	/// Computes the cache key for a source file, by hashing its contents along with the loader options
+	/// </summary>
+	/// <param name="sourceFile">The path to the source file</param>
+	/// <param name="optionsHash">A hash of the loader and any options that affect its output, see HashFnv1a</param>
+	static uint64_t ComputeKey(const std::string& sourceFile, uint64_t optionsHash);
+
+	/// <summary>
+	/// Attempts to load a mesh from the cache, uploading the data directly from a mapping of the cache file
+	/// </summary>
+	/// <typeparam name="VertType">The type of vertex stored in the cache</typeparam>
+	/// <param name="sourceFile">The path to the source file the cache was created from</param>
+	/// <param name="key">The key computed by ComputeKey</param>
+	/// <returns>The baked mesh, or nullptr if there was no valid cache entry</returns>
+	template <typename VertType>
+	static VertexArrayObject::sptr TryLoad(const std::string& sourceFile, uint64_t key) {
+		return _TryLoad(sourceFile, key, sizeof(VertType), VertType::V_DECL);
+	}
+
+	/// <summary>
+	/// Attempts to load a mesh from the cache into a mesh builder, without touching any OpenGL state. This lets loads
+	/// on worker threads use the cache, leaving only the upload for the main thread
+	/// </summary>
+	/// <typeparam name="VertType">The type of vertex stored in the cache</typeparam>
+	/// <param name="sourceFile">The path to the source file the cache was created from</param>
+	/// <param name="key">The key computed by ComputeKey</param>
+	/// <param name="mesh">The mesh builder to replace the contents of</param>
+	/// <returns>True if there was a valid cache entry and it was copied into mesh</returns>
+	template <typename VertType>
+	static bool TryLoadData(const std::string& sourceFile, uint64_t key, MeshBuilder<VertType>& mesh) {
+		return _TryLoadData(sourceFile, key, sizeof(VertType), [&](const char* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount) {
+			mesh._vertices.resize(vertexCount);
+			mesh._indices.assign(indices, indices + indexCount);
+			if (vertexCount > 0) {
+				memcpy(mesh._vertices.data(), vertices, vertexCount * sizeof(VertType));
+			}
+		});
+	}
+
+	/// <summary>
+	/// Writes the contents of a mesh builder into the cache
+	/// </summary>
+	/// <typeparam name="VertType">The type of vertex stored in the mesh</typeparam>
+	/// <param name="sourceFile">The path to the source file the mesh was created from</param>
+	/// <param name="key">The key computed by ComputeKey</param>
+	/// <param name="mesh">The mesh to store</param>
+	template <typename VertType>
+	static void Store(const std::string& sourceFile, uint64_t key, const MeshBuilder<VertType>& mesh) {
+		_Store(sourceFile, key, sizeof(VertType), mesh.GetVertexDataPtr(), mesh.GetVertexCount(), mesh.GetIndexDataPtr(), mesh.GetIndexCount());
+	}
+
+protected:
+	MeshCache() = default;
+	~MeshCache() = default;
+
+	static std::string _GetCachePath(const std::string& sourceFile, uint64_t key);
+	static VertexArrayObject::sptr _TryLoad(const std::string& sourceFile, uint64_t key, size_t vertexStride, const std::vector<BufferAttribute>& attributes);
+	static bool _TryLoadData(const std::string& sourceFile, uint64_t key, size_t vertexStride,
+		const std::function<void(const char* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount)>& copy);
+	static bool _Validate(const std::string& path, const std::string& sourceFile, uint64_t key, size_t vertexStride, const char* data, size_t size, MeshCacheHeader& header);
+	static void _Store(const std::string& sourceFile, uint64_t key, size_t vertexStride, const void* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount);
+};
@@ -1,4 +1,8 @@
 #pragma once
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
 #include <GLM/glm.hpp>
 #include <GLM/gtc/matrix_transform.hpp>
 #include "VertexArrayObject.h"
@@ -20,10 +24,35 @@ public:
 	static void AddPlane(MeshBuilder<VertexPosNormTexCol>& mesh, const glm::vec3& pos, const glm::vec3& normal, const glm::vec3& tangent, const glm::vec2& scale, const glm::vec4& col = glm::vec4(1.0f));
 
 	static void InvertFaces(MeshBuilder<VertexPosNormTexCol>& mesh);
+
+	/// <summary>
+	/// Frees the unit spheres that have been cached, they will be rebuilt the next time they are needed
+	/// </summary>
+	static void ClearPrimitiveCache();
 	
 protected:	
 	MeshFactory() = default;
 	~MeshFactory() = default;
 
+	/// <summary>
+	/// A primitive with a radius of 1 centered on the origin, which is built once per tessellation level and then
+	/// copied into meshes. Since the primitive is a unit sphere, the position of each vertex is the same as it's normal
+	/// </summary>
+	struct UnitPrimitive {
+		std::vector<VertexPosNormTexCol> Vertices;
+		std::vector<uint32_t>            Indices;
+	};
+	typedef std::shared_ptr<const UnitPrimitive> PrimitivePtr;
+
+	static PrimitivePtr _GetPrimitive(std::unordered_map<int, PrimitivePtr>& cache, int tessellation, void(*builder)(UnitPrimitive&, int));
+	static void _BuildIcoSphere(UnitPrimitive& result, int tessellation);
+	static void _BuildUvSphere(UnitPrimitive& result, int tessellation);
+	static void _AppendSphere(MeshBuilder<VertexPosNormTexCol>& mesh, const UnitPrimitive& primitive, const glm::vec3& center, const glm::vec3& radii, const glm::vec4& col);
+
 	inline static const glm::mat4 MAT4_IDENTITY = glm::mat4(1.0f);
+
+	// The unit spheres we've built so far, keyed by tessellation level. Loaders can run on worker threads, so access is locked
+	inline static std::unordered_map<int, PrimitivePtr> _icoSpheres;
+	inline static std::unordered_map<int, PrimitivePtr> _uvSpheres;
+	inline static std::mutex _primitiveLock;
 };
\ No newline at end of file
@@ -0,0 +1,162 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// <summary>
+/// Index and vertex reordering passes that make meshes cheaper to draw. These only work on raw index and
+/// vertex arrays and never touch OpenGL, see MeshBuilder::Optimize for running all of them on a mesh
+/// </summary>
+class MeshOptimizer
+{
+public:
+	/// <summary>
+	/// Selects which passes MeshBuilder::Optimize will run
+	/// </summary>
+	struct Settings
+	{
+		// Merges vertices whose positions are within WeldEpsilon of each other and whose other attributes are identical
+		bool  Weld;
+		float WeldEpsilon;
+		// Reorders triangles to make better use of the post-transform vertex cache
+		bool  VertexCache;
+		// Reorders clusters of triangles so that outward facing ones are drawn first, trading up to
+		// OverdrawThreshold times the vertex cache misses for less overdraw
+		bool  Overdraw;
+		float OverdrawThreshold;
+		// Reorders vertices into the order they are first used in, and removes unused vertices
+		bool  VertexFetch;
+
+		Settings() :
+			Weld(true), WeldEpsilon(0.0f), VertexCache(true), Overdraw(true), OverdrawThreshold(1.05f), VertexFetch(true) {}
+	};
+
+	/// <summary>
+	/// Post-transform vertex cache statistics for an index buffer
+	/// </summary>
+	struct CacheStats
+	{
+		// Average cache miss ratio, the number of vertex shader invocations per triangle (0.5 is ideal, 3 is worst)
+		float ACMR;
+		// Average transformed vertex ratio, the number of vertex shader invocations per vertex (1 is ideal)
+		float ATVR;
+
+		CacheStats() : ACMR(0.0f), ATVR(0.0f) {}
+	};
+
+	/// <summary>
+	/// The results of running MeshBuilder::Optimize
+	/// </summary>
+	struct Stats
+	{
+		size_t     VerticesBefore;
+		size_t     VerticesAfter;
+		CacheStats Before;
+		CacheStats After;
+
+		Stats() : VerticesBefore(0), VerticesAfter(0) {}
+	};
+
+	/// <summary>
+	/// The size of the FIFO cache we simulate when measuring ACMR and ATVR, and when splitting clusters for overdraw.
+	/// 16 is a conservative estimate that matches older hardware, newer hardware will do at least as well
+	/// </summary>
+	inline static size_t AnalysisCacheSize = 16;
+
+	/// <summary>
+	/// Simulates a FIFO post-transform cache over an index buffer to measure how many times vertices get transformed
+	/// </summary>
+	/// <param name="indices">The triangle list to analyze</param>
+	/// <param name="indexCount">The number of indices, must be a multiple of 3</param>
+	/// <param name="vertexCount">The number of vertices the indices reference</param>
+	static CacheStats AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount);
+
+	/// <summary>
+	/// Generates a remap table that merges duplicate vertices. Positions are read from the first 3 floats of each
+	/// vertex, and are merged when each component is within epsilon. All the bytes after the position must match exactly
+	/// </summary>
+	/// <param name="remap">Receives the index of the vertex to use in place of each vertex, must have room for vertexCount entries</param>
+	/// <param name="vertices">The vertex data</param>
+	/// <param name="vertexCount">The number of vertices</param>
+	/// <param name="stride">The size of a single vertex, in bytes</param>
+	/// <param name="epsilon">The largest difference in position components that will be merged, 0 for exact matches only</param>
+	/// <returns>The number of unique vertices</returns>
+	static size_t GenerateWeldRemap(uint32_t* remap, const void* vertices, size_t vertexCount, size_t stride, float epsilon);
+
+	/// <summary>
+	/// Reorders triangles to reduce post-transform vertex cache misses, using Tom Forsyth's linear-speed vertex cache optimization
+	/// </summary>
+	/// <param name="indices">The triangle list to reorder in place</param>
+	/// <param name="indexCount">The number of indices, must be a multiple of 3</param>
+	/// <param name="vertexCount">The number of vertices the indices reference</param>
+	static void OptimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount);
+
+	/// <summary>
+	/// Reorders clusters of triangles to reduce overdraw without knowing the view direction. The index buffer should
+	/// already be optimized for the vertex cache, and is split into clusters that keep the ACMR within threshold times
+	/// the original. Clusters that face away from the center of the mesh are drawn first, since they are the most likely to occlude
+	/// </summary>
+	/// <param name="indices">The triangle list to reorder in place</param>
+	/// <param name="indexCount">The number of indices, must be a multiple of 3</param>
+	/// <param name="positions">The vertex positions, as 3 floats at the start of each vertex</param>
+	/// <param name="vertexCount">The number of vertices the indices reference</param>
+	/// <param name="stride">The distance between the start of each vertex, in bytes</param>
+	/// <param name="threshold">How much worse the ACMR is allowed to get, 1.05 allows it to get 5% worse</param>
+	static void OptimizeOverdraw(uint32_t* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t stride, float threshold);
+
+	/// <summary>
+	/// Reduces the number of triangles in a mesh by collapsing edges in order of their quadric error (Garland and
+	/// Heckbert). Only the index buffer changes, the simplified triangles reference a subset of the original vertices.
+	/// Vertices on attribute seams (the same position with different normals or UVs) are never moved, and vertices on
+	/// open borders only slide along the border, so the result keeps its outline and texture mapping
+	/// </summary>
+	/// <param name="destination">Receives the simplified triangle list, must have room for indexCount entries (may be the same as indices)</param>
+	/// <param name="indices">The triangle list to simplify</param>
+	/// <param name="indexCount">The number of indices, must be a multiple of 3</param>
+	/// <param name="positions">The vertex positions, as 3 floats at the start of each vertex</param>
+	/// <param name="vertexCount">The number of vertices the indices reference</param>
+	/// <param name="stride">The distance between the start of each vertex, in bytes</param>
+	/// <param name="targetIndexCount">The number of indices to stop at, the result may have more if the error limit is hit first</param>
+	/// <param name="targetError">The largest error to allow, as a fraction of the mesh's largest dimension (ex: 0.01 for 1%)</param>
+	/// <param name="resultError">If not null, receives the largest error that was introduced, in the same units as targetError</param>
+	/// <returns>The number of indices written to destination</returns>
+	static size_t Simplify(uint32_t* destination, const uint32_t* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t stride,
+		size_t targetIndexCount, float targetError, float* resultError = nullptr);
+
+	/// <summary>
+	/// Generates a remap table that puts vertices in the order that they are first referenced by the index buffer,
+	/// so that vertex fetches walk through memory in order. Unused vertices are mapped to UINT32_MAX
+	/// </summary>
+	/// <param name="remap">Receives the new index of each vertex, must have room for vertexCount entries</param>
+	/// <param name="indices">The triangle list to read</param>
+	/// <param name="indexCount">The number of indices</param>
+	/// <param name="vertexCount">The number of vertices the indices reference</param>
+	/// <returns>The number of vertices that are referenced by the index buffer</returns>
+	static size_t GenerateFetchRemap(uint32_t* remap, const uint32_t* indices, size_t indexCount, size_t vertexCount);
+
+	/// <summary>
+	/// Applies a remap table to a vertex array, dropping any vertices that are mapped to UINT32_MAX
+	/// </summary>
+	/// <param name="vertices">The vertices to remap</param>
+	/// <param name="remap">The new index of each vertex</param>
+	/// <param name="uniqueCount">The number of vertices in the result</param>
+	template <typename VertType>
+	static void RemapVertices(std::vector<VertType>& vertices, const uint32_t* remap, size_t uniqueCount) {
+		std::vector<VertType> result(uniqueCount);
+		for (size_t ix = 0; ix < vertices.size(); ix++) {
+			if (remap[ix] != UINT32_MAX) {
+				result[remap[ix]] = vertices[ix];
+			}
+		}
+		vertices.swap(result);
+	}
+
+	/// <summary>
+	/// Applies a remap table to an index buffer
+	/// </summary>
+	static void RemapIndices(uint32_t* indices, size_t indexCount, const uint32_t* remap);
+
+protected:
+	MeshOptimizer() = default;
+	~MeshOptimizer() = default;
+};
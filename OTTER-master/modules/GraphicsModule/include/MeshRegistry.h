@@ -0,0 +1,103 @@
+#pragma once
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <GLM/glm.hpp>
+
+#include "LodMesh.h"
+#include "VertexArrayObject.h"
+#include "VertexTypes.h"
+
+/// <summary>
+/// Hands out shared meshes, so that loading the same file with the same options multiple times will only
+/// parse and upload it once. The registry only holds weak references, so meshes are freed once no
+/// renderers are using them
+/// </summary>
+class MeshRegistry
+{
+public:
+	/// <summary>
+	/// Tracks how effective the registry has been at sharing meshes
+	/// </summary>
+	struct Stats {
+		size_t Hits;       // Number of requests that were served from an existing mesh
+		size_t Misses;     // Number of requests that had to load a new mesh
+		size_t BytesSaved; // The total size of GPU buffers that we did not need to create due to hits
+
+		Stats() : Hits(0), Misses(0), BytesSaved(0) {}
+	};
+
+	/// <summary>
+	/// Gets or loads a mesh from an OBJ file, see ObjLoader::LoadFromFile
+	/// </summary>
+	/// <param name="filename">The path of the OBJ file to load</param>
+	/// <param name="inColor">The color to apply to all vertices in the mesh</param>
+	/// <param name="format">The vertex type to store the mesh with</param>
+	static VertexArrayObject::sptr LoadObj(const std::string& filename, const glm::vec4& inColor = glm::vec4(1.0f), VertexFormat format = VertexFormat::Full);
+	/// <summary>
+	/// Gets or loads a mesh from a NotObj scene file, see NotObjLoader::LoadFromFile
+	/// </summary>
+	/// <param name="filename">The path of the NotObj file to load</param>
+	static VertexArrayObject::sptr LoadNotObj(const std::string& filename);
+
+	/// <summary>
+	/// Gets the key that LoadObj will store a mesh under, so that other loaders can share entries with it
+	/// </summary>
+	/// <param name="filename">The path of the OBJ file</param>
+	/// <param name="inColor">The color applied to all vertices in the mesh</param>
+	/// <param name="format">The vertex type the mesh is stored with</param>
+	static std::string GetObjKey(const std::string& filename, const glm::vec4& inColor = glm::vec4(1.0f), VertexFormat format = VertexFormat::Full);
+
+	/// <summary>
+	/// Gets the key to store a LOD mesh under, based on the key of the mesh it was generated from
+	/// </summary>
+	/// <param name="meshKey">The key of the full detail mesh, ex: from GetObjKey</param>
+	/// <param name="settings">The settings the levels were generated with</param>
+	static std::string GetLodKey(const std::string& meshKey, const LodMesh::Settings& settings);
+
+	/// <summary>
+	/// Gets the mesh stored under the given key if it is still alive, otherwise invokes the loader and stores the result
+	/// </summary>
+	/// <param name="key">A unique key identifying the source and all options that affect the resulting mesh</param>
+	/// <param name="loader">The function to call to create the mesh if it is not already loaded</param>
+	static VertexArrayObject::sptr GetOrLoad(const std::string& key, const std::function<VertexArrayObject::sptr()>& loader);
+	/// <summary>
+	/// Gets the LOD mesh stored under the given key if it is still alive, otherwise invokes the loader and stores the result
+	/// </summary>
+	/// <param name="key">A unique key identifying the source and all options that affect the resulting mesh, see GetLodKey</param>
+	/// <param name="loader">The function to call to create the mesh if it is not already loaded</param>
+	static LodMesh::sptr GetOrLoadLods(const std::string& key, const std::function<LodMesh::sptr()>& loader);
+
+	/// <summary>
+	/// Removes any entries for meshes that have already been freed
+	/// </summary>
+	static void Prune();
+
+	/// <summary>
+	/// Gets the hit/miss statistics for the registry
+	/// </summary>
+	static Stats GetStats();
+	/// <summary>
+	/// Resets the hit/miss statistics for the registry
+	/// </summary>
+	static void ResetStats();
+
+	/// <summary>
+	/// Gets the canonical form of a path, so that different spellings of the same file share a key
+	/// </summary>
+	static std::string CanonicalPath(const std::string& path);
+
+protected:
+	MeshRegistry() = default;
+	~MeshRegistry() = default;
+
+	template <typename MeshType>
+	static std::shared_ptr<MeshType> _GetOrLoad(std::unordered_map<std::string, std::weak_ptr<MeshType>>& meshes, const std::string& key,
+		const std::function<std::shared_ptr<MeshType>()>& loader);
+
+	inline static std::unordered_map<std::string, std::weak_ptr<VertexArrayObject>> _meshes;
+	inline static std::unordered_map<std::string, std::weak_ptr<LodMesh>> _lodMeshes;
+	inline static Stats _stats;
+	inline static std::mutex _lock;
+};
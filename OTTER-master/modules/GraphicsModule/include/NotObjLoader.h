@@ -1,12 +1,73 @@
 #pragma once
+#include <functional>
+#include <string>
+#include <vector>
+
 #include "MeshFactory.h"
 
 class NotObjLoader
 {
 public:
+	/// <summary>
+	/// One of the unique primitives in a scene, along with every place that it appears
+	/// </summary>
+	struct InstancedPrimitive
+	{
+		// The type and tessellation of the primitive, ex: "cube" or "ico 2"
+		std::string             Name;
+		// The primitive at unit size with white vertices, shared between every scene that uses it
+		VertexArrayObject::sptr Mesh;
+		// The model matrix of each instance
+		std::vector<glm::mat4>  Transforms;
+		// The color of each instance, to be multiplied with the vertex color
+		std::vector<glm::vec4>  Colors;
+
+		InstancedPrimitive() : Name(""), Mesh(nullptr), Transforms(std::vector<glm::mat4>()), Colors(std::vector<glm::vec4>()) {}
+	};
+
+	/// <summary>
+	/// Loads a scene file, expanding every primitive into a single mesh
+	/// </summary>
+	/// <param name="filename">The path of the NotObj file to load</param>
 	static VertexArrayObject::sptr LoadFromFile(const std::string& filename);
+	/// <summary>
+	/// Loads a scene file without duplicating any geometry, instead returning one mesh per unique primitive
+	/// (type and tessellation) along with the transform and color of each instance, ready for instanced drawing.
+	/// Memory use scales with the number of unique primitives rather than the number of lines in the file
+	/// </summary>
+	/// <param name="filename">The path of the NotObj file to load</param>
+	/// <returns>The unique primitives in the scene, in the order they first appear in the file</returns>
+	static std::vector<InstancedPrimitive> LoadInstancedFromFile(const std::string& filename);
 
 protected:
 	NotObjLoader() = default;
 	~NotObjLoader() = default;
-};
\ No newline at end of file
+
+	enum class PrimitiveType
+	{
+		Cube,
+		Plane,
+		IcoSphere,
+		UvSphere
+	};
+
+	// A single primitive line from a scene file, only the fields that the type uses are filled in
+	struct Primitive
+	{
+		PrimitiveType Type;
+		int           Tessellation;
+		glm::vec3     Position;
+		glm::vec3     Scale;    // The scale of a cube, the radii of a sphere, or the size of a plane in X and Y
+		glm::vec3     EulerDeg; // The rotation of a cube
+		glm::vec3     Normal;   // The normal of a plane
+		glm::vec3     Tangent;  // The tangent of a plane
+		glm::vec4     Color;
+
+		Primitive() : Type(PrimitiveType::Cube), Tessellation(0), Position(glm::vec3(0.0f)), Scale(glm::vec3(1.0f)), EulerDeg(glm::vec3(0.0f)),
+			Normal(glm::vec3(0.0f, 0.0f, 1.0f)), Tangent(glm::vec3(1.0f, 0.0f, 0.0f)), Color(glm::vec4(1.0f)) {}
+	};
+
+	static void _ParseFile(const std::string& filename, const std::function<void(const Primitive&)>& callback);
+	static VertexArrayObject::sptr _GetUnitMesh(PrimitiveType type, int tessellation);
+	static glm::mat4 _GetTransform(const Primitive& primitive);
+};
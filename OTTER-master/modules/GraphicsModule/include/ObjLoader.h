@@ -1,12 +1,58 @@
 #pragma once
 #include "MeshFactory.h"
+#include <EnumToString.h>
+
+/// <summary>
+/// Selects how the ObjLoader will read and tokenize the text of an OBJ file
+/// </summary>
+ENUM(ObjParseMode, int,
+	Stream = 0, // Reads the file via std::ifstream and string streams
+	Mapped = 1, // Memory maps the file and tokenizes it in place, with no per-line allocations
+	Parallel = 2 // Memory maps the file and tokenizes chunks of it on multiple threads, output matches Mapped exactly
+);
 
 class ObjLoader
 {
 public:
-	static VertexArrayObject::sptr LoadFromFile(const std::string& filename, const glm::vec4& inColor = glm::vec4(1.0f));
+	/// <summary>
+	/// Loads an OBJ file and bakes it into a VAO
+	/// </summary>
+	/// <param name="filename">The path of the OBJ file to load</param>
+	/// <param name="inColor">The color to apply to all vertices in the mesh</param>
+	/// <param name="mode">The parsing mode to use when reading the file</param>
+	/// <param name="format">The vertex type to store the mesh with</param>
+	/// <returns>A VAO containing the mesh data</returns>
+	static VertexArrayObject::sptr LoadFromFile(const std::string& filename, const glm::vec4& inColor = glm::vec4(1.0f), ObjParseMode mode = ObjParseMode::Mapped, VertexFormat format = VertexFormat::Full);
+
+	/// <summary>
+	/// Loads an OBJ file into a mesh builder, without touching any OpenGL state. This is useful
+	/// for when we want to modify the mesh before baking, or to load meshes without a context
+	/// </summary>
+	/// <param name="filename">The path of the OBJ file to load</param>
+	/// <param name="mesh">The mesh builder to append the vertices and indices to</param>
+	/// <param name="inColor">The color to apply to all vertices in the mesh</param>
+	/// <param name="mode">The parsing mode to use when reading the file</param>
+	static void LoadMeshData(const std::string& filename, MeshBuilder<VertexPosNormTexCol>& mesh, const glm::vec4& inColor = glm::vec4(1.0f), ObjParseMode mode = ObjParseMode::Mapped);
+
+	/// <summary>
+	/// Computes the MeshCache key that LoadFromFile stores a file under, so that other loaders can share its entries
+	/// </summary>
+	/// <param name="filename">The path of the OBJ file</param>
+	/// <param name="inColor">The color applied to all vertices in the mesh</param>
+	/// <param name="format">The vertex type the mesh is stored with</param>
+	static uint64_t GetCacheKey(const std::string& filename, const glm::vec4& inColor, VertexFormat format = VertexFormat::Full);
 
 protected:
 	ObjLoader() = default;
 	~ObjLoader() = default;
-};
\ No newline at end of file
+
+	template <typename VertType>
+	static VertexArrayObject::sptr _LoadFromFile(const std::string& filename, const glm::vec4& inColor, ObjParseMode mode, VertexFormat format);
+
+	static void _ParseStream(const std::string& filename, MeshBuilder<VertexPosNormTexCol>& mesh, const glm::vec4& inColor);
+	static void _ParseMapped(const std::string& filename, MeshBuilder<VertexPosNormTexCol>& mesh, const glm::vec4& inColor);
+	static void _ParseParallel(const std::string& filename, MeshBuilder<VertexPosNormTexCol>& mesh, const glm::vec4& inColor);
+
+	// The smallest chunk of the file that we will hand off to a thread when parsing in parallel
+	inline static const size_t PARALLEL_MIN_CHUNK_SIZE = 64 * 1024;
+};
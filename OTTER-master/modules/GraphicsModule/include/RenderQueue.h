@@ -0,0 +1,152 @@
+#pragma once
+#include <bitset>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+/// <summary>
+/// Sorts the draws for a frame by a packed 64 bit key, using an LSD radix sort instead of a comparison sort.
+/// From the most to least significant bits, the key holds:
+///    8 bits  - render layer (higher layers are drawn last)
+///    10 bits - shader ID
+///    14 bits - material ID
+///    14 bits - mesh ID
+///    2 bits  - level of detail
+///    16 bits - quantized depth (front to back)
+/// Layers marked as transparent with SetLayerTransparent need to blend over what is behind them, so their depth is
+/// inverted (back to front) and moved up to sit directly below the layer, with the rest of the fields shifted down:
+///    8 bits  - render layer
+///    16 bits - inverted quantized depth (back to front)
+///    10 bits - shader ID
+///    14 bits - material ID
+///    14 bits - mesh ID
+///    2 bits  - level of detail
+/// IDs that don't fit in their bits wrap around, which only means that unrelated objects may be grouped together
+/// in the sort. The render layer is clamped instead, since draw order between layers matters for correctness
+///
+/// The queue remembers the order from the last sort, and if the same values are pushed again and that order is still
+/// sorted by the new keys, the sort is skipped entirely. This is the common case when nothing in the scene has moved
+/// </summary>
+class RenderQueue final
+{
+public:
+	typedef std::shared_ptr<RenderQueue> sptr;
+	static inline sptr Create() {
+		return std::make_shared<RenderQueue>();
+	}
+
+	// We'll disallow moving and copying, since we want to manually control when the destructor is called
+	// We'll use these classes via pointers
+	RenderQueue(const RenderQueue& other) = delete;
+	RenderQueue(RenderQueue&& other) = delete;
+	RenderQueue& operator=(const RenderQueue& other) = delete;
+	RenderQueue& operator=(RenderQueue&& other) = delete;
+
+	/// <summary>
+	/// A single draw in the queue, the value is up to the caller (ex: an entity ID or an index into a list)
+	/// </summary>
+	struct Item
+	{
+		uint64_t Key;
+		uint32_t Value;
+
+		Item() : Key(0), Value(0) {}
+		Item(uint64_t key, uint32_t value) : Key(key), Value(value) {}
+	};
+
+	/// <summary>
+	/// Counts how often the queue was able to skip sorting
+	/// </summary>
+	struct Stats
+	{
+		size_t Sorts;
+		size_t SkippedSorts;
+
+		Stats() : Sorts(0), SkippedSorts(0) {}
+	};
+
+	/// <summary>
+	/// Packs the sort key for a draw
+	/// </summary>
+	/// <param name="layer">The render layer, clamped to 0-255</param>
+	/// <param name="shaderId">The ID of the shader, ex: Shader::GetHandle</param>
+	/// <param name="materialId">The ID of the material, ex: ShaderMaterial::GetId</param>
+	/// <param name="meshId">The ID of the mesh, ex: VertexArrayObject::GetHandle</param>
+	/// <param name="lodLevel">The level of detail, clamped to 0-3</param>
+	/// <param name="depth">The distance to the camera as a fraction of the far plane, clamped to 0-1</param>
+	static uint64_t MakeKey(int layer, uint32_t shaderId, uint32_t materialId, uint32_t meshId, int lodLevel, float depth);
+
+	/// <summary>
+	/// Sets whether a render layer holds transparent objects, which are sorted back to front by MakeKey
+	/// </summary>
+	/// <param name="layer">The render layer, clamped to 0-255</param>
+	/// <param name="transparent">True to sort the layer back to front, false to sort it by state then front to back</param>
+	static void SetLayerTransparent(int layer, bool transparent = true);
+	/// <summary>
+	/// Gets whether a render layer has been marked as transparent with SetLayerTransparent
+	/// </summary>
+	static bool IsLayerTransparent(int layer);
+
+	RenderQueue();
+	~RenderQueue() = default;
+
+	/// <summary>
+	/// Removes all the items, call this at the start of each frame. The order from the last sort is kept so that
+	/// the next sort can be skipped if nothing changed
+	/// </summary>
+	void Clear() { _items.clear(); }
+	/// <summary>
+	/// Reserves space for the given number of items, so pushing them will not allocate
+	/// </summary>
+	void Reserve(size_t count);
+	/// <summary>
+	/// Adds an item to the queue, items should be pushed in the same order every frame for sort skipping to work
+	/// </summary>
+	void Push(uint64_t key, uint32_t value) { _items.emplace_back(key, value); }
+
+	/// <summary>
+	/// Sorts the items by their keys, skipping the sort if the order from last time is still valid.
+	/// When the items are sorted, items with equal keys keep the order they were pushed in
+	/// </summary>
+	/// <returns>True if the items were sorted, false if the sort was skipped</returns>
+	bool Sort();
+
+	/// <summary>
+	/// Gets the number of items in the queue
+	/// </summary>
+	size_t GetCount() const { return _items.size(); }
+	/// <summary>
+	/// Gets the items in sorted order, only valid after a call to Sort
+	/// </summary>
+	const std::vector<Item>& GetSorted() const { return _sorted; }
+	/// <summary>
+	/// Gets how many times the queue has sorted or skipped sorting
+	/// </summary>
+	const Stats& GetStats() const { return _stats; }
+
+	/// <summary>
+	/// Sorts a list of items by their keys with an LSD radix sort, 8 bits at a time. Passes where every key has the
+	/// same byte are skipped, so keys that only use a few bits sort faster
+	/// </summary>
+	/// <param name="items">The items to sort</param>
+	/// <param name="scratch">A buffer to use while sorting, will be resized to match items</param>
+	static void RadixSort(std::vector<Item>& items, std::vector<Item>& scratch);
+
+protected:
+	// The render layers that are sorted back to front
+	inline static std::bitset<256> _transparentLayers;
+
+	// The items pushed this frame, in the order they were pushed
+	std::vector<Item>     _items;
+	// The items in sorted order
+	std::vector<Item>     _sorted;
+	// For each item in _sorted, the index it was pushed at
+	std::vector<uint32_t> _order;
+	// The values from the last sort, in the order they were pushed
+	std::vector<uint32_t> _lastValues;
+	// The working buffers for the radix sort
+	std::vector<Item>     _keys;
+	std::vector<Item>     _scratch;
+	Stats                 _stats;
+};
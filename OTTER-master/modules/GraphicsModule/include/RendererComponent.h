@@ -1,12 +1,21 @@
 #pragma once
 #include <VertexArrayObject.h>
+#include <LodMesh.h>
 #include <ShaderMaterial.h>
 
 class RendererComponent {
 public:
 	VertexArrayObject::sptr Mesh;
 	ShaderMaterial::sptr    Material;
+	// If set, Mesh is the VAO of this LOD mesh and the render loop will pick a level each frame
+	LodMesh::sptr           Lods;
+	// The level of detail that was drawn last frame
+	int                     LodLevel = 0;
+	// If false, the render loop will always draw this object without checking it's bounds, ex: for skyboxes
+	bool                    Cullable = true;
 
-	RendererComponent& SetMesh(const VertexArrayObject::sptr& mesh) { Mesh = mesh; return *this; }
+	RendererComponent& SetMesh(const VertexArrayObject::sptr& mesh) { Mesh = mesh; Lods = nullptr; return *this; }
+	RendererComponent& SetMesh(const LodMesh::sptr& lods) { Mesh = lods->GetVao(); Lods = lods; LodLevel = 0; return *this; }
 	RendererComponent& SetMaterial(const ShaderMaterial::sptr& material) { Material = material; return *this; }
+	RendererComponent& SetCullable(bool cullable) { Cullable = cullable; return *this; }
 };
\ No newline at end of file
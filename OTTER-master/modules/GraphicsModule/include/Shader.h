@@ -4,10 +4,57 @@
 
 #include <string>               // for std::string
 #include <unordered_map>        // for std::unordered_map
+#include <vector>               // for std::vector
 #include <GLM/glm.hpp>          // for our GLM types
 #include <GLM/gtc/type_ptr.hpp> // for glm::value_ptr
 #include "Logging.h"            // for the logging functions
 
+/// <summary>
+/// A uniform name that is registered once up front, so that shaders can find it's location with an array index
+/// instead of hashing the name on every call. These should be created once and kept around, ex:
+///    static const UniformId U_MODEL("u_Model");
+///    shader->SetUniformMatrix(U_MODEL, model);
+/// </summary>
+class UniformId final
+{
+public:
+	/// <summary>
+	/// Registers a uniform name, creating the same name twice will return the same ID
+	/// </summary>
+	explicit UniformId(const std::string& name);
+
+	/// <summary>
+	/// Gets the index of this ID, which shaders use to look up the location
+	/// </summary>
+	uint32_t GetIndex() const { return _index; }
+	/// <summary>
+	/// Gets the name of the uniform this ID refers to
+	/// </summary>
+	const std::string& GetName() const { return GetNames()[_index]; }
+
+	/// <summary>
+	/// Gets the names of every uniform that has been registered, in the order of their indices
+	/// </summary>
+	static const std::vector<std::string>& GetNames() { return _Registry(); }
+
+protected:
+	uint32_t _index;
+
+	static std::vector<std::string>& _Registry();
+};
+
+/// <summary>
+/// Describes where a uniform lives inside of a uniform block, as laid out by the driver
+/// </summary>
+struct UniformBlockMember
+{
+	GLint  Offset;       // The offset from the start of the block, in bytes
+	GLenum Type;         // The type of the uniform (ex: GL_FLOAT, GL_FLOAT_MAT3)
+	GLint  MatrixStride; // The distance between the columns of a matrix in bytes, 0 for anything else
+
+	UniformBlockMember() : Offset(0), Type(GL_NONE), MatrixStride(0) {}
+};
+
 /// <summary>
 /// This class will wrap around an OpenGL shader program
 /// </summary>
@@ -70,9 +117,78 @@ public:
 	/// Gets the underlying OpenGL handle that this class is wrapping
 	/// </summary>
 	GLuint GetHandle() const { return _handle; }
+	/// <summary>
+	/// Returns true if the vertex shader reads it's transforms from an InstanceBuffer (an inInstanceModel input),
+	/// meaning that it can be drawn with VertexArrayObject::RenderInstanced. Only valid after linking
+	/// </summary>
+	bool SupportsInstancing() const { return _supportsInstancing; }
+
+	/// <summary>
+	/// Assigns a uniform block to a fixed binding point in every shader that declares it, so that a single
+	/// UniformBuffer bound to that point is shared by all of them. Our shaders target GLSL 4.10, which can't
+	/// declare the binding in the shader itself, so this must be called before the shaders are linked
+	/// </summary>
+	/// <param name="blockName">The name of the block, ex: b_Camera</param>
+	/// <param name="binding">The binding point to use, ex: the slot passed to UniformBuffer::Bind</param>
+	static void SetUniformBlockBinding(const std::string& blockName, GLuint binding);
+
+	// The uniform block that ShaderMaterial packs it's parameters into, ex:
+	//    layout(std140) uniform b_Material { float u_Shininess; };
+	// Shaders bind this block to MATERIAL_BLOCK_BINDING on their own, so it does not need to be registered
+	inline static const std::string MATERIAL_BLOCK_NAME = "b_Material";
+	static const GLuint MATERIAL_BLOCK_BINDING = 2;
+
+	/// <summary>
+	/// Gets the size of this shader's material block in bytes, or 0 if it does not declare one
+	/// </summary>
+	size_t GetMaterialBlockSize() const { return _materialBlockSize; }
+	/// <summary>
+	/// Finds a uniform in this shader's material block by name
+	/// </summary>
+	/// <returns>The layout of the uniform, or nullptr if the material block does not contain it</returns>
+	const UniformBlockMember* FindMaterialParam(const std::string& name) const;
+	/// <summary>
+	/// Gets the texture unit that a sampler reads from. Every sampler is given it's own unit when the shader is
+	/// linked, starting at 1, so binding a texture never requires setting a uniform
+	/// </summary>
+	/// <returns>The unit of the sampler, or -1 if there is no sampler with the given name</returns>
+	int GetTextureUnit(const std::string& name) const;
 	
 public:
+	/// <summary>
+	/// Gets the location of a uniform by name. Shaders find all of their active uniforms when they are linked, so this
+	/// does not need to query OpenGL. Uniforms that are not found are reported once, and return -1
+	/// </summary>
 	int GetUniformLocation(const std::string& name);
+	/// <summary>
+	/// Gets the location of a registered uniform, this is just an array lookup and should be preferred for uniforms
+	/// that are set every frame or every draw
+	/// </summary>
+	int GetUniformLocation(const UniformId& id) {
+		if (id.GetIndex() >= _locationsById.size()) {
+			_ResolveIds();
+		}
+		int& location = _locationsById[id.GetIndex()];
+		if (location == MISSING_UNIFORM) {
+			LOG_WARN("Ignoring uniform \"{}\"", id.GetName());
+			location = -1;
+		}
+		return location;
+	}
+	template <typename T>
+	void SetUniform(const UniformId& id, const T& value) {
+		int location = GetUniformLocation(id);
+		if (location != -1) {
+			SetUniform(location, &value, 1);
+		}
+	}
+	template <typename T>
+	void SetUniformMatrix(const UniformId& id, const T& value, bool transposed = false) {
+		int location = GetUniformLocation(id);
+		if (location != -1) {
+			SetUniformMatrix(location, &value, 1, transposed);
+		}
+	}
 	
 	template <typename T>
 	void SetUniform(const std::string& name, const T& value) {
@@ -121,7 +237,34 @@ protected:
 	GLuint _fs;
 	
 	GLuint _handle;
+	bool   _supportsInstancing;
 
 	std::unordered_map<std::string, int> _uniformLocs;
+	// The texture units assigned to our samplers, by name
+	std::unordered_map<std::string, int> _textureUnits;
+	// The layout of our material block, see MATERIAL_BLOCK_NAME
+	std::unordered_map<std::string, UniformBlockMember> _materialParams;
+	size_t _materialBlockSize;
+	// The locations of the registered uniforms, indexed by UniformId::GetIndex
+	std::vector<int> _locationsById;
+	// Marks a registered uniform that this shader doesn't have, which has not been reported yet
+	inline static const int MISSING_UNIFORM = -2;
+
+	/// <summary>
+	/// Finds the active uniforms after linking, fills in _uniformLocs and the layout of the material block, and
+	/// assigns texture units to the samplers
+	/// </summary>
+	void _ReflectUniforms();
+	/// <summary>
+	/// Looks up the locations of any uniforms that have been registered since the last call
+	/// </summary>
+	void _ResolveIds();
+	/// <summary>
+	/// Assigns the binding points from SetUniformBlockBinding to the blocks that this shader declares
+	/// </summary>
+	void _BindUniformBlocks();
+
+	static std::unordered_map<std::string, GLuint>& _BlockBindings();
+	static bool _IsSamplerType(GLenum type);
 	
 };
\ No newline at end of file
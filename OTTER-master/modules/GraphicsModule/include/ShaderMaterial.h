@@ -1,6 +1,8 @@
 #pragma once
+#include <array>
 #include <string>
 #include "Shader.h"
+#include "UniformBuffer.h"
 #include "ITexture.h"
 #include "Macros.h"
 #include <EnumToString.h>
@@ -30,15 +32,37 @@ namespace  std
 	};
 }
 
+/// <summary>
+/// A shader and the parameters to draw with it. Parameters that are declared in the shader's material block (see
+/// Shader::MATERIAL_BLOCK_NAME) are packed into a std140 buffer that is only uploaded when they change, and each
+/// material gets it's own slice of one uniform buffer that is shared by every material. Applying a material that
+/// hasn't changed costs a single glBindBufferRange, plus one bind per texture. Any other parameters are kept in
+/// the maps below and set as individual uniforms every time the material is applied
+/// </summary>
 class ShaderMaterial {
 	SMART_MEMORY_MANAGED(ShaderMaterial)
 public:
-	
+	// The most textures a material can have
+	inline static const int MAX_TEXTURES = 8;
+	// The largest material block a shader can declare, in bytes. Each material's slice of the shared buffer is
+	// this size, rounded up to the alignment required by glBindBufferRange
+	inline static const size_t MAX_BLOCK_SIZE = 256;
+
+	/// <summary>
+	/// A texture used by a material, and the texture unit that the shader reads it from
+	/// </summary>
+	struct TextureBinding
+	{
+		int            Unit;
+		ITexture::sptr Texture;
+
+		TextureBinding() : Unit(-1), Texture(nullptr) {}
+	};
+
 	ShaderMaterial();
 	virtual ~ShaderMaterial();
 
 	Shader::sptr Shader;
-	std::unordered_map<ShaderParamName, ITexture::sptr> Textures;
 	std::unordered_map<ShaderParamName, float> FloatParams;
 	std::unordered_map<ShaderParamName, glm::vec2> Vec2Params;
 	std::unordered_map<ShaderParamName, glm::vec3> Vec3Params;
@@ -51,6 +75,19 @@ public:
 
 	void Apply();
 
+	/// <summary>
+	/// Gets a unique ID for this material, which is smaller than the pointer and can be packed into sort keys
+	/// </summary>
+	uint32_t GetId() const { return _id; }
+	/// <summary>
+	/// Gets the number of textures set on this material
+	/// </summary>
+	int GetTextureCount() const { return _textureCount; }
+	/// <summary>
+	/// Gets one of the textures set on this material, textures are sorted by their unit
+	/// </summary>
+	const TextureBinding& GetTexture(int index) const { return _textures[index]; }
+
 	void Set(const std::string& name, const ITexture::sptr& texture);
 	void Set(const std::string& name, float value);
 	void Set(const std::string& name, const glm::vec2& value);
@@ -60,4 +97,44 @@ public:
 	void Set(const std::string& name, const glm::mat3& value);
 
 protected:
+	uint32_t _id;
+
+	// Our textures sorted by unit, only the first _textureCount are used
+	std::array<TextureBinding, MAX_TEXTURES> _textures;
+	int                                      _textureCount;
+
+	// The CPU copy of our material block, laid out as the shader's block
+	std::vector<uint8_t> _blockData;
+	// True when _blockData has changed since it was last uploaded
+	bool                 _blockDirty;
+	// Our slice of the shared block buffer, or -1 if we don't have one yet
+	int                  _blockSlot;
+
+	inline static uint32_t _nextId = 1;
+
+	// The buffer that holds the blocks of every material, split into fixed size slots
+	inline static UniformBuffer::sptr _blockBuffer = nullptr;
+	inline static size_t              _blockSlotSize = 0;
+	inline static size_t              _blockSlotCapacity = 0;
+	inline static size_t              _blockSlotsUsed = 0;
+	inline static std::vector<int>    _freeBlockSlots;
+
+	/// <summary>
+	/// Writes a value into our material block if the shader's block has a parameter with the given name
+	/// </summary>
+	/// <param name="name">The name of the parameter</param>
+	/// <param name="type">The GL type of the value, which must match the parameter</param>
+	/// <param name="data">The values, one column at a time for matrices</param>
+	/// <param name="columns">The number of columns, 1 for anything other than a matrix</param>
+	/// <param name="columnSize">The size in bytes of a single column</param>
+	/// <returns>True if the parameter is in the material block, false if it should be set as a uniform instead</returns>
+	bool _SetBlockParam(const std::string& name, GLenum type, const void* data, int columns, size_t columnSize);
+
+	/// <summary>
+	/// Sizes our material block to match the shader's, and gives us a slice of the shared buffer
+	/// </summary>
+	void _InitBlock();
+
+	static int _AllocateBlockSlot();
+	static void _FreeBlockSlot(int slot);
 };
@@ -1,12 +1,15 @@
 #pragma once
 #include <memory>
 #include <cstdint>
+#include <string>
 #include <GLM/glm.hpp>
 
 
+#include "AssetMemory.h"
 #include "ITexture.h"
 #include "TextureEnums.h"
 #include "Texture2DData.h"
+#include "CompressedTextureData.h"
 
 struct Texture2DDescription
 {
@@ -51,6 +54,12 @@ public:
 	}
 
 public:
+	/// <summary>
+	/// The residency policy that new textures start with. Once a texture is on the GPU we rarely need the pixels
+	/// again, so by default they are freed after upload
+	/// </summary>
+	inline static ResidencyPolicy DefaultResidency = ResidencyPolicy::DropAfterUpload;
+
 	/// <summary>
 	/// Creates a new texture with the given description
 	/// </summary>
@@ -64,6 +73,12 @@ public:
 	/// </summary>
 	/// <param name="data">The texture data to upload into this texture</param>
 	void LoadData(const Texture2DData::sptr& data);
+	/// <summary>
+	/// Uploads block compressed data to this texture, including all of its mip levels. This will replace the
+	/// format in the description with the format of the data
+	/// </summary>
+	/// <param name="data">The compressed texture data to upload into this texture</param>
+	void LoadData(const CompressedTextureData::sptr& data);
 
 	/// <summary>
 	/// Loads an image directly from a file
@@ -71,6 +86,13 @@ public:
 	/// <param name="path">The path to load the image from</param>
 	/// <returns>A pointer to the loaded image</returns>
 	static Texture2D::sptr LoadFromFile(const std::string& path);
+	/// <summary>
+	/// Loads an image from a file and compresses it, see CompressedTextureData::LoadFromFile
+	/// </summary>
+	/// <param name="path">The path to load the image from</param>
+	/// <param name="format">The block compressed format to store the image in</param>
+	/// <returns>A pointer to the loaded image</returns>
+	static Texture2D::sptr LoadCompressedFromFile(const std::string& path, InternalFormat format = InternalFormat::BC1);
 	
 	uint32_t GetWidth() const { return _description.Width; }
 	uint32_t GetHeight() const { return _description.Height; }
@@ -87,9 +109,49 @@ public:
 	void SetAnisotropicFiltering(float level = -1.0f);
 
 	const Texture2DDescription& GetDescription() const { return _description; }
+
+	/// <summary>
+	/// Sets what this texture keeps in CPU memory after data is uploaded. Switching away from Keep frees any data
+	/// that is currently being held
+	/// </summary>
+	void SetResidency(ResidencyPolicy policy);
+	ResidencyPolicy GetResidency() const { return _residency; }
+
+	/// <summary>
+	/// Sets the file that this texture's data came from, so that it can be restreamed once the CPU copy has been
+	/// dropped. The loading functions set this for you
+	/// </summary>
+	void SetSourcePath(const std::string& path) { _sourcePath = path; }
+	const std::string& GetSourcePath() const { return _sourcePath; }
+
+	/// <summary>
+	/// Gets the CPU copy of the texture data, this will be nullptr unless the residency policy is Keep
+	/// </summary>
+	const Texture2DData::sptr& GetCpuData() const { return _cpuData; }
+	/// <summary>
+	/// Gets the CPU copy of the texture data, loading it again from the source path if it was dropped. Restreamed
+	/// data is only held on to if the residency policy is Keep, otherwise the caller owns the only reference
+	/// </summary>
+	/// <returns>The texture data, or nullptr if it is not available and can not be restreamed</returns>
+	Texture2DData::sptr RestreamData();
+
+	/// <summary>
+	/// Gets the number of bytes of CPU memory held by this texture
+	/// </summary>
+	size_t GetCpuSize() const;
+	/// <summary>
+	/// Gets the approximate number of bytes of GPU memory used by this texture, including it's mip levels
+	/// </summary>
+	size_t GetGpuSize() const;
 	
 private:
 	Texture2DDescription _description;
+	ResidencyPolicy      _residency;
+	std::string          _sourcePath;
+	// The data that was last uploaded, only held when the residency policy is Keep
+	Texture2DData::sptr  _cpuData;
+	// The number of mip levels to allocate storage for, only compressed data provides its own mip chain
+	uint32_t _levelCount;
 
 	void _RecreateTexture();
 };
@@ -1,9 +1,49 @@
 #pragma once
+#include <atomic>
 #include <memory>
 #include <cstdint>
 
 #include "TextureEnums.h"
 
+/// <summary>
+/// Counts the pixel buffers that the texture data classes have allocated and copied into, so that we can
+/// keep track of how many redundant copies are being made while loading images
+/// </summary>
+class TextureDataAllocations
+{
+public:
+	/// <summary>
+	/// Gets the number of buffers that have been allocated since the last reset
+	/// </summary>
+	static size_t GetCount() { return _count; }
+	/// <summary>
+	/// Gets the total size of all buffers that have been allocated since the last reset, in bytes
+	/// </summary>
+	static size_t GetBytes() { return _bytes; }
+
+	static void Reset() {
+		_count = 0;
+		_bytes = 0;
+	}
+
+protected:
+	friend class Texture2DData;
+	friend class TextureCubeMapData;
+
+	static void _Record(size_t bytes) {
+		_count++;
+		_bytes += bytes;
+	}
+
+	inline static std::atomic<size_t> _count{ 0 };
+	inline static std::atomic<size_t> _bytes{ 0 };
+};
+
+/// <summary>
+/// A function that frees a pixel buffer, used when texture data takes ownership of an existing buffer
+/// </summary>
+typedef void(*TextureDataDeleter)(void*);
+
 /// <summary>
 /// Stores data required to upload texture data into OpenGL
 /// </summary>
@@ -28,6 +68,17 @@ public:
 	/// <param name="sourceData">A pointer to the data to upload to this texture</param>
 	/// <param name="recommendedFormat">The recommended internal format to use when creating textures from this data</param>
 	Texture2DData(uint32_t width, uint32_t height, PixelFormat format, PixelType type, void* sourceData, InternalFormat recommendedFormat = InternalFormat::Unknown);
+	/// <summary>
+	/// Creates a new 2D texture data object that takes ownership of an existing buffer, rather than copying it
+	/// </summary>
+	/// <param name="width">The width of the texture, in pixels</param>
+	/// <param name="height">The height of the texture, in pixels</param>
+	/// <param name="format">The pixel format or layout of a pixel (ex: RGBA)</param>
+	/// <param name="type">The component type of the pixel (ex: uint8_t)</param>
+	/// <param name="data">The buffer to adopt, must be at least width * height * texel size bytes</param>
+	/// <param name="deleter">The function to call to free the buffer when this object is destroyed (ex: stbi_image_free)</param>
+	/// <param name="recommendedFormat">The recommended internal format to use when creating textures from this data</param>
+	Texture2DData(uint32_t width, uint32_t height, PixelFormat format, PixelType type, void* data, TextureDataDeleter deleter, InternalFormat recommendedFormat = InternalFormat::Unknown);
 	~Texture2DData();
 
 	/// <summary>
@@ -75,4 +126,5 @@ private:
 	PixelType   _type;
 	InternalFormat _recommendedFormat;
 	void* _data;
+	TextureDataDeleter _deleter;
 };
\ No newline at end of file
@@ -65,6 +65,8 @@ public:
 	/// image_pos_y.png --> CubeMapFace::PosY
 	/// image_neg_z.png --> CubeMapFace::NegZ
 	/// image_pos_z.png --> CubeMapFace::PosZ
+	/// The faces are decoded in parallel, straight into the cubemap's storage. Faces with a different number of channels
+	/// than the first image are converted to match it, and missing faces are left black
 	/// </summary>
 	/// <param name="rootImagePath">The base path for images, including extension. This file name will be appended with _pos_x, _neg_x, etc...</param>
 	/// <returns>A pointer to the data created from the images</returns>
@@ -5,6 +5,15 @@
 #include "Logging.h"
 #include "glad/glad.h"
 
+// The S3TC formats are an extension (EXT_texture_compression_s3tc) that glad does not generate for us, but
+// every desktop GPU supports them
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT  0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
 // https://www.khronos.org/registry/OpenGL-Refpages/gl4/html/glTexImage2D.xhtml
 // These are some of our more common available internal formats
 ENUM(InternalFormat, GLint,
@@ -18,7 +27,13 @@ ENUM(InternalFormat, GLint,
 	RGB10        = GL_RGB10,
 	RGB16        = GL_RGB16,
 	RGBA8        = GL_RGBA8,
-	RGBA16       = GL_RGBA16
+	RGBA16       = GL_RGBA16,
+
+	// Block compressed formats, these store 4x4 blocks of texels and can only be uploaded via glCompressedTextureSubImage2D
+	BC1          = GL_COMPRESSED_RGB_S3TC_DXT1_EXT,  // RGB, 8 bytes per block
+	BC3          = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, // RGBA, 16 bytes per block
+	BC5          = GL_COMPRESSED_RG_RGTC2,           // RG, 16 bytes per block (ex: normal maps)
+	BC7          = GL_COMPRESSED_RGBA_BPTC_UNORM     // RGBA, 16 bytes per block, higher quality than BC3
 
 	// Note: There are sized internal formats but there is a LOT of them
 );
@@ -126,4 +141,64 @@ constexpr GLint GetTexelComponentCount(PixelFormat format)
  */
 constexpr size_t GetTexelSize(PixelFormat format, PixelType type) {
 	return GetTexelComponentSize(type) * GetTexelComponentCount(format);
-}
\ No newline at end of file
+}
+
+/*
+ * Checks whether an internal format is one of our block compressed formats
+ */
+constexpr bool IsCompressedFormat(InternalFormat format) {
+	switch (format) {
+	case InternalFormat::BC1:
+	case InternalFormat::BC3:
+	case InternalFormat::BC5:
+	case InternalFormat::BC7:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/*
+ * Gets the number of bytes used to store a single 4x4 block of a compressed format
+ * @param format The block compressed format
+ * @returns The size of a block in bytes, or 0 if the format is not compressed
+ */
+constexpr size_t GetCompressedBlockSize(InternalFormat format) {
+	switch (format) {
+	case InternalFormat::BC1:
+		return 8;
+	case InternalFormat::BC3:
+	case InternalFormat::BC5:
+	case InternalFormat::BC7:
+		return 16;
+	default:
+		return 0;
+	}
+}
+
+/*
+ * Gets the number of bytes the GPU uses to store a single texel of an uncompressed internal format. Drivers
+ * usually pad 3 component formats out to 4 components, so we report them that way
+ * @param format The uncompressed internal format
+ * @returns The size of a texel in bytes, or 0 for compressed and unknown formats
+ */
+constexpr size_t GetInternalTexelSize(InternalFormat format) {
+	switch (format) {
+	case InternalFormat::R8:
+		return 1;
+	case InternalFormat::R16:
+	case InternalFormat::RG8:
+		return 2;
+	case InternalFormat::Depth:
+	case InternalFormat::DepthStencil:
+	case InternalFormat::RGB8:
+	case InternalFormat::RGB10:
+	case InternalFormat::RGBA8:
+		return 4;
+	case InternalFormat::RGB16:
+	case InternalFormat::RGBA16:
+		return 8;
+	default:
+		return 0;
+	}
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include "IBuffer.h"
+#include <memory>
+
+/// <summary>
+/// A uniform buffer holds the data for a uniform block, so that it can be shared between every shader that declares
+/// the block instead of being set on each shader. The layout of the data must match the block, which is easiest
+/// when the block is declared with layout(std140), ex:
+///    layout(std140) uniform b_Camera { mat4 u_View; ... };
+/// Blocks are matched up with buffers by binding point, see Shader::SetUniformBlockBinding
+/// </summary>
+class UniformBuffer : public IBuffer
+{
+public:
+	typedef std::shared_ptr<UniformBuffer> sptr;
+	static inline sptr Create(GLenum usage = GL_DYNAMIC_DRAW) {
+		return std::make_shared<UniformBuffer>(usage);
+	}
+
+public:
+	/// <summary>
+	/// Creates a new uniform buffer, with the given usage. Data will still need to be uploaded before it can be used
+	/// </summary>
+	/// <param name="usage">The usage hint for the buffer, default is GL_DYNAMIC_DRAW</param>
+	UniformBuffer(GLenum usage = GL_DYNAMIC_DRAW) : IBuffer(GL_UNIFORM_BUFFER, usage) { }
+
+	/// <summary>
+	/// Updates part of the buffer without re-allocating it, the buffer must already be large enough
+	/// </summary>
+	/// <param name="data">The data to copy into the buffer</param>
+	/// <param name="offset">The offset into the buffer to start writing at, in bytes</param>
+	/// <param name="size">The number of bytes to write</param>
+	void UpdateData(const void* data, size_t offset, size_t size);
+	/// <summary>
+	/// Replaces the contents of the buffer with a single struct, allocating the buffer the first time it's called
+	/// </summary>
+	/// <typeparam name="T">The type of struct to upload, should match the std140 layout of the block</typeparam>
+	/// <param name="data">The data to upload</param>
+	template <typename T>
+	void Update(const T& data) {
+		if (GetTotalSize() != sizeof(T)) {
+			IBuffer::LoadData(&data, sizeof(T), 1);
+		} else {
+			UpdateData(&data, 0, sizeof(T));
+		}
+	}
+
+	using IBuffer::Bind;
+	/// <summary>
+	/// Binds the whole buffer to an indexed uniform buffer binding point
+	/// </summary>
+	/// <param name="slot">The binding point to bind to</param>
+	void Bind(GLuint slot);
+	/// <summary>
+	/// Binds part of the buffer to an indexed uniform buffer binding point. The offset must be a multiple of
+	/// GetOffsetAlignment
+	/// </summary>
+	/// <param name="slot">The binding point to bind to</param>
+	/// <param name="offset">The offset into the buffer, in bytes</param>
+	/// <param name="size">The number of bytes to bind</param>
+	void BindRange(GLuint slot, size_t offset, size_t size);
+
+	/// <summary>
+	/// Unbinds the buffer bound to the given uniform buffer binding point
+	/// </summary>
+	static void UnBind(GLuint slot);
+	/// <summary>
+	/// Gets the alignment that offsets passed to BindRange must respect (GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT)
+	/// </summary>
+	static size_t GetOffsetAlignment();
+};
@@ -6,6 +6,10 @@
 
 #include "VertexBuffer.h"
 #include "IndexBuffer.h"
+#include "Bounds.h"
+#include "InstanceBuffer.h"
+
+class GeometryAllocation;
 
 /// <summary>
 /// We'll use this just to make it more clear what the intended usage of an attribute is in our code!
@@ -114,6 +118,17 @@ public:
 	/// <param name="attributes">A list of vertex attributes that will be fed by this buffer</param>
 	void AddVertexBuffer(const VertexBuffer::sptr& buffer, const std::vector<BufferAttribute>& attributes);
 
+	/// <summary>
+	/// Makes this VAO a view into a block of a GeometryArena, instead of owning it's own buffers. Rendering will
+	/// draw the allocation with the arena's shared VAO
+	/// </summary>
+	/// <param name="allocation">The allocation to draw, or nullptr to clear it</param>
+	void SetAllocation(const std::shared_ptr<GeometryAllocation>& allocation);
+	/// <summary>
+	/// Gets the arena allocation this VAO draws, or nullptr if it owns it's own buffers
+	/// </summary>
+	const std::shared_ptr<GeometryAllocation>& GetAllocation() const { return _allocation; }
+
 	/// <summary>
 	/// Binds this VAO as the source of data for draw operations
 	/// </summary>
@@ -122,13 +137,61 @@ public:
 	/// Unbinds the currently bound VAO
 	/// </summary>
 	static void UnBind();
+	/// <summary>
+	/// Binds a VAO by handle, skipping the bind if it is already bound. Meshes in a GeometryArena use this so that
+	/// drawing many of them in a row only binds the arena once. Code that binds VAOs without going through this
+	/// class should call UnBind afterwards, so that the next call here does not skip a bind it needs
+	/// </summary>
+	/// <param name="handle">The handle of the VAO to bind</param>
+	static void BindHandle(GLuint handle);
+	/// <summary>
+	/// Tells BindHandle that a VAO is being deleted, so a new VAO that reuses the handle will still get bound
+	/// </summary>
+	static void ForgetHandle(GLuint handle);
 
 	/// <summary>
 	/// Returns the underlying OpenGL handle that this class is wrapping around
 	/// </summary>
 	GLuint GetHandle() const { return _handle; }
 
+	/// <summary>
+	/// Returns the total size in bytes of all the vertex and index buffers bound to this VAO, or of it's arena allocation
+	/// </summary>
+	size_t GetTotalBufferSize() const;
+
+	/// <summary>
+	/// Sets the object space bounds of the mesh, this is done by MeshBuilder and MeshCache when the mesh is baked
+	/// </summary>
+	void SetBounds(const MeshBounds& bounds) { _bounds = bounds; }
+	/// <summary>
+	/// Gets the object space bounds of the mesh, which will be invalid if the mesh has not been baked yet
+	/// </summary>
+	const MeshBounds& GetBounds() const { return _bounds; }
+
 	void Render() const;
+	/// <summary>
+	/// Draws a range of the index buffer, ex: a single level of a LodMesh
+	/// </summary>
+	/// <param name="firstIndex">The first index to draw</param>
+	/// <param name="indexCount">The number of indices to draw</param>
+	void Render(uint32_t firstIndex, uint32_t indexCount) const;
+	/// <summary>
+	/// Draws several copies of the mesh in a single draw call, with each copy reading it's transform from the
+	/// instance buffer. The shader must read it's transforms from the instance attributes, see InstanceBuffer
+	/// </summary>
+	/// <param name="instances">The buffer holding the instance data, which must already be uploaded</param>
+	/// <param name="baseInstance">The index of the first instance in the buffer to draw</param>
+	/// <param name="instanceCount">The number of instances to draw</param>
+	void RenderInstanced(const InstanceBuffer& instances, uint32_t baseInstance, uint32_t instanceCount) const;
+	/// <summary>
+	/// Draws several copies of a range of the index buffer in a single draw call, ex: a single level of a LodMesh
+	/// </summary>
+	/// <param name="firstIndex">The first index to draw</param>
+	/// <param name="indexCount">The number of indices to draw</param>
+	/// <param name="instances">The buffer holding the instance data, which must already be uploaded</param>
+	/// <param name="baseInstance">The index of the first instance in the buffer to draw</param>
+	/// <param name="instanceCount">The number of instances to draw</param>
+	void RenderInstanced(uint32_t firstIndex, uint32_t indexCount, const InstanceBuffer& instances, uint32_t baseInstance, uint32_t instanceCount) const;
 	
 protected:
 	// Helper structure to store a buffer and the attributes
@@ -143,8 +206,17 @@ protected:
 	// The vertex buffers bound to this VAO
 	std::vector<VertexBufferBinding> _vertexBuffers;
 
+	// The arena block we draw instead of our own buffers, if any
+	std::shared_ptr<GeometryAllocation> _allocation;
+
+	// The object space bounds of our vertices, used for culling
+	MeshBounds _bounds;
+
 	GLsizei _vertexCount;
 	
 	// The underlying OpenGL handle that this class is wrapping around
 	GLuint _handle;
+
+	// The VAO we last bound, so that BindHandle can skip redundant binds
+	inline static GLuint _boundHandle = 0;
 };
@@ -0,0 +1,182 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+/// <summary>
+/// The default hash for VertexDedupTable, mixes every 32 bit word of a trivially copyable key
+/// (ex: a glm::ivec3 of attribute indices)
+/// </summary>
+struct VertexKeyHash
+{
+	template <typename KeyType>
+	uint64_t operator()(const KeyType& key) const {
+		static_assert(std::is_trivially_copyable<KeyType>::value && sizeof(KeyType) % sizeof(uint32_t) == 0,
+			"Keys must be trivially copyable and made of 32 bit words");
+		uint32_t words[sizeof(KeyType) / sizeof(uint32_t)];
+		memcpy(words, &key, sizeof(KeyType));
+
+		// Each word gets its own multiplier, so the products are independent and can be computed in parallel.
+		// This matters more than hash quality here, since the CPU can start on the next lookup while this one misses
+		static const uint64_t MULTIPLIERS[4] = { 0x9E3779B97F4A7C15ull, 0xC2B2AE3D27D4EB4Full, 0x165667B19E3779F9ull, 0xFF51AFD7ED558CCDull };
+		uint64_t result = 0;
+		for (size_t ix = 0; ix < sizeof(KeyType) / sizeof(uint32_t); ix++) {
+			if (ix > 0 && (ix & 3) == 0) {
+				result = (result << 21) | (result >> 43);
+			}
+			result ^= static_cast<uint64_t>(words[ix]) * MULTIPLIERS[ix & 3];
+		}
+		// Fold the high bits down, since we only use the low bits to pick a slot
+		result ^= result >> 32;
+		return result;
+	}
+};
+
+/// <summary>
+/// A flat, open addressing hash table that maps a combination of vertex attributes to the index of the vertex
+/// that was created for them. All the slots live in a single array and collisions are resolved by linear
+/// probing, which is much friendlier to the cache than a node based std::unordered_map when importing large meshes
+/// </summary>
+/// <typeparam name="KeyType">The key identifying a unique vertex, must be comparable with ==</typeparam>
+/// <typeparam name="Hasher">The hash function to use for keys</typeparam>
+template <typename KeyType, typename Hasher = VertexKeyHash>
+class VertexDedupTable
+{
+public:
+	/// <summary>
+	/// Creates a new table with enough room for the given number of unique vertices before it needs to grow
+	/// </summary>
+	/// <param name="expectedCount">The number of vertices we expect to add, the face vertex count makes a good upper bound</param>
+	VertexDedupTable(size_t expectedCount = 0) :
+		_slots(std::vector<Slot>()),
+		_mask(0),
+		_size(0)
+	{
+		Reserve(expectedCount);
+	}
+	~VertexDedupTable() = default;
+
+	/// <summary>
+	/// Makes sure the table can hold the given number of entries without growing
+	/// </summary>
+	/// <param name="count">The number of entries to make room for</param>
+	void Reserve(size_t count) {
+		// Keep the load factor under MAX_LOAD_NUMERATOR / MAX_LOAD_DENOMINATOR
+		size_t capacity = MIN_CAPACITY;
+		while (capacity * MAX_LOAD_NUMERATOR < count * MAX_LOAD_DENOMINATOR) {
+			capacity <<= 1;
+		}
+		if (capacity > _slots.size()) {
+			_Rehash(capacity);
+		}
+	}
+
+	/// <summary>
+	/// Finds the vertex index stored for the key, or stores the given index if the key has not been seen before
+	/// </summary>
+	/// <param name="key">The key to look up</param>
+	/// <param name="index">The vertex index to store if the key is not in the table, must not be EMPTY</param>
+	/// <param name="inserted">Set to true if the key was added to the table, or false if it already existed</param>
+	/// <returns>The vertex index associated with the key</returns>
+	uint32_t FindOrInsert(const KeyType& key, uint32_t index, bool& inserted) {
+		if ((_size + 1) * MAX_LOAD_DENOMINATOR > _slots.size() * MAX_LOAD_NUMERATOR) {
+			_Rehash(_slots.empty() ? MIN_CAPACITY : _slots.size() * 2);
+		}
+
+		size_t slotIx = static_cast<size_t>(_hasher(key)) & _mask;
+		while (true) {
+			Slot& slot = _slots[slotIx];
+			if (slot.Index == EMPTY) {
+				slot.Key = key;
+				slot.Index = index;
+				_size++;
+				inserted = true;
+				return index;
+			}
+			if (slot.Key == key) {
+				inserted = false;
+				return slot.Index;
+			}
+			slotIx = (slotIx + 1) & _mask;
+		}
+	}
+
+	/// <summary>
+	/// Finds the vertex index stored for a key
+	/// </summary>
+	/// <param name="key">The key to look up</param>
+	/// <returns>The vertex index associated with the key, or EMPTY if the key is not in the table</returns>
+	uint32_t Find(const KeyType& key) const {
+		if (_slots.empty()) {
+			return EMPTY;
+		}
+		size_t slotIx = static_cast<size_t>(_hasher(key)) & _mask;
+		while (true) {
+			const Slot& slot = _slots[slotIx];
+			if (slot.Index == EMPTY || slot.Key == key) {
+				return slot.Index;
+			}
+			slotIx = (slotIx + 1) & _mask;
+		}
+	}
+
+	/// <summary>
+	/// Removes all entries from the table, keeping the allocated slots
+	/// </summary>
+	void Clear() {
+		for (Slot& slot : _slots) {
+			slot.Index = EMPTY;
+		}
+		_size = 0;
+	}
+
+	/// <summary>
+	/// Gets the number of entries in the table
+	/// </summary>
+	size_t GetSize() const { return _size; }
+	/// <summary>
+	/// Gets the number of slots allocated for the table
+	/// </summary>
+	size_t GetCapacity() const { return _slots.size(); }
+
+	/// <summary>
+	/// The index value that marks an empty slot, vertex indices must never be this value
+	/// </summary>
+	inline static const uint32_t EMPTY = UINT32_MAX;
+
+protected:
+	struct Slot {
+		KeyType  Key;
+		uint32_t Index;
+	};
+
+	inline static const size_t MIN_CAPACITY = 16;
+	inline static const size_t MAX_LOAD_NUMERATOR = 7;
+	inline static const size_t MAX_LOAD_DENOMINATOR = 10;
+
+	std::vector<Slot> _slots;
+	size_t            _mask;
+	size_t            _size;
+	Hasher            _hasher;
+
+	void _Rehash(size_t capacity) {
+		std::vector<Slot> old;
+		old.swap(_slots);
+		_slots.resize(capacity);
+		for (Slot& slot : _slots) {
+			slot.Index = EMPTY;
+		}
+		_mask = capacity - 1;
+
+		for (const Slot& slot : old) {
+			if (slot.Index != EMPTY) {
+				size_t slotIx = static_cast<size_t>(_hasher(slot.Key)) & _mask;
+				while (_slots[slotIx].Index != EMPTY) {
+					slotIx = (slotIx + 1) & _mask;
+				}
+				_slots[slotIx] = slot;
+			}
+		}
+	}
+};
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <cstdint>
 #include <GLM/glm.hpp>
 #include <VertexArrayObject.h>
+#include <EnumToString.h>
 
 struct VertexPosCol {
 	glm::vec3 Position;
@@ -57,4 +59,61 @@ struct VertexPosNormTexCol {
 		Position({ x, y, z }), Normal({ nX, nY, nZ }), UV({ u, v }), Color({r, g, b, a}) {}
 
 	static const std::vector<BufferAttribute> V_DECL;
-};
\ No newline at end of file
+};
+
+/// <summary>
+/// A compact version of VertexPosNormTexCol, at 24 bytes instead of 48. The shader sees the same inputs, since
+/// OpenGL expands the normalized integers and half floats back to floats for us. The largest error in each attribute,
+/// give or take float rounding, is:
+///   Normal - 1/1022 per component (signed normalized 10_10_10_2)
+///   UV     - 1/4096 in the 0-1 range, or about 1/2048 of the value for larger UVs (half floats)
+///   Color  - 1/510 per component, and clamped to 0-1 (unsigned normalized bytes)
+/// </summary>
+struct VertexPosNormTexColPacked {
+	glm::vec3 Position;
+	uint32_t  Normal;
+	uint32_t  UV;
+	uint32_t  Color;
+
+	VertexPosNormTexColPacked() : Position(glm::vec3(0.0f)), Normal(0), UV(0), Color(0xFF000000) {}
+	VertexPosNormTexColPacked(const glm::vec3& pos, const glm::vec3& norm, const glm::vec2& uv, const glm::vec4& col);
+	explicit VertexPosNormTexColPacked(const VertexPosNormTexCol& vertex) :
+		VertexPosNormTexColPacked(vertex.Position, vertex.Normal, vertex.UV, vertex.Color) {}
+
+	/// <summary>
+	/// Expands this vertex back into full floats, the same way OpenGL will
+	/// </summary>
+	VertexPosNormTexCol Unpack() const;
+
+	static const std::vector<BufferAttribute> V_DECL;
+};
+
+/// <summary>
+/// A compact version of VertexPosNormTexCol with the color dropped, at 20 bytes instead of 48. Only use this with shaders
+/// that do not read the color input, since OpenGL will feed them (0, 0, 0, 1). Errors are the same as VertexPosNormTexColPacked
+/// </summary>
+struct VertexPosNormTexPacked {
+	glm::vec3 Position;
+	uint32_t  Normal;
+	uint32_t  UV;
+
+	VertexPosNormTexPacked() : Position(glm::vec3(0.0f)), Normal(0), UV(0) {}
+	VertexPosNormTexPacked(const glm::vec3& pos, const glm::vec3& norm, const glm::vec2& uv);
+	explicit VertexPosNormTexPacked(const VertexPosNormTexCol& vertex) :
+		VertexPosNormTexPacked(vertex.Position, vertex.Normal, vertex.UV) {}
+
+	/// <summary>
+	/// Expands this vertex back into full floats, the same way OpenGL will. The color will be white
+	/// </summary>
+	VertexPosNormTexCol Unpack() const;
+
+	static const std::vector<BufferAttribute> V_DECL;
+};
+
+/// <summary>
+/// Selects which vertex type the mesh loaders will emit
+/// </summary>
+ENUM(VertexFormat, int,
+	Full   = 0, // VertexPosNormTexCol
+	Packed = 1  // VertexPosNormTexColPacked
+);
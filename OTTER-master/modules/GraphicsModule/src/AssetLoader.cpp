@@ -0,0 +1,337 @@
+#include "AssetLoader.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cstdint>
+#include <stb_image.h>
+
+#include "AssetMemory.h"
+#include "HashUtils.h"
+#include "Logging.h"
+#include "MeshCache.h"
+#include "MeshRegistry.h"
+#include "ObjLoader.h"
+
+void AssetLoader::Init(size_t threadCount) {
+	if (_running) {
+		return;
+	}
+	if (threadCount == 0) {
+		// Leave a core free for the main thread, since it will be rendering while we load
+		threadCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+	}
+
+	_running = true;
+	_workers.reserve(threadCount);
+	for (size_t ix = 0; ix < threadCount; ix++) {
+		_workers.emplace_back(&AssetLoader::_WorkerMain);
+	}
+}
+
+void AssetLoader::Shutdown() {
+	{
+		std::lock_guard<std::mutex> lock(_lock);
+		_running = false;
+	}
+	_jobAdded.notify_all();
+	for (std::thread& worker : _workers) {
+		worker.join();
+	}
+	_workers.clear();
+	_jobs.clear();
+	_finished.clear();
+	_pending = 0;
+}
+
+std::shared_future<void> AssetLoader::Submit(const std::function<Upload()>& job) {
+	if (!_running) {
+		Init();
+	}
+
+	Job entry;
+	entry.Work = job;
+	entry.Done = std::make_shared<std::promise<void>>();
+	std::shared_future<void> result = entry.Done->get_future().share();
+	{
+		std::lock_guard<std::mutex> lock(_lock);
+		_jobs.push_back(std::move(entry));
+		_pending++;
+	}
+	_jobAdded.notify_one();
+	return result;
+}
+
+Texture2D::sptr AssetLoader::LoadTexture(const std::string& path, const Texture2DDescription& description) {
+	// The placeholder keeps its format once the image arrives, so we need a concrete one for it to have any storage.
+	// We read just the image header here to pick the same format Texture2DData::LoadFromFile would recommend, if
+	// the header can't be read we fall back to RGBA8
+	Texture2DDescription placeholderDesc = description;
+	placeholderDesc.Width = 1;
+	placeholderDesc.Height = 1;
+	if (placeholderDesc.Format == InternalFormat::Unknown) {
+		placeholderDesc.Format = _GuessTextureFormat(path);
+	}
+	Texture2D::sptr result = Texture2D::Create(placeholderDesc);
+	result->SetSourcePath(path);
+	result->Clear();
+	AssetMemory::Track(path, result);
+
+	// Only hold weak references in the jobs, so the texture is never released from a worker thread
+	std::weak_ptr<Texture2D> target = result;
+	Submit([path, target]() {
+		Texture2DData::sptr data = Texture2DData::LoadFromFile(path);
+		if (data == nullptr) {
+			return Upload();
+		}
+		return Upload([data, target]() {
+			Texture2D::sptr texture = target.lock();
+			if (texture != nullptr) {
+				texture->LoadData(data);
+			}
+		}, data->GetDataSize());
+	});
+
+	return result;
+}
+
+/// <summary>
+/// Creates the upload that fills a placeholder VAO with the contents of a mesh builder
+/// </summary>
+template <typename VertType>
+AssetLoader::Upload MakeMeshUpload(const std::shared_ptr<MeshBuilder<VertType>>& mesh, const std::weak_ptr<VertexArrayObject>& target) {
+	size_t bytes = mesh->GetVertexCount() * sizeof(VertType) + mesh->GetIndexCount() * sizeof(uint32_t);
+	return AssetLoader::Upload([mesh, target]() {
+		VertexArrayObject::sptr vao = target.lock();
+		if (vao != nullptr) {
+			mesh->BakeInto(vao);
+		}
+	}, bytes);
+}
+
+/// <summary>
+/// Creates the upload that fills a placeholder LOD mesh with the contents of a mesh builder and it's levels
+/// </summary>
+template <typename VertType>
+AssetLoader::Upload MakeLodUpload(const std::shared_ptr<MeshBuilder<VertType>>& mesh, const LodMesh::Description& description, const std::weak_ptr<LodMesh>& target) {
+	size_t bytes = mesh->GetVertexCount() * sizeof(VertType) + mesh->GetIndexCount() * sizeof(uint32_t);
+	return AssetLoader::Upload([mesh, description, target]() {
+		LodMesh::sptr lods = target.lock();
+		if (lods != nullptr) {
+			mesh->BakeInto(lods->GetVao());
+			lods->SetDescription(description);
+		}
+	}, bytes);
+}
+
+/// <summary>
+/// Mixes the optimizer passes into a cache key, field by field so that padding in the settings does not affect it
+/// </summary>
+uint64_t HashOptimizeSettings(const MeshOptimizer::Settings& settings, uint64_t seed) {
+	uint64_t result = HashFnv1a(&settings.Weld, sizeof(bool), seed);
+	result = HashFnv1a(&settings.WeldEpsilon, sizeof(float), result);
+	result = HashFnv1a(&settings.VertexCache, sizeof(bool), result);
+	result = HashFnv1a(&settings.Overdraw, sizeof(bool), result);
+	result = HashFnv1a(&settings.OverdrawThreshold, sizeof(float), result);
+	return HashFnv1a(&settings.VertexFetch, sizeof(bool), result);
+}
+
+/// <summary>
+/// Loads an OBJ file into a mesh builder of the given vertex type on a worker thread, going through the MeshCache the
+/// same way ObjLoader::LoadFromFile does. Optimized meshes are stored under their own key, so they do not collide
+/// with the unoptimized entries that ObjLoader writes
+/// </summary>
+template <typename VertType>
+AssetLoader::Upload LoadObjUpload(const std::string& filename, const glm::vec4& inColor, VertexFormat format, const std::weak_ptr<VertexArrayObject>& target) {
+	std::shared_ptr<MeshBuilder<VertType>> result = std::make_shared<MeshBuilder<VertType>>();
+
+	uint64_t cacheKey = 0;
+	if (MeshCache::Enabled) {
+		cacheKey = ObjLoader::GetCacheKey(filename, inColor, format);
+		if (AssetLoader::OptimizeMeshes) {
+			cacheKey = HashOptimizeSettings(AssetLoader::OptimizeSettings, cacheKey);
+		}
+		if (MeshCache::TryLoadData(filename, cacheKey, *result)) {
+			return MakeMeshUpload(result, target);
+		}
+	}
+
+	MeshBuilder<VertexPosNormTexCol> mesh;
+	ObjLoader::LoadMeshData(filename, mesh, inColor);
+	if (AssetLoader::OptimizeMeshes) {
+		MeshOptimizer::Stats stats = mesh.Optimize(AssetLoader::OptimizeSettings);
+		LOG_INFO("Optimized \"{}\": {} -> {} verts, ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}", filename,
+			stats.VerticesBefore, stats.VerticesAfter, stats.Before.ACMR, stats.After.ACMR, stats.Before.ATVR, stats.After.ATVR);
+	}
+
+	*result = mesh.Convert<VertType>();
+	if (MeshCache::Enabled) {
+		MeshCache::Store(filename, cacheKey, *result);
+	}
+	return MakeMeshUpload(result, target);
+}
+
+VertexArrayObject::sptr AssetLoader::LoadObj(const std::string& filename, const glm::vec4& inColor, VertexFormat format) {
+	return MeshRegistry::GetOrLoad(MeshRegistry::GetObjKey(filename, inColor, format), [&]() {
+		VertexArrayObject::sptr result = VertexArrayObject::Create();
+		result->SetDebugName(filename);
+
+		std::weak_ptr<VertexArrayObject> target = result;
+		Submit([filename, inColor, format, target]() {
+			if (format == VertexFormat::Packed) {
+				return LoadObjUpload<VertexPosNormTexColPacked>(filename, inColor, format, target);
+			}
+			return LoadObjUpload<VertexPosNormTexCol>(filename, inColor, format, target);
+		});
+
+		return result;
+	});
+}
+
+LodMesh::sptr AssetLoader::LoadObjLods(const std::string& filename, const glm::vec4& inColor, VertexFormat format, const LodMesh::Settings& settings) {
+	return MeshRegistry::GetOrLoadLods(MeshRegistry::GetLodKey(MeshRegistry::GetObjKey(filename, inColor, format), settings), [&]() {
+		LodMesh::sptr result = LodMesh::Create();
+		result->GetVao()->SetDebugName(filename);
+
+		std::weak_ptr<LodMesh> target = result;
+		Submit([filename, inColor, format, settings, target]() {
+			// The levels are generated from the parsed mesh, so we share ObjLoader's cache entry for it and only skip parsing
+			std::shared_ptr<MeshBuilder<VertexPosNormTexCol>> mesh = std::make_shared<MeshBuilder<VertexPosNormTexCol>>();
+			uint64_t cacheKey = MeshCache::Enabled ? ObjLoader::GetCacheKey(filename, inColor) : 0;
+			if (!MeshCache::Enabled || !MeshCache::TryLoadData(filename, cacheKey, *mesh)) {
+				ObjLoader::LoadMeshData(filename, *mesh, inColor);
+				if (MeshCache::Enabled) {
+					MeshCache::Store(filename, cacheKey, *mesh);
+				}
+			}
+			MeshOptimizer::Settings optimizeSettings = OptimizeSettings;
+			optimizeSettings.Weld = true;
+			mesh->Optimize(optimizeSettings);
+
+			LodMesh::Description description = mesh->GenerateLods(settings);
+			if (description.Levels.empty()) {
+				return Upload();
+			}
+			LOG_INFO("Generated {} levels of detail for \"{}\": {} -> {} tris, error {:.4f}", description.Levels.size(), filename,
+				description.Levels.front().IndexCount / 3, description.Levels.back().IndexCount / 3, description.Levels.back().Error);
+			if (format == VertexFormat::Packed) {
+				return MakeLodUpload(std::make_shared<MeshBuilder<VertexPosNormTexColPacked>>(mesh->Convert<VertexPosNormTexColPacked>()), description, target);
+			}
+			return MakeLodUpload(mesh, description, target);
+		});
+
+		return result;
+	});
+}
+
+void AssetLoader::Pump() {
+	using namespace std::chrono;
+	const steady_clock::time_point start = steady_clock::now();
+	size_t uploadCount = 0;
+	size_t bytesUploaded = 0;
+
+	while (true) {
+		FinishedJob job;
+		{
+			std::lock_guard<std::mutex> lock(_lock);
+			if (_finished.empty()) {
+				break;
+			}
+			// Always allow one upload per frame, otherwise an asset larger than the budget would never load
+			if (uploadCount > 0) {
+				const float elapsed = duration<float, std::milli>(steady_clock::now() - start).count();
+				if (bytesUploaded + _finished.front().Result.Bytes > UploadByteBudget || elapsed >= UploadTimeBudget) {
+					break;
+				}
+			}
+			job = std::move(_finished.front());
+			_finished.pop_front();
+		}
+
+		// A failed upload should only lose that one asset, the rest of the queue still needs to be applied
+		if (job.Result.Apply) {
+			try {
+				job.Result.Apply();
+			}
+			catch (const std::exception& e) {
+				LOG_ERROR("Asset upload failed: {}", e.what());
+			}
+		}
+		job.Done->set_value();
+		uploadCount++;
+		bytesUploaded += job.Result.Bytes;
+
+		{
+			std::lock_guard<std::mutex> lock(_lock);
+			_pending--;
+		}
+		_jobFinished.notify_all();
+	}
+}
+
+void AssetLoader::WaitAll() {
+	const size_t byteBudget = UploadByteBudget;
+	const float timeBudget = UploadTimeBudget;
+	UploadByteBudget = SIZE_MAX;
+	UploadTimeBudget = FLT_MAX;
+
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(_lock);
+			_jobFinished.wait(lock, []() { return !_finished.empty() || _pending == 0; });
+			if (_finished.empty()) {
+				break;
+			}
+		}
+		Pump();
+	}
+
+	UploadByteBudget = byteBudget;
+	UploadTimeBudget = timeBudget;
+}
+
+size_t AssetLoader::GetPendingCount() {
+	std::lock_guard<std::mutex> lock(_lock);
+	return _pending;
+}
+
+InternalFormat AssetLoader::_GuessTextureFormat(const std::string& path) {
+	int width, height, numChannels;
+	if (!stbi_info(path.c_str(), &width, &height, &numChannels)) {
+		return InternalFormat::RGBA8;
+	}
+	switch (numChannels) {
+		case 1: return InternalFormat::R8;
+		case 2: return InternalFormat::RG8;
+		case 3: return InternalFormat::RGB8;
+		default: return InternalFormat::RGBA8;
+	}
+}
+
+void AssetLoader::_WorkerMain() {
+	while (true) {
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(_lock);
+			_jobAdded.wait(lock, []() { return !_running || !_jobs.empty(); });
+			if (!_running) {
+				return;
+			}
+			job = std::move(_jobs.front());
+			_jobs.pop_front();
+		}
+
+		try {
+			Upload result = job.Work();
+			std::lock_guard<std::mutex> lock(_lock);
+			_finished.push_back({ std::move(result), job.Done });
+		}
+		catch (const std::exception& e) {
+			LOG_WARN("Asset load failed: {}", e.what());
+			job.Done->set_exception(std::current_exception());
+			std::lock_guard<std::mutex> lock(_lock);
+			_pending--;
+		}
+		_jobFinished.notify_all();
+	}
+}
@@ -0,0 +1,77 @@
+#include "AssetMemory.h"
+
+#include <algorithm>
+
+#include "LodMesh.h"
+#include "Logging.h"
+#include "Texture2D.h"
+#include "VertexArrayObject.h"
+
+void AssetMemory::Track(const std::string& name, const std::shared_ptr<Texture2D>& texture) {
+	std::lock_guard<std::mutex> lock(_lock);
+	_textures.emplace_back(name, texture);
+}
+
+void AssetMemory::Track(const std::string& name, const std::shared_ptr<VertexArrayObject>& mesh) {
+	std::lock_guard<std::mutex> lock(_lock);
+	_meshes.emplace_back(name, mesh);
+}
+
+void AssetMemory::Track(const std::string& name, const std::shared_ptr<LodMesh>& mesh) {
+	std::lock_guard<std::mutex> lock(_lock);
+	_lodMeshes.emplace_back(name, mesh);
+}
+
+/// <summary>
+/// Adds an entry for each live asset in a list to the report, and removes the assets that have been freed
+/// </summary>
+template <typename AssetType, typename SizeFunc>
+void CollectEntries(std::vector<std::pair<std::string, std::weak_ptr<AssetType>>>& assets, const std::string& type,
+	SizeFunc getSizes, std::vector<AssetMemory::Entry>& result)
+{
+	auto it = assets.begin();
+	while (it != assets.end()) {
+		std::shared_ptr<AssetType> asset = it->second.lock();
+		if (asset == nullptr) {
+			it = assets.erase(it);
+			continue;
+		}
+		size_t cpuBytes = 0, gpuBytes = 0;
+		getSizes(*asset, cpuBytes, gpuBytes);
+		result.emplace_back(it->first, type, cpuBytes, gpuBytes);
+		++it;
+	}
+}
+
+std::vector<AssetMemory::Entry> AssetMemory::GetReport() {
+	std::vector<Entry> result;
+
+	std::lock_guard<std::mutex> lock(_lock);
+	CollectEntries(_textures, "Texture2D", [](const Texture2D& texture, size_t& cpu, size_t& gpu) {
+		cpu = texture.GetCpuSize();
+		gpu = texture.GetGpuSize();
+	}, result);
+	// VAOs never keep their vertices after upload, so meshes only use GPU memory
+	CollectEntries(_meshes, "Mesh", [](const VertexArrayObject& mesh, size_t&, size_t& gpu) {
+		gpu = mesh.GetTotalBufferSize();
+	}, result);
+	CollectEntries(_lodMeshes, "LodMesh", [](const LodMesh& mesh, size_t& cpu, size_t& gpu) {
+		cpu = mesh.GetDescription().Levels.size() * sizeof(LodMesh::Level);
+		gpu = mesh.GetVao()->GetTotalBufferSize();
+	}, result);
+
+	std::sort(result.begin(), result.end(), [](const Entry& a, const Entry& b) { return a.GpuBytes > b.GpuBytes; });
+	return result;
+}
+
+void AssetMemory::LogReport() {
+	std::vector<Entry> report = GetReport();
+	size_t totalCpu = 0, totalGpu = 0;
+	LOG_INFO("Asset memory ({} assets):", report.size());
+	for (const Entry& entry : report) {
+		LOG_INFO("  {:<10} CPU {:>10} GPU {:>10}  {}", entry.Type, entry.CpuBytes, entry.GpuBytes, entry.Name);
+		totalCpu += entry.CpuBytes;
+		totalGpu += entry.GpuBytes;
+	}
+	LOG_INFO("  Total      CPU {:>10} GPU {:>10}", totalCpu, totalGpu);
+}
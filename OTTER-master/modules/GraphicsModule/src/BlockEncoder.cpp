@@ -0,0 +1,370 @@
+#include "BlockEncoder.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+
+// The interpolation weights for BC7's 4 bit indices, out of 64
+static const int BC7_WEIGHTS4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+/*
+ * Finds the line that best fits a block of texels (the principal axis), and returns the extents of the texels
+ * projected onto it. These make for a good initial guess at the endpoints for all our formats
+ * @param rgba The 16 RGBA8 texels in the block
+ * @param channels The number of channels to consider, 3 to ignore alpha or 4 to include it
+ * @param start Receives the start of the line, in the 0-255 range
+ * @param end Receives the end of the line, in the 0-255 range
+ */
+static void FitLine(const uint8_t* rgba, int channels, float start[4], float end[4]) {
+	float mean[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	float minValue[4] = { 255.0f, 255.0f, 255.0f, 255.0f };
+	float maxValue[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	for (int ix = 0; ix < 16; ix++) {
+		for (int c = 0; c < channels; c++) {
+			const float value = rgba[ix * 4 + c];
+			mean[c] += value;
+			minValue[c] = std::min(minValue[c], value);
+			maxValue[c] = std::max(maxValue[c], value);
+		}
+	}
+	for (int c = 0; c < channels; c++) {
+		mean[c] /= 16.0f;
+		start[c] = end[c] = mean[c];
+	}
+
+	float covariance[4][4] = {};
+	for (int ix = 0; ix < 16; ix++) {
+		float delta[4];
+		for (int c = 0; c < channels; c++) {
+			delta[c] = rgba[ix * 4 + c] - mean[c];
+		}
+		for (int a = 0; a < channels; a++) {
+			for (int b = 0; b < channels; b++) {
+				covariance[a][b] += delta[a] * delta[b];
+			}
+		}
+	}
+
+	// Power iteration, starting from the diagonal of the bounding box, converges quickly on the principal axis
+	float axis[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	for (int c = 0; c < channels; c++) {
+		axis[c] = maxValue[c] - minValue[c];
+	}
+	for (int iteration = 0; iteration < 8; iteration++) {
+		float next[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		float largest = 0.0f;
+		for (int a = 0; a < channels; a++) {
+			for (int b = 0; b < channels; b++) {
+				next[a] += covariance[a][b] * axis[b];
+			}
+			largest = std::max(largest, std::abs(next[a]));
+		}
+		if (largest < 1e-6f) {
+			break;
+		}
+		for (int c = 0; c < channels; c++) {
+			axis[c] = next[c] / largest;
+		}
+	}
+
+	float length = 0.0f;
+	for (int c = 0; c < channels; c++) {
+		length += axis[c] * axis[c];
+	}
+	// If every texel is the same we can just use the mean for both endpoints
+	if (length < 1e-12f) {
+		return;
+	}
+	length = std::sqrt(length);
+	for (int c = 0; c < channels; c++) {
+		axis[c] /= length;
+	}
+
+	float minT = FLT_MAX, maxT = -FLT_MAX;
+	for (int ix = 0; ix < 16; ix++) {
+		float t = 0.0f;
+		for (int c = 0; c < channels; c++) {
+			t += (rgba[ix * 4 + c] - mean[c]) * axis[c];
+		}
+		minT = std::min(minT, t);
+		maxT = std::max(maxT, t);
+	}
+	for (int c = 0; c < channels; c++) {
+		start[c] = std::clamp(mean[c] + axis[c] * minT, 0.0f, 255.0f);
+		end[c] = std::clamp(mean[c] + axis[c] * maxT, 0.0f, 255.0f);
+	}
+}
+
+static uint16_t PackRGB565(const float color[3]) {
+	const int r = std::clamp((int)(color[0] * 31.0f / 255.0f + 0.5f), 0, 31);
+	const int g = std::clamp((int)(color[1] * 63.0f / 255.0f + 0.5f), 0, 63);
+	const int b = std::clamp((int)(color[2] * 31.0f / 255.0f + 0.5f), 0, 31);
+	return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+}
+
+static void UnpackRGB565(uint16_t packed, int result[3]) {
+	const int r = (packed >> 11) & 31;
+	const int g = (packed >> 5) & 63;
+	const int b = packed & 31;
+	result[0] = (r << 3) | (r >> 2);
+	result[1] = (g << 2) | (g >> 4);
+	result[2] = (b << 3) | (b >> 2);
+}
+
+/*
+ * Picks the closest of the 4 palette entries for every texel in a BC1 block
+ * @returns The total squared error of the block
+ */
+static uint32_t SelectBC1Indices(const uint8_t* rgba, uint16_t color0, uint16_t color1, uint32_t& indices) {
+	int palette[4][3];
+	UnpackRGB565(color0, palette[0]);
+	UnpackRGB565(color1, palette[1]);
+	for (int c = 0; c < 3; c++) {
+		palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+		palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+	}
+
+	uint32_t error = 0;
+	indices = 0;
+	for (int ix = 0; ix < 16; ix++) {
+		uint32_t bestError = UINT32_MAX;
+		uint32_t best = 0;
+		for (uint32_t p = 0; p < 4; p++) {
+			uint32_t entryError = 0;
+			for (int c = 0; c < 3; c++) {
+				const int delta = rgba[ix * 4 + c] - palette[p][c];
+				entryError += delta * delta;
+			}
+			if (entryError < bestError) {
+				bestError = entryError;
+				best = p;
+			}
+		}
+		indices |= best << (ix * 2);
+		error += bestError;
+	}
+	return error;
+}
+
+void BlockEncoder::EncodeBlock(InternalFormat format, const uint8_t* rgba, uint8_t* result) {
+	switch (format) {
+	case InternalFormat::BC1:
+		EncodeBC1(rgba, result);
+		break;
+	case InternalFormat::BC3:
+		EncodeBC3(rgba, result);
+		break;
+	case InternalFormat::BC5:
+		EncodeBC5(rgba, result);
+		break;
+	case InternalFormat::BC7:
+		EncodeBC7(rgba, result);
+		break;
+	default:
+		LOG_ASSERT(false, "Format {} is not a block compressed format!", format);
+		break;
+	}
+}
+
+void BlockEncoder::EncodeBC1(const uint8_t* rgba, uint8_t* result) {
+	float start[4], end[4];
+	FitLine(rgba, 3, start, end);
+
+	uint16_t color0 = PackRGB565(end);
+	uint16_t color1 = PackRGB565(start);
+	uint32_t indices;
+	uint32_t error = SelectBC1Indices(rgba, color0, color1, indices);
+
+	// Refine the endpoints with a least squares fit against the indices we picked, this recovers a lot of the
+	// error introduced by clamping to the extents of the block
+	static const float WEIGHTS[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+	float aa = 0.0f, bb = 0.0f, ab = 0.0f;
+	float ax[3] = { 0.0f, 0.0f, 0.0f }, bx[3] = { 0.0f, 0.0f, 0.0f };
+	for (int ix = 0; ix < 16; ix++) {
+		const float a = WEIGHTS[(indices >> (ix * 2)) & 3];
+		const float b = 1.0f - a;
+		aa += a * a;
+		bb += b * b;
+		ab += a * b;
+		for (int c = 0; c < 3; c++) {
+			ax[c] += a * rgba[ix * 4 + c];
+			bx[c] += b * rgba[ix * 4 + c];
+		}
+	}
+	const float determinant = aa * bb - ab * ab;
+	if (std::abs(determinant) > 1e-6f) {
+		float refined0[3], refined1[3];
+		for (int c = 0; c < 3; c++) {
+			refined0[c] = std::clamp((ax[c] * bb - bx[c] * ab) / determinant, 0.0f, 255.0f);
+			refined1[c] = std::clamp((bx[c] * aa - ax[c] * ab) / determinant, 0.0f, 255.0f);
+		}
+		const uint16_t refinedColor0 = PackRGB565(refined0);
+		const uint16_t refinedColor1 = PackRGB565(refined1);
+		uint32_t refinedIndices;
+		const uint32_t refinedError = SelectBC1Indices(rgba, refinedColor0, refinedColor1, refinedIndices);
+		if (refinedError < error) {
+			color0 = refinedColor0;
+			color1 = refinedColor1;
+			indices = refinedIndices;
+		}
+	}
+
+	// The decoder only uses the 4 color mode when color0 > color1, so we may need to swap the endpoints, which
+	// swaps index 0 with 1 and 2 with 3
+	if (color0 < color1) {
+		std::swap(color0, color1);
+		indices ^= 0x55555555u;
+	}
+	else if (color0 == color1) {
+		indices = 0;
+	}
+
+	result[0] = color0 & 0xFF;
+	result[1] = color0 >> 8;
+	result[2] = color1 & 0xFF;
+	result[3] = color1 >> 8;
+	for (int ix = 0; ix < 4; ix++) {
+		result[4 + ix] = (indices >> (ix * 8)) & 0xFF;
+	}
+}
+
+void BlockEncoder::EncodeBC3(const uint8_t* rgba, uint8_t* result) {
+	EncodeBC4(rgba, 3, result);
+	EncodeBC1(rgba, result + 8);
+}
+
+void BlockEncoder::EncodeBC5(const uint8_t* rgba, uint8_t* result) {
+	EncodeBC4(rgba, 0, result);
+	EncodeBC4(rgba, 1, result + 8);
+}
+
+void BlockEncoder::EncodeBC4(const uint8_t* rgba, int channel, uint8_t* result) {
+	int minValue = 255, maxValue = 0;
+	for (int ix = 0; ix < 16; ix++) {
+		minValue = std::min(minValue, (int)rgba[ix * 4 + channel]);
+		maxValue = std::max(maxValue, (int)rgba[ix * 4 + channel]);
+	}
+
+	// Storing the max first selects the 8 value mode, where the 6 in-between values are interpolated
+	result[0] = static_cast<uint8_t>(maxValue);
+	result[1] = static_cast<uint8_t>(minValue);
+
+	uint64_t indices = 0;
+	if (maxValue != minValue) {
+		int palette[8];
+		palette[0] = maxValue;
+		palette[1] = minValue;
+		for (int ix = 2; ix < 8; ix++) {
+			palette[ix] = ((8 - ix) * maxValue + (ix - 1) * minValue + 3) / 7;
+		}
+		for (int ix = 0; ix < 16; ix++) {
+			const int value = rgba[ix * 4 + channel];
+			int bestError = INT32_MAX;
+			uint64_t best = 0;
+			for (int p = 0; p < 8; p++) {
+				const int entryError = std::abs(value - palette[p]);
+				if (entryError < bestError) {
+					bestError = entryError;
+					best = p;
+				}
+			}
+			indices |= best << (ix * 3);
+		}
+	}
+	for (int ix = 0; ix < 6; ix++) {
+		result[2 + ix] = (indices >> (ix * 8)) & 0xFF;
+	}
+}
+
+/*
+ * Quantizes a BC7 mode 6 endpoint to 7 bits per channel and a p-bit that is shared by all channels
+ */
+static void QuantizeBC7Endpoint(const float value[4], int quantized[4], int& pBit) {
+	float bestError = FLT_MAX;
+	for (int p = 0; p < 2; p++) {
+		int candidate[4];
+		float error = 0.0f;
+		for (int c = 0; c < 4; c++) {
+			candidate[c] = std::clamp((int)((value[c] - p) / 2.0f + 0.5f), 0, 127);
+			const float delta = ((candidate[c] << 1) | p) - value[c];
+			error += delta * delta;
+		}
+		if (error < bestError) {
+			bestError = error;
+			pBit = p;
+			std::copy(candidate, candidate + 4, quantized);
+		}
+	}
+}
+
+void BlockEncoder::EncodeBC7(const uint8_t* rgba, uint8_t* result) {
+	float start[4], end[4];
+	FitLine(rgba, 4, start, end);
+
+	int quantized0[4], quantized1[4];
+	int pBit0, pBit1;
+	QuantizeBC7Endpoint(start, quantized0, pBit0);
+	QuantizeBC7Endpoint(end, quantized1, pBit1);
+
+	int palette[16][4];
+	for (int c = 0; c < 4; c++) {
+		const int endpoint0 = (quantized0[c] << 1) | pBit0;
+		const int endpoint1 = (quantized1[c] << 1) | pBit1;
+		for (int ix = 0; ix < 16; ix++) {
+			palette[ix][c] = ((64 - BC7_WEIGHTS4[ix]) * endpoint0 + BC7_WEIGHTS4[ix] * endpoint1 + 32) >> 6;
+		}
+	}
+
+	int indices[16];
+	for (int ix = 0; ix < 16; ix++) {
+		int bestError = INT32_MAX;
+		for (int p = 0; p < 16; p++) {
+			int entryError = 0;
+			for (int c = 0; c < 4; c++) {
+				const int delta = rgba[ix * 4 + c] - palette[p][c];
+				entryError += delta * delta;
+			}
+			if (entryError < bestError) {
+				bestError = entryError;
+				indices[ix] = p;
+			}
+		}
+	}
+
+	// The first index is stored with an implied high bit of 0, the weights are symmetric so we can swap the
+	// endpoints and flip the indices to make that true
+	if (indices[0] & 8) {
+		std::swap(quantized0, quantized1);
+		std::swap(pBit0, pBit1);
+		for (int ix = 0; ix < 16; ix++) {
+			indices[ix] = 15 - indices[ix];
+		}
+	}
+
+	uint64_t bits[2] = { 0, 0 };
+	int position = 0;
+	auto write = [&](uint32_t value, int count) {
+		for (int ix = 0; ix < count; ix++, position++) {
+			if ((value >> ix) & 1) {
+				bits[position / 64] |= 1ull << (position % 64);
+			}
+		}
+	};
+	// Mode 6 is selected by 6 zero bits followed by a one
+	write(1 << 6, 7);
+	for (int c = 0; c < 4; c++) {
+		write(quantized0[c], 7);
+		write(quantized1[c], 7);
+	}
+	write(pBit0, 1);
+	write(pBit1, 1);
+	write(indices[0], 3);
+	for (int ix = 1; ix < 16; ix++) {
+		write(indices[ix], 4);
+	}
+
+	for (int ix = 0; ix < 16; ix++) {
+		result[ix] = (bits[ix / 8] >> ((ix % 8) * 8)) & 0xFF;
+	}
+}
@@ -0,0 +1,160 @@
+#include "Bounds.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__)
+#include <xmmintrin.h>
+#define BOUNDS_USE_SSE
+#endif
+
+BoundingBox BoundingBox::Transform(const glm::mat4& transform) const {
+	if (!IsValid()) {
+		return *this;
+	}
+	// Transform the center, then project each of the transformed axes onto the world axes to get the new extents
+	const glm::vec3 center = glm::vec3(transform * glm::vec4(GetCenter(), 1.0f));
+	const glm::vec3 extents = GetExtents();
+	const glm::vec3 newExtents =
+		glm::abs(glm::vec3(transform[0])) * extents.x +
+		glm::abs(glm::vec3(transform[1])) * extents.y +
+		glm::abs(glm::vec3(transform[2])) * extents.z;
+	return BoundingBox(center - newExtents, center + newExtents);
+}
+
+BoundingSphere BoundingSphere::Transform(const glm::mat4& transform) const {
+	if (!IsValid()) {
+		return *this;
+	}
+	const float scale = std::sqrt(std::max(glm::dot(glm::vec3(transform[0]), glm::vec3(transform[0])),
+		std::max(glm::dot(glm::vec3(transform[1]), glm::vec3(transform[1])), glm::dot(glm::vec3(transform[2]), glm::vec3(transform[2])))));
+	return BoundingSphere(glm::vec3(transform * glm::vec4(Center, 1.0f)), Radius * scale);
+}
+
+MeshBounds MeshBounds::Transform(const glm::mat4& transform) const {
+	MeshBounds result;
+	result.Box = Box.Transform(transform);
+	result.Sphere = Sphere.Transform(transform);
+	return result;
+}
+
+MeshBounds MeshBounds::Compute(const void* positions, size_t count, size_t stride) {
+	MeshBounds result;
+	if (positions == nullptr || count == 0) {
+		return result;
+	}
+	const char* data = static_cast<const char*>(positions);
+	glm::vec3 min, max;
+
+	#ifdef BOUNDS_USE_SSE
+	// Each load grabs 4 floats, the last of which belongs to the next attribute and is ignored. The final vertex is
+	// loaded separately so that we never read past the end of the buffer
+	__m128 minV = _mm_set_ps(0.0f, ((const float*)data)[2], ((const float*)data)[1], ((const float*)data)[0]);
+	__m128 maxV = minV;
+	for (size_t ix = 1; ix + 1 < count; ix++) {
+		const __m128 pos = _mm_loadu_ps(reinterpret_cast<const float*>(data + ix * stride));
+		minV = _mm_min_ps(minV, pos);
+		maxV = _mm_max_ps(maxV, pos);
+	}
+	const float* last = reinterpret_cast<const float*>(data + (count - 1) * stride);
+	const __m128 lastV = _mm_set_ps(0.0f, last[2], last[1], last[0]);
+	minV = _mm_min_ps(minV, lastV);
+	maxV = _mm_max_ps(maxV, lastV);
+
+	float minOut[4], maxOut[4];
+	_mm_storeu_ps(minOut, minV);
+	_mm_storeu_ps(maxOut, maxV);
+	min = glm::vec3(minOut[0], minOut[1], minOut[2]);
+	max = glm::vec3(maxOut[0], maxOut[1], maxOut[2]);
+	#else
+	memcpy(&min, data, sizeof(glm::vec3));
+	max = min;
+	for (size_t ix = 1; ix < count; ix++) {
+		glm::vec3 pos;
+		memcpy(&pos, data + ix * stride, sizeof(glm::vec3));
+		min = glm::min(min, pos);
+		max = glm::max(max, pos);
+	}
+	#endif
+
+	result.Box = BoundingBox(min, max);
+
+	// The sphere is centered on the box, and we only need a square root for the furthest vertex
+	const glm::vec3 center = result.Box.GetCenter();
+	float maxDistSq = 0.0f;
+	for (size_t ix = 0; ix < count; ix++) {
+		glm::vec3 pos;
+		memcpy(&pos, data + ix * stride, sizeof(glm::vec3));
+		const glm::vec3 offset = pos - center;
+		maxDistSq = std::max(maxDistSq, glm::dot(offset, offset));
+	}
+	result.Sphere = BoundingSphere(center, std::sqrt(maxDistSq));
+	return result;
+}
+
+Frustum::Frustum() {
+	// Planes that face inwards from infinitely far away, so everything is visible
+	for (int ix = 0; ix < 6; ix++) {
+		_planes[ix] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+	}
+}
+
+Frustum::Frustum(const glm::mat4& viewProjection) {
+	Update(viewProjection);
+}
+
+void Frustum::Update(const glm::mat4& viewProjection) {
+	// Gribb & Hartmann, the planes are sums and differences of the rows of the matrix. GLM is column major, so
+	// we need to pull the rows out first
+	const glm::vec4 row0 = glm::vec4(viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]);
+	const glm::vec4 row1 = glm::vec4(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]);
+	const glm::vec4 row2 = glm::vec4(viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]);
+	const glm::vec4 row3 = glm::vec4(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+
+	_planes[0] = row3 + row0; // Left
+	_planes[1] = row3 - row0; // Right
+	_planes[2] = row3 + row1; // Bottom
+	_planes[3] = row3 - row1; // Top
+	_planes[4] = row3 + row2; // Near
+	_planes[5] = row3 - row2; // Far
+
+	for (glm::vec4& plane : _planes) {
+		const float length = glm::length(glm::vec3(plane));
+		if (length > 0.0f) {
+			plane /= length;
+		}
+	}
+}
+
+bool Frustum::Intersects(const BoundingSphere& sphere) const {
+	if (!sphere.IsValid()) {
+		return true;
+	}
+	for (const glm::vec4& plane : _planes) {
+		if (glm::dot(glm::vec3(plane), sphere.Center) + plane.w < -sphere.Radius) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool Frustum::Intersects(const BoundingBox& box) const {
+	if (!box.IsValid()) {
+		return true;
+	}
+	const glm::vec3 center = box.GetCenter();
+	const glm::vec3 extents = box.GetExtents();
+	for (const glm::vec4& plane : _planes) {
+		// The distance from the center to the corner that is furthest along the plane's normal
+		const float radius = glm::dot(glm::abs(glm::vec3(plane)), extents);
+		if (glm::dot(glm::vec3(plane), center) + plane.w < -radius) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool Frustum::Intersects(const MeshBounds& bounds) const {
+	return Intersects(bounds.Sphere) && Intersects(bounds.Box);
+}
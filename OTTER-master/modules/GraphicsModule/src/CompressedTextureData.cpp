@@ -0,0 +1,352 @@
+#include "CompressedTextureData.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <thread>
+
+#include "BlockEncoder.h"
+#include "HashUtils.h"
+#include "Logging.h"
+#include "MappedFile.h"
+
+namespace fs = std::filesystem;
+
+// See https://docs.microsoft.com/en-us/windows/win32/direct3ddds/dds-header
+struct DDSPixelFormat
+{
+	uint32_t Size;
+	uint32_t Flags;
+	uint32_t FourCC;
+	uint32_t RGBBitCount;
+	uint32_t RBitMask;
+	uint32_t GBitMask;
+	uint32_t BBitMask;
+	uint32_t ABitMask;
+};
+
+struct DDSHeader
+{
+	uint32_t       Size;
+	uint32_t       Flags;
+	uint32_t       Height;
+	uint32_t       Width;
+	uint32_t       PitchOrLinearSize;
+	uint32_t       Depth;
+	uint32_t       MipMapCount;
+	uint32_t       Reserved1[11];
+	DDSPixelFormat PixelFormat;
+	uint32_t       Caps;
+	uint32_t       Caps2;
+	uint32_t       Caps3;
+	uint32_t       Caps4;
+	uint32_t       Reserved2;
+};
+
+struct DDSHeaderDX10
+{
+	uint32_t DxgiFormat;
+	uint32_t ResourceDimension;
+	uint32_t MiscFlag;
+	uint32_t ArraySize;
+	uint32_t MiscFlags2;
+};
+
+static_assert(sizeof(DDSPixelFormat) == 32, "DDS pixel format must be 32 bytes");
+static_assert(sizeof(DDSHeader) == 124, "DDS header must be 124 bytes");
+static_assert(sizeof(DDSHeaderDX10) == 20, "DDS DX10 header must be 20 bytes");
+
+static const uint32_t DDS_MAGIC       = 0x20534444; // "DDS "
+static const uint32_t DDS_FOURCC_DX10 = 0x30315844; // "DX10"
+static const uint32_t DDS_FLAGS       = 0x1 | 0x2 | 0x4 | 0x1000 | 0x20000 | 0x80000; // Caps, height, width, pixel format, mip count, linear size
+static const uint32_t DDPF_FOURCC     = 0x4;
+static const uint32_t DDSCAPS_COMPLEX = 0x8;
+static const uint32_t DDSCAPS_TEXTURE = 0x1000;
+static const uint32_t DDSCAPS_MIPMAP  = 0x400000;
+static const uint32_t DDS_DIMENSION_TEXTURE2D = 3;
+
+static uint32_t GetDxgiFormat(InternalFormat format) {
+	switch (format) {
+	case InternalFormat::BC1: return 71; // DXGI_FORMAT_BC1_UNORM
+	case InternalFormat::BC3: return 77; // DXGI_FORMAT_BC3_UNORM
+	case InternalFormat::BC5: return 83; // DXGI_FORMAT_BC5_UNORM
+	case InternalFormat::BC7: return 98; // DXGI_FORMAT_BC7_UNORM
+	default: return 0;
+	}
+}
+
+static InternalFormat FromDxgiFormat(uint32_t format) {
+	switch (format) {
+	case 71: return InternalFormat::BC1;
+	case 77: return InternalFormat::BC3;
+	case 83: return InternalFormat::BC5;
+	case 98: return InternalFormat::BC7;
+	default: return InternalFormat::Unknown;
+	}
+}
+
+/*
+ * Encodes a single RGBA8 image into blocks, splitting rows of blocks between threads
+ */
+static void EncodeLevel(const std::vector<uint8_t>& rgba, uint32_t width, uint32_t height, InternalFormat format, uint8_t* result) {
+	const uint32_t blocksX = (width + 3) / 4;
+	const uint32_t blocksY = (height + 3) / 4;
+	const size_t blockSize = GetCompressedBlockSize(format);
+
+	auto encodeRows = [&](uint32_t firstRow, uint32_t lastRow) {
+		uint8_t block[64];
+		for (uint32_t by = firstRow; by < lastRow; by++) {
+			for (uint32_t bx = 0; bx < blocksX; bx++) {
+				// Blocks that hang off the edge of the image repeat the edge texels
+				for (uint32_t y = 0; y < 4; y++) {
+					const uint32_t sy = std::min(by * 4 + y, height - 1);
+					for (uint32_t x = 0; x < 4; x++) {
+						const uint32_t sx = std::min(bx * 4 + x, width - 1);
+						memcpy(block + (y * 4 + x) * 4, &rgba[((size_t)sy * width + sx) * 4], 4);
+					}
+				}
+				BlockEncoder::EncodeBlock(format, block, result + ((size_t)by * blocksX + bx) * blockSize);
+			}
+		}
+	};
+
+	const uint32_t threadCount = std::min(std::max(std::thread::hardware_concurrency(), 1u), blocksY);
+	if (threadCount <= 1) {
+		encodeRows(0, blocksY);
+		return;
+	}
+	std::vector<std::future<void>> tasks;
+	tasks.reserve(threadCount);
+	for (uint32_t ix = 0; ix < threadCount; ix++) {
+		tasks.push_back(std::async(std::launch::async, encodeRows, blocksY * ix / threadCount, blocksY * (ix + 1) / threadCount));
+	}
+	for (std::future<void>& task : tasks) {
+		task.get();
+	}
+}
+
+/*
+ * Halves the size of an RGBA8 image with a 2x2 box filter
+ */
+static std::vector<uint8_t> Downsample(const std::vector<uint8_t>& rgba, uint32_t width, uint32_t height, uint32_t& outWidth, uint32_t& outHeight) {
+	outWidth = std::max(width / 2, 1u);
+	outHeight = std::max(height / 2, 1u);
+	std::vector<uint8_t> result((size_t)outWidth * outHeight * 4);
+	for (uint32_t y = 0; y < outHeight; y++) {
+		const uint32_t y0 = std::min(y * 2, height - 1), y1 = std::min(y * 2 + 1, height - 1);
+		for (uint32_t x = 0; x < outWidth; x++) {
+			const uint32_t x0 = std::min(x * 2, width - 1), x1 = std::min(x * 2 + 1, width - 1);
+			for (int c = 0; c < 4; c++) {
+				const int sum = rgba[((size_t)y0 * width + x0) * 4 + c] + rgba[((size_t)y0 * width + x1) * 4 + c] +
+				                rgba[((size_t)y1 * width + x0) * 4 + c] + rgba[((size_t)y1 * width + x1) * 4 + c];
+				result[((size_t)y * outWidth + x) * 4 + c] = static_cast<uint8_t>((sum + 2) / 4);
+			}
+		}
+	}
+	return result;
+}
+
+CompressedTextureData::CompressedTextureData(uint32_t width, uint32_t height, InternalFormat format) :
+	_width(width), _height(height), _format(format), _levels(std::vector<MipLevel>())
+{
+	LOG_ASSERT(width > 0 && height > 0, "Width and height must both be greater than zero! Got {}x{}", width, height);
+	LOG_ASSERT(IsCompressedFormat(format), "Format {} is not a block compressed format!", format);
+}
+
+size_t CompressedTextureData::GetLevelDataSize(InternalFormat format, uint32_t width, uint32_t height) {
+	return (size_t)((width + 3) / 4) * ((height + 3) / 4) * GetCompressedBlockSize(format);
+}
+
+size_t CompressedTextureData::GetDataSize() const {
+	size_t result = 0;
+	for (const MipLevel& level : _levels) {
+		result += level.Data.size();
+	}
+	return result;
+}
+
+CompressedTextureData::sptr CompressedTextureData::Encode(const Texture2DData::sptr& source, InternalFormat format, bool generateMipMaps) {
+	LOG_ASSERT(source->GetPixelType() == PixelType::UByte, "Only unsigned byte textures can be compressed! Got {}", source->GetPixelType());
+
+	// Expand the source into RGBA8 so the encoders only have to handle one layout, missing channels follow the
+	// same rules as OpenGL (0 for color, 255 for alpha)
+	const uint32_t width = source->GetWidth();
+	const uint32_t height = source->GetHeight();
+	const int channels = GetTexelComponentCount(source->GetFormat());
+	const bool swizzle = source->GetFormat() == PixelFormat::BGR || source->GetFormat() == PixelFormat::BGRA;
+	const uint8_t* data = static_cast<const uint8_t*>(source->GetDataPtr());
+	std::vector<uint8_t> rgba((size_t)width * height * 4);
+	for (size_t ix = 0; ix < (size_t)width * height; ix++) {
+		for (int c = 0; c < 4; c++) {
+			rgba[ix * 4 + c] = c < channels ? data[ix * channels + c] : (c == 3 ? 255 : 0);
+		}
+		if (swizzle) {
+			std::swap(rgba[ix * 4], rgba[ix * 4 + 2]);
+		}
+	}
+
+	CompressedTextureData::sptr result = std::make_shared<CompressedTextureData>(width, height, format);
+	result->DebugName = source->DebugName;
+
+	uint32_t levelWidth = width, levelHeight = height;
+	while (true) {
+		MipLevel level;
+		level.Width = levelWidth;
+		level.Height = levelHeight;
+		level.Data.resize(GetLevelDataSize(format, levelWidth, levelHeight));
+		EncodeLevel(rgba, levelWidth, levelHeight, format, level.Data.data());
+		result->_levels.push_back(std::move(level));
+
+		if (!generateMipMaps || (levelWidth == 1 && levelHeight == 1)) {
+			break;
+		}
+		rgba = Downsample(rgba, levelWidth, levelHeight, levelWidth, levelHeight);
+	}
+
+	return result;
+}
+
+CompressedTextureData::sptr CompressedTextureData::LoadFromFile(const std::string& file, InternalFormat format, bool generateMipMaps) {
+	std::string cachePath;
+	if (CacheEnabled) {
+		// The key covers the contents of the source image and everything that affects the encoder output
+		uint64_t key;
+		try {
+			MappedFile source(file);
+			const uint64_t options[3] = { (uint64_t)*format, (uint64_t)generateMipMaps, VERSION };
+			key = HashFnv1a(source.GetData(), source.GetSize(), HashFnv1a(options, sizeof(options)));
+		}
+		catch (const std::runtime_error& e) {
+			LOG_WARN("Failed to open image \"{}\": {}", file, e.what());
+			return nullptr;
+		}
+
+		cachePath = (fs::path(CacheDirectory) / fmt::format("{}_{:016x}.dds", fs::path(file).stem().string(), key)).string();
+		if (fs::exists(cachePath)) {
+			CompressedTextureData::sptr cached = LoadFromDDS(cachePath);
+			if (cached != nullptr && cached->GetFormat() == format) {
+				cached->DebugName = fs::path(file).filename().string();
+				return cached;
+			}
+		}
+	}
+
+	Texture2DData::sptr source = Texture2DData::LoadFromFile(file);
+	if (source == nullptr) {
+		return nullptr;
+	}
+	CompressedTextureData::sptr result = Encode(source, format, generateMipMaps);
+
+	if (CacheEnabled) {
+		// Write to a temporary file first, so that a partially written cache is never picked up
+		std::error_code error;
+		fs::create_directories(CacheDirectory, error);
+		const std::string tempPath = cachePath + ".tmp";
+		if (result->SaveToDDS(tempPath)) {
+			fs::rename(tempPath, cachePath, error);
+			if (error) {
+				LOG_WARN("Failed to move texture cache into place at \"{}\": {}", cachePath, error.message());
+				fs::remove(tempPath, error);
+			}
+		} else {
+			fs::remove(tempPath, error);
+		}
+	}
+
+	return result;
+}
+
+CompressedTextureData::sptr CompressedTextureData::LoadFromDDS(const std::string& file) {
+	try {
+		MappedFile mapping(file);
+		const char* data = mapping.GetData();
+		const size_t size = mapping.GetSize();
+
+		const size_t headerSize = sizeof(uint32_t) + sizeof(DDSHeader) + sizeof(DDSHeaderDX10);
+		if (size < headerSize) {
+			LOG_WARN("DDS file \"{}\" is truncated", file);
+			return nullptr;
+		}
+		uint32_t magic;
+		DDSHeader header;
+		DDSHeaderDX10 header10;
+		memcpy(&magic, data, sizeof(uint32_t));
+		memcpy(&header, data + sizeof(uint32_t), sizeof(DDSHeader));
+		memcpy(&header10, data + sizeof(uint32_t) + sizeof(DDSHeader), sizeof(DDSHeaderDX10));
+
+		const InternalFormat format = FromDxgiFormat(header10.DxgiFormat);
+		if (magic != DDS_MAGIC || header.Size != sizeof(DDSHeader) || !(header.PixelFormat.Flags & DDPF_FOURCC) ||
+			header.PixelFormat.FourCC != DDS_FOURCC_DX10 || header10.ResourceDimension != DDS_DIMENSION_TEXTURE2D ||
+			header10.ArraySize != 1 || format == InternalFormat::Unknown || header.Width == 0 || header.Height == 0) {
+			LOG_WARN("DDS file \"{}\" is not a supported 2D block compressed texture", file);
+			return nullptr;
+		}
+
+		CompressedTextureData::sptr result = std::make_shared<CompressedTextureData>(header.Width, header.Height, format);
+		result->DebugName = fs::path(file).filename().string();
+
+		const uint32_t levelCount = std::max(header.MipMapCount, 1u);
+		size_t offset = headerSize;
+		uint32_t width = header.Width, height = header.Height;
+		for (uint32_t ix = 0; ix < levelCount; ix++) {
+			const size_t levelSize = GetLevelDataSize(format, width, height);
+			if (offset + levelSize > size) {
+				LOG_WARN("DDS file \"{}\" is truncated", file);
+				return nullptr;
+			}
+			MipLevel level;
+			level.Width = width;
+			level.Height = height;
+			level.Data.assign(data + offset, data + offset + levelSize);
+			result->_levels.push_back(std::move(level));
+
+			offset += levelSize;
+			width = std::max(width / 2, 1u);
+			height = std::max(height / 2, 1u);
+		}
+
+		return result;
+	}
+	catch (const std::runtime_error& e) {
+		LOG_WARN("Failed to read DDS file \"{}\": {}", file, e.what());
+		return nullptr;
+	}
+}
+
+bool CompressedTextureData::SaveToDDS(const std::string& file) const {
+	DDSHeader header = {};
+	header.Size = sizeof(DDSHeader);
+	header.Flags = DDS_FLAGS;
+	header.Height = _height;
+	header.Width = _width;
+	header.PitchOrLinearSize = static_cast<uint32_t>(GetLevelDataSize(_format, _width, _height));
+	header.MipMapCount = GetLevelCount();
+	header.PixelFormat.Size = sizeof(DDSPixelFormat);
+	header.PixelFormat.Flags = DDPF_FOURCC;
+	header.PixelFormat.FourCC = DDS_FOURCC_DX10;
+	header.Caps = DDSCAPS_TEXTURE | (_levels.size() > 1 ? DDSCAPS_COMPLEX | DDSCAPS_MIPMAP : 0);
+
+	DDSHeaderDX10 header10 = {};
+	header10.DxgiFormat = GetDxgiFormat(_format);
+	header10.ResourceDimension = DDS_DIMENSION_TEXTURE2D;
+	header10.ArraySize = 1;
+
+	// Note that our rows are stored bottom to top as OpenGL expects, so other tools will show the image upside down
+	std::ofstream stream(file, std::ios::binary | std::ios::trunc);
+	if (!stream) {
+		LOG_WARN("Failed to open DDS file \"{}\" for writing", file);
+		return false;
+	}
+	stream.write(reinterpret_cast<const char*>(&DDS_MAGIC), sizeof(uint32_t));
+	stream.write(reinterpret_cast<const char*>(&header), sizeof(DDSHeader));
+	stream.write(reinterpret_cast<const char*>(&header10), sizeof(DDSHeaderDX10));
+	for (const MipLevel& level : _levels) {
+		stream.write(reinterpret_cast<const char*>(level.Data.data()), level.Data.size());
+	}
+	if (!stream) {
+		LOG_WARN("Failed to write DDS file \"{}\"", file);
+		return false;
+	}
+	return true;
+}
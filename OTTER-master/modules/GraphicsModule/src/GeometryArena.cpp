@@ -0,0 +1,323 @@
+#include "GeometryArena.h"
+
+#include <algorithm>
+
+#include "Logging.h"
+
+// Index blocks start on a 4 byte boundary, so that 32 bit indices stay aligned after 16 bit ones
+static const size_t INDEX_ALIGNMENT = 4;
+
+GeometryAllocation::GeometryAllocation(const std::shared_ptr<GeometryArena>& arena) :
+	_arena(arena),
+	_baseVertex(0),
+	_vertexCount(0),
+	_indexOffset(0),
+	_indexBytes(0),
+	_indexCount(0),
+	_indexType(GL_UNSIGNED_INT)
+{ }
+
+GeometryAllocation::~GeometryAllocation() {
+	if (_arena != nullptr) {
+		_arena->_Free(this);
+	}
+}
+
+size_t GeometryAllocation::GetTotalSize() const {
+	return _vertexCount * _arena->GetVertexStride() + _indexBytes;
+}
+
+void GeometryAllocation::Draw() const {
+	Draw(0, static_cast<uint32_t>(_indexCount));
+}
+
+void GeometryAllocation::Draw(uint32_t firstIndex, uint32_t indexCount) const {
+	VertexArrayObject::BindHandle(_arena->GetVaoHandle());
+	const size_t indexSize = _indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+	const size_t offset = _indexOffset + static_cast<size_t>(firstIndex) * indexSize;
+	glDrawElementsBaseVertex(GL_TRIANGLES, indexCount, _indexType, reinterpret_cast<const void*>(offset), static_cast<GLint>(_baseVertex));
+}
+
+void GeometryAllocation::DrawInstanced(uint32_t firstIndex, uint32_t indexCount, const InstanceBuffer& instances, uint32_t baseInstance, uint32_t instanceCount) const {
+	if (instanceCount == 0) {
+		return;
+	}
+	// Every mesh in the arena shares it's VAO, so the instance attributes need to be pointed at our buffer each time,
+	// and detached again afterwards so that regular draws from the arena don't keep them enabled
+	instances.AttachTo(_arena->GetVaoHandle());
+	VertexArrayObject::BindHandle(_arena->GetVaoHandle());
+	const size_t indexSize = _indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+	const size_t offset = _indexOffset + static_cast<size_t>(firstIndex) * indexSize;
+	glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, indexCount, _indexType, reinterpret_cast<const void*>(offset),
+		instanceCount, static_cast<GLint>(_baseVertex), baseInstance);
+	InstanceBuffer::DetachFrom(_arena->GetVaoHandle());
+}
+
+GeometryArena::GeometryArena(const std::vector<BufferAttribute>& attributes, size_t vertexStride) :
+	_attributes(attributes),
+	_vertexStride(vertexStride),
+	_vao(0),
+	_vertexBuffer(nullptr),
+	_indexBuffer(nullptr),
+	_vertexCapacity(0),
+	_indexCapacity(0),
+	_stats(Stats())
+{
+	glCreateVertexArrays(1, &_vao);
+	// Every attribute reads from binding 0, which we point at whichever buffer currently holds our vertices
+	for (const BufferAttribute& attrib : _attributes) {
+		glEnableVertexArrayAttrib(_vao, attrib.Slot);
+		glVertexArrayAttribFormat(_vao, attrib.Slot, attrib.Size, attrib.Type, attrib.Normalized, static_cast<GLuint>(attrib.Offset));
+		glVertexArrayAttribBinding(_vao, attrib.Slot, 0);
+	}
+	_Resize(InitialVertexCapacity, InitialIndexCapacity);
+}
+
+GeometryArena::~GeometryArena() {
+	LOG_ASSERT(_allocations.empty(), "Geometry arena destroyed while allocations are still alive!");
+	VertexArrayObject::ForgetHandle(_vao);
+	if (_vao != 0) {
+		glDeleteVertexArrays(1, &_vao);
+		_vao = 0;
+	}
+}
+
+GeometryArena::sptr GeometryArena::Get(const std::vector<BufferAttribute>& attributes, size_t vertexStride) {
+	const std::string key = _GetFormatKey(attributes, vertexStride);
+	std::weak_ptr<GeometryArena>& entry = _arenas[key];
+	sptr result = entry.lock();
+	if (result == nullptr) {
+		result = std::make_shared<GeometryArena>(attributes, vertexStride);
+		entry = result;
+	}
+	return result;
+}
+
+GeometryArena::Stats GeometryArena::GetTotalStats() {
+	Stats result;
+	for (const auto& [key, entry] : _arenas) {
+		sptr arena = entry.lock();
+		if (arena == nullptr) {
+			continue;
+		}
+		const Stats stats = arena->GetStats();
+		result.Allocations     += stats.Allocations;
+		result.VerticesUsed    += stats.VerticesUsed;
+		result.VertexCapacity  += stats.VertexCapacity;
+		result.IndexBytesUsed  += stats.IndexBytesUsed;
+		result.IndexCapacity   += stats.IndexCapacity;
+		result.IndexBytesSaved += stats.IndexBytesSaved;
+		result.Grows           += stats.Grows;
+		result.Compactions     += stats.Compactions;
+	}
+	return result;
+}
+
+GeometryAllocation::sptr GeometryArena::Allocate(const void* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount) {
+	LOG_ASSERT(vertexCount > 0 && indexCount > 0, "Geometry arena allocations need both vertices and indices!");
+
+	// Indices are relative to the base vertex, so any mesh with up to 65536 vertices can use 16 bit indices
+	const bool compact = vertexCount - 1 <= UINT16_MAX;
+	const size_t indexSize = compact ? sizeof(uint16_t) : sizeof(uint32_t);
+	const size_t indexBytes = (indexCount * indexSize + INDEX_ALIGNMENT - 1) / INDEX_ALIGNMENT * INDEX_ALIGNMENT;
+
+	size_t vertexOffset = 0, indexOffset = 0;
+	if (!_TryAllocate(vertexCount, indexBytes, vertexOffset, indexOffset)) {
+		// If there is enough free space but it is split into pieces that are too small, moving everything together is
+		// cheaper than growing, since growing copies the whole buffer and keeps the holes
+		if (_GetFreeSize(_freeVertices) >= vertexCount && _GetFreeSize(_freeIndices) >= indexBytes) {
+			Compact();
+		}
+		if (!_TryAllocate(vertexCount, indexBytes, vertexOffset, indexOffset)) {
+			// Only grow the buffers that are short on space, since vertex and index usage rarely grow at the same rate
+			const size_t vertexFree = _GetFreeSize(_freeVertices);
+			const size_t indexFree = _GetFreeSize(_freeIndices);
+			_Resize(
+				vertexFree >= vertexCount ? _vertexCapacity : std::max(_vertexCapacity * 2, _vertexCapacity - vertexFree + vertexCount),
+				indexFree >= indexBytes ? _indexCapacity : std::max(_indexCapacity * 2, _indexCapacity - indexFree + indexBytes));
+			_stats.Grows++;
+			// Growing keeps the existing holes, so the new space may not be contiguous with the tail; compact if we need to
+			if (!_TryAllocate(vertexCount, indexBytes, vertexOffset, indexOffset)) {
+				Compact();
+				bool success = _TryAllocate(vertexCount, indexBytes, vertexOffset, indexOffset);
+				LOG_ASSERT(success, "Geometry arena failed to allocate after growing!");
+			}
+		}
+	}
+
+	GeometryAllocation::sptr result = std::make_shared<GeometryAllocation>(shared_from_this());
+	result->_baseVertex = vertexOffset;
+	result->_vertexCount = vertexCount;
+	result->_indexOffset = indexOffset;
+	result->_indexBytes = indexBytes;
+	result->_indexCount = indexCount;
+	result->_indexType = compact ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+	_allocations.push_back(result.get());
+
+	glNamedBufferSubData(_vertexBuffer->GetHandle(), vertexOffset * _vertexStride, vertexCount * _vertexStride, vertices);
+	if (compact) {
+		std::vector<uint16_t> narrowed(indices, indices + indexCount);
+		glNamedBufferSubData(_indexBuffer->GetHandle(), indexOffset, indexCount * sizeof(uint16_t), narrowed.data());
+		_stats.IndexBytesSaved += indexCount * (sizeof(uint32_t) - sizeof(uint16_t));
+	} else {
+		glNamedBufferSubData(_indexBuffer->GetHandle(), indexOffset, indexCount * sizeof(uint32_t), indices);
+	}
+	return result;
+}
+
+void GeometryArena::Compact() {
+	// Buffer copies can't overlap within a buffer, so we pack everything into new buffers and then swap them in
+	VertexBuffer::sptr vertexBuffer = VertexBuffer::Create();
+	vertexBuffer->LoadData(nullptr, _vertexStride, _vertexCapacity);
+	IndexBuffer::sptr indexBuffer = IndexBuffer::Create();
+	indexBuffer->LoadData(nullptr, sizeof(uint32_t), _indexCapacity / sizeof(uint32_t), GL_UNSIGNED_INT);
+
+	// Keeping the existing order means allocations made together (ex: all the meshes in a level) stay together
+	std::vector<GeometryAllocation*> order = _allocations;
+	std::sort(order.begin(), order.end(), [](const GeometryAllocation* a, const GeometryAllocation* b) { return a->_baseVertex < b->_baseVertex; });
+	size_t cursor = 0;
+	for (GeometryAllocation* allocation : order) {
+		glCopyNamedBufferSubData(_vertexBuffer->GetHandle(), vertexBuffer->GetHandle(),
+			allocation->_baseVertex * _vertexStride, cursor * _vertexStride, allocation->_vertexCount * _vertexStride);
+		allocation->_baseVertex = cursor;
+		cursor += allocation->_vertexCount;
+	}
+	_freeVertices.clear();
+	_FreeRange(_freeVertices, cursor, _vertexCapacity - cursor);
+
+	std::sort(order.begin(), order.end(), [](const GeometryAllocation* a, const GeometryAllocation* b) { return a->_indexOffset < b->_indexOffset; });
+	cursor = 0;
+	for (GeometryAllocation* allocation : order) {
+		glCopyNamedBufferSubData(_indexBuffer->GetHandle(), indexBuffer->GetHandle(), allocation->_indexOffset, cursor, allocation->_indexBytes);
+		allocation->_indexOffset = cursor;
+		cursor += allocation->_indexBytes;
+	}
+	_freeIndices.clear();
+	_FreeRange(_freeIndices, cursor, _indexCapacity - cursor);
+
+	_SetBuffers(vertexBuffer, indexBuffer);
+	_stats.Compactions++;
+}
+
+GeometryArena::Stats GeometryArena::GetStats() const {
+	Stats result = _stats;
+	result.Allocations = _allocations.size();
+	result.VertexCapacity = _vertexCapacity;
+	result.VerticesUsed = _vertexCapacity - _GetFreeSize(_freeVertices);
+	result.IndexCapacity = _indexCapacity;
+	result.IndexBytesUsed = _indexCapacity - _GetFreeSize(_freeIndices);
+	return result;
+}
+
+std::string GeometryArena::_GetFormatKey(const std::vector<BufferAttribute>& attributes, size_t vertexStride) {
+	std::string result = fmt::format("{}", vertexStride);
+	for (const BufferAttribute& attrib : attributes) {
+		result += fmt::format("|{},{},{},{},{}", attrib.Slot, attrib.Size, attrib.Type, attrib.Normalized, attrib.Offset);
+	}
+	return result;
+}
+
+bool GeometryArena::_AllocateRange(std::vector<Range>& freeList, size_t size, size_t& offset) {
+	// First fit, which keeps the low end of the buffer packed and leaves the large block at the end for big meshes
+	for (auto it = freeList.begin(); it != freeList.end(); it++) {
+		if (it->Size >= size) {
+			offset = it->Offset;
+			it->Offset += size;
+			it->Size -= size;
+			if (it->Size == 0) {
+				freeList.erase(it);
+			}
+			return true;
+		}
+	}
+	return false;
+}
+
+void GeometryArena::_FreeRange(std::vector<Range>& freeList, size_t offset, size_t size) {
+	if (size == 0) {
+		return;
+	}
+	auto next = std::lower_bound(freeList.begin(), freeList.end(), offset, [](const Range& range, size_t value) { return range.Offset < value; });
+	// Merge with the blocks on either side when they touch, so the list never holds two adjacent blocks
+	const bool mergePrev = next != freeList.begin() && (next - 1)->Offset + (next - 1)->Size == offset;
+	const bool mergeNext = next != freeList.end() && offset + size == next->Offset;
+	if (mergePrev && mergeNext) {
+		(next - 1)->Size += size + next->Size;
+		freeList.erase(next);
+	} else if (mergePrev) {
+		(next - 1)->Size += size;
+	} else if (mergeNext) {
+		next->Offset = offset;
+		next->Size += size;
+	} else {
+		freeList.insert(next, { offset, size });
+	}
+}
+
+size_t GeometryArena::_GetFreeSize(const std::vector<Range>& freeList) {
+	size_t result = 0;
+	for (const Range& range : freeList) {
+		result += range.Size;
+	}
+	return result;
+}
+
+bool GeometryArena::_TryAllocate(size_t vertexCount, size_t indexBytes, size_t& vertexOffset, size_t& indexOffset) {
+	if (!_AllocateRange(_freeVertices, vertexCount, vertexOffset)) {
+		return false;
+	}
+	if (!_AllocateRange(_freeIndices, indexBytes, indexOffset)) {
+		_FreeRange(_freeVertices, vertexOffset, vertexCount);
+		return false;
+	}
+	return true;
+}
+
+void GeometryArena::_Free(GeometryAllocation* allocation) {
+	auto it = std::find(_allocations.begin(), _allocations.end(), allocation);
+	if (it == _allocations.end()) {
+		return;
+	}
+	_allocations.erase(it);
+	_FreeRange(_freeVertices, allocation->_baseVertex, allocation->_vertexCount);
+	_FreeRange(_freeIndices, allocation->_indexOffset, allocation->_indexBytes);
+	if (allocation->_indexType == GL_UNSIGNED_SHORT) {
+		_stats.IndexBytesSaved -= allocation->_indexCount * (sizeof(uint32_t) - sizeof(uint16_t));
+	}
+}
+
+void GeometryArena::_Resize(size_t vertexCapacity, size_t indexCapacity) {
+	indexCapacity = (indexCapacity + INDEX_ALIGNMENT - 1) / INDEX_ALIGNMENT * INDEX_ALIGNMENT;
+
+	// Only re-create the buffers whose size changes, the other one can be left where it is
+	VertexBuffer::sptr vertexBuffer = _vertexBuffer;
+	if (vertexBuffer == nullptr || vertexCapacity != _vertexCapacity) {
+		vertexBuffer = VertexBuffer::Create();
+		vertexBuffer->LoadData(nullptr, _vertexStride, vertexCapacity);
+		// Existing allocations keep their offsets, so we can copy the old buffer over in one go
+		if (_vertexBuffer != nullptr) {
+			glCopyNamedBufferSubData(_vertexBuffer->GetHandle(), vertexBuffer->GetHandle(), 0, 0, _vertexCapacity * _vertexStride);
+		}
+	}
+	IndexBuffer::sptr indexBuffer = _indexBuffer;
+	if (indexBuffer == nullptr || indexCapacity != _indexCapacity) {
+		indexBuffer = IndexBuffer::Create();
+		indexBuffer->LoadData(nullptr, sizeof(uint32_t), indexCapacity / sizeof(uint32_t), GL_UNSIGNED_INT);
+		if (_indexBuffer != nullptr) {
+			glCopyNamedBufferSubData(_indexBuffer->GetHandle(), indexBuffer->GetHandle(), 0, 0, _indexCapacity);
+		}
+	}
+	_FreeRange(_freeVertices, _vertexCapacity, vertexCapacity - _vertexCapacity);
+	_FreeRange(_freeIndices, _indexCapacity, indexCapacity - _indexCapacity);
+	_vertexCapacity = vertexCapacity;
+	_indexCapacity = indexCapacity;
+
+	_SetBuffers(vertexBuffer, indexBuffer);
+}
+
+void GeometryArena::_SetBuffers(const VertexBuffer::sptr& vertexBuffer, const IndexBuffer::sptr& indexBuffer) {
+	_vertexBuffer = vertexBuffer;
+	_indexBuffer = indexBuffer;
+	glVertexArrayVertexBuffer(_vao, 0, _vertexBuffer->GetHandle(), 0, static_cast<GLsizei>(_vertexStride));
+	glVertexArrayElementBuffer(_vao, _indexBuffer->GetHandle());
+}
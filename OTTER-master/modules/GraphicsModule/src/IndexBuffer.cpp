@@ -0,0 +1,25 @@
+#include "IndexBuffer.h"
+
+#include <algorithm>
+#include <vector>
+
+IndexBuffer::~IndexBuffer() {
+	_SetBytesSaved(0);
+}
+
+void IndexBuffer::LoadCompactData(const uint32_t* data, size_t count, uint32_t maxIndex) {
+	if (maxIndex == UINT32_MAX && count > 0) {
+		maxIndex = *std::max_element(data, data + count);
+	}
+
+	if (maxIndex <= UINT16_MAX) {
+		std::vector<uint16_t> narrowed(data, data + count);
+		IBuffer::LoadData(narrowed.data(), sizeof(uint16_t), count);
+		_elementType = GL_UNSIGNED_SHORT;
+		_SetBytesSaved(count * (sizeof(uint32_t) - sizeof(uint16_t)));
+	} else {
+		IBuffer::LoadData(data, sizeof(uint32_t), count);
+		_elementType = GL_UNSIGNED_INT;
+		_SetBytesSaved(0);
+	}
+}
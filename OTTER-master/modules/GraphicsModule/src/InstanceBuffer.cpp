@@ -0,0 +1,58 @@
+#include "InstanceBuffer.h"
+
+#include <cstddef>
+
+// The vertex buffer binding that our attributes read from. Our other VAOs only use the bindings that match the slots
+// of their attributes (0-3), so we borrow the binding of our first slot
+static const GLuint INSTANCE_BINDING = InstanceBuffer::MODEL_SLOT;
+
+InstanceBuffer::InstanceBuffer() :
+	_instances(std::vector<InstanceData>()),
+	_buffer(VertexBuffer::Create(GL_STREAM_DRAW))
+{ }
+
+uint32_t InstanceBuffer::Add(const glm::mat4& model, const glm::mat3& normalMatrix) {
+	_instances.emplace_back(model, normalMatrix);
+	return static_cast<uint32_t>(_instances.size() - 1);
+}
+
+void InstanceBuffer::Upload() {
+	if (_instances.empty()) {
+		return;
+	}
+	// The instances change every frame, so re-specifying the whole buffer lets the driver orphan the old one
+	// instead of waiting for the last frame's draws to finish
+	_buffer->LoadData(_instances.data(), _instances.size());
+}
+
+void InstanceBuffer::AttachTo(GLuint vao) const {
+	if (_instances.empty()) {
+		return;
+	}
+	// Matrices are passed as one attribute per column
+	for (GLuint col = 0; col < 4; col++) {
+		const GLuint slot = MODEL_SLOT + col;
+		glEnableVertexArrayAttrib(vao, slot);
+		glVertexArrayAttribFormat(vao, slot, 4, GL_FLOAT, false, static_cast<GLuint>(offsetof(InstanceData, Model) + col * sizeof(glm::vec4)));
+		glVertexArrayAttribBinding(vao, slot, INSTANCE_BINDING);
+	}
+	for (GLuint col = 0; col < 3; col++) {
+		const GLuint slot = NORMAL_MATRIX_SLOT + col;
+		glEnableVertexArrayAttrib(vao, slot);
+		glVertexArrayAttribFormat(vao, slot, 3, GL_FLOAT, false, static_cast<GLuint>(offsetof(InstanceData, NormalMatrix) + col * sizeof(glm::vec3)));
+		glVertexArrayAttribBinding(vao, slot, INSTANCE_BINDING);
+	}
+	glVertexArrayBindingDivisor(vao, INSTANCE_BINDING, 1);
+	glVertexArrayVertexBuffer(vao, INSTANCE_BINDING, _buffer->GetHandle(), 0, sizeof(InstanceData));
+}
+
+void InstanceBuffer::DetachFrom(GLuint vao) {
+	for (GLuint col = 0; col < 4; col++) {
+		glDisableVertexArrayAttrib(vao, MODEL_SLOT + col);
+	}
+	for (GLuint col = 0; col < 3; col++) {
+		glDisableVertexArrayAttrib(vao, NORMAL_MATRIX_SLOT + col);
+	}
+	glVertexArrayBindingDivisor(vao, INSTANCE_BINDING, 0);
+	glVertexArrayVertexBuffer(vao, INSTANCE_BINDING, 0, 0, sizeof(InstanceData));
+}
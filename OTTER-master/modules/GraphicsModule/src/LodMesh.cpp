@@ -0,0 +1,59 @@
+#include "LodMesh.h"
+
+#include <algorithm>
+#include <cfloat>
+
+LodMesh::LodMesh() :
+	_vao(VertexArrayObject::Create()),
+	_description(Description())
+{ }
+
+size_t LodMesh::GetTriangleCount(int level) const {
+	if (_description.Levels.empty()) {
+		return 0;
+	}
+	level = std::clamp(level, 0, GetLevelCount() - 1);
+	return _description.Levels[level].IndexCount / 3;
+}
+
+float LodMesh::GetScreenSize(const glm::mat4& world, const glm::vec3& cameraPosition, const glm::mat4& projection) const {
+	const glm::vec3 center = glm::vec3(world * glm::vec4(_description.Center, 1.0f));
+	// Use the largest axis scale, so that the sphere still contains the mesh with non-uniform scaling
+	const float scale = std::max(glm::length(glm::vec3(world[0])), std::max(glm::length(glm::vec3(world[1])), glm::length(glm::vec3(world[2]))));
+	const float radius = _description.Radius * scale;
+	const float distance = glm::length(center - cameraPosition);
+	// The camera is inside the bounding sphere, so the mesh may cover the whole screen
+	if (distance <= radius) {
+		return FLT_MAX;
+	}
+	// projection[1][1] is 1 / tan(fov / 2), which converts a size at the given distance into a fraction of half the screen
+	return radius * projection[1][1] / distance;
+}
+
+int LodMesh::SelectLevel(float screenSize, int currentLevel) const {
+	// Levels are sorted from most to least detail, so their errors are increasing. Moving to a coarser level than the
+	// current one needs the error to be comfortably below the limit, and we only move back once it is comfortably above
+	for (int level = GetLevelCount() - 1; level > 0; level--) {
+		const float limit = MaxScreenError * (level > currentLevel ? 1.0f - Hysteresis : 1.0f + Hysteresis);
+		if (_description.Levels[level].Error * screenSize <= limit) {
+			return level;
+		}
+	}
+	return 0;
+}
+
+void LodMesh::Render(int level) const {
+	if (_description.Levels.empty()) {
+		return;
+	}
+	const Level& selected = _description.Levels[std::clamp(level, 0, GetLevelCount() - 1)];
+	_vao->Render(selected.FirstIndex, selected.IndexCount);
+}
+
+void LodMesh::RenderInstanced(int level, const InstanceBuffer& instances, uint32_t baseInstance, uint32_t instanceCount) const {
+	if (_description.Levels.empty()) {
+		return;
+	}
+	const Level& selected = _description.Levels[std::clamp(level, 0, GetLevelCount() - 1)];
+	_vao->RenderInstanced(selected.FirstIndex, selected.IndexCount, instances, baseInstance, instanceCount);
+}
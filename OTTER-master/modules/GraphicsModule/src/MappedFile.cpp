@@ -0,0 +1,93 @@
+#include "MappedFile.h"
+
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "Logging.h"
+
+MappedFile::MappedFile(const std::string& filename) :
+	_data(nullptr),
+	_size(0),
+	_fileHandle(nullptr),
+	_mapHandle(nullptr)
+{
+#ifdef _WIN32
+	HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		throw std::runtime_error("Failed to open file");
+	}
+	_fileHandle = file;
+
+	LARGE_INTEGER size;
+	GetFileSizeEx(file, &size);
+	_size = static_cast<size_t>(size.QuadPart);
+
+	// Windows will not let us map an empty file, so we just leave the data as null
+	if (_size > 0) {
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping == nullptr) {
+			CloseHandle(file);
+			throw std::runtime_error("Failed to map file");
+		}
+		_mapHandle = mapping;
+		_data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	}
+#else
+	int file = open(filename.c_str(), O_RDONLY);
+	if (file == -1) {
+		throw std::runtime_error("Failed to open file");
+	}
+	_fileHandle = reinterpret_cast<void*>(static_cast<intptr_t>(file));
+
+	struct stat info;
+	fstat(file, &info);
+	_size = static_cast<size_t>(info.st_size);
+
+	if (_size > 0) {
+		void* data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, file, 0);
+		if (data == MAP_FAILED) {
+			close(file);
+			throw std::runtime_error("Failed to map file");
+		}
+		madvise(data, _size, MADV_SEQUENTIAL);
+		_data = static_cast<const char*>(data);
+	}
+#endif
+
+	if (_size > 0 && _data == nullptr) {
+		LOG_WARN("Failed to map view of \"{}\"", filename);
+		_size = 0;
+	}
+}
+
+MappedFile::~MappedFile()
+{
+#ifdef _WIN32
+	if (_data != nullptr) {
+		UnmapViewOfFile(_data);
+	}
+	if (_mapHandle != nullptr) {
+		CloseHandle(_mapHandle);
+	}
+	if (_fileHandle != nullptr) {
+		CloseHandle(_fileHandle);
+	}
+#else
+	if (_data != nullptr) {
+		munmap(const_cast<char*>(_data), _size);
+	}
+	close(static_cast<int>(reinterpret_cast<intptr_t>(_fileHandle)));
+#endif
+	_data = nullptr;
+	_size = 0;
+}
@@ -0,0 +1,163 @@
+#include "MeshCache.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#include "GeometryArena.h"
+#include "HashUtils.h"
+#include "Logging.h"
+#include "MappedFile.h"
+
+namespace fs = std::filesystem;
+
+static const char MESH_CACHE_MAGIC[4] = { 'O', 'T', 'M', 'C' };
+
+uint64_t MeshCache::ComputeKey(const std::string& sourceFile, uint64_t optionsHash) {
+	MappedFile file(sourceFile);
+	uint64_t result = HashFnv1a(file.GetData(), file.GetSize(), optionsHash);
+	// Mix in the version, so that bumping it invalidates every existing entry
+	return HashFnv1a(&VERSION, sizeof(VERSION), result);
+}
+
+std::string MeshCache::_GetCachePath(const std::string& sourceFile, uint64_t key) {
+	std::string name = fs::path(sourceFile).stem().string();
+	return (fs::path(Directory) / fmt::format("{}_{:016x}.mesh", name, key)).string();
+}
+
+VertexArrayObject::sptr MeshCache::_TryLoad(const std::string& sourceFile, uint64_t key, size_t vertexStride, const std::vector<BufferAttribute>& attributes) {
+	std::string path = _GetCachePath(sourceFile, key);
+	if (!fs::exists(path)) {
+		return nullptr;
+	}
+
+	try {
+		MappedFile file(path);
+
+		MeshCacheHeader header;
+		if (!_Validate(path, sourceFile, key, vertexStride, file.GetData(), file.GetSize(), header)) {
+			return nullptr;
+		}
+		const size_t vertexBytes = (size_t)header.VertexCount * header.VertexStride;
+
+		// We can upload straight from the mapping, no need to copy into our own buffers
+		const char* vertices = file.GetData() + sizeof(MeshCacheHeader);
+		const char* indices = vertices + vertexBytes;
+
+		VertexArrayObject::sptr result = VertexArrayObject::Create();
+
+		// The bounds aren't stored in the cache, but they're cheap to recalculate while the vertices are mapped
+		for (const BufferAttribute& attrib : attributes) {
+			if (attrib.Usage == AttribUsage::Position && attrib.Type == GL_FLOAT && attrib.Size >= 3) {
+				result->SetBounds(MeshBounds::Compute(vertices + attrib.Offset, header.VertexCount, header.VertexStride));
+				break;
+			}
+		}
+
+		if (GeometryArena::Enabled && header.VertexCount > 0 && header.IndexCount > 0) {
+			GeometryArena::sptr arena = GeometryArena::Get(attributes, header.VertexStride);
+			result->SetAllocation(arena->Allocate(vertices, header.VertexCount, reinterpret_cast<const uint32_t*>(indices), header.IndexCount));
+			return result;
+		}
+
+		VertexBuffer::sptr vbo = VertexBuffer::Create();
+		vbo->LoadData(vertices, header.VertexStride, header.VertexCount);
+
+		IndexBuffer::sptr ebo = IndexBuffer::Create();
+		ebo->LoadCompactData(reinterpret_cast<const uint32_t*>(indices), header.IndexCount, header.VertexCount == 0 ? 0 : header.VertexCount - 1);
+
+		result->AddVertexBuffer(vbo, attributes);
+		result->SetIndexBuffer(ebo);
+
+		return result;
+	}
+	catch (const std::runtime_error& e) {
+		LOG_WARN("Failed to read mesh cache \"{}\": {}", path, e.what());
+		return nullptr;
+	}
+}
+
+bool MeshCache::_TryLoadData(const std::string& sourceFile, uint64_t key, size_t vertexStride,
+	const std::function<void(const char* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount)>& copy) {
+	std::string path = _GetCachePath(sourceFile, key);
+	if (!fs::exists(path)) {
+		return false;
+	}
+
+	try {
+		MappedFile file(path);
+
+		MeshCacheHeader header;
+		if (!_Validate(path, sourceFile, key, vertexStride, file.GetData(), file.GetSize(), header)) {
+			return false;
+		}
+
+		const char* vertices = file.GetData() + sizeof(MeshCacheHeader);
+		const char* indices = vertices + (size_t)header.VertexCount * header.VertexStride;
+		copy(vertices, header.VertexCount, reinterpret_cast<const uint32_t*>(indices), header.IndexCount);
+		return true;
+	}
+	catch (const std::runtime_error& e) {
+		LOG_WARN("Failed to read mesh cache \"{}\": {}", path, e.what());
+		return false;
+	}
+}
+
+bool MeshCache::_Validate(const std::string& path, const std::string& sourceFile, uint64_t key, size_t vertexStride, const char* data, size_t size, MeshCacheHeader& header) {
+	// Validate the header before trusting any of the sizes in it
+	if (size < sizeof(MeshCacheHeader)) {
+		LOG_WARN("Mesh cache \"{}\" is truncated, ignoring", path);
+		return false;
+	}
+	memcpy(&header, data, sizeof(MeshCacheHeader));
+	const size_t vertexBytes = (size_t)header.VertexCount * header.VertexStride;
+	const size_t indexBytes = (size_t)header.IndexCount * sizeof(uint32_t);
+	if (memcmp(header.Magic, MESH_CACHE_MAGIC, 4) != 0 || header.Version != VERSION ||
+		header.Key != key || header.VertexStride != vertexStride ||
+		size != sizeof(MeshCacheHeader) + vertexBytes + indexBytes) {
+		LOG_WARN("Mesh cache \"{}\" does not match the source \"{}\", ignoring", path, sourceFile);
+		return false;
+	}
+	return true;
+}
+
+void MeshCache::_Store(const std::string& sourceFile, uint64_t key, size_t vertexStride, const void* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount) {
+	std::string path = _GetCachePath(sourceFile, key);
+	std::string tempPath = path + ".tmp";
+
+	std::error_code error;
+	fs::create_directories(Directory, error);
+
+	MeshCacheHeader header;
+	memcpy(header.Magic, MESH_CACHE_MAGIC, 4);
+	header.Version = VERSION;
+	header.Key = key;
+	header.VertexStride = static_cast<uint32_t>(vertexStride);
+	header.VertexCount = static_cast<uint32_t>(vertexCount);
+	header.IndexCount = static_cast<uint32_t>(indexCount);
+	header.Reserved = 0;
+
+	// Write to a temporary file first, so that a partially written cache is never picked up
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file) {
+			LOG_WARN("Failed to open mesh cache \"{}\" for writing", tempPath);
+			return;
+		}
+		file.write(reinterpret_cast<const char*>(&header), sizeof(MeshCacheHeader));
+		file.write(static_cast<const char*>(vertices), vertexCount * vertexStride);
+		file.write(reinterpret_cast<const char*>(indices), indexCount * sizeof(uint32_t));
+		if (!file) {
+			LOG_WARN("Failed to write mesh cache \"{}\"", tempPath);
+			file.close();
+			fs::remove(tempPath, error);
+			return;
+		}
+	}
+
+	fs::rename(tempPath, path, error);
+	if (error) {
+		LOG_WARN("Failed to move mesh cache into place at \"{}\": {}", path, error.message());
+		fs::remove(tempPath, error);
+	}
+}
@@ -90,65 +90,110 @@ Vertex CalculateSphereVert(glm::vec3 norm, glm::vec3 scale, glm::vec3 center) {
 	return vert;
 }
 
+// The corners of an icosahedron, these are normalized by CalculateSphereVert. 1.618... is the golden ratio
+constexpr float ICOSAHEDRON_VERTS[12][3] = {
+	{ -1.0f,  1.61803398875f, 0.0f }, { 1.0f,  1.61803398875f, 0.0f },
+	{ -1.0f, -1.61803398875f, 0.0f }, { 1.0f, -1.61803398875f, 0.0f },
+
+	{ 0.0f, -1.0f,  1.61803398875f }, { 0.0f, 1.0f,  1.61803398875f },
+	{ 0.0f, -1.0f, -1.61803398875f }, { 0.0f, 1.0f, -1.61803398875f },
+
+	{  1.61803398875f, 0.0f, -1.0f }, {  1.61803398875f, 0.0f, 1.0f },
+	{ -1.61803398875f, 0.0f, -1.0f }, { -1.61803398875f, 0.0f, 1.0f }
+};
+
+// The triangles of an icosahedron, indexing into ICOSAHEDRON_VERTS
+constexpr int ICOSAHEDRON_FACES[20][3] = {
+	// 5 faces around point 0
+	{ 0, 11, 5 }, { 0, 5, 1 }, { 0, 1, 7 }, { 0, 7, 10 }, { 0, 10, 11 },
+	// 5 adjacent faces
+	{ 1, 5, 9 }, { 5, 11, 4 }, { 11, 10, 2 }, { 10, 7, 6 }, { 7, 1, 8 },
+	// 5 faces around point 3
+	{ 3, 9, 4 }, { 3, 4, 2 }, { 3, 2, 6 }, { 3, 6, 8 }, { 3, 8, 9 },
+	// 5 adjacent faces
+	{ 4, 9, 5 }, { 2, 4, 11 }, { 6, 2, 10 }, { 8, 6, 7 }, { 9, 8, 1 }
+};
+
 void MeshFactory::AddIcoSphere(MeshBuilder<VertexPosNormTexCol>& data, const glm::vec3& center, float radius, int tessellation, const glm::vec4& col) {
 	AddIcoSphere(data, center, glm::vec3(radius), tessellation, col);
 }
 
 void MeshFactory::AddIcoSphere(MeshBuilder<VertexPosNormTexCol>& data, const glm::vec3& center, const glm::vec3& radii, int tessellation, const glm::vec4& col) {
 	LOG_ASSERT(tessellation >= 0, "Tessellation must be greater than zero!");
+	PrimitivePtr sphere = _GetPrimitive(_icoSpheres, tessellation, &MeshFactory::_BuildIcoSphere);
+	_AppendSphere(data, *sphere, center, radii, col);
+}
 
-	uint32_t indexOffset = data.GetVertexCount();
-	uint32_t initialIndex = data.GetIndexCount();
-	std::vector<glm::ivec3> faces;
-
-	uint32_t estimatedFaces = 12 + pow(tessellation + 1, 3);
-
-	float t = (1.0f + sqrtf(5.0f)) / 2.0f;
-
-	data._vertices.emplace_back(CalculateSphereVert(glm::vec3(-1, t, 0), radii, center));
-	data._vertices.emplace_back(CalculateSphereVert(glm::vec3(1, t, 0), radii, center));
-	data._vertices.emplace_back(CalculateSphereVert(glm::vec3(-1, -t, 0), radii, center));
-	data._vertices.emplace_back(CalculateSphereVert(glm::vec3(1, -t, 0), radii, center));
+void MeshFactory::AddUvSphere(MeshBuilder<VertexPosNormTexCol>& data, const glm::vec3& center, float radius, int tessellation, const glm::vec4& col) {
+	AddUvSphere(data, center, glm::vec3(radius), tessellation, col);
+}
 
-	data._vertices.emplace_back(CalculateSphereVert(glm::vec3(0, -1, t), radii, center));
-	data._vertices.emplace_back(CalculateSphereVert(glm::vec3(0, 1, t), radii, center));
-	data._vertices.emplace_back(CalculateSphereVert(glm::vec3(0, -1, -t), radii, center));
-	data._vertices.emplace_back(CalculateSphereVert(glm::vec3(0, 1, -t), radii, center));
+void MeshFactory::AddUvSphere(MeshBuilder<VertexPosNormTexCol>& data, const glm::vec3& center, const glm::vec3& radii, int tessellation, const glm::vec4& col) {
+	LOG_ASSERT(tessellation >= 0, "Tessellation must be greater than zero!");
+	PrimitivePtr sphere = _GetPrimitive(_uvSpheres, tessellation, &MeshFactory::_BuildUvSphere);
+	_AppendSphere(data, *sphere, center, radii, col);
+}
 
-	data._vertices.emplace_back(CalculateSphereVert(glm::vec3(t, 0, -1), radii, center));
-	data._vertices.emplace_back(CalculateSphereVert(glm::vec3(t, 0, 1), radii, center));
-	data._vertices.emplace_back(CalculateSphereVert(glm::vec3(-t, 0, -1), radii, center));
-	data._vertices.emplace_back(CalculateSphereVert(glm::vec3(-t, 0, 1), radii, center));
+void MeshFactory::ClearPrimitiveCache() {
+	std::lock_guard<std::mutex> lock(_primitiveLock);
+	_icoSpheres.clear();
+	_uvSpheres.clear();
+}
 
-	glm::ivec3 iOff = glm::ivec3(indexOffset);
+MeshFactory::PrimitivePtr MeshFactory::_GetPrimitive(std::unordered_map<int, PrimitivePtr>& cache, int tessellation, void(*builder)(UnitPrimitive&, int)) {
+	std::lock_guard<std::mutex> lock(_primitiveLock);
+	auto it = cache.find(tessellation);
+	if (it != cache.end()) {
+		return it->second;
+	}
+	std::shared_ptr<UnitPrimitive> result = std::make_shared<UnitPrimitive>();
+	builder(*result, tessellation);
+	cache[tessellation] = result;
+	return result;
+}
 
-	// 5 faces around point 0
-	faces.emplace_back(iOff + glm::ivec3(0, 11, 5));
-	faces.emplace_back(iOff + glm::ivec3(0, 5, 1));
-	faces.emplace_back(iOff + glm::ivec3(0, 1, 7));
-	faces.emplace_back(iOff + glm::ivec3(0, 7, 10));
-	faces.emplace_back(iOff + glm::ivec3(0, 10, 11));
+void MeshFactory::_AppendSphere(MeshBuilder<VertexPosNormTexCol>& mesh, const UnitPrimitive& primitive, const glm::vec3& center, const glm::vec3& radii, const glm::vec4& col) {
+	const size_t vertexCount = primitive.Vertices.size();
+	const size_t indexCount = primitive.Indices.size();
+	const uint32_t offset = static_cast<uint32_t>(mesh._vertices.size());
+	const size_t firstIndex = mesh._indices.size();
+
+	// Reserving first lets the vectors grow geometrically, so scenes with lots of spheres don't re-allocate for each one
+	mesh.ReserveVertexSpace(vertexCount);
+	mesh.ReserveIndexSpace(indexCount);
+	mesh._vertices.resize(offset + vertexCount);
+	mesh._indices.resize(firstIndex + indexCount);
+
+	// Plain loops over contiguous arrays, so that the compiler can vectorize the transform
+	const Vertex* source = primitive.Vertices.data();
+	Vertex* dest = mesh._vertices.data() + offset;
+	for (size_t ix = 0; ix < vertexCount; ix++) {
+		dest[ix].Position = center + (source[ix].Normal * radii);
+		dest[ix].Normal = source[ix].Normal;
+		dest[ix].UV = source[ix].UV;
+		dest[ix].Color = col;
+	}
 
-	// 5 adjacent faces
-	faces.emplace_back(iOff + glm::ivec3(1, 5, 9));
-	faces.emplace_back(iOff + glm::ivec3(5, 11, 4));
-	faces.emplace_back(iOff + glm::ivec3(11, 10, 2));
-	faces.emplace_back(iOff + glm::ivec3(10, 7, 6));
-	faces.emplace_back(iOff + glm::ivec3(7, 1, 8));
+	const uint32_t* sourceIndices = primitive.Indices.data();
+	uint32_t* destIndices = mesh._indices.data() + firstIndex;
+	for (size_t ix = 0; ix < indexCount; ix++) {
+		destIndices[ix] = sourceIndices[ix] + offset;
+	}
+}
 
-	// 5 faces around point 3
-	faces.emplace_back(iOff + glm::ivec3(3, 9, 4));
-	faces.emplace_back(iOff + glm::ivec3(3, 4, 2));
-	faces.emplace_back(iOff + glm::ivec3(3, 2, 6));
-	faces.emplace_back(iOff + glm::ivec3(3, 6, 8));
-	faces.emplace_back(iOff + glm::ivec3(3, 8, 9));
+void MeshFactory::_BuildIcoSphere(UnitPrimitive& result, int tessellation) {
+	const glm::vec3 scale = glm::vec3(1.0f);
+	const glm::vec3 center = glm::vec3(0.0f);
+	std::vector<Vertex>& vertices = result.Vertices;
 
-	// 5 adjacent faces
-	faces.emplace_back(iOff + glm::ivec3(4, 9, 5));
-	faces.emplace_back(iOff + glm::ivec3(2, 4, 11));
-	faces.emplace_back(iOff + glm::ivec3(6, 2, 10));
-	faces.emplace_back(iOff + glm::ivec3(8, 6, 7));
-	faces.emplace_back(iOff + glm::ivec3(9, 8, 1));
+	std::vector<glm::ivec3> faces;
+	faces.reserve(20);
+	for (const auto& corner : ICOSAHEDRON_VERTS) {
+		vertices.emplace_back(CalculateSphereVert(glm::vec3(corner[0], corner[1], corner[2]), scale, center));
+	}
+	for (const auto& face : ICOSAHEDRON_FACES) {
+		faces.emplace_back(face[0], face[1], face[2]);
+	}
 
 	// Cache used to index our midpoints
 	std::unordered_map<uint64_t, uint32_t> midPointCache;
@@ -156,51 +201,37 @@ void MeshFactory::AddIcoSphere(MeshBuilder<VertexPosNormTexCol>& data, const glm
 	for (int ix = 0; ix < tessellation; ix++)
 	{
 		std::vector<glm::ivec3> tempFaces;
+		tempFaces.reserve(faces.size() * 4);
 		for (auto& indices : faces)
 		{
-			uint32_t a = AddMiddlePoint(indexOffset, radii, center, indices[0], indices[1], data._vertices, midPointCache);
-			uint32_t b = AddMiddlePoint(indexOffset, radii, center, indices[1], indices[2], data._vertices, midPointCache);
-			uint32_t c = AddMiddlePoint(indexOffset, radii, center, indices[2], indices[0], data._vertices, midPointCache);
+			uint32_t a = AddMiddlePoint(0, scale, center, indices[0], indices[1], vertices, midPointCache);
+			uint32_t b = AddMiddlePoint(0, scale, center, indices[1], indices[2], vertices, midPointCache);
+			uint32_t c = AddMiddlePoint(0, scale, center, indices[2], indices[0], vertices, midPointCache);
 
 			tempFaces.emplace_back(glm::ivec3(indices[0], a, c));
 			tempFaces.emplace_back(glm::ivec3(indices[1], b, a));
 			tempFaces.emplace_back(glm::ivec3(indices[2], c, b));
 			tempFaces.emplace_back(glm::ivec3(a, b, c));
 		}
-		faces = tempFaces;
+		faces = std::move(tempFaces);
 	}
 
+	result.Indices.reserve(faces.size() * 3);
 	for (auto& face : faces) {
-		data._indices.push_back(face[0]);
-		data._indices.push_back(face[1]);
-		data._indices.push_back(face[2]);
-	}
-
-	// Apply color to all verts we added
-	for (int ix = indexOffset; ix < data._vertices.size(); ix++) {
-		data._vertices[ix].Color = col;
+		result.Indices.push_back(face[0]);
+		result.Indices.push_back(face[1]);
+		result.Indices.push_back(face[2]);
 	}
 
-	CorrectUVSeams(data._vertices, data._indices, initialIndex);
-
-}
-
-void MeshFactory::AddUvSphere(MeshBuilder<VertexPosNormTexCol>& data, const glm::vec3& center, float radius, int tessellation, const glm::vec4& col) {
-	AddUvSphere(data, center, glm::vec3(radius), tessellation, col);
+	CorrectUVSeams(result.Vertices, result.Indices, 0);
 }
 
-void MeshFactory::AddUvSphere(MeshBuilder<VertexPosNormTexCol>& data, const glm::vec3& center, const glm::vec3& radii, int tessellation, const glm::vec4& col) {
-	LOG_ASSERT(tessellation >= 0, "Tessellation must be greater than zero!");
+void MeshFactory::_BuildUvSphere(UnitPrimitive& result, int tessellation) {
 	int slices = 1 + pow(2, tessellation + 1);
 	int stacks = (slices / 2) + 1;
 
-
-	int numverts = (slices + 1) * (slices - 1) + 2;
-	std::vector<Vertex>& verts = data._vertices;
-
-	uint32_t offset = verts.size();
-	uint32_t initialIndex = data._indices.size();
-	verts.reserve(verts.size() + numverts);
+	std::vector<Vertex>& verts = result.Vertices;
+	verts.reserve((stacks + 1) * (slices + 1));
 
 	float stackAngle, sliceAngle;
 	float x, y, z, xy;
@@ -223,23 +254,17 @@ void MeshFactory::AddUvSphere(MeshBuilder<VertexPosNormTexCol>& data, const glm:
 			vert.Normal.x = x;
 			vert.Normal.y = y;
 			vert.Normal.z = z;
-			vert.Position = center + (vert.Normal * radii);
+			vert.Position = vert.Normal;
 			float u = (float)j / slices;
 			float v = 1.0f - (float)i / stacks;
 			vert.UV = { u, v };
 			verts.push_back(vert);
 		}
 	}
-	verts[offset].UV = { 0.5f, 1.0f };
+	verts[0].UV = { 0.5f, 1.0f };
 	verts[verts.size() - 1].UV = { 0.5f, 0.0f };
 
-	// Apply color to all verts we added
-	for(int ix = offset; ix < verts.size(); ix++) {
-		verts[ix].Color = col;
-	}
-	
-	int numIndices = (slices - 1) * slices * 6;
-	data._indices.reserve(data._indices.size() + numIndices);
+	result.Indices.reserve((stacks - 1) * slices * 6);
 
 	// Body loop
 	int k1, k2;
@@ -251,16 +276,16 @@ void MeshFactory::AddUvSphere(MeshBuilder<VertexPosNormTexCol>& data, const glm:
 		{
 			// Our top loop
 			if (i != 0) {
-				data._indices.push_back(offset + k1);
-				data._indices.push_back(offset + k2);
-				data._indices.push_back(offset + k1 + 1);
+				result.Indices.push_back(k1);
+				result.Indices.push_back(k2);
+				result.Indices.push_back(k1 + 1);
 			}
 
 			// Everything but our bottom loop
 			if (i != (stacks - 1)) {
-				data._indices.push_back(offset + k1 + 1);
-				data._indices.push_back(offset + k2);
-				data._indices.push_back(offset + k2 + 1);
+				result.Indices.push_back(k1 + 1);
+				result.Indices.push_back(k2);
+				result.Indices.push_back(k2 + 1);
 			}
 		}
 	}
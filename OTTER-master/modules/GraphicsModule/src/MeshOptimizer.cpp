@@ -0,0 +1,727 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <GLM/glm.hpp>
+
+#include "VertexDedupTable.h"
+
+// Tunables for Forsyth's vertex scoring, these are the values from the original article
+const size_t FORSYTH_CACHE_SIZE = 32;
+const float FORSYTH_CACHE_DECAY_POWER = 1.5f;
+const float FORSYTH_LAST_TRI_SCORE = 0.75f;
+const float FORSYTH_VALENCE_BOOST_SCALE = 2.0f;
+const float FORSYTH_VALENCE_BOOST_POWER = 0.5f;
+
+/// <summary>
+/// Scores a vertex based on where it is in the simulated LRU cache and how many triangles still need it.
+/// Vertices that are in the cache, and vertices with few triangles left, get higher scores
+/// </summary>
+float ForsythVertexScore(int cachePosition, uint32_t liveTris) {
+	// No triangles need this vertex, so it should not pull any triangles forward
+	if (liveTris == 0) {
+		return -1.0f;
+	}
+	float score = 0.0f;
+	if (cachePosition >= 0) {
+		// The vertices of the last triangle get a fixed score, so that we don't favor re-using the same edge over and over
+		if (cachePosition < 3) {
+			score = FORSYTH_LAST_TRI_SCORE;
+		} else {
+			const float scale = 1.0f / (FORSYTH_CACHE_SIZE - 3);
+			score = powf(1.0f - (cachePosition - 3) * scale, FORSYTH_CACHE_DECAY_POWER);
+		}
+	}
+	// Boost vertices with only a few triangles left, so we finish them off instead of leaving lone triangles behind
+	score += FORSYTH_VALENCE_BOOST_SCALE * powf(static_cast<float>(liveTris), -FORSYTH_VALENCE_BOOST_POWER);
+	return score;
+}
+
+/// <summary>
+/// Adds a triangle to a simulated FIFO cache, returning the number of vertices that missed. A vertex is in the cache
+/// if it was added within the last cacheSize misses, so the cache can be flushed by adding cacheSize + 1 to the timestamp
+/// </summary>
+uint32_t UpdateFifoCache(const uint32_t* tri, size_t cacheSize, std::vector<uint32_t>& timestamps, uint32_t& timestamp) {
+	uint32_t misses = 0;
+	for (int ix = 0; ix < 3; ix++) {
+		if (timestamp - timestamps[tri[ix]] > cacheSize) {
+			timestamps[tri[ix]] = timestamp++;
+			misses++;
+		}
+	}
+	return misses;
+}
+
+/// <summary>
+/// Reads the position at the start of a vertex
+/// </summary>
+glm::vec3 ReadPosition(const void* vertices, size_t stride, uint32_t index) {
+	glm::vec3 result;
+	memcpy(&result, static_cast<const uint8_t*>(vertices) + stride * index, sizeof(glm::vec3));
+	return result;
+}
+
+/// <summary>
+/// Gets the spatial hash cell that a position falls into. When epsilon is 0 we only merge exact matches, so we use
+/// the bits of the position directly. Otherwise, cells are epsilon wide so any match is in one of the 27 neighboring cells
+/// </summary>
+glm::ivec3 GetWeldCell(glm::vec3 position, float epsilon) {
+	glm::ivec3 result;
+	if (epsilon <= 0.0f) {
+		// Adding 0 turns -0 into +0, so that they land in the same cell
+		position += glm::vec3(0.0f);
+		memcpy(&result, &position, sizeof(glm::ivec3));
+	} else {
+		for (int ix = 0; ix < 3; ix++) {
+			double cell = std::floor(static_cast<double>(position[ix]) / epsilon);
+			// Clamping means very distant positions share a cell, which is slower but still correct
+			result[ix] = static_cast<int>(std::min(std::max(cell, -2147483647.0), 2147483647.0));
+		}
+	}
+	return result;
+}
+
+// How much more the border constraint planes count than the surface itself, keeps open edges from shrinking inwards
+const float SIMPLIFY_BORDER_WEIGHT = 10.0f;
+// Collapses in a single pass are allowed up to this many times the error of the collapse that would reach the target,
+// which stops one pass from making a lot of expensive collapses while cheap ones are still being created
+const float SIMPLIFY_PASS_ERROR_SCALE = 1.5f;
+
+/// <summary>
+/// How a position can move during simplification
+/// </summary>
+enum class SimplifyVertexKind : uint8_t {
+	Manifold, // Surrounded by triangles, can collapse onto any neighbor
+	Border,   // On an open edge, can only collapse along the border
+	Locked    // On an attribute seam or non-manifold, never moves
+};
+
+/// <summary>
+/// A symmetric 4x4 error quadric, holding the weighted sum of squared distances to a set of planes. Weight
+/// lets us get back the average squared distance, so that errors are comparable between dense and sparse areas
+/// </summary>
+struct Quadric {
+	float A00, A11, A22, A10, A20, A21;
+	float B0, B1, B2, C;
+	float Weight;
+
+	Quadric() : A00(0.0f), A11(0.0f), A22(0.0f), A10(0.0f), A20(0.0f), A21(0.0f), B0(0.0f), B1(0.0f), B2(0.0f), C(0.0f), Weight(0.0f) {}
+	/// <summary>
+	/// Creates the quadric for the plane dot(normal, p) + distance = 0
+	/// </summary>
+	Quadric(const glm::vec3& n, float distance, float weight) :
+		A00(n.x * n.x * weight), A11(n.y * n.y * weight), A22(n.z * n.z * weight),
+		A10(n.y * n.x * weight), A20(n.z * n.x * weight), A21(n.z * n.y * weight),
+		B0(n.x * distance * weight), B1(n.y * distance * weight), B2(n.z * distance * weight),
+		C(distance * distance * weight), Weight(weight) {}
+
+	Quadric& operator+=(const Quadric& other) {
+		A00 += other.A00; A11 += other.A11; A22 += other.A22;
+		A10 += other.A10; A20 += other.A20; A21 += other.A21;
+		B0 += other.B0; B1 += other.B1; B2 += other.B2;
+		C += other.C;
+		Weight += other.Weight;
+		return *this;
+	}
+
+	/// <summary>
+	/// Gets the average squared distance from p to the planes in this quadric
+	/// </summary>
+	float Evaluate(const glm::vec3& p) const {
+		// p^T A p + 2 B.p + C
+		const float ax = A00 * p.x + A10 * p.y + A20 * p.z;
+		const float ay = A10 * p.x + A11 * p.y + A21 * p.z;
+		const float az = A20 * p.x + A21 * p.y + A22 * p.z;
+		const float result = ax * p.x + ay * p.y + az * p.z + 2.0f * (B0 * p.x + B1 * p.y + B2 * p.z) + C;
+		return Weight > 0.0f ? fabsf(result) / Weight : 0.0f;
+	}
+};
+
+/// <summary>
+/// Checks whether moving the corner 'from' of a triangle to 'to' would flip it over, or fold it close to flipping
+/// </summary>
+bool CollapseFlipsTriangle(const glm::vec3& from, const glm::vec3& to, const glm::vec3& b, const glm::vec3& c) {
+	const glm::vec3 before = glm::cross(b - from, c - from);
+	const glm::vec3 after = glm::cross(b - to, c - to);
+	return glm::dot(before, after) < 0.25f * glm::length(before) * glm::length(after);
+}
+
+MeshOptimizer::CacheStats MeshOptimizer::AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount) {
+	CacheStats result;
+	const size_t triCount = indexCount / 3;
+	if (triCount == 0) {
+		return result;
+	}
+
+	std::vector<uint32_t> timestamps(vertexCount, 0);
+	uint32_t timestamp = static_cast<uint32_t>(AnalysisCacheSize) + 1;
+	size_t misses = 0;
+	for (size_t ix = 0; ix < triCount; ix++) {
+		misses += UpdateFifoCache(indices + ix * 3, AnalysisCacheSize, timestamps, timestamp);
+	}
+
+	// ATVR is relative to the vertices that are actually used, so that unused vertices don't make the ratio look better
+	std::vector<bool> used(vertexCount, false);
+	size_t usedCount = 0;
+	for (size_t ix = 0; ix < triCount * 3; ix++) {
+		if (!used[indices[ix]]) {
+			used[indices[ix]] = true;
+			usedCount++;
+		}
+	}
+
+	result.ACMR = static_cast<float>(misses) / triCount;
+	result.ATVR = static_cast<float>(misses) / usedCount;
+	return result;
+}
+
+size_t MeshOptimizer::GenerateWeldRemap(uint32_t* remap, const void* vertices, size_t vertexCount, size_t stride, float epsilon) {
+	const uint8_t* data = static_cast<const uint8_t*>(vertices);
+	const size_t positionSize = sizeof(glm::vec3);
+	const int range = epsilon > 0.0f ? 1 : 0;
+
+	// Each cell in the spatial hash stores the first unique vertex that landed in it, the rest are chained through next
+	VertexDedupTable<glm::ivec3> cells(vertexCount);
+	std::vector<uint32_t> next(vertexCount, UINT32_MAX);
+	size_t uniqueCount = 0;
+
+	for (uint32_t vertexIx = 0; vertexIx < vertexCount; vertexIx++) {
+		const glm::vec3 position = ReadPosition(vertices, stride, vertexIx);
+		const glm::ivec3 cell = GetWeldCell(position, epsilon);
+
+		// Search the neighboring cells for a unique vertex that we can merge with
+		uint32_t match = UINT32_MAX;
+		for (int z = -range; z <= range && match == UINT32_MAX; z++) {
+			for (int y = -range; y <= range && match == UINT32_MAX; y++) {
+				for (int x = -range; x <= range && match == UINT32_MAX; x++) {
+					uint32_t other = cells.Find(cell + glm::ivec3(x, y, z));
+					for (; other != UINT32_MAX; other = next[other]) {
+						const glm::vec3 delta = glm::abs(ReadPosition(vertices, stride, other) - position);
+						if (delta.x <= epsilon && delta.y <= epsilon && delta.z <= epsilon &&
+							memcmp(data + stride * vertexIx + positionSize, data + stride * other + positionSize, stride - positionSize) == 0) {
+							match = other;
+							break;
+						}
+					}
+				}
+			}
+		}
+
+		if (match != UINT32_MAX) {
+			remap[vertexIx] = match;
+		} else {
+			remap[vertexIx] = vertexIx;
+			uniqueCount++;
+			// Insert the vertex into its cell, linking it in after the first vertex if the cell already exists
+			bool inserted;
+			uint32_t head = cells.FindOrInsert(cell, vertexIx, inserted);
+			if (!inserted) {
+				next[vertexIx] = next[head];
+				next[head] = vertexIx;
+			}
+		}
+	}
+	return uniqueCount;
+}
+
+void MeshOptimizer::OptimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount) {
+	const size_t triCount = indexCount / 3;
+	if (triCount == 0) {
+		return;
+	}
+
+	// Build the list of triangles that use each vertex, the first liveTris entries are the ones that have not been emitted
+	std::vector<uint32_t> offsets(vertexCount + 1, 0);
+	for (size_t ix = 0; ix < triCount * 3; ix++) {
+		offsets[indices[ix] + 1]++;
+	}
+	std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+	std::vector<uint32_t> liveTris(vertexCount);
+	for (size_t ix = 0; ix < vertexCount; ix++) {
+		liveTris[ix] = offsets[ix + 1] - offsets[ix];
+	}
+	std::vector<uint32_t> adjacency(triCount * 3);
+	std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+	for (size_t ix = 0; ix < triCount * 3; ix++) {
+		adjacency[fill[indices[ix]]++] = static_cast<uint32_t>(ix / 3);
+	}
+
+	std::vector<int> cachePositions(vertexCount, -1);
+	std::vector<float> vertexScores(vertexCount);
+	for (size_t ix = 0; ix < vertexCount; ix++) {
+		vertexScores[ix] = ForsythVertexScore(-1, liveTris[ix]);
+	}
+
+	std::vector<float> triScores(triCount);
+	std::vector<bool> emitted(triCount, false);
+	uint32_t best = UINT32_MAX;
+	float bestScore = -1.0f;
+	for (size_t ix = 0; ix < triCount; ix++) {
+		const uint32_t* tri = indices + ix * 3;
+		triScores[ix] = vertexScores[tri[0]] + vertexScores[tri[1]] + vertexScores[tri[2]];
+		if (triScores[ix] > bestScore) {
+			bestScore = triScores[ix];
+			best = static_cast<uint32_t>(ix);
+		}
+	}
+
+	std::vector<uint32_t> result(triCount * 3);
+	uint32_t cache[FORSYTH_CACHE_SIZE + 3];
+	uint32_t newCache[FORSYTH_CACHE_SIZE + 3];
+	size_t cacheCount = 0;
+	size_t cursor = 0;
+
+	for (size_t outIx = 0; outIx < triCount; outIx++) {
+		// If none of the cached vertices have triangles left, we fall back to the next triangle in the input order
+		if (best == UINT32_MAX) {
+			while (emitted[cursor]) {
+				cursor++;
+			}
+			best = static_cast<uint32_t>(cursor);
+		}
+
+		const uint32_t* tri = indices + best * 3;
+		memcpy(&result[outIx * 3], tri, sizeof(uint32_t) * 3);
+		emitted[best] = true;
+
+		// Remove the triangle from the live lists of its vertices
+		for (int corner = 0; corner < 3; corner++) {
+			uint32_t* live = adjacency.data() + offsets[tri[corner]];
+			uint32_t& count = liveTris[tri[corner]];
+			for (uint32_t ix = 0; ix < count; ix++) {
+				if (live[ix] == best) {
+					live[ix] = live[count - 1];
+					count--;
+					break;
+				}
+			}
+		}
+
+		// The triangle's vertices move to the front of the LRU cache, followed by everything that was already in it
+		size_t newCount = 0;
+		for (int corner = 0; corner < 3; corner++) {
+			if (std::find(newCache, newCache + newCount, tri[corner]) == newCache + newCount) {
+				newCache[newCount++] = tri[corner];
+			}
+		}
+		for (size_t ix = 0; ix < cacheCount; ix++) {
+			if (cache[ix] != tri[0] && cache[ix] != tri[1] && cache[ix] != tri[2]) {
+				newCache[newCount++] = cache[ix];
+			}
+		}
+
+		// Update the vertex scores, vertices that were pushed past the end of the cache are no longer in it
+		for (size_t ix = 0; ix < newCount; ix++) {
+			const uint32_t vertex = newCache[ix];
+			cachePositions[vertex] = ix < FORSYTH_CACHE_SIZE ? static_cast<int>(ix) : -1;
+			vertexScores[vertex] = ForsythVertexScore(cachePositions[vertex], liveTris[vertex]);
+		}
+		cacheCount = std::min(newCount, FORSYTH_CACHE_SIZE);
+		memcpy(cache, newCache, sizeof(uint32_t) * cacheCount);
+
+		// Only the triangles touching the vertices we just updated can have changed scores, so we pick the next triangle from those
+		best = UINT32_MAX;
+		bestScore = -1.0f;
+		for (size_t ix = 0; ix < newCount; ix++) {
+			const uint32_t vertex = newCache[ix];
+			const uint32_t* live = adjacency.data() + offsets[vertex];
+			for (uint32_t liveIx = 0; liveIx < liveTris[vertex]; liveIx++) {
+				const uint32_t* other = indices + live[liveIx] * 3;
+				float score = vertexScores[other[0]] + vertexScores[other[1]] + vertexScores[other[2]];
+				triScores[live[liveIx]] = score;
+				if (score > bestScore) {
+					bestScore = score;
+					best = live[liveIx];
+				}
+			}
+		}
+	}
+
+	memcpy(indices, result.data(), sizeof(uint32_t) * result.size());
+}
+
+void MeshOptimizer::OptimizeOverdraw(uint32_t* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t stride, float threshold) {
+	const size_t triCount = indexCount / 3;
+	if (triCount < 2) {
+		return;
+	}
+	const size_t cacheSize = AnalysisCacheSize;
+	std::vector<uint32_t> timestamps(vertexCount, 0);
+	uint32_t timestamp = static_cast<uint32_t>(cacheSize) + 1;
+
+	// Hard boundaries are triangles that miss on all 3 vertices, they share nothing with the triangles before them
+	std::vector<uint32_t> hardClusters;
+	for (size_t ix = 0; ix < triCount; ix++) {
+		if (UpdateFifoCache(indices + ix * 3, cacheSize, timestamps, timestamp) == 3 || ix == 0) {
+			hardClusters.push_back(static_cast<uint32_t>(ix));
+		}
+	}
+
+	// Split the hard clusters further, starting a new cluster whenever the one we're building has an ACMR that is
+	// within threshold of the hard cluster it came from. We flush the cache between clusters, since we don't know
+	// what will be drawn before each cluster once they are sorted
+	std::vector<uint32_t> clusters;
+	for (size_t clusterIx = 0; clusterIx < hardClusters.size(); clusterIx++) {
+		const size_t start = hardClusters[clusterIx];
+		const size_t end = clusterIx + 1 < hardClusters.size() ? hardClusters[clusterIx + 1] : triCount;
+
+		timestamp += static_cast<uint32_t>(cacheSize) + 1;
+		size_t clusterMisses = 0;
+		for (size_t ix = start; ix < end; ix++) {
+			clusterMisses += UpdateFifoCache(indices + ix * 3, cacheSize, timestamps, timestamp);
+		}
+		const float clusterThreshold = threshold * clusterMisses / (end - start);
+
+		timestamp += static_cast<uint32_t>(cacheSize) + 1;
+		clusters.push_back(static_cast<uint32_t>(start));
+		size_t runningMisses = 0, runningTris = 0;
+		for (size_t ix = start; ix < end; ix++) {
+			runningMisses += UpdateFifoCache(indices + ix * 3, cacheSize, timestamps, timestamp);
+			runningTris++;
+			if (static_cast<float>(runningMisses) / runningTris <= clusterThreshold) {
+				clusters.push_back(static_cast<uint32_t>(ix + 1));
+				timestamp += static_cast<uint32_t>(cacheSize) + 1;
+				runningMisses = 0;
+				runningTris = 0;
+			}
+		}
+		// The last split is either the end of the hard cluster, or leaves a few triangles with a poor ACMR
+		// at the end, in both cases we merge the last two clusters
+		if (clusters.back() != start) {
+			clusters.pop_back();
+		}
+	}
+
+	// Find the area weighted centroid and normal of each cluster, and of the whole mesh
+	struct Cluster {
+		glm::vec3 Centroid;
+		glm::vec3 Normal;
+		float     Area;
+		float     SortKey;
+	};
+	std::vector<Cluster> clusterData(clusters.size());
+	glm::vec3 meshCentroid(0.0f);
+	float meshArea = 0.0f;
+	for (size_t clusterIx = 0; clusterIx < clusters.size(); clusterIx++) {
+		const size_t start = clusters[clusterIx];
+		const size_t end = clusterIx + 1 < clusters.size() ? clusters[clusterIx + 1] : triCount;
+		Cluster& cluster = clusterData[clusterIx];
+		cluster.Centroid = glm::vec3(0.0f);
+		cluster.Normal = glm::vec3(0.0f);
+		cluster.Area = 0.0f;
+		for (size_t ix = start; ix < end; ix++) {
+			const glm::vec3 a = ReadPosition(positions, stride, indices[ix * 3 + 0]);
+			const glm::vec3 b = ReadPosition(positions, stride, indices[ix * 3 + 1]);
+			const glm::vec3 c = ReadPosition(positions, stride, indices[ix * 3 + 2]);
+			const glm::vec3 normal = glm::cross(b - a, c - a);
+			const float area = glm::length(normal);
+			cluster.Centroid += (a + b + c) * (area / 3.0f);
+			cluster.Normal += normal;
+			cluster.Area += area;
+		}
+		meshCentroid += cluster.Centroid;
+		meshArea += cluster.Area;
+		cluster.Centroid = cluster.Area > 0.0f ? cluster.Centroid / cluster.Area : cluster.Centroid;
+	}
+	meshCentroid = meshArea > 0.0f ? meshCentroid / meshArea : meshCentroid;
+
+	// Clusters that are far from the center and face away from it are the most likely to occlude the rest of the mesh
+	for (Cluster& cluster : clusterData) {
+		const float normalLength = glm::length(cluster.Normal);
+		cluster.SortKey = normalLength > 0.0f ? glm::dot(cluster.Centroid - meshCentroid, cluster.Normal / normalLength) : 0.0f;
+	}
+	std::vector<uint32_t> order(clusters.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return clusterData[a].SortKey > clusterData[b].SortKey; });
+
+	std::vector<uint32_t> result;
+	result.reserve(triCount * 3);
+	for (uint32_t clusterIx : order) {
+		const size_t start = clusters[clusterIx];
+		const size_t end = clusterIx + 1 < clusters.size() ? clusters[clusterIx + 1] : triCount;
+		result.insert(result.end(), indices + start * 3, indices + end * 3);
+	}
+	memcpy(indices, result.data(), sizeof(uint32_t) * result.size());
+}
+
+/// <summary>
+/// Fills a table with the directed edges between positions used by a triangle list, mapped to the first triangle that
+/// uses them. An edge is open (on a border) when no triangle uses it in the opposite direction
+/// </summary>
+void BuildEdgeTable(VertexDedupTable<glm::uvec2>& edges, const uint32_t* indices, size_t indexCount, const std::vector<uint32_t>& positionIds) {
+	edges.Clear();
+	edges.Reserve(indexCount);
+	for (size_t ix = 0; ix < indexCount; ix++) {
+		const uint32_t from = positionIds[indices[ix]];
+		const uint32_t to = positionIds[indices[ix - ix % 3 + (ix + 1) % 3]];
+		if (from != to) {
+			bool inserted;
+			edges.FindOrInsert(glm::uvec2(from, to), static_cast<uint32_t>(ix / 3), inserted);
+		}
+	}
+}
+
+size_t MeshOptimizer::Simplify(uint32_t* destination, const uint32_t* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t stride,
+	size_t targetIndexCount, float targetError, float* resultError)
+{
+	const size_t triCount = indexCount / 3;
+	if (destination != indices) {
+		memcpy(destination, indices, sizeof(uint32_t) * triCount * 3);
+	}
+	if (resultError != nullptr) {
+		*resultError = 0.0f;
+	}
+	if (triCount == 0 || vertexCount == 0) {
+		return triCount * 3;
+	}
+
+	// Work on positions scaled into a unit cube, so that errors are relative to the size of the mesh
+	glm::vec3 minBounds = ReadPosition(positions, stride, 0);
+	glm::vec3 maxBounds = minBounds;
+	for (uint32_t ix = 1; ix < vertexCount; ix++) {
+		const glm::vec3 position = ReadPosition(positions, stride, ix);
+		minBounds = glm::min(minBounds, position);
+		maxBounds = glm::max(maxBounds, position);
+	}
+	const glm::vec3 size = maxBounds - minBounds;
+	const float extent = std::max(size.x, std::max(size.y, size.z));
+	const float scale = extent > 0.0f ? 1.0f / extent : 1.0f;
+	std::vector<glm::vec3> scaled(vertexCount);
+	for (uint32_t ix = 0; ix < vertexCount; ix++) {
+		scaled[ix] = (ReadPosition(positions, stride, ix) - minBounds) * scale;
+	}
+
+	// Vertices that share a position are a single point in the mesh's topology, so everything below is tracked per
+	// position, using the first vertex with that position as its ID. If more than one of the vertices is used, the
+	// position is on an attribute seam and we lock it so that the seam (and the UV mapping) survives
+	std::vector<uint32_t> positionIds(vertexCount);
+	std::vector<SimplifyVertexKind> kinds(vertexCount, SimplifyVertexKind::Manifold);
+	{
+		std::vector<bool> used(vertexCount, false);
+		for (size_t ix = 0; ix < triCount * 3; ix++) {
+			used[destination[ix]] = true;
+		}
+		VertexDedupTable<glm::ivec3> table(vertexCount);
+		for (uint32_t ix = 0; ix < vertexCount; ix++) {
+			bool inserted = true;
+			positionIds[ix] = used[ix] ? table.FindOrInsert(GetWeldCell(scaled[ix], 0.0f), ix, inserted) : ix;
+			if (!inserted) {
+				kinds[positionIds[ix]] = SimplifyVertexKind::Locked;
+			}
+		}
+	}
+
+	// Build the quadric for each position from the planes of the triangles around it, weighted by the square root of
+	// their area so that the weights are in the same units as the border planes. Open edges get an extra plane that
+	// is perpendicular to the triangle, which keeps the border from moving when the vertices on it collapse
+	VertexDedupTable<glm::uvec2> edges;
+	BuildEdgeTable(edges, destination, triCount * 3, positionIds);
+	std::vector<Quadric> quadrics(vertexCount);
+	std::vector<uint8_t> openEdgeCounts(vertexCount, 0);
+	for (size_t triIx = 0; triIx < triCount; triIx++) {
+		const uint32_t* tri = destination + triIx * 3;
+		const glm::vec3 normal = glm::cross(scaled[tri[1]] - scaled[tri[0]], scaled[tri[2]] - scaled[tri[0]]);
+		const float area = glm::length(normal);
+		const glm::vec3 unitNormal = area > 0.0f ? normal / area : glm::vec3(0.0f);
+		if (area > 0.0f) {
+			const Quadric plane(unitNormal, -glm::dot(unitNormal, scaled[tri[0]]), sqrtf(area));
+			for (int corner = 0; corner < 3; corner++) {
+				quadrics[positionIds[tri[corner]]] += plane;
+			}
+		}
+
+		for (int corner = 0; corner < 3; corner++) {
+			const uint32_t from = positionIds[tri[corner]];
+			const uint32_t to = positionIds[tri[(corner + 1) % 3]];
+			if (from == to) {
+				continue;
+			}
+			// The same directed edge in two triangles means more than two triangles meet at the edge
+			if (edges.Find(glm::uvec2(from, to)) != triIx) {
+				kinds[from] = SimplifyVertexKind::Locked;
+				kinds[to] = SimplifyVertexKind::Locked;
+			}
+			if (edges.Find(glm::uvec2(to, from)) != VertexDedupTable<glm::uvec2>::EMPTY) {
+				continue;
+			}
+
+			// Each vertex on a simple border has exactly one open edge leaving it, anything else is a pinch point
+			if (++openEdgeCounts[from] > 1) {
+				kinds[from] = SimplifyVertexKind::Locked;
+			}
+			for (uint32_t id : { from, to }) {
+				if (kinds[id] == SimplifyVertexKind::Manifold) {
+					kinds[id] = SimplifyVertexKind::Border;
+				}
+			}
+			const glm::vec3 edge = scaled[to] - scaled[from];
+			const float length = glm::length(edge);
+			if (length > 0.0f && area > 0.0f) {
+				const glm::vec3 planeNormal = glm::normalize(glm::cross(edge, unitNormal));
+				const Quadric border(planeNormal, -glm::dot(planeNormal, scaled[from]), length * SIMPLIFY_BORDER_WEIGHT);
+				quadrics[from] += border;
+				quadrics[to] += border;
+			}
+		}
+	}
+
+	// A candidate edge collapse, moving the vertex From onto the position of the vertex To
+	struct Collapse {
+		uint32_t From;
+		uint32_t To;
+		float    Error;
+		bool     OnBorder;
+	};
+
+	const float errorLimit = targetError * targetError;
+	float maxError = 0.0f;
+	size_t resultCount = triCount * 3;
+	std::vector<Collapse> collapses;
+	std::vector<uint32_t> triOffsets(vertexCount + 1);
+	std::vector<uint32_t> triList;
+	std::vector<uint32_t> collapseRemap(vertexCount);
+	std::vector<bool> collapseLocked(vertexCount);
+
+	// Each pass collapses a batch of the cheapest edges that don't touch each other, then rebuilds the triangle list
+	while (resultCount > targetIndexCount) {
+		if (resultCount < triCount * 3) {
+			BuildEdgeTable(edges, destination, resultCount, positionIds);
+		}
+
+		// Find the triangles around each vertex, so we can check collapses for flipped triangles
+		std::fill(triOffsets.begin(), triOffsets.end(), 0);
+		for (size_t ix = 0; ix < resultCount; ix++) {
+			triOffsets[destination[ix] + 1]++;
+		}
+		std::partial_sum(triOffsets.begin(), triOffsets.end(), triOffsets.begin());
+		triList.resize(resultCount);
+		for (size_t ix = 0; ix < resultCount; ix++) {
+			triList[triOffsets[destination[ix]]++] = static_cast<uint32_t>(ix / 3);
+		}
+		// Filling the list advanced each offset to the start of the next vertex, so shift them back
+		std::copy_backward(triOffsets.begin(), triOffsets.end() - 1, triOffsets.end());
+		triOffsets[0] = 0;
+
+		// Find the cheapest direction to collapse each edge in
+		collapses.clear();
+		for (size_t ix = 0; ix < resultCount; ix++) {
+			const uint32_t a = destination[ix];
+			const uint32_t b = destination[ix - ix % 3 + (ix + 1) % 3];
+			const uint32_t idA = positionIds[a];
+			const uint32_t idB = positionIds[b];
+			if (idA == idB) {
+				continue;
+			}
+			const bool open = edges.Find(glm::uvec2(idB, idA)) == VertexDedupTable<glm::uvec2>::EMPTY;
+			// Interior edges are seen from both of their triangles, we only need to look at them once
+			if (!open && idA > idB) {
+				continue;
+			}
+
+			Collapse collapse = { 0, 0, FLT_MAX, false };
+			for (const Collapse& option : { Collapse{ a, b, 0.0f, false }, Collapse{ b, a, 0.0f, false } }) {
+				const SimplifyVertexKind kind = kinds[positionIds[option.From]];
+				if (kind == SimplifyVertexKind::Locked || (kind == SimplifyVertexKind::Border && !open)) {
+					continue;
+				}
+				const float error = quadrics[positionIds[option.From]].Evaluate(scaled[option.To]);
+				if (error < collapse.Error) {
+					collapse = { option.From, option.To, error, kind == SimplifyVertexKind::Border };
+				}
+			}
+			if (collapse.Error <= errorLimit) {
+				collapses.push_back(collapse);
+			}
+		}
+		if (collapses.empty()) {
+			break;
+		}
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse& l, const Collapse& r) { return l.Error < r.Error; });
+
+		// Estimate how many collapses we need to hit the target, a collapse removes 2 triangles, or 1 on a border
+		const size_t trianglesNeeded = (resultCount - targetIndexCount + 2) / 3;
+		size_t goalIx = 0;
+		for (size_t removed = 0; goalIx < collapses.size() - 1 && removed < trianglesNeeded; goalIx++) {
+			removed += collapses[goalIx].OnBorder ? 1 : 2;
+		}
+		const float passLimit = collapses[goalIx].Error * SIMPLIFY_PASS_ERROR_SCALE;
+
+		std::iota(collapseRemap.begin(), collapseRemap.end(), 0);
+		std::fill(collapseLocked.begin(), collapseLocked.end(), false);
+		size_t trianglesRemoved = 0;
+		for (const Collapse& collapse : collapses) {
+			if (trianglesRemoved >= trianglesNeeded || (collapse.Error > passLimit && trianglesRemoved > 0)) {
+				break;
+			}
+			const uint32_t fromId = positionIds[collapse.From];
+			const uint32_t toId = positionIds[collapse.To];
+			if (collapseLocked[fromId] || collapseLocked[toId]) {
+				continue;
+			}
+
+			// The triangles that contain both ends disappear, but the rest of the triangles around From must not flip over
+			bool flips = false;
+			for (uint32_t listIx = triOffsets[collapse.From]; listIx < triOffsets[collapse.From + 1] && !flips; listIx++) {
+				const uint32_t* tri = destination + triList[listIx] * 3;
+				const int corner = tri[0] == collapse.From ? 0 : (tri[1] == collapse.From ? 1 : 2);
+				const uint32_t next = tri[(corner + 1) % 3];
+				const uint32_t prev = tri[(corner + 2) % 3];
+				if (positionIds[next] != toId && positionIds[prev] != toId) {
+					flips = CollapseFlipsTriangle(scaled[collapse.From], scaled[collapse.To], scaled[next], scaled[prev]);
+				}
+			}
+			if (flips) {
+				continue;
+			}
+
+			collapseRemap[collapse.From] = collapse.To;
+			collapseLocked[fromId] = true;
+			collapseLocked[toId] = true;
+			quadrics[toId] += quadrics[fromId];
+			maxError = std::max(maxError, collapse.Error);
+			trianglesRemoved += collapse.OnBorder ? 1 : 2;
+		}
+		if (trianglesRemoved == 0) {
+			break;
+		}
+
+		// Apply the collapses, dropping the triangles that have become degenerate
+		size_t writeIx = 0;
+		for (size_t ix = 0; ix < resultCount; ix += 3) {
+			const uint32_t a = collapseRemap[destination[ix + 0]];
+			const uint32_t b = collapseRemap[destination[ix + 1]];
+			const uint32_t c = collapseRemap[destination[ix + 2]];
+			if (positionIds[a] != positionIds[b] && positionIds[b] != positionIds[c] && positionIds[c] != positionIds[a]) {
+				destination[writeIx++] = a;
+				destination[writeIx++] = b;
+				destination[writeIx++] = c;
+			}
+		}
+		resultCount = writeIx;
+	}
+
+	if (resultError != nullptr) {
+		*resultError = sqrtf(maxError);
+	}
+	return resultCount;
+}
+
+size_t MeshOptimizer::GenerateFetchRemap(uint32_t* remap, const uint32_t* indices, size_t indexCount, size_t vertexCount) {
+	std::fill(remap, remap + vertexCount, UINT32_MAX);
+	uint32_t nextIndex = 0;
+	for (size_t ix = 0; ix < indexCount; ix++) {
+		if (remap[indices[ix]] == UINT32_MAX) {
+			remap[indices[ix]] = nextIndex++;
+		}
+	}
+	return nextIndex;
+}
+
+void MeshOptimizer::RemapIndices(uint32_t* indices, size_t indexCount, const uint32_t* remap) {
+	for (size_t ix = 0; ix < indexCount; ix++) {
+		indices[ix] = remap[indices[ix]];
+	}
+}
@@ -0,0 +1,111 @@
+#include "MeshRegistry.h"
+
+#include <filesystem>
+
+#include "AssetMemory.h"
+#include "Logging.h"
+#include "NotObjLoader.h"
+#include "ObjLoader.h"
+
+VertexArrayObject::sptr MeshRegistry::LoadObj(const std::string& filename, const glm::vec4& inColor, VertexFormat format) {
+	return GetOrLoad(GetObjKey(filename, inColor, format), [&]() { return ObjLoader::LoadFromFile(filename, inColor, ObjParseMode::Mapped, format); });
+}
+
+VertexArrayObject::sptr MeshRegistry::LoadNotObj(const std::string& filename) {
+	std::string key = fmt::format("notobj|{}", CanonicalPath(filename));
+	return GetOrLoad(key, [&]() { return NotObjLoader::LoadFromFile(filename); });
+}
+
+std::string MeshRegistry::GetObjKey(const std::string& filename, const glm::vec4& inColor, VertexFormat format) {
+	return fmt::format("obj|{}|{},{},{},{}|{}", CanonicalPath(filename), inColor.r, inColor.g, inColor.b, inColor.a, ~format);
+}
+
+std::string MeshRegistry::GetLodKey(const std::string& meshKey, const LodMesh::Settings& settings) {
+	return fmt::format("{}|lod|{},{},{}", meshKey, settings.LevelCount, settings.Reduction, settings.MaxError);
+}
+
+/// <summary>
+/// Gets the size of the GPU buffers used by a mesh, for the registry statistics
+/// </summary>
+size_t GetMeshBufferSize(const VertexArrayObject& mesh) {
+	return mesh.GetTotalBufferSize();
+}
+size_t GetMeshBufferSize(const LodMesh& mesh) {
+	return mesh.GetVao()->GetTotalBufferSize();
+}
+
+template <typename MeshType>
+std::shared_ptr<MeshType> MeshRegistry::_GetOrLoad(std::unordered_map<std::string, std::weak_ptr<MeshType>>& meshes, const std::string& key,
+	const std::function<std::shared_ptr<MeshType>()>& loader)
+{
+	{
+		std::lock_guard<std::mutex> lock(_lock);
+		auto it = meshes.find(key);
+		if (it != meshes.end()) {
+			std::shared_ptr<MeshType> existing = it->second.lock();
+			if (existing != nullptr) {
+				_stats.Hits++;
+				_stats.BytesSaved += GetMeshBufferSize(*existing);
+				return existing;
+			}
+		}
+	}
+
+	// We don't hold the lock while loading, since loaders may be slow or request other meshes
+	std::shared_ptr<MeshType> result = loader();
+
+	if (result != nullptr) {
+		AssetMemory::Track(key, result);
+	}
+
+	std::lock_guard<std::mutex> lock(_lock);
+	_stats.Misses++;
+	if (result != nullptr) {
+		meshes[key] = result;
+	}
+	return result;
+}
+
+VertexArrayObject::sptr MeshRegistry::GetOrLoad(const std::string& key, const std::function<VertexArrayObject::sptr()>& loader) {
+	return _GetOrLoad(_meshes, key, loader);
+}
+
+LodMesh::sptr MeshRegistry::GetOrLoadLods(const std::string& key, const std::function<LodMesh::sptr()>& loader) {
+	return _GetOrLoad(_lodMeshes, key, loader);
+}
+
+/// <summary>
+/// Removes the entries for meshes that have been freed from one of the registry's maps
+/// </summary>
+template <typename MeshType>
+void PruneExpired(std::unordered_map<std::string, std::weak_ptr<MeshType>>& meshes) {
+	for (auto it = meshes.begin(); it != meshes.end();) {
+		if (it->second.expired()) {
+			it = meshes.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
+
+void MeshRegistry::Prune() {
+	std::lock_guard<std::mutex> lock(_lock);
+	PruneExpired(_meshes);
+	PruneExpired(_lodMeshes);
+}
+
+MeshRegistry::Stats MeshRegistry::GetStats() {
+	std::lock_guard<std::mutex> lock(_lock);
+	return _stats;
+}
+
+void MeshRegistry::ResetStats() {
+	std::lock_guard<std::mutex> lock(_lock);
+	_stats = Stats();
+}
+
+std::string MeshRegistry::CanonicalPath(const std::string& path) {
+	std::error_code error;
+	std::filesystem::path result = std::filesystem::weakly_canonical(path, error);
+	return error ? path : result.string();
+}
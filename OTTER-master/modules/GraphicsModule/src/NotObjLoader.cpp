@@ -4,10 +4,90 @@
 #include <sstream>
 #include <fstream>
 #include <iostream>
+#include <unordered_map>
+#include <GLM/gtc/quaternion.hpp>
 
+#include "HashUtils.h"
+#include "MeshCache.h"
+#include "MeshRegistry.h"
 #include "StringUtils.h"
 
 VertexArrayObject::sptr NotObjLoader::LoadFromFile(const std::string& filename)
+{
+	// If we've loaded this file before, we can skip parsing and generating the geometry entirely
+	uint64_t cacheKey = 0;
+	if (MeshCache::Enabled) {
+		const char loaderName[] = "NotObjLoader";
+		cacheKey = MeshCache::ComputeKey(filename, HashFnv1a(loaderName, sizeof(loaderName)));
+		VertexArrayObject::sptr cached = MeshCache::TryLoad<VertexPosNormTexCol>(filename, cacheKey);
+		if (cached != nullptr) {
+			return cached;
+		}
+	}
+
+	MeshBuilder<VertexPosNormTexCol> mesh;
+	_ParseFile(filename, [&](const Primitive& primitive) {
+		switch (primitive.Type) {
+		case PrimitiveType::Cube:
+			MeshFactory::AddCube(mesh, primitive.Position, primitive.Scale, primitive.EulerDeg, primitive.Color);
+			break;
+		case PrimitiveType::Plane:
+			MeshFactory::AddPlane(mesh, primitive.Position, primitive.Normal, primitive.Tangent, glm::vec2(primitive.Scale), primitive.Color);
+			break;
+		case PrimitiveType::IcoSphere:
+			MeshFactory::AddIcoSphere(mesh, primitive.Position, primitive.Scale, primitive.Tessellation, primitive.Color);
+			break;
+		case PrimitiveType::UvSphere:
+			MeshFactory::AddUvSphere(mesh, primitive.Position, primitive.Scale, primitive.Tessellation, primitive.Color);
+			break;
+		}
+	});
+
+	// Note: with actual OBJ files you're going to run into the issue where faces are composited of different indices
+	// You'll need to keep track of these and create vertex entries for each vertex in the face
+	// If you want to get fancy, you can track which vertices you've already added
+
+	if (MeshCache::Enabled) {
+		MeshCache::Store(filename, cacheKey, mesh);
+	}
+	return mesh.Bake();
+}
+
+std::vector<NotObjLoader::InstancedPrimitive> NotObjLoader::LoadInstancedFromFile(const std::string& filename)
+{
+	std::vector<InstancedPrimitive> result;
+	// Maps the type and tessellation of a primitive to it's index in the result
+	std::unordered_map<int, size_t> lookup;
+
+	_ParseFile(filename, [&](const Primitive& primitive) {
+		// Tessellation only matters for spheres, so cubes and planes always share a single entry
+		bool isSphere = primitive.Type == PrimitiveType::IcoSphere || primitive.Type == PrimitiveType::UvSphere;
+		int tessellation = isSphere ? primitive.Tessellation : 0;
+		int key = (tessellation << 2) | static_cast<int>(primitive.Type);
+
+		auto it = lookup.find(key);
+		if (it == lookup.end()) {
+			InstancedPrimitive entry;
+			entry.Mesh = _GetUnitMesh(primitive.Type, tessellation);
+			switch (primitive.Type) {
+				case PrimitiveType::Cube:      entry.Name = "cube"; break;
+				case PrimitiveType::Plane:     entry.Name = "plane"; break;
+				case PrimitiveType::IcoSphere: entry.Name = "ico " + std::to_string(tessellation); break;
+				case PrimitiveType::UvSphere:  entry.Name = "uv " + std::to_string(tessellation); break;
+			}
+			it = lookup.emplace(key, result.size()).first;
+			result.push_back(std::move(entry));
+		}
+
+		InstancedPrimitive& entry = result[it->second];
+		entry.Transforms.push_back(_GetTransform(primitive));
+		entry.Colors.push_back(primitive.Color);
+	});
+
+	return result;
+}
+
+void NotObjLoader::_ParseFile(const std::string& filename, const std::function<void(const Primitive&)>& callback)
 {
 	// Open our file in binary mode
 	std::ifstream file;
@@ -18,95 +98,128 @@ VertexArrayObject::sptr NotObjLoader::LoadFromFile(const std::string& filename)
 		throw std::runtime_error("Failed to open file");
 	}
 
-	MeshBuilder<VertexPosNormTexCol> mesh;
 	std::string line;
-	
+
 	// Iterate as long as there is content to read
 	while (std::getline(file, line)) {
 		trim(line);
+		Primitive primitive;
+		std::istringstream ss;
+
 		if (line.substr(0, 1) == "#")
 		{
 			// Comment, no-op
+			continue;
 		}
 		else if (line.substr(0, 5) == "cube ") // We can do equality check this way since the left side is a string and not a char*
 		{
-			std::istringstream ss = std::istringstream(line.substr(5));
-			glm::vec3 pos;
-			ss >> pos.x >> pos.y >> pos.z;
-			
-			glm::vec3 scale;
-			ss >> scale.x >> scale.y >> scale.z;
-			
-			glm::vec3 eulerDeg;
-			ss >> eulerDeg.x >> eulerDeg.y >> eulerDeg.z;
-			
-			glm::vec4 color = glm::vec4(1.0f);
-			if (ss.rdbuf()->in_avail() > 0) {
-				ss >> color.r >> color.g >> color.b;
-			}
-			if (ss.rdbuf()->in_avail() > 0) {
-				ss >> color.a;
-			}
-
-			MeshFactory::AddCube(mesh, pos, scale, eulerDeg, color);
-			
+			ss = std::istringstream(line.substr(5));
+			primitive.Type = PrimitiveType::Cube;
+			ss >> primitive.Position.x >> primitive.Position.y >> primitive.Position.z;
+			ss >> primitive.Scale.x >> primitive.Scale.y >> primitive.Scale.z;
+			ss >> primitive.EulerDeg.x >> primitive.EulerDeg.y >> primitive.EulerDeg.z;
 		}
 		else if (line.substr(0, 6) == "plane ")
 		{
-			std::istringstream ss = std::istringstream(line.substr(6));
-			glm::vec3 pos;
-			ss >> pos.x >> pos.y >> pos.z;
-			glm::vec3 normal;
-			ss >> normal.x >> normal.y >> normal.z;
-			glm::vec3 tangent;
-			ss >> tangent.x >> tangent.y >> tangent.z;
-			glm::vec2 size;
-			ss >> size.x >> size.y;
-			glm::vec4 color = glm::vec4(1.0f);
-			if (ss.rdbuf()->in_avail() > 0) {
-				ss >> color.r >> color.g >> color.b;
-			}
-			if (ss.rdbuf()->in_avail() > 0) {
-				ss >> color.a;
-			}
-			
-			MeshFactory::AddPlane(mesh, pos, normal, tangent, size, color);
+			ss = std::istringstream(line.substr(6));
+			primitive.Type = PrimitiveType::Plane;
+			ss >> primitive.Position.x >> primitive.Position.y >> primitive.Position.z;
+			ss >> primitive.Normal.x >> primitive.Normal.y >> primitive.Normal.z;
+			ss >> primitive.Tangent.x >> primitive.Tangent.y >> primitive.Tangent.z;
+			ss >> primitive.Scale.x >> primitive.Scale.y;
 		}
 		else if (line.substr(0, 7) == "sphere ")
 		{
-			std::istringstream ss = std::istringstream(line.substr(7));
+			ss = std::istringstream(line.substr(7));
 
 			std::string mode;
 			ss >> mode;
-
-			int tesselation = 0;
-			ss >> tesselation;
-
-			glm::vec3 pos;
-			ss >> pos.x >> pos.y >> pos.z;
-
-			glm::vec3 radii;
-			ss >> radii.x >> radii.y >> radii.z;
-			
-			glm::vec4 color = glm::vec4(1.0f);
-			if (ss.rdbuf()->in_avail() > 0) {
-				ss >> color.r >> color.g >> color.b;
-			}
-			if (ss.rdbuf()->in_avail() > 0) {
-				ss >> color.a;
-			}
-						
 			if (mode == "ico") {
-				MeshFactory::AddIcoSphere(mesh, pos, radii, tesselation, color);
+				primitive.Type = PrimitiveType::IcoSphere;
 			} else if (mode == "uv") {
-				MeshFactory::AddUvSphere(mesh, pos, radii, tesselation, color);
+				primitive.Type = PrimitiveType::UvSphere;
+			} else {
+				continue;
 			}
+
+			ss >> primitive.Tessellation;
+			ss >> primitive.Position.x >> primitive.Position.y >> primitive.Position.z;
+			ss >> primitive.Scale.x >> primitive.Scale.y >> primitive.Scale.z;
+		}
+		else
+		{
+			continue;
 		}
+
+		// All primitives end with an optional color and alpha
+		if (ss.rdbuf()->in_avail() > 0) {
+			ss >> primitive.Color.r >> primitive.Color.g >> primitive.Color.b;
+		}
+		if (ss.rdbuf()->in_avail() > 0) {
+			ss >> primitive.Color.a;
+		}
+
+		callback(primitive);
 	}
+}
 
-	// Note: with actual OBJ files you're going to run into the issue where faces are composited of different indices
-	// You'll need to keep track of these and create vertex entries for each vertex in the face
-	// If you want to get fancy, you can track which vertices you've already added
+VertexArrayObject::sptr NotObjLoader::_GetUnitMesh(PrimitiveType type, int tessellation)
+{
+	// Unit primitives go through the registry, so every scene that uses one shares the same buffers
+	std::string key = "primitive|";
+	switch (type) {
+		case PrimitiveType::Cube:      key += "cube"; break;
+		case PrimitiveType::Plane:     key += "plane"; break;
+		case PrimitiveType::IcoSphere: key += "ico|" + std::to_string(tessellation); break;
+		case PrimitiveType::UvSphere:  key += "uv|" + std::to_string(tessellation); break;
+	}
 
-	return mesh.Bake();
+	return MeshRegistry::GetOrLoad(key, [&]() {
+		MeshBuilder<VertexPosNormTexCol> mesh;
+		switch (type) {
+		case PrimitiveType::Cube:
+			MeshFactory::AddCube(mesh, glm::mat4(1.0f));
+			break;
+		case PrimitiveType::Plane:
+			// A 1x1 plane in XY facing +Z, which _GetTransform maps onto the plane's tangent, binormal and normal
+			MeshFactory::AddPlane(mesh, glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec2(1.0f));
+			break;
+		case PrimitiveType::IcoSphere:
+			MeshFactory::AddIcoSphere(mesh, glm::vec3(0.0f), 1.0f, tessellation);
+			break;
+		case PrimitiveType::UvSphere:
+			MeshFactory::AddUvSphere(mesh, glm::vec3(0.0f), 1.0f, tessellation);
+			break;
+		}
+		VertexArrayObject::sptr result = mesh.Bake();
+		result->SetDebugName(key);
+		return result;
+	});
+}
+
+glm::mat4 NotObjLoader::_GetTransform(const Primitive& primitive)
+{
+	switch (primitive.Type) {
+		case PrimitiveType::Cube:
+			// Matches the transform that MeshFactory::AddCube builds
+			return glm::translate(glm::mat4(1.0f), primitive.Position) *
+				glm::mat4(glm::quat(glm::radians(primitive.EulerDeg))) *
+				glm::scale(glm::mat4(1.0f), primitive.Scale);
+		case PrimitiveType::Plane:
+		{
+			// Matches the corners that MeshFactory::AddPlane calculates
+			glm::vec3 normal = glm::normalize(primitive.Normal);
+			glm::vec3 tangent = glm::normalize(primitive.Tangent);
+			glm::vec3 binormal = glm::cross(normal, tangent);
+			return glm::mat4(
+				glm::vec4(tangent * primitive.Scale.x, 0.0f),
+				glm::vec4(binormal * primitive.Scale.y, 0.0f),
+				glm::vec4(normal, 0.0f),
+				glm::vec4(primitive.Position, 1.0f));
+		}
+		case PrimitiveType::IcoSphere:
+		case PrimitiveType::UvSphere:
+		default:
+			return glm::translate(glm::mat4(1.0f), primitive.Position) * glm::scale(glm::mat4(1.0f), primitive.Scale);
+	}
 }
@@ -4,12 +4,174 @@
 #include <sstream>
 #include <fstream>
 #include <iostream>
-#include <unordered_map>
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <future>
+#include <thread>
 
+#include "Logging.h"
+#include "MappedFile.h"
+#include "HashUtils.h"
+#include "MeshCache.h"
 #include "StringUtils.h"
+#include "VertexDedupTable.h"
 
-VertexArrayObject::sptr ObjLoader::LoadFromFile(const std::string& filename, const glm::vec4& inColor)
-{	
+/// <summary>
+/// Stores the attributes and vertex lookup that are shared by all of our parsing modes
+/// </summary>
+struct ObjParseState
+{
+	// Stores attributes
+	std::vector<glm::vec3> Positions;
+	std::vector<glm::vec3> Normals;
+	std::vector<glm::vec2> TextureCoords;
+
+	// Maps a resolved combination of attribute indices to the vertex we created for it, to avoid duplicate vertices
+	VertexDedupTable<glm::ivec3> IndexMap;
+
+	// Stores the vertex indices for the face we are currently reading, re-used between faces
+	std::vector<uint32_t> Edges;
+
+	MeshBuilder<VertexPosNormTexCol>& Mesh;
+	glm::vec4 Color;
+
+	ObjParseState(MeshBuilder<VertexPosNormTexCol>& mesh, const glm::vec4& color) :
+		Mesh(mesh), Color(color) {}
+
+	/// <summary>
+	/// Pre-sizes the vertex lookup, so that it does not need to re-hash while we are reading faces
+	/// </summary>
+	/// <param name="uniqueVertices">An estimate of the number of unique vertices the mesh will have</param>
+	void Reserve(size_t uniqueVertices) {
+		IndexMap.Reserve(uniqueVertices);
+	}
+
+	/// <summary>
+	/// Resolves an attribute index from the file into a 1-based index, or 0 if the attribute is not used.
+	/// The OBJ format can have negative values, which are a reference from the last added attributes (-1 is the last one)
+	/// </summary>
+	static int ResolveIndex(int index, size_t count) {
+		return index < 0 ? static_cast<int>(count) + index + 1 : index;
+	}
+
+	void AddPosition(const glm::vec3& value) { Positions.push_back(value); }
+	void AddNormal(const glm::vec3& value) { Normals.push_back(value); }
+	void AddTextureCoord(const glm::vec2& value) { TextureCoords.push_back(value); }
+
+	/// <summary>
+	/// Adds a vertex to the face we are building, re-using an existing vertex if the combination of
+	/// attributes has already been added to the mesh
+	/// </summary>
+	/// <param name="vertexIndices">The position, UV and normal indices for the vertex, as written in the file</param>
+	void AddFaceVertex(glm::ivec3 vertexIndices) {
+		vertexIndices.x = ResolveIndex(vertexIndices.x, Positions.size());
+		vertexIndices.y = ResolveIndex(vertexIndices.y, TextureCoords.size());
+		vertexIndices.z = ResolveIndex(vertexIndices.z, Normals.size());
+
+		// The lower bounds are checked first, so the indices are never negative when we compare them to the sizes
+		if (vertexIndices.x < 1 || static_cast<size_t>(vertexIndices.x) > Positions.size() ||
+			vertexIndices.y < 0 || static_cast<size_t>(vertexIndices.y) > TextureCoords.size() ||
+			vertexIndices.z < 0 || static_cast<size_t>(vertexIndices.z) > Normals.size()) {
+			throw std::runtime_error("Face references an attribute that does not exist");
+		}
+
+		// Look up the combination of attributes, the index we pass in is the one the vertex will get if it is new
+		bool inserted;
+		uint32_t index = IndexMap.FindOrInsert(vertexIndices, static_cast<uint32_t>(Mesh.GetVertexCount()), inserted);
+
+		if (inserted) {
+			// Construct a new vertex using the indices for the vertex
+			VertexPosNormTexCol vertex;
+			vertex.Position = Positions[vertexIndices.x - 1];
+			vertex.UV = vertexIndices.y != 0 ? TextureCoords[vertexIndices.y - 1] : glm::vec2(0.0f);
+			vertex.Normal = vertexIndices.z != 0 ? Normals[vertexIndices.z - 1] : glm::vec3(0.0f, 0.0f, 1.0f);
+			vertex.Color = Color;
+
+			// Add to the mesh, this will be at the index we stored in the table
+			Mesh.AddVertex(vertex);
+		}
+		// Add to edges list for if we are using quads
+		Edges.push_back(index);
+	}
+
+	/// <summary>
+	/// Triangulates the face we have been building as a fan, and clears the edge list for the next face
+	/// </summary>
+	void EmitFace() {
+		for (size_t ix = 2; ix < Edges.size(); ix++) {
+			Mesh.AddIndexTri(Edges[0], Edges[ix - 1], Edges[ix]);
+		}
+		Edges.clear();
+	}
+};
+
+VertexArrayObject::sptr ObjLoader::LoadFromFile(const std::string& filename, const glm::vec4& inColor, ObjParseMode mode, VertexFormat format)
+{
+	switch (format) {
+		case VertexFormat::Packed:
+			return _LoadFromFile<VertexPosNormTexColPacked>(filename, inColor, mode, format);
+		default:
+			return _LoadFromFile<VertexPosNormTexCol>(filename, inColor, mode, format);
+	}
+}
+
+template <typename VertType>
+VertexArrayObject::sptr ObjLoader::_LoadFromFile(const std::string& filename, const glm::vec4& inColor, ObjParseMode mode, VertexFormat format)
+{
+	// If we've loaded this file with the same color and format before, we can skip parsing entirely
+	uint64_t cacheKey = 0;
+	if (MeshCache::Enabled) {
+		cacheKey = GetCacheKey(filename, inColor, format);
+		VertexArrayObject::sptr cached = MeshCache::TryLoad<VertType>(filename, cacheKey);
+		if (cached != nullptr) {
+			return cached;
+		}
+	}
+
+	// We'll leverage the mesh builder class
+	MeshBuilder<VertexPosNormTexCol> mesh;
+	LoadMeshData(filename, mesh, inColor, mode);
+
+	MeshBuilder<VertType> result = mesh.Convert<VertType>();
+	if (MeshCache::Enabled) {
+		MeshCache::Store(filename, cacheKey, result);
+	}
+	return result.Bake();
+}
+
+uint64_t ObjLoader::GetCacheKey(const std::string& filename, const glm::vec4& inColor, VertexFormat format)
+{
+	const char loaderName[] = "ObjLoader";
+	uint64_t optionsHash = HashFnv1a(&inColor, sizeof(glm::vec4), HashFnv1a(loaderName, sizeof(loaderName)));
+	// Full meshes keep the key they had before we supported other formats, so existing cache entries stay valid
+	if (format != VertexFormat::Full) {
+		optionsHash = HashFnv1a(&format, sizeof(VertexFormat), optionsHash);
+	}
+	return MeshCache::ComputeKey(filename, optionsHash);
+}
+
+void ObjLoader::LoadMeshData(const std::string& filename, MeshBuilder<VertexPosNormTexCol>& mesh, const glm::vec4& inColor, ObjParseMode mode)
+{
+	switch (mode) {
+		case ObjParseMode::Stream:
+			_ParseStream(filename, mesh, inColor);
+			break;
+		case ObjParseMode::Mapped:
+			_ParseMapped(filename, mesh, inColor);
+			break;
+		case ObjParseMode::Parallel:
+			_ParseParallel(filename, mesh, inColor);
+			break;
+		default:
+			LOG_WARN("Unknown OBJ parse mode {}, falling back to Stream", mode);
+			_ParseStream(filename, mesh, inColor);
+			break;
+	}
+}
+
+void ObjLoader::_ParseStream(const std::string& filename, MeshBuilder<VertexPosNormTexCol>& mesh, const glm::vec4& inColor)
+{
 	// Open our file in binary mode
 	std::ifstream file;
 	file.open(filename, std::ios::binary);
@@ -19,21 +181,12 @@ VertexArrayObject::sptr ObjLoader::LoadFromFile(const std::string& filename, con
 		throw std::runtime_error("Failed to open file");
 	}
 
-	// Stores attributes
-	std::vector<glm::vec3> positions;
-	std::vector<glm::vec3> normals;
-	std::vector<glm::vec2> textureCoords;
-
-	// We'll use bitmask keys and a map to avoid duplicate vertices
-	std::unordered_map<uint64_t, uint32_t> indexMap;
-
-	// We'll leverage the mesh builder class
-	MeshBuilder<VertexPosNormTexCol> mesh;
+	ObjParseState state(mesh, inColor);
 
 	// Temporaries for loading data
 	glm::vec3 temp;
 	glm::ivec3 vertexIndices;
-	
+
 	std::string line;
 	// Iterate as long as there is content to read
 	while (file.peek() != EOF) {
@@ -43,87 +196,294 @@ VertexArrayObject::sptr ObjLoader::LoadFromFile(const std::string& filename, con
 		// Load in vertex positions
 		if (command == "v") {
 			file >> temp.x >> temp.y >> temp.z;
-			positions.push_back(temp);
+			state.Positions.push_back(temp);
 		}
 		// Load in vertex normals
 		else if (command == "vn") {
 			file >> temp.x >> temp.y >> temp.z;
-			normals.push_back(temp);
+			state.Normals.push_back(temp);
 		}
 		// Load in UV coordinates
 		else if (command == "vt") {
 			file >> temp.x >> temp.y;
-			textureCoords.push_back(temp);
+			state.TextureCoords.push_back(temp);
 		}
 		// Load in face lines
 		else if (command == "f") {
 			// Read the entire line, trim it, and stuff it into a string stream
 			std::string line;
 			std::getline(file, line);
-			trim(line);			
+			trim(line);
 			std::stringstream stream = std::stringstream(line);
 
-			// We'll store the edges in case we added a quad
-			uint32_t edges[4];
-			int ix = 0;
 			// Iterate over up to 4 sets of attributes
-			for (; ix < 4; ix++) {
+			for (int ix = 0; ix < 4; ix++) {
 				if (stream.peek() != EOF) {
 					// Load in the faces, split up by slashes
 					char tempChar;
 					vertexIndices = glm::ivec3(0);
 					stream >> vertexIndices.x >> tempChar >> vertexIndices.y >> tempChar >> vertexIndices.z;
-					// The OBJ format can have negative values, which are a reference from the last added attributes
-					if (vertexIndices.x < 0) { vertexIndices.x = positions.size() - 1 + vertexIndices.x; }
-					if (vertexIndices.y < 0) { vertexIndices.y = textureCoords.size() - 1 + vertexIndices.y; }
-					if (vertexIndices.z < 0) { vertexIndices.z = normals.size() - 1 + vertexIndices.z; }
-					// We can construct a key using a bitmask of the attribute indices
-					// This let's us quickly look up a combination of attributes to see if it's already been added
-					// Note that this limits us to 2,097,150 unique attributes for positions, normals and textures
-					const uint64_t mask = 0b0'000000000000000000000'000000000000000000000'111111111111111111111;
-					uint64_t key = ((vertexIndices.x & mask) << 42) | ((vertexIndices.y & mask) << 21) | (vertexIndices.z & mask);
-
-					// Find the index associated with the combination of attributes
-					auto it = indexMap.find(key);
-
-					// If it exists, we push the index to our indices
-					if (it != indexMap.end()) {
-						edges[ix] = it->second;
-					}
-					else {
-						// Construct a new vertex using the indices for the vertex
-						VertexPosNormTexCol vertex;
-						vertex.Position = positions[vertexIndices.x - 1];
-						vertex.UV = vertexIndices.y != 0 ? textureCoords[vertexIndices.y - 1] : glm::vec2(0.0f);
-						vertex.Normal = vertexIndices.z != 0 ? normals[vertexIndices.z - 1] : glm::vec3(0.0f, 0.0f, 1.0f);
-						vertex.Color = inColor;
-
-						// Add to the mesh, get index of the added vertex
-						uint32_t index = mesh.AddVertex(vertex);
-						// Cache the index based on our key
-						indexMap[key] = index;
-						// Add index to mesh, and add to edges list for if we are using quads
-						edges[ix] = index;
-					}
+					state.AddFaceVertex(vertexIndices);
 				} else {
 					break;
 				}
 			}
-			// Handling for trangle faces
-			if (ix == 3) {
-				mesh.AddIndexTri(edges[0], edges[1], edges[2]);
+			// Handles both triangle and quad faces
+			state.EmitFace();
+		}
+	}
+}
+
+/// <summary>
+/// Skips spaces and tabs (but not line endings) starting at the given character
+/// </summary>
+inline const char* SkipSpaces(const char* p, const char* end) {
+	while (p < end && (*p == ' ' || *p == '\t')) { p++; }
+	return p;
+}
+
+/// <summary>
+/// Skips to the first character after the next line feed, or the end of the buffer
+/// </summary>
+inline const char* SkipLine(const char* p, const char* end) {
+	const char* lineEnd = static_cast<const char*>(memchr(p, '\n', end - p));
+	return lineEnd != nullptr ? lineEnd + 1 : end;
+}
+
+/// <summary>
+/// Skips over the rest of the current token (anything that is not whitespace)
+/// </summary>
+inline const char* SkipToken(const char* p, const char* end) {
+	while (p < end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') { p++; }
+	return p;
+}
+
+/// <summary>
+/// Parses a single number directly from the buffer, leaving result as zero if there is no valid number
+/// </summary>
+/// <returns>A pointer to the first character after the number</returns>
+template <typename T>
+inline const char* ParseNumber(const char* p, const char* end, T& result) {
+	p = SkipSpaces(p, end);
+	// from_chars does not accept a leading plus sign
+	if (p < end && *p == '+') { p++; }
+	std::from_chars_result parsed = std::from_chars(p, end, result);
+	if (parsed.ec == std::errc::invalid_argument) {
+		result = 0;
+		return SkipToken(p, end);
+	}
+	return parsed.ptr;
+}
+
+/// <summary>
+/// Tokenizes the OBJ text between p and end in place, passing each record to the handler. The handler must
+/// provide AddPosition, AddNormal, AddTextureCoord, AddFaceVertex and EmitFace
+/// </summary>
+template <typename Handler>
+void TokenizeObj(const char* p, const char* end, Handler& handler)
+{
+	// Temporaries for loading data
+	glm::vec3 temp;
+	glm::ivec3 vertexIndices;
+
+	while (p < end) {
+		p = SkipSpaces(p, end);
+		const char* command = p;
+		p = SkipToken(p, end);
+		const size_t commandLength = p - command;
+
+		// Load in vertex positions, normals and UVs
+		if (commandLength == 1 && command[0] == 'v') {
+			p = ParseNumber(p, end, temp.x);
+			p = ParseNumber(p, end, temp.y);
+			p = ParseNumber(p, end, temp.z);
+			handler.AddPosition(temp);
+		}
+		else if (commandLength == 2 && command[0] == 'v' && command[1] == 'n') {
+			p = ParseNumber(p, end, temp.x);
+			p = ParseNumber(p, end, temp.y);
+			p = ParseNumber(p, end, temp.z);
+			handler.AddNormal(temp);
+		}
+		else if (commandLength == 2 && command[0] == 'v' && command[1] == 't') {
+			p = ParseNumber(p, end, temp.x);
+			p = ParseNumber(p, end, temp.y);
+			handler.AddTextureCoord(temp);
+		}
+		// Load in face lines, these can be v, v/vt, v//vn or v/vt/vn, with any number of vertices
+		else if (commandLength == 1 && command[0] == 'f') {
+			p = SkipSpaces(p, end);
+			while (p < end && *p != '\r' && *p != '\n' && *p != '#') {
+				vertexIndices = glm::ivec3(0);
+				p = ParseNumber(p, end, vertexIndices.x);
+				if (p < end && *p == '/') {
+					p++;
+					if (p < end && *p != '/') {
+						p = ParseNumber(p, end, vertexIndices.y);
+					}
+					if (p < end && *p == '/') {
+						p = ParseNumber(p + 1, end, vertexIndices.z);
+					}
+				}
+				// Skip anything left over in this token that we could not understand
+				p = SkipSpaces(SkipToken(p, end), end);
+				if (vertexIndices.x != 0) {
+					handler.AddFaceVertex(vertexIndices);
+				}
 			}
-			// Handling for quad faces
-			else if (ix == 4) {
-				mesh.AddIndexTri(edges[0], edges[1], edges[2]);
-				mesh.AddIndexTri(edges[0], edges[2], edges[3]);
+			handler.EmitFace();
+		}
+
+		// Anything else (comments, groups, materials) is ignored
+		p = SkipLine(p, end);
+	}
+}
+
+void ObjLoader::_ParseMapped(const std::string& filename, MeshBuilder<VertexPosNormTexCol>& mesh, const glm::vec4& inColor)
+{
+	// Map the file into memory, this will throw if the file could not be opened
+	MappedFile file(filename);
+
+	ObjParseState state(mesh, inColor);
+	// We don't know the face count until we have read the file, but each unique vertex usually costs at least
+	// a position line and a few face references, so the file size gives us a reasonable upper bound
+	state.Reserve(file.GetSize() / 64);
+	TokenizeObj(file.GetData(), file.GetData() + file.GetSize(), state);
+}
+
+/// <summary>
+/// A single vertex of a face read by an ObjChunk. Negative (relative) indices are resolved against the
+/// attributes in the chunk, and flagged so they can be offset by the attributes in earlier chunks when merging
+/// </summary>
+struct ObjFaceVertex
+{
+	glm::ivec3 Indices;
+	uint8_t    RelativeMask;
+};
+
+/// <summary>
+/// Stores the records that were read from a single chunk of an OBJ file
+/// </summary>
+struct ObjChunk
+{
+	std::vector<glm::vec3> Positions;
+	std::vector<glm::vec3> Normals;
+	std::vector<glm::vec2> TextureCoords;
+
+	// All face vertices in the chunk, and the number of vertices in each face
+	std::vector<ObjFaceVertex> FaceVertices;
+	std::vector<uint32_t>      FaceSizes;
+	uint32_t                   CurrentFaceSize = 0;
+
+	void AddPosition(const glm::vec3& value) { Positions.push_back(value); }
+	void AddNormal(const glm::vec3& value) { Normals.push_back(value); }
+	void AddTextureCoord(const glm::vec2& value) { TextureCoords.push_back(value); }
+
+	void AddFaceVertex(glm::ivec3 vertexIndices) {
+		const size_t counts[3] = { Positions.size(), TextureCoords.size(), Normals.size() };
+		ObjFaceVertex vertex;
+		vertex.RelativeMask = 0;
+		for (int ix = 0; ix < 3; ix++) {
+			if (vertexIndices[ix] < 0) {
+				vertexIndices[ix] = ObjParseState::ResolveIndex(vertexIndices[ix], counts[ix]);
+				vertex.RelativeMask |= 1 << ix;
 			}
 		}
+		vertex.Indices = vertexIndices;
+		FaceVertices.push_back(vertex);
+		CurrentFaceSize++;
 	}
 
-	// Note: with actual OBJ files you're going to run into the issue where faces are composited of different indices
-	// You'll need to keep track of these and create vertex entries for each vertex in the face
-	// If you want to get fancy, you can track which vertices you've already added
+	void EmitFace() {
+		FaceSizes.push_back(CurrentFaceSize);
+		CurrentFaceSize = 0;
+	}
+};
+
+void ObjLoader::_ParseParallel(const std::string& filename, MeshBuilder<VertexPosNormTexCol>& mesh, const glm::vec4& inColor)
+{
+	// Map the file into memory, this will throw if the file could not be opened
+	MappedFile file(filename);
+	const char* data = file.GetData();
+	const size_t size = file.GetSize();
+
+	// Determine how many chunks to split the file into, small files will just use a single chunk
+	size_t chunkCount = std::thread::hardware_concurrency();
+	chunkCount = std::max<size_t>(std::min<size_t>(chunkCount, size / PARALLEL_MIN_CHUNK_SIZE), 1);
 
-	return mesh.Bake();
+	// Split the file into roughly even chunks, moving each split forward to the start of the next line
+	std::vector<const char*> splits(chunkCount + 1);
+	splits[0] = data;
+	splits[chunkCount] = data + size;
+	for (size_t ix = 1; ix < chunkCount; ix++) {
+		splits[ix] = std::max(SkipLine(data + (size * ix) / chunkCount, data + size), splits[ix - 1]);
+	}
+
+	// Tokenize all chunks concurrently, the first chunk will be handled on this thread
+	std::vector<ObjChunk> chunks(chunkCount);
+	std::vector<std::future<void>> tasks;
+	tasks.reserve(chunkCount - 1);
+	for (size_t ix = 1; ix < chunkCount; ix++) {
+		tasks.push_back(std::async(std::launch::async, [&, ix]() {
+			TokenizeObj(splits[ix], splits[ix + 1], chunks[ix]);
+		}));
+	}
+	TokenizeObj(splits[0], splits[1], chunks[0]);
+	// Get will re-throw any exceptions from our worker threads
+	for (auto& task : tasks) {
+		task.get();
+	}
+
+	ObjParseState state(mesh, inColor);
+
+	// Gather all the attributes in file order, tracking where each chunk's attributes begin
+	std::vector<glm::ivec3> bases(chunkCount);
+	size_t totalPositions = 0, totalNormals = 0, totalTextureCoords = 0;
+	for (size_t ix = 0; ix < chunkCount; ix++) {
+		bases[ix] = glm::ivec3(totalPositions, totalTextureCoords, totalNormals);
+		totalPositions += chunks[ix].Positions.size();
+		totalNormals += chunks[ix].Normals.size();
+		totalTextureCoords += chunks[ix].TextureCoords.size();
+	}
+	// Size the vertex lookup from the face count, a mesh can't have more unique vertices than face vertices. Most
+	// meshes share attributes between faces though, so we cap the estimate at the largest attribute count
+	size_t totalFaceVertices = 0;
+	for (const ObjChunk& chunk : chunks) {
+		totalFaceVertices += chunk.FaceVertices.size();
+	}
+	state.Reserve(std::min(totalFaceVertices, std::max({ totalPositions, totalNormals, totalTextureCoords })));
+	state.Positions.reserve(totalPositions);
+	state.Normals.reserve(totalNormals);
+	state.TextureCoords.reserve(totalTextureCoords);
+	for (ObjChunk& chunk : chunks) {
+		state.Positions.insert(state.Positions.end(), chunk.Positions.begin(), chunk.Positions.end());
+		state.Normals.insert(state.Normals.end(), chunk.Normals.begin(), chunk.Normals.end());
+		state.TextureCoords.insert(state.TextureCoords.end(), chunk.TextureCoords.begin(), chunk.TextureCoords.end());
+		chunk.Positions = std::vector<glm::vec3>();
+		chunk.Normals = std::vector<glm::vec3>();
+		chunk.TextureCoords = std::vector<glm::vec2>();
+	}
+
+	// Replay the faces in file order, so that vertices are de-duplicated and ordered exactly as in the serial path
+	for (size_t ix = 0; ix < chunkCount; ix++) {
+		const ObjChunk& chunk = chunks[ix];
+		size_t vertexIx = 0;
+		for (uint32_t faceSize : chunk.FaceSizes) {
+			for (uint32_t corner = 0; corner < faceSize; corner++) {
+				const ObjFaceVertex& vertex = chunk.FaceVertices[vertexIx++];
+				glm::ivec3 indices = vertex.Indices;
+				for (int component = 0; component < 3; component++) {
+					if (vertex.RelativeMask & (1 << component)) {
+						indices[component] += bases[ix][component];
+						// A relative index that points before the start of the file is invalid
+						if (indices[component] < 0) {
+							throw std::runtime_error("Face references an attribute that does not exist");
+						}
+					}
+				}
+				state.AddFaceVertex(indices);
+			}
+			state.EmitFace();
+		}
+	}
 }
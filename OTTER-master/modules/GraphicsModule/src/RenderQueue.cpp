@@ -0,0 +1,134 @@
+#include "RenderQueue.h"
+
+#include <algorithm>
+
+uint64_t RenderQueue::MakeKey(int layer, uint32_t shaderId, uint32_t materialId, uint32_t meshId, int lodLevel, float depth) {
+	const uint64_t layerBits = static_cast<uint64_t>(std::clamp(layer, 0, 0xFF));
+	const uint64_t shaderBits = shaderId & 0x3FF;
+	const uint64_t materialBits = materialId & 0x3FFF;
+	const uint64_t meshBits = meshId & 0x3FFF;
+	const uint64_t lodBits = static_cast<uint64_t>(std::clamp(lodLevel, 0, 3));
+	const uint64_t depthBits = static_cast<uint64_t>(std::clamp(depth, 0.0f, 1.0f) * 0xFFFF);
+	// Transparent draws have to be ordered by depth before anything else, grouping them by state would blend them
+	// in the wrong order
+	if (_transparentLayers[layerBits]) {
+		return (layerBits << 56) | ((0xFFFF - depthBits) << 40) | (shaderBits << 30) | (materialBits << 16) | (meshBits << 2) | lodBits;
+	}
+	return (layerBits << 56) | (shaderBits << 46) | (materialBits << 32) | (meshBits << 18) | (lodBits << 16) | depthBits;
+}
+
+void RenderQueue::SetLayerTransparent(int layer, bool transparent) {
+	_transparentLayers[std::clamp(layer, 0, 0xFF)] = transparent;
+}
+
+bool RenderQueue::IsLayerTransparent(int layer) {
+	return _transparentLayers[std::clamp(layer, 0, 0xFF)];
+}
+
+RenderQueue::RenderQueue() :
+	_items(std::vector<Item>()),
+	_sorted(std::vector<Item>()),
+	_order(std::vector<uint32_t>()),
+	_lastValues(std::vector<uint32_t>()),
+	_keys(std::vector<Item>()),
+	_scratch(std::vector<Item>()),
+	_stats(Stats())
+{ }
+
+void RenderQueue::Reserve(size_t count) {
+	_items.reserve(count);
+	_sorted.reserve(count);
+	_order.reserve(count);
+	_lastValues.reserve(count);
+	_keys.reserve(count);
+	_scratch.reserve(count);
+}
+
+bool RenderQueue::Sort() {
+	const size_t count = _items.size();
+
+	// If the same values were pushed in the same order as last time, try re-using the last order with the new keys.
+	// Both checks are a single linear pass, which is much cheaper than sorting again
+	if (count == _lastValues.size() && count == _order.size()) {
+		bool sameValues = true;
+		for (size_t ix = 0; ix < count && sameValues; ix++) {
+			sameValues = _items[ix].Value == _lastValues[ix];
+		}
+		if (sameValues) {
+			bool stillSorted = true;
+			for (size_t ix = 0; ix < count && stillSorted; ix++) {
+				_sorted[ix] = _items[_order[ix]];
+				stillSorted = ix == 0 || _sorted[ix - 1].Key <= _sorted[ix].Key;
+			}
+			if (stillSorted) {
+				_stats.SkippedSorts++;
+				return false;
+			}
+		}
+	}
+
+	// Sort the keys along with the index they were pushed at, so that we can remember the order for next time
+	_keys.resize(count);
+	for (size_t ix = 0; ix < count; ix++) {
+		_keys[ix] = Item(_items[ix].Key, static_cast<uint32_t>(ix));
+	}
+	RadixSort(_keys, _scratch);
+
+	_order.resize(count);
+	_sorted.resize(count);
+	_lastValues.resize(count);
+	for (size_t ix = 0; ix < count; ix++) {
+		_order[ix] = _keys[ix].Value;
+		_sorted[ix] = _items[_order[ix]];
+		_lastValues[ix] = _items[ix].Value;
+	}
+	_stats.Sorts++;
+	return true;
+}
+
+void RenderQueue::RadixSort(std::vector<Item>& items, std::vector<Item>& scratch) {
+	const size_t count = items.size();
+	if (count < 2) {
+		return;
+	}
+	scratch.resize(count);
+
+	// Build the histograms for all 8 bytes in a single pass over the keys
+	size_t histograms[8][256] = {};
+	for (const Item& item : items) {
+		for (int pass = 0; pass < 8; pass++) {
+			histograms[pass][(item.Key >> (pass * 8)) & 0xFF]++;
+		}
+	}
+
+	Item* source = items.data();
+	Item* dest = scratch.data();
+	for (int pass = 0; pass < 8; pass++) {
+		const int shift = pass * 8;
+		size_t* histogram = histograms[pass];
+
+		// If every key has the same value for this byte, this pass would not change the order
+		if (histogram[(source[0].Key >> shift) & 0xFF] == count) {
+			continue;
+		}
+
+		// Turn the counts into the offset that each bucket starts at
+		size_t offset = 0;
+		for (int bucket = 0; bucket < 256; bucket++) {
+			const size_t bucketCount = histogram[bucket];
+			histogram[bucket] = offset;
+			offset += bucketCount;
+		}
+
+		// Scatter the items into their buckets, which keeps items with the same byte in the same order
+		for (size_t ix = 0; ix < count; ix++) {
+			dest[histogram[(source[ix].Key >> shift) & 0xFF]++] = source[ix];
+		}
+		std::swap(source, dest);
+	}
+
+	// After an odd number of passes the sorted items are in the scratch buffer
+	if (source != items.data()) {
+		items.swap(scratch);
+	}
+}
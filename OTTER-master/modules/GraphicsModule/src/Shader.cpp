@@ -1,12 +1,30 @@
 #include "Shader.h"
 #include "Logging.h"
+#include <algorithm>
 #include <fstream>
 #include <sstream>
 
+UniformId::UniformId(const std::string& name) {
+	std::vector<std::string>& names = _Registry();
+	auto it = std::find(names.begin(), names.end(), name);
+	_index = static_cast<uint32_t>(it - names.begin());
+	if (it == names.end()) {
+		names.push_back(name);
+	}
+}
+
+std::vector<std::string>& UniformId::_Registry() {
+	// Function local so that IDs can safely be created during static initialization
+	static std::vector<std::string> names;
+	return names;
+}
+
 Shader::Shader() :
 	_vs(0),
 	_fs(0),
-	_handle(0)
+	_handle(0),
+	_supportsInstancing(false),
+	_materialBlockSize(0)
 {
 	_handle = glCreateProgram();
 }
@@ -113,6 +131,11 @@ bool Shader::Link()
 			LOG_ERROR("Shader failed to link for an unknown reason!");
 		}
 	}
+	else {
+		_supportsInstancing = glGetAttribLocation(_handle, "inInstanceModel") != -1;
+		_ReflectUniforms();
+		_BindUniformBlocks();
+	}
 	return status != GL_FALSE;
 }
 
@@ -158,19 +181,19 @@ void Shader::SetUniform(int location, const glm::ivec4* value, int count) {
 
 void Shader::SetUniform(int location, const bool* value, int count) {
 	LOG_ASSERT(count == 1, "SetUniform for bools only supports setting single values at a time!");
-	glProgramUniform1i(location, *value, 1);
+	glProgramUniform1i(_handle, location, *value);
 }
 void Shader::SetUniform(int location, const glm::bvec2* value, int count) {
 	LOG_ASSERT(count == 1, "SetUniform for bools only supports setting single values at a time!");
-	glProgramUniform2i(location, value->x, value->y, 1);
+	glProgramUniform2i(_handle, location, value->x, value->y);
 }
 void Shader::SetUniform(int location, const glm::bvec3* value, int count) {
 	LOG_ASSERT(count == 1, "SetUniform for bools only supports setting single values at a time!");
-	glProgramUniform3i(location, value->x, value->y, value->z, 1);
+	glProgramUniform3i(_handle, location, value->x, value->y, value->z);
 }
 void Shader::SetUniform(int location, const glm::bvec4* value, int count) {
 	LOG_ASSERT(count == 1, "SetUniform for bools only supports setting single values at a time!");
-	glProgramUniform4i(location, value->x, value->y, value->z, value->w, 1);
+	glProgramUniform4i(_handle, location, value->x, value->y, value->z, value->w);
 }
 
 int Shader::GetUniformLocation(const std::string& name) {
@@ -178,7 +201,8 @@ int Shader::GetUniformLocation(const std::string& name) {
 	std::unordered_map<std::string, int>::const_iterator it = _uniformLocs.find(name);
 	int result = -1;
 
-	// If our entry was not found, we call glGetUniform and store it for next time
+	// All active uniforms are found when we link, so if our entry was not found we fall back to glGetUniformLocation
+	// (ex: for names that refer to part of an array), and store the result so that misses are only reported once
 	if (it == _uniformLocs.end()) {
 		result = glGetUniformLocation(_handle, name.c_str());
 		_uniformLocs[name] = result;
@@ -193,4 +217,158 @@ int Shader::GetUniformLocation(const std::string& name) {
 	}
 
 	return result;
-}
\ No newline at end of file
+}
+
+void Shader::_ReflectUniforms() {
+	_uniformLocs.clear();
+	_locationsById.clear();
+	_textureUnits.clear();
+	_materialParams.clear();
+	_materialBlockSize = 0;
+
+	// Find the size of our material block, if we have one
+	const GLuint materialBlock = glGetProgramResourceIndex(_handle, GL_UNIFORM_BLOCK, MATERIAL_BLOCK_NAME.c_str());
+	if (materialBlock != GL_INVALID_INDEX) {
+		const GLenum sizeProperty = GL_BUFFER_DATA_SIZE;
+		GLint size = 0;
+		glGetProgramResourceiv(_handle, GL_UNIFORM_BLOCK, materialBlock, 1, &sizeProperty, 1, nullptr, &size);
+		_materialBlockSize = static_cast<size_t>(size);
+	}
+
+	GLint count = 0, maxNameLength = 0;
+	glGetProgramInterfaceiv(_handle, GL_UNIFORM, GL_ACTIVE_RESOURCES, &count);
+	glGetProgramInterfaceiv(_handle, GL_UNIFORM, GL_MAX_NAME_LENGTH, &maxNameLength);
+
+	// Samplers are collected so that we can hand out texture units in the order of their locations
+	std::vector<std::pair<GLint, std::string>> samplers;
+
+	std::vector<char> buffer(std::max(maxNameLength, 1));
+	const GLenum properties[] = { GL_LOCATION, GL_BLOCK_INDEX, GL_OFFSET, GL_TYPE, GL_MATRIX_STRIDE };
+	for (GLint ix = 0; ix < count; ix++) {
+		GLint values[5] = { -1, -1, 0, GL_NONE, 0 };
+		glGetProgramResourceiv(_handle, GL_UNIFORM, ix, 5, properties, 5, nullptr, values);
+		const GLint location = values[0];
+		const GLint blockIndex = values[1];
+		// Uniforms inside of uniform blocks don't have locations, they are set through their buffer. We only need to
+		// know the layout of the material block, since ShaderMaterial packs it for us
+		if (location == -1 && (materialBlock == GL_INVALID_INDEX || blockIndex != static_cast<GLint>(materialBlock))) {
+			continue;
+		}
+
+		GLsizei length = 0;
+		glGetProgramResourceName(_handle, GL_UNIFORM, ix, static_cast<GLsizei>(buffer.size()), &length, buffer.data());
+		std::string name(buffer.data(), length);
+
+		if (location == -1) {
+			UniformBlockMember member;
+			member.Offset = values[2];
+			member.Type = static_cast<GLenum>(values[3]);
+			member.MatrixStride = values[4];
+			_materialParams[name] = member;
+			continue;
+		}
+
+		_uniformLocs[name] = location;
+		if (_IsSamplerType(static_cast<GLenum>(values[3]))) {
+			samplers.emplace_back(location, name);
+		}
+
+		// Arrays are reported as "name[0]", but glGetUniformLocation also accepts just the name, so we do the same
+		if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0) {
+			_uniformLocs[name.substr(0, name.size() - 3)] = location;
+		}
+	}
+
+	// Give each sampler it's own texture unit up front, so that materials only need to bind their textures. Unit 0 is
+	// left free for textures that are bound temporarily (ex: while loading)
+	std::sort(samplers.begin(), samplers.end());
+	int unit = 1;
+	for (const auto& [location, name] : samplers) {
+		glProgramUniform1i(_handle, location, unit);
+		_textureUnits[name] = unit;
+		unit++;
+	}
+}
+
+const UniformBlockMember* Shader::FindMaterialParam(const std::string& name) const {
+	std::unordered_map<std::string, UniformBlockMember>::const_iterator it = _materialParams.find(name);
+	return it != _materialParams.end() ? &it->second : nullptr;
+}
+
+int Shader::GetTextureUnit(const std::string& name) const {
+	std::unordered_map<std::string, int>::const_iterator it = _textureUnits.find(name);
+	return it != _textureUnits.end() ? it->second : -1;
+}
+
+void Shader::_ResolveIds() {
+	// We don't report missing uniforms here, since most shaders won't use every registered uniform. Instead we mark
+	// them so that they get reported the first time they're actually used
+	const std::vector<std::string>& names = UniformId::GetNames();
+	for (size_t ix = _locationsById.size(); ix < names.size(); ix++) {
+		std::unordered_map<std::string, int>::const_iterator it = _uniformLocs.find(names[ix]);
+		_locationsById.push_back(it != _uniformLocs.end() && it->second != -1 ? it->second : MISSING_UNIFORM);
+	}
+}
+
+void Shader::SetUniformBlockBinding(const std::string& blockName, GLuint binding) {
+	LOG_ASSERT(binding != MATERIAL_BLOCK_BINDING, "Binding {} is reserved for the material block!", binding);
+	_BlockBindings()[blockName] = binding;
+}
+
+void Shader::_BindUniformBlocks() {
+	GLint count = 0, maxNameLength = 0;
+	glGetProgramInterfaceiv(_handle, GL_UNIFORM_BLOCK, GL_ACTIVE_RESOURCES, &count);
+	glGetProgramInterfaceiv(_handle, GL_UNIFORM_BLOCK, GL_MAX_NAME_LENGTH, &maxNameLength);
+
+	const std::unordered_map<std::string, GLuint>& bindings = _BlockBindings();
+	std::vector<char> buffer(std::max(maxNameLength, 1));
+	for (GLint ix = 0; ix < count; ix++) {
+		GLsizei length = 0;
+		glGetProgramResourceName(_handle, GL_UNIFORM_BLOCK, ix, static_cast<GLsizei>(buffer.size()), &length, buffer.data());
+		std::string name(buffer.data(), length);
+
+		std::unordered_map<std::string, GLuint>::const_iterator it = bindings.find(name);
+		if (name == MATERIAL_BLOCK_NAME) {
+			glUniformBlockBinding(_handle, ix, MATERIAL_BLOCK_BINDING);
+		} else if (it != bindings.end()) {
+			glUniformBlockBinding(_handle, ix, it->second);
+		} else {
+			LOG_WARN("Uniform block \"{}\" does not have a binding point, it will read from binding 0", name);
+		}
+	}
+}
+
+std::unordered_map<std::string, GLuint>& Shader::_BlockBindings() {
+	// Function local for the same reason as UniformId::_Registry
+	static std::unordered_map<std::string, GLuint> bindings;
+	return bindings;
+}
+
+bool Shader::_IsSamplerType(GLenum type) {
+	switch (type) {
+	case GL_SAMPLER_1D:
+	case GL_SAMPLER_2D:
+	case GL_SAMPLER_3D:
+	case GL_SAMPLER_CUBE:
+	case GL_SAMPLER_1D_SHADOW:
+	case GL_SAMPLER_2D_SHADOW:
+	case GL_SAMPLER_1D_ARRAY:
+	case GL_SAMPLER_2D_ARRAY:
+	case GL_SAMPLER_CUBE_MAP_ARRAY:
+	case GL_SAMPLER_2D_ARRAY_SHADOW:
+	case GL_SAMPLER_CUBE_SHADOW:
+	case GL_SAMPLER_2D_MULTISAMPLE:
+	case GL_SAMPLER_BUFFER:
+	case GL_INT_SAMPLER_2D:
+	case GL_INT_SAMPLER_3D:
+	case GL_INT_SAMPLER_CUBE:
+	case GL_INT_SAMPLER_2D_ARRAY:
+	case GL_UNSIGNED_INT_SAMPLER_2D:
+	case GL_UNSIGNED_INT_SAMPLER_3D:
+	case GL_UNSIGNED_INT_SAMPLER_CUBE:
+	case GL_UNSIGNED_INT_SAMPLER_2D_ARRAY:
+		return true;
+	default:
+		return false;
+	}
+}
@@ -1,5 +1,8 @@
 #include "ShaderMaterial.h"
 
+#include <algorithm>
+#include <cstring>
+
 template<typename T>
 void SubmitUniforms(const Shader::sptr& shader, const std::unordered_map<ShaderParamName, T>& values) {
 	for (auto& kvp : values) {
@@ -15,23 +18,38 @@ void SubmitUniformsMat(const Shader::sptr& shader, const std::unordered_map<Shad
 }
 
 ShaderMaterial::ShaderMaterial()
-	: Shader(nullptr),  RenderLayer(0)
+	: Shader(nullptr),  RenderLayer(0), _id(_nextId++),
+	_textures(), _textureCount(0), _blockData(), _blockDirty(false), _blockSlot(-1)
 {
 }
 
 ShaderMaterial::~ShaderMaterial() {
 	LOG_INFO("Deleting material");
+	if (_blockSlot != -1) {
+		_FreeBlockSlot(_blockSlot);
+	}
 }
 
 void ShaderMaterial::Apply()
 {	
-	int slot = 1;
-	for (auto& kvp : Textures) {
-		if (kvp.first.Location != -1 && kvp.second != nullptr) {
-			Shader->SetUniform(kvp.first.Location, slot);
-			kvp.second->Bind(slot);
-			slot++;
+	// The shader gave each of it's samplers a texture unit when it was linked, so we only need to bind our textures
+	for (int ix = 0; ix < _textureCount; ix++) {
+		if (_textures[ix].Texture != nullptr) {
+			_textures[ix].Texture->Bind(_textures[ix].Unit);
+		}
+	}
+
+	// Our block only needs to be uploaded if a parameter has changed since the last time we were applied
+	if (_blockData.empty() && Shader->GetMaterialBlockSize() > 0) {
+		_InitBlock();
+	}
+	if (_blockSlot != -1) {
+		const size_t offset = _blockSlot * _blockSlotSize;
+		if (_blockDirty) {
+			_blockBuffer->UpdateData(_blockData.data(), offset, _blockData.size());
+			_blockDirty = false;
 		}
+		_blockBuffer->BindRange(Shader::MATERIAL_BLOCK_BINDING, offset, _blockData.size());
 	}
 
 	SubmitUniforms(Shader, FloatParams);
@@ -44,13 +62,39 @@ void ShaderMaterial::Apply()
 
 void ShaderMaterial::Set(const std::string& name, const ITexture::sptr& texture) {
 	LOG_ASSERT(Shader != nullptr, "Must set Material shader before setting params");
-	ShaderParamName pName = name;
-	pName.Location = Shader->GetUniformLocation(name);
-	Textures[pName] = texture;
+	const int unit = Shader->GetTextureUnit(name);
+	if (unit == -1) {
+		// Looking up the location will report the uniform if the shader doesn't have it
+		if (Shader->GetUniformLocation(name) != -1) {
+			LOG_WARN("Uniform \"{}\" is not a sampler, ignoring texture", name);
+		}
+		return;
+	}
+
+	// Keep the textures sorted by unit, replacing the texture if we already have one for this unit
+	int ix = 0;
+	while (ix < _textureCount && _textures[ix].Unit < unit) {
+		ix++;
+	}
+	if (ix == _textureCount || _textures[ix].Unit != unit) {
+		if (_textureCount == MAX_TEXTURES) {
+			LOG_WARN("Material already has {} textures, ignoring \"{}\"", MAX_TEXTURES, name);
+			return;
+		}
+		for (int move = _textureCount; move > ix; move--) {
+			_textures[move] = _textures[move - 1];
+		}
+		_textureCount++;
+		_textures[ix].Unit = unit;
+	}
+	_textures[ix].Texture = texture;
 }
 
 void ShaderMaterial::Set(const std::string& name, float value) {
 	LOG_ASSERT(Shader != nullptr, "Must set Material shader before setting params");
+	if (_SetBlockParam(name, GL_FLOAT, &value, 1, sizeof(float))) {
+		return;
+	}
 	ShaderParamName pName = name;
 	pName.Location = Shader->GetUniformLocation(name);
 	FloatParams[pName] = value;
@@ -58,6 +102,9 @@ void ShaderMaterial::Set(const std::string& name, float value) {
 
 void ShaderMaterial::Set(const std::string& name, const glm::vec2& value) {
 	LOG_ASSERT(Shader != nullptr, "Must set Material shader before setting params");
+	if (_SetBlockParam(name, GL_FLOAT_VEC2, glm::value_ptr(value), 1, sizeof(glm::vec2))) {
+		return;
+	}
 	ShaderParamName pName = name;
 	pName.Location = Shader->GetUniformLocation(name);
 	Vec2Params[pName] = value;
@@ -65,6 +112,9 @@ void ShaderMaterial::Set(const std::string& name, const glm::vec2& value) {
 
 void ShaderMaterial::Set(const std::string& name, const glm::vec3& value) {
 	LOG_ASSERT(Shader != nullptr, "Must set Material shader before setting params");
+	if (_SetBlockParam(name, GL_FLOAT_VEC3, glm::value_ptr(value), 1, sizeof(glm::vec3))) {
+		return;
+	}
 	ShaderParamName pName = name;
 	pName.Location = Shader->GetUniformLocation(name);
 	Vec3Params[pName] = value;
@@ -72,6 +122,9 @@ void ShaderMaterial::Set(const std::string& name, const glm::vec3& value) {
 
 void ShaderMaterial::Set(const std::string& name, const glm::vec4& value) {
 	LOG_ASSERT(Shader != nullptr, "Must set Material shader before setting params");
+	if (_SetBlockParam(name, GL_FLOAT_VEC4, glm::value_ptr(value), 1, sizeof(glm::vec4))) {
+		return;
+	}
 	ShaderParamName pName = name;
 	pName.Location = Shader->GetUniformLocation(name);
 	Vec4Params[pName] = value;
@@ -79,6 +132,9 @@ void ShaderMaterial::Set(const std::string& name, const glm::vec4& value) {
 
 void ShaderMaterial::Set(const std::string& name, const glm::mat4& value) {
 	LOG_ASSERT(Shader != nullptr, "Must set Material shader before setting params");
+	if (_SetBlockParam(name, GL_FLOAT_MAT4, glm::value_ptr(value), 4, sizeof(glm::vec4))) {
+		return;
+	}
 	ShaderParamName pName = name;
 	pName.Location = Shader->GetUniformLocation(name);
 	Mat4Params[pName] = value;
@@ -86,7 +142,87 @@ void ShaderMaterial::Set(const std::string& name, const glm::mat4& value) {
 
 void ShaderMaterial::Set(const std::string& name, const glm::mat3& value) {
 	LOG_ASSERT(Shader != nullptr, "Must set Material shader before setting params");
+	if (_SetBlockParam(name, GL_FLOAT_MAT3, glm::value_ptr(value), 3, sizeof(glm::vec3))) {
+		return;
+	}
 	ShaderParamName pName = name;
 	pName.Location = Shader->GetUniformLocation(name);
 	Mat3Params[pName] = value;
 }
+
+bool ShaderMaterial::_SetBlockParam(const std::string& name, GLenum type, const void* data, int columns, size_t columnSize) {
+	const UniformBlockMember* member = Shader->FindMaterialParam(name);
+	if (member == nullptr) {
+		return false;
+	}
+	if (member->Type != type) {
+		LOG_WARN("Material parameter \"{}\" does not match the type in the shader, ignoring it", name);
+		return true;
+	}
+	if (_blockData.empty()) {
+		_InitBlock();
+	}
+
+	// In std140 matrix columns are padded out to the matrix stride, so they're copied one at a time. Values that
+	// haven't changed don't mark the block as dirty, so setting the same value every frame costs nothing on the GPU
+	const size_t stride = member->MatrixStride > 0 ? static_cast<size_t>(member->MatrixStride) : columnSize;
+	const uint8_t* source = static_cast<const uint8_t*>(data);
+	for (int col = 0; col < columns; col++) {
+		uint8_t* dest = _blockData.data() + member->Offset + col * stride;
+		if (memcmp(dest, source + col * columnSize, columnSize) != 0) {
+			memcpy(dest, source + col * columnSize, columnSize);
+			_blockDirty = true;
+		}
+	}
+	return true;
+}
+
+void ShaderMaterial::_InitBlock() {
+	const size_t size = Shader->GetMaterialBlockSize();
+	LOG_ASSERT(size <= MAX_BLOCK_SIZE, "Material block is {} bytes, but materials only have room for {}!", size, MAX_BLOCK_SIZE);
+	_blockData.assign(size, 0);
+	_blockDirty = true;
+	if (_blockSlot == -1) {
+		_blockSlot = _AllocateBlockSlot();
+	}
+}
+
+int ShaderMaterial::_AllocateBlockSlot() {
+	if (_blockSlotsUsed == 0) {
+		const size_t alignment = UniformBuffer::GetOffsetAlignment();
+		_blockSlotSize = (MAX_BLOCK_SIZE + alignment - 1) / alignment * alignment;
+	}
+	_blockSlotsUsed++;
+	if (!_freeBlockSlots.empty()) {
+		const int slot = _freeBlockSlots.back();
+		_freeBlockSlots.pop_back();
+		return slot;
+	}
+
+	// With no free slots, every slot below the number in use is taken
+	const size_t slot = _blockSlotsUsed - 1;
+	if (slot >= _blockSlotCapacity) {
+		// Slots are addressed by index, so growing just needs to copy the old blocks to the start of the new buffer
+		const size_t capacity = std::max<size_t>(64, _blockSlotCapacity * 2);
+		UniformBuffer::sptr buffer = UniformBuffer::Create();
+		buffer->LoadData(nullptr, _blockSlotSize, capacity);
+		if (_blockBuffer != nullptr) {
+			glCopyNamedBufferSubData(_blockBuffer->GetHandle(), buffer->GetHandle(), 0, 0, _blockBuffer->GetTotalSize());
+		}
+		_blockBuffer = buffer;
+		_blockSlotCapacity = capacity;
+	}
+	return static_cast<int>(slot);
+}
+
+void ShaderMaterial::_FreeBlockSlot(int slot) {
+	_blockSlotsUsed--;
+	if (_blockSlotsUsed == 0) {
+		// Release the buffer along with the last material, so that it isn't freed after the OpenGL context is gone
+		_blockBuffer = nullptr;
+		_blockSlotCapacity = 0;
+		_freeBlockSlots.clear();
+	} else {
+		_freeBlockSlots.push_back(slot);
+	}
+}
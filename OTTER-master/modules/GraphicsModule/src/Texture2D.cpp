@@ -1,7 +1,9 @@
 #include "Texture2D.h"
 
+#include <algorithm>
+
 Texture2D::Texture2D(const Texture2DDescription& description) :
-	ITexture(), _description(description)
+	ITexture(), _description(description), _residency(DefaultResidency), _sourcePath(""), _cpuData(nullptr), _levelCount(1)
 {
 
 	_RecreateTexture();
@@ -21,7 +23,7 @@ void Texture2D::_RecreateTexture() {
 
 	if (_description.Width * _description.Height > 0 && _description.Format != InternalFormat::Unknown)
 	{
-		glTextureStorage2D(_handle, 1, *_description.Format, _description.Width, _description.Height);
+		glTextureStorage2D(_handle, _levelCount, *_description.Format, _description.Width, _description.Height);
 
 		glTextureParameteri(_handle, GL_TEXTURE_WRAP_S, (GLenum)_description.HorizontalWrap);
 		glTextureParameteri(_handle, GL_TEXTURE_WRAP_T, (GLenum)_description.VerticalWrap);
@@ -33,12 +35,14 @@ void Texture2D::_RecreateTexture() {
 
 void Texture2D::LoadData(const Texture2DData::sptr& data) {
 	if (_description.Width != data->GetWidth() ||
-		_description.Height != data->GetHeight()) 
+		_description.Height != data->GetHeight() ||
+		IsCompressedFormat(_description.Format))
 	{
 		_description.Width = data->GetWidth();
 		_description.Height = data->GetHeight();
+		_levelCount = 1;
 		
-		if (_description.Format == InternalFormat::Unknown) {
+		if (_description.Format == InternalFormat::Unknown || IsCompressedFormat(_description.Format)) {
 			_description.Format = data->GetRecommendedFormat();
 		}
 		
@@ -61,13 +65,78 @@ void Texture2D::LoadData(const Texture2DData::sptr& data) {
 	if (_description.GenerateMipMaps) {
 		glGenerateTextureMipmap(_handle);
 	}
+
+	_cpuData = _residency == ResidencyPolicy::Keep ? data : nullptr;
+}
+
+void Texture2D::LoadData(const CompressedTextureData::sptr& data) {
+	// Compressed storage can't be converted, so we always need a new texture with the right format and level count
+	_description.Width = data->GetWidth();
+	_description.Height = data->GetHeight();
+	_description.Format = data->GetFormat();
+	_levelCount = data->GetLevelCount();
+	_RecreateTexture();
+	// We only keep uncompressed data, compressed textures can still restream the decoded image from their source
+	_cpuData = nullptr;
+
+	if (!data->DebugName.empty()) {
+		glObjectLabel(GL_TEXTURE, _handle, data->DebugName.length(), data->DebugName.c_str());
+	}
+
+	for (uint32_t ix = 0; ix < data->GetLevelCount(); ix++) {
+		const CompressedTextureData::MipLevel& level = data->GetLevel(ix);
+		glCompressedTextureSubImage2D(_handle, ix, 0, 0, level.Width, level.Height, *data->GetFormat(), (GLsizei)level.Data.size(), level.Data.data());
+	}
 }
 
 Texture2D::sptr Texture2D::LoadFromFile(const std::string& path) {
 	Texture2DData::sptr data = Texture2DData::LoadFromFile(path);
 	LOG_ASSERT(data != nullptr, "Failed to load image from file!");
 	Texture2D::sptr result = Texture2D::Create();
+	result->SetSourcePath(path);
 	result->LoadData(data);
+	AssetMemory::Track(path, result);
+	return result;
+}
+
+void Texture2D::SetResidency(ResidencyPolicy policy) {
+	_residency = policy;
+	if (_residency != ResidencyPolicy::Keep) {
+		_cpuData = nullptr;
+	}
+}
+
+Texture2DData::sptr Texture2D::RestreamData() {
+	if (_cpuData != nullptr) {
+		return _cpuData;
+	}
+	if (_residency == ResidencyPolicy::MetadataOnly || _sourcePath.empty()) {
+		return nullptr;
+	}
+	Texture2DData::sptr result = Texture2DData::LoadFromFile(_sourcePath);
+	if (result == nullptr) {
+		LOG_WARN("Failed to restream texture data from \"{}\"", _sourcePath);
+	} else if (_residency == ResidencyPolicy::Keep) {
+		_cpuData = result;
+	}
+	return result;
+}
+
+size_t Texture2D::GetCpuSize() const {
+	return _cpuData != nullptr ? _cpuData->GetDataSize() : 0;
+}
+
+size_t Texture2D::GetGpuSize() const {
+	size_t result = 0;
+	for (uint32_t ix = 0; ix < _levelCount; ix++) {
+		size_t width = std::max(_description.Width >> ix, 1u);
+		size_t height = std::max(_description.Height >> ix, 1u);
+		if (IsCompressedFormat(_description.Format)) {
+			result += ((width + 3) / 4) * ((height + 3) / 4) * GetCompressedBlockSize(_description.Format);
+		} else {
+			result += width * height * GetInternalTexelSize(_description.Format);
+		}
+	}
 	return result;
 }
 
@@ -109,3 +178,13 @@ void Texture2D::SetAnisotropicFiltering(float level)
 		glTextureParameterf(_handle, GL_TEXTURE_MAX_ANISOTROPY, _description.MaxAnisotropic);
 	}
 }
+
+Texture2D::sptr Texture2D::LoadCompressedFromFile(const std::string& path, InternalFormat format) {
+	CompressedTextureData::sptr data = CompressedTextureData::LoadFromFile(path, format);
+	LOG_ASSERT(data != nullptr, "Failed to load image from file!");
+	Texture2D::sptr result = Texture2D::Create();
+	result->SetSourcePath(path);
+	result->LoadData(data);
+	AssetMemory::Track(path, result);
+	return result;
+}
\ No newline at end of file
@@ -1,13 +1,20 @@
 #include "TextureCubeMapData.h"
+#include <atomic>
 #include <filesystem>
+#include <future>
+#include <stb_image.h>
+
+// The most faces we will decode at once, each decode holds a full face worth of data from STBI until it is copied
+static constexpr int MAX_FACE_DECODES = 2;
 
 TextureCubeMapData::TextureCubeMapData(uint32_t size, PixelFormat format, PixelType type, void* sourceData, InternalFormat recommendedFormat) :
-	_size(size), _format(format), _type(type), _data(nullptr), _recommendedFormat(recommendedFormat) {
+	_size(size), _format(format), _type(type), _recommendedFormat(recommendedFormat), _data(nullptr) {
 	LOG_ASSERT(size > 0, "Size must be greater than zero! Got {}", size)
 	_faceDataSize = (size_t)_size * _size * GetTexelSize(_format, _type);
 	_dataSize = _faceDataSize * 6;
 	_data = malloc(_dataSize);
 	LOG_ASSERT(_data != nullptr, "Failed to allocate texture data!")
+	TextureDataAllocations::_Record(_dataSize);
 	if (sourceData != nullptr) {
 		memcpy(_data, sourceData, _dataSize);
 	}
@@ -52,22 +59,102 @@ TextureCubeMapData::sptr TextureCubeMapData::LoadFromImages(const std::string& r
 		"_neg_z"
 	};
 
-	std::vector<Texture2DData::sptr> data;
-	data.resize(6);
-
+	// Read just the headers up front, so that we can allocate the cubemap before decoding anything
+	std::string paths[6];
+	bool exists[6];
+	int size = 0, numChannels = 0;
 	for(int ix = 0; ix < 6; ix++) {
-		fs::path imagePath = rootFile;
-		imagePath += PATHS[ix];
-		imagePath += extension;
-		if (fs::exists(imagePath)) {
-			data[ix] = Texture2DData::LoadFromFile(imagePath.string());
+		fs::path facePath = rootFile;
+		facePath += PATHS[ix];
+		facePath += extension;
+		paths[ix] = facePath.string();
+		exists[ix] = fs::exists(facePath);
+
+		int width, height, channels;
+		if (!exists[ix]) {
+			LOG_WARN("Image \"{}\" could not be found!", paths[ix]);
+		}
+		else if (!stbi_info(paths[ix].c_str(), &width, &height, &channels)) {
+			LOG_WARN("STBI Failed to load image from \"{}\"", paths[ix]);
+			exists[ix] = false;
 		}
 		else {
-			LOG_WARN("Image \"{}\" could not be found!", imagePath.string());
+			LOG_ASSERT(width == height, "Data is not square! {}x{}", width, height);
+			// We'll grab our settings from the first image we find, and convert the rest to match
+			if (size == 0) {
+				size = width;
+				numChannels = channels;
+			} else {
+				LOG_ASSERT(width == size, "Data does not match size of cubemap! {}x{} vs {}", width, height, size);
+			}
 		}
 	}
+	LOG_ASSERT(size > 0, "None of the images for cubemap \"{}\" could be loaded!", rootImagePath);
+
+	// We'll determine a recommended format for the image based on number of channels
+	InternalFormat internal_format;
+	PixelFormat    image_format;
+	switch (numChannels) {
+	case 1:
+		internal_format = InternalFormat::R8;
+		image_format = PixelFormat::Red;
+		break;
+	case 2:
+		internal_format = InternalFormat::RG8;
+		image_format = PixelFormat::RG;
+		break;
+	case 3:
+		internal_format = InternalFormat::RGB8;
+		image_format = PixelFormat::RGB;
+		break;
+	case 4:
+		internal_format = InternalFormat::RGBA8;
+		image_format = PixelFormat::RGBA;
+		break;
+	default:
+		LOG_ASSERT(false, "Unsupported texture format for cubemap \"{}\" with {} channels", rootImagePath, numChannels)
+		break;
+	}
+
+	TextureCubeMapData::sptr result = std::make_shared<TextureCubeMapData>(size, image_format, PixelType::UByte, nullptr, internal_format);
+	result->DebugName = imagePath.filename().string();
 
-	return CreateFromImages(data);
+	// Decode the faces in parallel, each copying directly into its slot in the cubemap and freeing STBI's copy
+	// right away, rather than going through an intermediate Texture2DData per face. Only a couple of decodes run at
+	// once, with the workers pulling face indices as they finish, so that STBI's buffers for all 6 faces are never
+	// alive at the same time. Note that the flip setting is global in STBI, so we need to set it before starting
+	// any of the threads
+	stbi_set_flip_vertically_on_load(true);
+	std::atomic<int> nextFace = 0;
+	auto decodeFaces = [&]() {
+		for (int ix = nextFace++; ix < 6; ix = nextFace++) {
+			char* target = static_cast<char*>(result->_data) + (result->_faceDataSize * ix);
+			if (!exists[ix]) {
+				memset(target, 0, result->_faceDataSize);
+				continue;
+			}
+			int width, height, channels;
+			uint8_t* data = stbi_load(paths[ix].c_str(), &width, &height, &channels, numChannels);
+			if (data == nullptr) {
+				LOG_WARN("STBI Failed to load image from \"{}\"", paths[ix]);
+				memset(target, 0, result->_faceDataSize);
+				continue;
+			}
+			memcpy(target, data, result->_faceDataSize);
+			stbi_image_free(data);
+		}
+	};
+	std::future<void> workers[MAX_FACE_DECODES];
+	for (int ix = 0; ix < MAX_FACE_DECODES; ix++) {
+		workers[ix] = std::async(std::launch::async, decodeFaces);
+	}
+	// Use get rather than wait, so that anything thrown while decoding a face is re-thrown here. If one does throw,
+	// the destructors of the remaining futures will still wait for their tasks before result is released
+	for (int ix = 0; ix < MAX_FACE_DECODES; ix++) {
+		workers[ix].get();
+	}
+
+	return result;
 }
 
 void TextureCubeMapData::LoadFaceData(const Texture2DData::sptr& data, CubeMapFace face) {
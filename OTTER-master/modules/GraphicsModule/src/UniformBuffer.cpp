@@ -0,0 +1,27 @@
+#include "UniformBuffer.h"
+#include "Logging.h"
+
+void UniformBuffer::UpdateData(const void* data, size_t offset, size_t size) {
+	LOG_ASSERT(offset + size <= GetTotalSize(), "Update is outside of the buffer!");
+	glNamedBufferSubData(_handle, offset, size, data);
+}
+
+void UniformBuffer::Bind(GLuint slot) {
+	glBindBufferBase(GL_UNIFORM_BUFFER, slot, _handle);
+}
+
+void UniformBuffer::BindRange(GLuint slot, size_t offset, size_t size) {
+	glBindBufferRange(GL_UNIFORM_BUFFER, slot, _handle, offset, size);
+}
+
+void UniformBuffer::UnBind(GLuint slot) {
+	glBindBufferBase(GL_UNIFORM_BUFFER, slot, 0);
+}
+
+size_t UniformBuffer::GetOffsetAlignment() {
+	static GLint alignment = 0;
+	if (alignment == 0) {
+		glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	}
+	return static_cast<size_t>(alignment);
+}
@@ -1,10 +1,12 @@
 #include "VertexArrayObject.h"
+#include "GeometryArena.h"
 #include "IndexBuffer.h"
 #include "Logging.h"
 #include "VertexBuffer.h"
 
 VertexArrayObject::VertexArrayObject() :
 	_indexBuffer(nullptr),
+	_allocation(nullptr),
 	_handle(0),
 	_vertexCount(0)
 {
@@ -13,6 +15,7 @@ VertexArrayObject::VertexArrayObject() :
 
 VertexArrayObject::~VertexArrayObject()
 {
+	ForgetHandle(_handle);
 	if (_handle != 0) {
 		glDeleteVertexArrays(1, &_handle);
 		_handle = 0;
@@ -24,6 +27,7 @@ void VertexArrayObject::SetDebugName(const std::string& name) {
 }
 
 void VertexArrayObject::SetIndexBuffer(const IndexBuffer::sptr& ibo) {
+	LOG_ASSERT(_allocation == nullptr, "VAOs that draw from a geometry arena can't have their own buffers!");
 	_indexBuffer = ibo;
 	Bind();
 	if (_indexBuffer != nullptr) _indexBuffer->Bind();
@@ -33,6 +37,7 @@ void VertexArrayObject::SetIndexBuffer(const IndexBuffer::sptr& ibo) {
 
 void VertexArrayObject::AddVertexBuffer(const VertexBuffer::sptr& buffer, const std::vector<BufferAttribute>& attributes)
 {
+	LOG_ASSERT(_allocation == nullptr, "VAOs that draw from a geometry arena can't have their own buffers!");
 	if (_vertexCount == 0) {
 		_vertexCount = buffer->GetElementCount();
 	} else {
@@ -53,15 +58,52 @@ void VertexArrayObject::AddVertexBuffer(const VertexBuffer::sptr& buffer, const
 
 }
 
+void VertexArrayObject::SetAllocation(const std::shared_ptr<GeometryAllocation>& allocation) {
+	LOG_ASSERT(_indexBuffer == nullptr && _vertexBuffers.empty(), "VAOs with their own buffers can't draw from a geometry arena!");
+	_allocation = allocation;
+	_vertexCount = _allocation != nullptr ? static_cast<GLsizei>(_allocation->GetVertexCount()) : 0;
+}
+
 void VertexArrayObject::Bind() const {
-	glBindVertexArray(_handle);
+	_boundHandle = _allocation != nullptr ? _allocation->GetArena()->GetVaoHandle() : _handle;
+	glBindVertexArray(_boundHandle);
 }
 
 void VertexArrayObject::UnBind() {
+	_boundHandle = 0;
 	glBindVertexArray(0);
 }
 
+void VertexArrayObject::BindHandle(GLuint handle) {
+	if (_boundHandle != handle) {
+		_boundHandle = handle;
+		glBindVertexArray(handle);
+	}
+}
+
+void VertexArrayObject::ForgetHandle(GLuint handle) {
+	if (_boundHandle == handle) {
+		_boundHandle = 0;
+	}
+}
+
+size_t VertexArrayObject::GetTotalBufferSize() const {
+	if (_allocation != nullptr) {
+		return _allocation->GetTotalSize();
+	}
+	size_t result = _indexBuffer != nullptr ? _indexBuffer->GetTotalSize() : 0;
+	for (const VertexBufferBinding& binding : _vertexBuffers) {
+		result += binding.Buffer->GetTotalSize();
+	}
+	return result;
+}
+
 void VertexArrayObject::Render() const {
+	// Arena meshes leave the shared VAO bound, so the next mesh from the same arena doesn't need to bind anything
+	if (_allocation != nullptr) {
+		_allocation->Draw();
+		return;
+	}
 	Bind();
 	if (_indexBuffer != nullptr) {
 		glDrawElements(GL_TRIANGLES, _indexBuffer->GetElementCount(), _indexBuffer->GetElementType(), nullptr);
@@ -70,3 +112,51 @@ void VertexArrayObject::Render() const {
 	}
 	UnBind();
 }
+
+void VertexArrayObject::Render(uint32_t firstIndex, uint32_t indexCount) const {
+	if (_allocation != nullptr) {
+		_allocation->Draw(firstIndex, indexCount);
+		return;
+	}
+	LOG_ASSERT(_indexBuffer != nullptr, "Drawing a range requires an index buffer!");
+	Bind();
+	const size_t offset = static_cast<size_t>(firstIndex) * _indexBuffer->GetElementSize();
+	glDrawElements(GL_TRIANGLES, indexCount, _indexBuffer->GetElementType(), reinterpret_cast<const void*>(offset));
+	UnBind();
+}
+
+void VertexArrayObject::RenderInstanced(const InstanceBuffer& instances, uint32_t baseInstance, uint32_t instanceCount) const {
+	if (instanceCount == 0) {
+		return;
+	}
+	if (_allocation != nullptr) {
+		_allocation->DrawInstanced(0, static_cast<uint32_t>(_allocation->GetIndexCount()), instances, baseInstance, instanceCount);
+		return;
+	}
+	instances.AttachTo(_handle);
+	Bind();
+	if (_indexBuffer != nullptr) {
+		glDrawElementsInstancedBaseInstance(GL_TRIANGLES, _indexBuffer->GetElementCount(), _indexBuffer->GetElementType(), nullptr, instanceCount, baseInstance);
+	} else {
+		glDrawArraysInstancedBaseInstance(GL_TRIANGLES, 0, _vertexCount, instanceCount, baseInstance);
+	}
+	UnBind();
+	InstanceBuffer::DetachFrom(_handle);
+}
+
+void VertexArrayObject::RenderInstanced(uint32_t firstIndex, uint32_t indexCount, const InstanceBuffer& instances, uint32_t baseInstance, uint32_t instanceCount) const {
+	if (instanceCount == 0) {
+		return;
+	}
+	if (_allocation != nullptr) {
+		_allocation->DrawInstanced(firstIndex, indexCount, instances, baseInstance, instanceCount);
+		return;
+	}
+	LOG_ASSERT(_indexBuffer != nullptr, "Drawing a range requires an index buffer!");
+	instances.AttachTo(_handle);
+	Bind();
+	const size_t offset = static_cast<size_t>(firstIndex) * _indexBuffer->GetElementSize();
+	glDrawElementsInstancedBaseInstance(GL_TRIANGLES, indexCount, _indexBuffer->GetElementType(), reinterpret_cast<const void*>(offset), instanceCount, baseInstance);
+	UnBind();
+	InstanceBuffer::DetachFrom(_handle);
+}
@@ -1,10 +1,13 @@
 #include "VertexTypes.h"
+#include <GLM/gtc/packing.hpp>
 #pragma warning( push )
 
 VertexPosCol* VPC = nullptr;
 VertexPosNormCol* VPNC = nullptr;
 VertexPosNormTex* VPNT = nullptr;
 VertexPosNormTexCol* VPNTC = nullptr;
+VertexPosNormTexColPacked* VPNTCP = nullptr;
+VertexPosNormTexPacked* VPNTP = nullptr;
 
 const std::vector<BufferAttribute> VertexPosCol::V_DECL = {
 	BufferAttribute(0, 3, GL_FLOAT, false, sizeof(VertexPosCol), (size_t)&VPC->Position, AttribUsage::Position),
@@ -26,4 +29,37 @@ const std::vector<BufferAttribute> VertexPosNormTexCol::V_DECL = {
 	BufferAttribute(2, 3, GL_FLOAT, false, sizeof(VertexPosNormTexCol), (size_t)&VPNTC->Normal, AttribUsage::Normal),
 	BufferAttribute(3, 2, GL_FLOAT, false, sizeof(VertexPosNormTexCol), (size_t)&VPNTC->UV, AttribUsage::Texture),
 };
-#pragma warning(pop)
\ No newline at end of file
+const std::vector<BufferAttribute> VertexPosNormTexColPacked::V_DECL = {
+	BufferAttribute(0, 3, GL_FLOAT, false, sizeof(VertexPosNormTexColPacked), (size_t)&VPNTCP->Position, AttribUsage::Position),
+	BufferAttribute(1, 4, GL_UNSIGNED_BYTE, true, sizeof(VertexPosNormTexColPacked), (size_t)&VPNTCP->Color, AttribUsage::Color),
+	BufferAttribute(2, 4, GL_INT_2_10_10_10_REV, true, sizeof(VertexPosNormTexColPacked), (size_t)&VPNTCP->Normal, AttribUsage::Normal),
+	BufferAttribute(3, 2, GL_HALF_FLOAT, false, sizeof(VertexPosNormTexColPacked), (size_t)&VPNTCP->UV, AttribUsage::Texture),
+};
+const std::vector<BufferAttribute> VertexPosNormTexPacked::V_DECL = {
+	BufferAttribute(0, 3, GL_FLOAT, false, sizeof(VertexPosNormTexPacked), (size_t)&VPNTP->Position, AttribUsage::Position),
+	BufferAttribute(2, 4, GL_INT_2_10_10_10_REV, true, sizeof(VertexPosNormTexPacked), (size_t)&VPNTP->Normal, AttribUsage::Normal),
+	BufferAttribute(3, 2, GL_HALF_FLOAT, false, sizeof(VertexPosNormTexPacked), (size_t)&VPNTP->UV, AttribUsage::Texture),
+};
+#pragma warning(pop)
+
+// The GLM packing functions put x in the lowest bits, which matches the component order OpenGL reads
+// for GL_INT_2_10_10_10_REV, and the memory order of GL_HALF_FLOAT and GL_UNSIGNED_BYTE on little endian machines
+
+VertexPosNormTexColPacked::VertexPosNormTexColPacked(const glm::vec3& pos, const glm::vec3& norm, const glm::vec2& uv, const glm::vec4& col) :
+	Position(pos),
+	Normal(glm::packSnorm3x10_1x2(glm::vec4(norm, 0.0f))),
+	UV(glm::packHalf2x16(uv)),
+	Color(glm::packUnorm4x8(col)) {}
+
+VertexPosNormTexCol VertexPosNormTexColPacked::Unpack() const {
+	return VertexPosNormTexCol(Position, glm::vec3(glm::unpackSnorm3x10_1x2(Normal)), glm::unpackHalf2x16(UV), glm::unpackUnorm4x8(Color));
+}
+
+VertexPosNormTexPacked::VertexPosNormTexPacked(const glm::vec3& pos, const glm::vec3& norm, const glm::vec2& uv) :
+	Position(pos),
+	Normal(glm::packSnorm3x10_1x2(glm::vec4(norm, 0.0f))),
+	UV(glm::packHalf2x16(uv)) {}
+
+VertexPosNormTexCol VertexPosNormTexPacked::Unpack() const {
+	return VertexPosNormTexCol(Position, glm::vec3(glm::unpackSnorm3x10_1x2(Normal)), glm::unpackHalf2x16(UV), glm::vec4(1.0f));
+}
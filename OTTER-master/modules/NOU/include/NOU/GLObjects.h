@@ -13,17 +13,157 @@ You'll be learning a LOT more about this in your graphics class.
 #include <vector>
 #include <map>
 #include <string>
+#include <cstring>
 
 #include "glad/glad.h"
 
 namespace nou
 {
+	//Class for streaming data that changes every frame (particles, sprites, etc.)
+	//Calling glBufferData on every update makes the driver reallocate the buffer
+	//(and may stall if the GPU is still drawing with the old contents).
+	//Instead, we allocate storage once and keep it mapped for the lifetime of the buffer.
+	//The storage is split into REGION_COUNT regions: each update writes to the next region
+	//while the GPU may still be reading from the previous ones, and a fence tells us
+	//when a region we want to reuse is no longer in use.
+	//Requires OpenGL 4.4 (see IsSupported).
+	class StreamBuffer
+	{
+		public:
+
+		//Number of regions in the ring - three lets us write one update while
+		//the GPU is still working on up to two older ones.
+		static const int REGION_COUNT = 3;
+
+		//Counters for how our streaming buffers are doing.
+		struct Stats
+		{
+			//Number of times a region was handed out for writing.
+			size_t updates;
+			//Updates where the region was already free, i.e. updates that would have
+			//reallocated with glBufferData but needed no synchronization at all.
+			size_t stallsAvoided;
+			//Updates where we had to wait for the GPU to finish with the region.
+			size_t waits;
+
+			Stats()
+			{
+				updates = 0;
+				stallsAvoided = 0;
+				waits = 0;
+			}
+		};
+
+		static bool IsSupported() { return GLAD_GL_VERSION_4_4 != 0; }
+
+		static const Stats& GetStats() { return s_stats; }
+
+		StreamBuffer(GLsizeiptr regionSize)
+		{
+			m_regionSize = regionSize;
+			m_region = 0;
+
+			for (int i = 0; i < REGION_COUNT; ++i)
+				m_fences[i] = nullptr;
+
+			//Immutable storage lets us keep the buffer mapped while the GPU uses it.
+			//Coherent mapping means our writes become visible without explicit flushes.
+			GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+			glGenBuffers(1, &m_id);
+			glBindBuffer(GL_ARRAY_BUFFER, m_id);
+			glBufferStorage(GL_ARRAY_BUFFER, m_regionSize * REGION_COUNT, nullptr, flags);
+			m_mapped = static_cast<char*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, m_regionSize * REGION_COUNT, flags));
+		}
+
+		~StreamBuffer()
+		{
+			for (int i = 0; i < REGION_COUNT; ++i)
+			{
+				if (m_fences[i] != nullptr)
+					glDeleteSync(m_fences[i]);
+			}
+
+			glBindBuffer(GL_ARRAY_BUFFER, m_id);
+			glUnmapBuffer(GL_ARRAY_BUFFER);
+			glDeleteBuffers(1, &m_id);
+		}
+
+		StreamBuffer(const StreamBuffer&) = delete;
+
+		GLuint GetID() const { return m_id; }
+
+		GLsizeiptr RegionSize() const { return m_regionSize; }
+
+		//Byte offset of the current region from the start of the buffer.
+		GLintptr RegionOffset() const { return m_regionSize * m_region; }
+
+		//Moves on to the next region and returns a pointer to write into it.
+		//Everything that reads the current region must have been submitted by now,
+		//since we fence it here - for a buffer that is updated and then drawn, this
+		//is always true by the time the next update comes around.
+		void* NextRegion()
+		{
+			if (m_fences[m_region] != nullptr)
+				glDeleteSync(m_fences[m_region]);
+			m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+			m_region = (m_region + 1) % REGION_COUNT;
+			++s_stats.updates;
+
+			//Make sure the GPU is done with the region we are about to overwrite.
+			GLsync fence = m_fences[m_region];
+			if (fence == nullptr || glClientWaitSync(fence, 0, 0) != GL_TIMEOUT_EXPIRED)
+			{
+				++s_stats.stallsAvoided;
+			}
+			else
+			{
+				++s_stats.waits;
+				//Flush on the first wait so the fence is guaranteed to signal eventually.
+				GLbitfield waitFlags = GL_SYNC_FLUSH_COMMANDS_BIT;
+				while (glClientWaitSync(fence, waitFlags, 1000000) == GL_TIMEOUT_EXPIRED)
+					waitFlags = 0;
+			}
+
+			if (fence != nullptr)
+			{
+				glDeleteSync(fence);
+				m_fences[m_region] = nullptr;
+			}
+
+			return m_mapped + RegionOffset();
+		}
+
+		protected:
+
+		//The OpenGL ID of our buffer.
+		GLuint m_id;
+
+		//Pointer to the start of our persistently mapped storage.
+		char* m_mapped;
+
+		//Size of a single region in bytes.
+		GLsizeiptr m_regionSize;
+
+		//The region holding the most recent data.
+		int m_region;
+
+		//Fences placed after each region was last used (nullptr if unused).
+		GLsync m_fences[REGION_COUNT];
+
+		inline static Stats s_stats;
+	};
+
 	//Class for managing OpenGL Vertex Buffer Objects (VBOs).
 	//A vertex buffer stores a hunk of data for OpenGL on the GPU.
 	//This might be a list of vertex positions, texture coordinates, etc.
 	//As implemented, if you want to use these in a container, you MUST
 	//use a pointer (e.g., std::vector<VertexBuffer> is not okay,
 	//but std::vector<std::unique_ptr<VertexBuffer>> is good).
+	//Dynamic buffers stream their data through a StreamBuffer when it is
+	//supported, so each update writes to a new part of the buffer - use
+	//StartIndex() (or a VertexArray, which handles this for you) to find the latest data.
 	class VertexBuffer
 	{
 		public:
@@ -35,14 +175,34 @@ namespace nou
 			m_startIndex = 0;
 			m_len = 0;
 			m_dynamic = dynamic;
+			m_id = 0;
+
+			if (!m_dynamic || !StreamBuffer::IsSupported())
+				glGenBuffers(1, &m_id);
 
-			glGenBuffers(1, &m_id);
 			UpdateData(data);
 		}
 
+		//Creates a buffer from raw bytes, for data that doesn't have a matching C++ type
+		//(e.g., interleaved vertices, where each element is a whole vertex).
+		VertexBuffer(GLint elementLen, GLsizei elementSize, const void* data, GLsizei count, bool dynamic = false)
+		{
+			m_elementLen = elementLen;
+			m_startIndex = 0;
+			m_len = 0;
+			m_dynamic = dynamic;
+			m_id = 0;
+
+			if (!m_dynamic || !StreamBuffer::IsSupported())
+				glGenBuffers(1, &m_id);
+
+			UpdateData(data, count, elementSize);
+		}
+
 		~VertexBuffer()
 		{
-			glDeleteBuffers(1, &m_id);
+			if (m_stream == nullptr)
+				glDeleteBuffers(1, &m_id);
 		}
 
 		//This is called a copy constructor.
@@ -79,21 +239,112 @@ namespace nou
 
 		GLuint GetID() const { return m_id; }
 
+		bool IsStreamed() const { return m_dynamic && StreamBuffer::IsSupported(); }
+
+		//The number of bytes of GPU memory used by this buffer.
+		//Streamed buffers keep several regions alive at once, so use more than their data.
+		size_t GPUBytes() const
+		{
+			if (m_stream != nullptr)
+				return (size_t)m_stream->RegionSize() * StreamBuffer::REGION_COUNT;
+
+			return (size_t)m_len * m_elementSize;
+		}
+
+		//The number of bytes of CPU memory held by this buffer (dynamic buffers that
+		//aren't streamed keep a staging copy around so it can be reused every update).
+		size_t CPUBytes() const { return m_staging.capacity(); }
+
 		//This uploads the data specified into our OpenGL buffer on the GPU.
 		template<typename T>
 		void UpdateData(const std::vector<T>& data)
 		{
-			m_len = (GLsizei)data.size();
-			m_elementSize = sizeof(T);
+			UpdateData(data.data(), (GLsizei)data.size(), sizeof(T));
+		}
 
-			GLenum usage = (m_dynamic) ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW;
+		//Same as above, for raw bytes (count elements of elementSize bytes each).
+		void UpdateData(const void* data, GLsizei count, GLsizei elementSize)
+		{
+			//Buffers that aren't streamed can be uploaded straight from the caller's data,
+			//there's no need to copy it into our staging memory first.
+			if (!IsStreamed())
+			{
+				m_len = count;
+				m_elementSize = elementSize;
+				Upload(data, (GLsizeiptr)m_len * m_elementSize);
+				return;
+			}
 
-			glBindBuffer(GL_ARRAY_BUFFER, m_id);
-			glBufferData(GL_ARRAY_BUFFER, m_len * m_elementSize, &(data[0]), usage);
+			void* dest = BeginWrite(count, elementSize);
+			std::memcpy(dest, data, (size_t)count * elementSize);
+			EndWrite();
+		}
+
+		//Returns a pointer to write count elements of new data into.
+		//For streamed buffers this points straight at GPU-visible memory,
+		//so dynamic data can be written in place without building a std::vector first.
+		//Every element must be written (the memory holds old data), and
+		//EndWrite must be called once you're done.
+		template<typename T>
+		T* BeginWrite(GLsizei count)
+		{
+			return static_cast<T*>(BeginWrite(count, sizeof(T)));
+		}
+
+		//Same as above, for elements of elementSize bytes.
+		void* BeginWrite(GLsizei count, GLsizei elementSize)
+		{
+			m_len = count;
+			m_elementSize = elementSize;
+
+			GLsizeiptr bytes = (GLsizeiptr)m_len * m_elementSize;
+
+			if (!IsStreamed())
+			{
+				m_staging.resize(bytes);
+				return m_staging.data();
+			}
+
+			//Grow our storage if the new data won't fit in a region, with some room to spare
+			//so that a slowly growing buffer doesn't reallocate every frame.
+			if (m_stream == nullptr || m_stream->RegionSize() < bytes)
+			{
+				GLsizeiptr regionSize = (m_stream == nullptr) ? bytes : bytes + bytes / 2;
+				regionSize = ((regionSize + m_elementSize - 1) / m_elementSize) * m_elementSize;
+				m_stream = std::make_unique<StreamBuffer>((regionSize > 0) ? regionSize : m_elementSize);
+				m_id = m_stream->GetID();
+			}
+
+			void* result = m_stream->NextRegion();
+			m_startIndex = (GLsizei)(m_stream->RegionOffset() / m_elementSize);
+			return result;
+		}
+
+		//Finishes a write started with BeginWrite.
+		void EndWrite()
+		{
+			if (IsStreamed())
+				return;
+
+			Upload(m_staging.data(), (GLsizeiptr)m_staging.size());
+
+			//Static data is rarely updated again, so there's no point holding a copy of it
+			//on the CPU once OpenGL has it.
+			if (!m_dynamic)
+				std::vector<char>().swap(m_staging);
 		}
 
 		protected:
 
+		//Replaces the contents of a buffer that isn't streamed.
+		void Upload(const void* data, GLsizeiptr bytes)
+		{
+			GLenum usage = (m_dynamic) ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW;
+
+			glBindBuffer(GL_ARRAY_BUFFER, m_id);
+			glBufferData(GL_ARRAY_BUFFER, bytes, data, usage);
+		}
+
 		//The OpenGL ID of our VBO.
 		GLuint m_id;
 
@@ -111,6 +362,12 @@ namespace nou
 
 		//Whether we expect to update this data frequently.
 		bool m_dynamic;
+
+		//Ring of persistently mapped storage for dynamic data (nullptr for static buffers).
+		std::unique_ptr<StreamBuffer> m_stream;
+
+		//CPU copy of the data being written with BeginWrite, for buffers that are not streamed.
+		std::vector<char> m_staging;
 	};
 
 	//Class for managing OpenGL Vertex Array Objects (VAOs).
@@ -227,17 +484,16 @@ namespace nou
 		//buffer specified to be found in the location specified.
 		void BindAttrib(const VertexBuffer& buf, GLuint attribLoc)
 		{
-			m_vbos[attribLoc] = &buf;
-
-			m_len = buf.Length();
+			BindAttrib(buf, attribLoc, buf.ElementLength(), 0, 0);
+		}
 
-			glBindVertexArray(m_id);
-			glEnableVertexAttribArray(attribLoc);
-			glBindBuffer(GL_ARRAY_BUFFER, buf.GetID());
-			glVertexAttribPointer(attribLoc, buf.ElementLength(), 
-								  GL_FLOAT, GL_FALSE, 0,
-								 reinterpret_cast<void*>((long long)buf.StartIndex() *
-														 (long long)buf.ElementSize()));
+		//Same as above, for an attribute stored inside an interleaved buffer
+		//(one where each element is a whole vertex - see Mesh::SetInterleaved).
+		//elementLen is the number of floats in the attribute, and offset is
+		//where it starts (in bytes) from the start of each vertex.
+		void BindAttrib(const VertexBuffer& buf, GLuint attribLoc, GLint elementLen, GLsizei offset)
+		{
+			BindAttrib(buf, attribLoc, elementLen, offset, buf.ElementSize());
 		}
 
 		void SetDrawMode(DrawMode drawMode)
@@ -250,6 +506,7 @@ namespace nou
 			m_len = m_vbos.begin()->second->Length();
 
 			glBindVertexArray(m_id);
+			RefreshStreamedAttribs();
 			glDrawArrays((int)m_drawMode, 0, m_len);
 		}
 
@@ -259,6 +516,7 @@ namespace nou
 				return;
 
 			glBindVertexArray(m_id);
+			RefreshStreamedAttribs();
 			glDrawElements((int)m_drawMode,
 						   static_cast<GLsizei>(count),
 						   GL_UNSIGNED_INT,
@@ -275,6 +533,60 @@ namespace nou
 
 		//A record of the VBOs associated with this VAO.
 		std::map<GLint, const VertexBuffer*> m_vbos;
+
+		//How each attribute reads from its buffer, and the buffer and offset it
+		//currently points at (so we know when a streamed buffer has moved on to a new region).
+		struct AttribFormat
+		{
+			GLint elementLen;
+			GLsizei offset;
+			GLsizei stride;
+			GLuint boundID;
+			GLsizei boundStart;
+		};
+
+		std::map<GLint, AttribFormat> m_formats;
+
+		void BindAttrib(const VertexBuffer& buf, GLuint attribLoc, GLint elementLen, GLsizei offset, GLsizei stride)
+		{
+			m_vbos[attribLoc] = &buf;
+			m_formats[attribLoc] = { elementLen, offset, stride, 0, 0 };
+
+			m_len = buf.Length();
+
+			glBindVertexArray(m_id);
+			glEnableVertexAttribArray(attribLoc);
+			PointAttrib(buf, attribLoc);
+		}
+
+		//Points an attribute at the latest data in a buffer (our VAO must be bound).
+		void PointAttrib(const VertexBuffer& buf, GLuint attribLoc)
+		{
+			AttribFormat& format = m_formats[attribLoc];
+			format.boundID = buf.GetID();
+			format.boundStart = buf.StartIndex();
+
+			glBindBuffer(GL_ARRAY_BUFFER, buf.GetID());
+			glVertexAttribPointer(attribLoc, format.elementLen, 
+								  GL_FLOAT, GL_FALSE, format.stride,
+								 reinterpret_cast<void*>((long long)buf.StartIndex() *
+														 (long long)buf.ElementSize() + format.offset));
+		}
+
+		//Streamed buffers write each update to a different part of their storage,
+		//so we re-point any attributes whose data has moved since we last drew.
+		void RefreshStreamedAttribs()
+		{
+			for (auto& [attribLoc, buf] : m_vbos)
+			{
+				if (!buf->IsStreamed())
+					continue;
+
+				const AttribFormat& format = m_formats[attribLoc];
+				if (format.boundID != buf->GetID() || format.boundStart != buf->StartIndex())
+					PointAttrib(*buf, attribLoc);
+			}
+		}
 	};
 }
 
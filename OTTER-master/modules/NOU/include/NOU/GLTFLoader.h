@@ -31,7 +31,9 @@ namespace nou::GLTF
 	};
 
 	//Loads a 3D model into the mesh object given.
-	void LoadMesh(const std::string& filename, Mesh& mesh, bool flipUVY = true);
+	//With interleaved set, all of the vertex data goes into a single buffer
+	//(see Mesh::SetInterleaved), which is faster to draw.
+	void LoadMesh(const std::string& filename, Mesh& mesh, bool flipUVY = true, bool interleaved = false);
 	
 	void DumpErrorsAndWarnings(const std::string& filename,
 							   const std::string& err,
@@ -43,7 +45,15 @@ namespace nou::GLTF
 
 	//Takes a glTF model and extracts vertex positions, normals, and texture coordinates.
 	bool ExtractGeometry(const tinygltf::Model& gltf, Mesh& mesh, bool flipUVY,
-					     std::string& err, std::string& warn);
+					     std::string& err, std::string& warn, bool interleaved = false);
+
+	//Same as above, but gives back the arrays instead of storing them in a mesh
+	//(e.g., so they can be interleaved with other attributes first).
+	bool ExtractGeometry(const tinygltf::Model& gltf, 
+						 std::vector<glm::vec3>& verts, std::vector<glm::vec2>& uvs,
+						 std::vector<glm::vec3>& normals, bool flipUVY,
+						 bool& hasNormals, bool& hasUVs,
+						 std::string& err, std::string& warn);
 
 	bool ProcessPrimitive(const tinygltf::Model& gltf, size_t geomIndex, 
 					      std::vector<glm::vec3>& verts, std::vector<glm::vec2>& uvs,
@@ -14,8 +14,9 @@ Very basic class for managing the data associated with a 3D model.
 
 #include <vector>
 #include <string>
-#include <map>
+#include <array>
 #include <memory>
+#include <functional>
 
 namespace nou
 {
@@ -34,47 +35,176 @@ namespace nou
 			SKIN_WEIGHT = 4
 		};
 
-		Mesh() = default;
+		//The number of attributes in the enumerator above.
+		static const int ATTRIB_COUNT = 5;
+
+		//The number of floats each attribute takes up in an interleaved vertex,
+		//indexed by Attrib (0 if the mesh doesn't have that attribute).
+		//Attributes are packed one after another in Attrib order.
+		typedef std::array<GLint, ATTRIB_COUNT> Layout;
+
+		//What a mesh holds on to on the CPU after its data has been uploaded.
+		//Once the GPU has a copy we usually don't need ours, and keeping both
+		//doubles the memory used by every model.
+		enum class Residency
+		{
+			//Keep a copy of every attribute (e.g., for collision or picking).
+			KEEP = 0,
+			//Drop the data, but keep the vertex count and bounding box.
+			BOUNDS_ONLY = 1,
+			//Drop everything but the GPU buffers.
+			DROP_AFTER_UPLOAD = 2
+		};
+
+		//A function that loads the mesh's attributes again (e.g., from the file it came from).
+		//Returns false if the data couldn't be loaded.
+		typedef std::function<bool(std::vector<glm::vec3>& verts,
+								   std::vector<glm::vec3>& normals,
+								   std::vector<glm::vec2>& uvs)> Reloader;
+
+		//The residency new meshes start with.
+		static inline Residency defaultResidency = Residency::BOUNDS_ONLY;
+
+		Mesh();
 		virtual ~Mesh() = default;
 
 		void SetVerts(const std::vector<glm::vec3>& verts);
 		void SetNormals(const std::vector<glm::vec3>& normals);
 		void SetUVs(const std::vector<glm::vec2>& uvs);
 
+		//Uploads vertex data with all attributes interleaved in a single buffer,
+		//so drawing fetches each vertex from one place in memory instead of one
+		//buffer per attribute. Any attributes in the layout replace the buffers
+		//set up by SetVerts, SetNormals, etc.
+		void SetInterleaved(const std::vector<float>& data, const Layout& layout);
+
+		//Packs separate attribute arrays into a single interleaved array for SetInterleaved.
+		//sources holds a pointer to the data for each attribute in the layout (indexed by Attrib).
+		static std::vector<float> Interleave(const Layout& layout, 
+											 const std::array<const float*, ATTRIB_COUNT>& sources,
+											 size_t vertCount);
+
 		//Fetches a vertex buffer associated with the desired attribute.
 		//Used by mesh rendering components to grab the requisite data
 		//associated with this model in OpenGL.
+		//Returns nullptr for interleaved attributes - use BindAttrib instead.
 		const VertexBuffer* GetVBO(Attrib attrib) const;
 
+		//Associates the data for an attribute with a VAO at the given location,
+		//whether it lives in its own buffer or in our interleaved buffer.
+		//Returns false if this mesh doesn't have the attribute.
+		bool BindAttrib(VertexArray& vao, Attrib attrib, GLuint attribLoc) const;
+
+		//Binds all of our attributes to a VAO, at the locations given by Attrib.
+		void BindAttribs(VertexArray& vao) const;
+
+		//Changes what we keep on the CPU. Switching away from KEEP drops
+		//any data we're holding right away.
+		void SetResidency(Residency residency);
+		Residency GetResidency() const { return m_residency; }
+
+		//Remembers how to get our data back after it has been dropped (see RestoreCPUData).
+		//Loaders like GLTF::LoadMesh set this up for you.
+		void SetReloader(const Reloader& reloader) { m_reloader = reloader; }
+
+		//Stores CPU copies of our attributes without uploading anything, following
+		//our residency (the bounds are always updated). Used for meshes whose
+		//buffers were filled some other way, e.g. with SetInterleaved.
+		void SetCPUData(const std::vector<glm::vec3>& verts,
+						const std::vector<glm::vec3>& normals,
+						const std::vector<glm::vec2>& uvs);
+
+		//Makes sure the CPU copies are available, loading them again with our
+		//reloader if they were dropped. They stay around until DropCPUData is
+		//called, regardless of our residency.
+		//Returns false if the data is gone and can't be reloaded.
+		bool RestoreCPUData();
+
+		//Frees the CPU copies of our attributes (the bounds are kept unless
+		//our residency is DROP_AFTER_UPLOAD).
+		void DropCPUData();
+
+		bool HasCPUData() const { return !m_verts.empty(); }
+
+		//CPU copies of our attributes - these are empty unless our residency is
+		//KEEP or RestoreCPUData has been called.
+		const std::vector<glm::vec3>& GetVerts() const { return m_verts; }
+		const std::vector<glm::vec3>& GetNormals() const { return m_normals; }
+		const std::vector<glm::vec2>& GetUVs() const { return m_uvs; }
+
+		//The number of vertices in the mesh, even if the CPU data has been dropped.
+		size_t VertexCount() const { return m_vertCount; }
+
+		//Our axis-aligned bounding box, in model space.
+		//Returns false if we don't have one (no data yet, or DROP_AFTER_UPLOAD).
+		bool GetBounds(glm::vec3& min, glm::vec3& max) const;
+
+		//Memory used by this mesh, in bytes.
+		size_t CPUBytes() const;
+		size_t GPUBytes() const;
+
+		//Prints the CPU and GPU memory used by this mesh.
+		void PrintMemory(const std::string& name) const;
+
 		protected:
 
 		std::vector<glm::vec3> m_verts;
 		std::vector<glm::vec3> m_normals;
 		std::vector<glm::vec2> m_uvs;
 
-		std::map<Attrib, std::unique_ptr<VertexBuffer>> m_vbo;
+		Residency m_residency;
+		Reloader m_reloader;
+
+		size_t m_vertCount;
+		bool m_hasBounds;
+		glm::vec3 m_boundsMin;
+		glm::vec3 m_boundsMax;
+
+		//Updates the vertex count and bounds from a set of positions.
+		void UpdateBounds(const std::vector<glm::vec3>& verts);
+
+		//Keeps a copy of an attribute if our residency calls for it.
+		template<typename T>
+		void Retain(std::vector<T>& dest, const std::vector<T>& data)
+		{
+			if (m_residency == Residency::KEEP)
+				dest = data;
+			else
+				std::vector<T>().swap(dest);
+		}
+
+		//Separate buffers for each attribute, indexed by Attrib.
+		std::array<std::unique_ptr<VertexBuffer>, ATTRIB_COUNT> m_vbo;
+
+		//A single buffer holding the attributes in m_layout, one whole vertex per element.
+		std::unique_ptr<VertexBuffer> m_interleaved;
+		Layout m_layout;
+		//Offset in bytes of each attribute from the start of an interleaved vertex.
+		std::array<GLsizei, ATTRIB_COUNT> m_offsets;
 
 		//Sets up a VertexBuffer for the desired attribute.
 		template<typename T>
 		void SetVBO(Attrib attrib, GLint elementLen, const std::vector<T>& data)
 		{
+			auto& vbo = m_vbo[static_cast<size_t>(attrib)];
+
+			//This attribute no longer comes from our interleaved data.
+			m_layout[static_cast<size_t>(attrib)] = 0;
+
 			//We shouldn't be trying to send an empty array!
 			//A VBO with no data would just lead to memory access errors.
 			if (data.size() == 0)
 			{
-				m_vbo.erase(attrib);
+				vbo.reset();
 				return;
 			}
 
-			auto it = m_vbo.find(attrib);
-
 			//If our VBO does not already exist, make a new one.
-			if (it == m_vbo.end())
-				m_vbo.insert({attrib,
-					std::make_unique<VertexBuffer>(elementLen, data)});
+			if (vbo == nullptr)
+				vbo = std::make_unique<VertexBuffer>(elementLen, data);
 			//If our VBO does exist, update it with the new data specified.
 			else
-				it->second->UpdateData(data);
+				vbo->UpdateData(data);
 		}
 	};
 }
\ No newline at end of file
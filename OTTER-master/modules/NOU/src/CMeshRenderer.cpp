@@ -36,18 +36,12 @@ namespace nou
 	//to the VAO used for this renderer.
 	//Basically, this makes sure that OpenGL will be able to find all of
 	//the data needed to draw our 3D model.
+	//(The mesh knows whether its data is in separate or interleaved buffers.)
 	void CMeshRenderer::SetMesh(const Mesh& mesh)
 	{
-		const VertexBuffer* vbo;
-
-		if ((vbo = mesh.GetVBO(Mesh::Attrib::POSITION)) != nullptr)
-			m_vao->BindAttrib(*vbo, (GLint)Mesh::Attrib::POSITION);
-
-		if ((vbo = mesh.GetVBO(Mesh::Attrib::NORMAL)) != nullptr)
-			m_vao->BindAttrib(*vbo, (GLint)Mesh::Attrib::NORMAL);
-
-		if ((vbo = mesh.GetVBO(Mesh::Attrib::UV)) != nullptr)
-			m_vao->BindAttrib(*vbo, (GLint)Mesh::Attrib::UV);
+		mesh.BindAttrib(*m_vao, Mesh::Attrib::POSITION, (GLint)Mesh::Attrib::POSITION);
+		mesh.BindAttrib(*m_vao, Mesh::Attrib::NORMAL, (GLint)Mesh::Attrib::NORMAL);
+		mesh.BindAttrib(*m_vao, Mesh::Attrib::UV, (GLint)Mesh::Attrib::UV);
 	}
 
 	void CMeshRenderer::SetMaterial(Material& mat)
@@ -15,7 +15,7 @@ Helpful reference: https://www.khronos.org/files/gltf20-reference-guide.pdf
 
 namespace nou::GLTF
 {
-	void LoadMesh(const std::string& filename, Mesh& mesh, bool flipUVY)
+	void LoadMesh(const std::string& filename, Mesh& mesh, bool flipUVY, bool interleaved)
 	{
 		auto gltf = std::make_unique<tinygltf::Model>();
 
@@ -29,7 +29,7 @@ namespace nou::GLTF
 			return;
 		}
 
-		result = ExtractGeometry(*gltf, mesh, flipUVY, err, warn);
+		result = ExtractGeometry(*gltf, mesh, flipUVY, err, warn, interleaved);
 
 		if (!result)
 		{
@@ -39,6 +39,30 @@ namespace nou::GLTF
 
 		DumpErrorsAndWarnings(filename, err, warn);
 		printf("Loaded mesh from %s.\n", filename.c_str());
+
+		//If the mesh drops its CPU data after upload, this lets it load the data
+		//again from the file should it ever need it.
+		mesh.SetReloader([filename, flipUVY](std::vector<glm::vec3>& verts,
+											 std::vector<glm::vec3>& normals,
+											 std::vector<glm::vec2>& uvs)
+		{
+			auto gltf = std::make_unique<tinygltf::Model>();
+			std::string err, warn;
+			bool hasNormals = true, hasUVs = true;
+
+			bool result = ParseGLTF(filename, *gltf, err, warn) &&
+						  ExtractGeometry(*gltf, verts, uvs, normals, flipUVY,
+										  hasNormals, hasUVs, err, warn);
+
+			DumpErrorsAndWarnings(filename, err, warn);
+
+			if (!hasNormals)
+				normals.clear();
+			if (!hasUVs)
+				uvs.clear();
+
+			return result;
+		});
 	}
 
 	void DumpErrorsAndWarnings(const std::string& filename,
@@ -103,6 +127,60 @@ namespace nou::GLTF
 	}
 
 	bool ExtractGeometry(const tinygltf::Model& gltf, Mesh& mesh, bool flipUVY,
+						 std::string& err, std::string& warn, bool interleaved)
+	{
+		std::vector<glm::vec3> verts;
+		std::vector<glm::vec3> normals;
+		std::vector<glm::vec2> uvs;
+
+		bool hasNormals = true, hasUVs = true;
+
+		if (!ExtractGeometry(gltf, verts, uvs, normals, flipUVY, hasNormals, hasUVs, err, warn))
+			return false;
+
+		if (interleaved && !verts.empty())
+		{
+			//Write everything into a single array, one whole vertex after another.
+			Mesh::Layout layout = {};
+			std::array<const float*, Mesh::ATTRIB_COUNT> sources = {};
+
+			layout[(size_t)Mesh::Attrib::POSITION] = 3;
+			sources[(size_t)Mesh::Attrib::POSITION] = &(verts[0].x);
+
+			if (hasNormals)
+			{
+				layout[(size_t)Mesh::Attrib::NORMAL] = 3;
+				sources[(size_t)Mesh::Attrib::NORMAL] = &(normals[0].x);
+			}
+
+			if (hasUVs)
+			{
+				layout[(size_t)Mesh::Attrib::UV] = 2;
+				sources[(size_t)Mesh::Attrib::UV] = &(uvs[0].x);
+			}
+
+			mesh.SetInterleaved(Mesh::Interleave(layout, sources, verts.size()), layout);
+			mesh.SetCPUData(verts,
+							hasNormals ? normals : std::vector<glm::vec3>(),
+							hasUVs ? uvs : std::vector<glm::vec2>());
+			return true;
+		}
+
+		mesh.SetVerts(verts);
+
+		if(hasNormals)
+			mesh.SetNormals(normals);
+
+		if(hasUVs)
+			mesh.SetUVs(uvs);
+
+		return true;
+	}
+
+	bool ExtractGeometry(const tinygltf::Model& gltf,
+						 std::vector<glm::vec3>& verts, std::vector<glm::vec2>& uvs,
+						 std::vector<glm::vec3>& normals, bool flipUVY,
+						 bool& hasNormals, bool& hasUVs,
 						 std::string& err, std::string& warn)
 	{
 		if (gltf.meshes.size() == 0)
@@ -119,12 +197,6 @@ namespace nou::GLTF
 			return false;
 		}
 
-		std::vector<glm::vec3> verts;
-		std::vector<glm::vec3> normals;
-		std::vector<glm::vec2> uvs;
-
-		bool hasNormals = true, hasUVs = true;
-
 		for (size_t i = 0; i < meshData.primitives.size(); ++i)
 		{
 			if(!ProcessPrimitive(gltf, i, verts, uvs, normals, 
@@ -132,14 +204,6 @@ namespace nou::GLTF
 				return false;
 		}
 
-		mesh.SetVerts(verts);
-
-		if(hasNormals)
-			mesh.SetNormals(normals);
-
-		if(hasUVs)
-			mesh.SetUVs(uvs);
-
 		return true;
 	}
 
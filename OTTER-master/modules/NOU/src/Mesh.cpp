@@ -8,33 +8,252 @@ Very basic class for managing the data associated with a 3D model.
 
 #include "NOU/Mesh.h"
 
+#include <cstring>
+#include <cstdio>
+
 namespace nou
 {
+	Mesh::Mesh()
+	{
+		m_layout.fill(0);
+		m_offsets.fill(0);
+
+		m_residency = defaultResidency;
+		m_vertCount = 0;
+		m_hasBounds = false;
+		m_boundsMin = glm::vec3(0.0f);
+		m_boundsMax = glm::vec3(0.0f);
+	}
+
 	void Mesh::SetVerts(const std::vector<glm::vec3>& verts)
 	{
-		m_verts = verts;
-		SetVBO(Attrib::POSITION, 3, m_verts);
+		SetVBO(Attrib::POSITION, 3, verts);
+		UpdateBounds(verts);
+		Retain(m_verts, verts);
 	}
 
 	void Mesh::SetNormals(const std::vector<glm::vec3>& normals)
 	{
-		m_normals = normals;
-		SetVBO(Attrib::NORMAL, 3, m_normals);			
+		SetVBO(Attrib::NORMAL, 3, normals);
+		Retain(m_normals, normals);
 	}
 
 	void Mesh::SetUVs(const std::vector<glm::vec2>& uvs)
 	{
-		m_uvs = uvs;
-		SetVBO(Attrib::UV, 2, m_uvs);
+		SetVBO(Attrib::UV, 2, uvs);
+		Retain(m_uvs, uvs);
+	}
+
+	void Mesh::SetInterleaved(const std::vector<float>& data, const Layout& layout)
+	{
+		GLint vertLen = 0;
+
+		for (int i = 0; i < ATTRIB_COUNT; ++i)
+		{
+			m_offsets[i] = static_cast<GLsizei>(vertLen * sizeof(float));
+			vertLen += layout[i];
+
+			//Attributes in the layout now come from our interleaved buffer.
+			if (layout[i] > 0)
+				m_vbo[i].reset();
+		}
+
+		m_layout = layout;
+
+		if (vertLen == 0 || data.size() == 0)
+		{
+			m_interleaved.reset();
+			m_layout.fill(0);
+			return;
+		}
+
+		//Each element of the buffer is a whole vertex.
+		GLsizei vertSize = static_cast<GLsizei>(vertLen * sizeof(float));
+		GLsizei vertCount = static_cast<GLsizei>(data.size() / vertLen);
+
+		if (m_interleaved == nullptr)
+			m_interleaved = std::make_unique<VertexBuffer>(vertLen, vertSize, data.data(), vertCount);
+		else
+			m_interleaved->UpdateData(data.data(), vertCount, vertSize);
+	}
+
+	std::vector<float> Mesh::Interleave(const Layout& layout,
+										const std::array<const float*, ATTRIB_COUNT>& sources,
+										size_t vertCount)
+	{
+		GLint vertLen = 0;
+
+		for (int i = 0; i < ATTRIB_COUNT; ++i)
+			vertLen += layout[i];
+
+		std::vector<float> result;
+		result.resize(vertCount * vertLen);
+
+		float* dest = result.data();
+
+		for (size_t v = 0; v < vertCount; ++v)
+		{
+			for (int i = 0; i < ATTRIB_COUNT; ++i)
+			{
+				if (layout[i] == 0)
+					continue;
+
+				memcpy(dest, sources[i] + v * layout[i], layout[i] * sizeof(float));
+				dest += layout[i];
+			}
+		}
+
+		return result;
 	}
 
 	const VertexBuffer* Mesh::GetVBO(Mesh::Attrib attrib) const
 	{
-		auto it = m_vbo.find(attrib);
+		return m_vbo[static_cast<size_t>(attrib)].get();
+	}
+
+	bool Mesh::BindAttrib(VertexArray& vao, Attrib attrib, GLuint attribLoc) const
+	{
+		size_t i = static_cast<size_t>(attrib);
+
+		if (m_vbo[i] != nullptr)
+		{
+			vao.BindAttrib(*m_vbo[i], attribLoc);
+			return true;
+		}
+
+		if (m_interleaved != nullptr && m_layout[i] > 0)
+		{
+			vao.BindAttrib(*m_interleaved, attribLoc, m_layout[i], m_offsets[i]);
+			return true;
+		}
+
+		return false;
+	}
+
+	void Mesh::BindAttribs(VertexArray& vao) const
+	{
+		for (int i = 0; i < ATTRIB_COUNT; ++i)
+			BindAttrib(vao, static_cast<Attrib>(i), i);
+	}
+
+	void Mesh::SetResidency(Residency residency)
+	{
+		m_residency = residency;
+
+		if (m_residency != Residency::KEEP)
+			DropCPUData();
+	}
+
+	void Mesh::SetCPUData(const std::vector<glm::vec3>& verts,
+						  const std::vector<glm::vec3>& normals,
+						  const std::vector<glm::vec2>& uvs)
+	{
+		UpdateBounds(verts);
+		Retain(m_verts, verts);
+		Retain(m_normals, normals);
+		Retain(m_uvs, uvs);
+	}
+
+	bool Mesh::RestoreCPUData()
+	{
+		if (HasCPUData())
+			return true;
+
+		if (!m_reloader)
+			return false;
+
+		std::vector<glm::vec3> verts, normals;
+		std::vector<glm::vec2> uvs;
+
+		if (!m_reloader(verts, normals, uvs) || verts.empty())
+			return false;
+
+		UpdateBounds(verts);
+
+		m_verts = std::move(verts);
+		m_normals = std::move(normals);
+		m_uvs = std::move(uvs);
+
+		return true;
+	}
+
+	void Mesh::DropCPUData()
+	{
+		std::vector<glm::vec3>().swap(m_verts);
+		std::vector<glm::vec3>().swap(m_normals);
+		std::vector<glm::vec2>().swap(m_uvs);
+
+		if (m_residency == Residency::DROP_AFTER_UPLOAD)
+			m_hasBounds = false;
+	}
+
+	void Mesh::UpdateBounds(const std::vector<glm::vec3>& verts)
+	{
+		m_vertCount = verts.size();
+		m_hasBounds = false;
+
+		if (verts.empty() || m_residency == Residency::DROP_AFTER_UPLOAD)
+			return;
+
+		m_boundsMin = verts[0];
+		m_boundsMax = verts[0];
+
+		for (const auto& v : verts)
+		{
+			m_boundsMin = glm::min(m_boundsMin, v);
+			m_boundsMax = glm::max(m_boundsMax, v);
+		}
+
+		m_hasBounds = true;
+	}
+
+	bool Mesh::GetBounds(glm::vec3& min, glm::vec3& max) const
+	{
+		if (!m_hasBounds)
+			return false;
+
+		min = m_boundsMin;
+		max = m_boundsMax;
+		return true;
+	}
+
+	size_t Mesh::CPUBytes() const
+	{
+		size_t result = m_verts.capacity() * sizeof(glm::vec3) +
+						m_normals.capacity() * sizeof(glm::vec3) +
+						m_uvs.capacity() * sizeof(glm::vec2);
+
+		for (const auto& vbo : m_vbo)
+		{
+			if (vbo != nullptr)
+				result += vbo->CPUBytes();
+		}
 
-		if (it == m_vbo.end())
-			return nullptr;
+		if (m_interleaved != nullptr)
+			result += m_interleaved->CPUBytes();
 
-		return it->second.get();
+		return result;
+	}
+
+	size_t Mesh::GPUBytes() const
+	{
+		size_t result = 0;
+
+		for (const auto& vbo : m_vbo)
+		{
+			if (vbo != nullptr)
+				result += vbo->GPUBytes();
+		}
+
+		if (m_interleaved != nullptr)
+			result += m_interleaved->GPUBytes();
+
+		return result;
+	}
+
+	void Mesh::PrintMemory(const std::string& name) const
+	{
+		printf("%s: %zu vertices, %zu bytes on the CPU, %zu bytes on the GPU.\n",
+			   name.c_str(), m_vertCount, CPUBytes(), GPUBytes());
 	}
 }
\ No newline at end of file
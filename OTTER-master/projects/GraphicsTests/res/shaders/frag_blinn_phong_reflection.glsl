@@ -12,25 +12,41 @@ uniform sampler2D s_Specular;
 // 
 uniform sampler2D s_Reflectivity;
 uniform samplerCube s_Environment;
-uniform mat3 u_EnvironmentRotation;
 
-uniform vec3  u_AmbientCol;
-uniform float u_AmbientStrength;
-
-uniform vec3  u_LightPos;
-uniform vec3  u_LightCol;
-uniform float u_AmbientLightStrength;
-uniform float u_SpecularLightStrength;
-uniform float u_Shininess;
-// NEW in week 7, see https://learnopengl.com/Lighting/Light-casters for a good reference on how this all works, or
+// Per-material parameters, packed into a uniform buffer by ShaderMaterial
+layout(std140) uniform b_Material {
+	mat3  u_EnvironmentRotation;
+	float u_Shininess;
+	float u_TextureMix;
+};
+
+// Shared by every shader, uploaded once per frame (see CameraUniforms in BackendHandler.h)
+layout(std140) uniform b_Camera {
+	mat4 u_View;
+	mat4 u_ViewProjection;
+	mat4 u_SkyboxMatrix;
+	vec3 u_CamPos;
+};
+
+// Shared by every shader, uploaded when the lighting changes (see LightingUniforms in BackendHandler.h)
+// NEW in week 7, see https://learnopengl.com/Lighting/Light-casters for a good reference on how the attenuation works, or
 // https://developer.valvesoftware.com/wiki/Constant-Linear-Quadratic_Falloff
-uniform float u_LightAttenuationConstant;
-uniform float u_LightAttenuationLinear;
-uniform float u_LightAttenuationQuadratic;
-
-uniform float u_TextureMix;
-
-uniform vec3  u_CamPos;
+layout(std140) uniform b_Lighting {
+	vec3  u_LightPos;
+	float u_LightAttenuationConstant;
+	vec3  u_LightCol;
+	float u_LightAttenuationLinear;
+	vec3  u_AmbientCol;
+	float u_LightAttenuationQuadratic;
+	float u_AmbientStrength;
+	float u_AmbientLightStrength;
+	float u_SpecularLightStrength;
+	int   u_AmbientToggle;
+	int   u_SpecularToggle;
+	int   u_LightingOff;
+	int   u_AmbientAndSpecToggle;
+	int   u_CustomShaderToggle;
+};
 
 out vec4 frag_color;
 
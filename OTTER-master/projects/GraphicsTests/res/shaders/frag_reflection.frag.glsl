@@ -6,9 +6,19 @@ layout(location = 2) in vec3 inNormal;
 layout(location = 3) in vec2 inUV;
 
 uniform samplerCube s_Environment;
-uniform mat3 u_EnvironmentRotation;
 
-uniform vec3  u_CamPos;
+// Per-material parameters, packed into a uniform buffer by ShaderMaterial
+layout(std140) uniform b_Material {
+	mat3 u_EnvironmentRotation;
+};
+
+// Shared by every shader, uploaded once per frame (see CameraUniforms in BackendHandler.h)
+layout(std140) uniform b_Camera {
+	mat4 u_View;
+	mat4 u_ViewProjection;
+	mat4 u_SkyboxMatrix;
+	vec3 u_CamPos;
+};
 
 out vec4 frag_color;
 
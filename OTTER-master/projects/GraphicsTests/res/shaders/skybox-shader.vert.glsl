@@ -4,8 +4,18 @@ layout(location = 0) in vec3 inPosition;
 
 layout(location = 0) out vec3 outNormal;
 
-uniform mat4 u_SkyboxMatrix;
-uniform mat3 u_EnvironmentRotation;
+// Shared by every shader, uploaded once per frame (see CameraUniforms in BackendHandler.h)
+layout(std140) uniform b_Camera {
+	mat4 u_View;
+	mat4 u_ViewProjection;
+	mat4 u_SkyboxMatrix;
+	vec3 u_CamPos;
+};
+
+// Per-material parameters, packed into a uniform buffer by ShaderMaterial
+layout(std140) uniform b_Material {
+	mat3 u_EnvironmentRotation;
+};
 
 void main() {
     vec4 pos = u_SkyboxMatrix * vec4(inPosition, 1.0);
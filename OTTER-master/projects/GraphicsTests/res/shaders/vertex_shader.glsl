@@ -4,6 +4,9 @@ layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inColor;
 layout(location = 2) in vec3 inNormal;
 layout(location = 3) in vec2 inUV;
+// Per-instance transforms, only used when u_Instanced is set (see InstanceBuffer)
+layout(location = 4) in mat4 inInstanceModel;
+layout(location = 8) in mat3 inInstanceNormalMatrix;
 
 layout(location = 0) out vec3 outPos;
 layout(location = 1) out vec3 outColor;
@@ -11,22 +14,32 @@ layout(location = 2) out vec3 outNormal;
 layout(location = 3) out vec2 outUV;
 
 uniform mat4 u_ModelViewProjection;
-uniform mat4 u_View;
 uniform mat4 u_Model;
 uniform mat3 u_NormalMatrix;
-uniform vec3 u_LightPos;
+uniform bool u_Instanced;
 
+// Shared by every shader, uploaded once per frame (see CameraUniforms in BackendHandler.h)
+layout(std140) uniform b_Camera {
+	mat4 u_View;
+	mat4 u_ViewProjection;
+	mat4 u_SkyboxMatrix;
+	vec3 u_CamPos;
+};
 
 void main() {
 
-	gl_Position = u_ModelViewProjection * vec4(inPosition, 1.0);
+	// Instanced draws read their transforms from the instance buffer instead of the per-object uniforms
+	mat4 model = u_Instanced ? inInstanceModel : u_Model;
+	mat3 normalMatrix = u_Instanced ? inInstanceNormalMatrix : u_NormalMatrix;
+
+	gl_Position = u_Instanced ? u_ViewProjection * model * vec4(inPosition, 1.0) : u_ModelViewProjection * vec4(inPosition, 1.0);
 
 	// Lecture 5
 	// Pass vertex pos in world space to frag shader
-	outPos = (u_Model * vec4(inPosition, 1.0)).xyz;
+	outPos = (model * vec4(inPosition, 1.0)).xyz;
 
 	// Normals
-	outNormal = u_NormalMatrix * inNormal;
+	outNormal = normalMatrix * inNormal;
 
 	// Pass our UV coords to the fragment shader
 	outUV = inUV;
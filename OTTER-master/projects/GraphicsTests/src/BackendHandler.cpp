@@ -2,6 +2,8 @@
 
 GLFWwindow* BackendHandler::window = nullptr;
 std::vector<std::function<void()>> BackendHandler::imGuiCallbacks;
+UniformBuffer::sptr BackendHandler::cameraBlock = nullptr;
+UniformBuffer::sptr BackendHandler::lightingBlock = nullptr;
 
 
 void BackendHandler::GlDebugMessage(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* userParam)
@@ -37,6 +39,8 @@ bool BackendHandler::InitAll()
 	if (!InitGLAD())
 		return 1;
 
+	InitUniformBlocks();
+
 	InitImGui();
 }
 
@@ -158,21 +162,79 @@ void BackendHandler::RenderImGui()
 	}
 }
 
+// The uniforms that are set for every frame or every draw, registered up front so that shaders can look up their
+// locations by index instead of by name
+static const UniformId U_MODEL_VIEW_PROJECTION("u_ModelViewProjection");
+static const UniformId U_MODEL("u_Model");
+static const UniformId U_NORMAL_MATRIX("u_NormalMatrix");
+static const UniformId U_INSTANCED("u_Instanced");
+
 void BackendHandler::RenderVAO(const Shader::sptr& shader, const VertexArrayObject::sptr& vao, const glm::mat4& viewProjection, const Transform& transform)
 {
-	shader->SetUniformMatrix("u_ModelViewProjection", viewProjection * transform.WorldTransform());
-	shader->SetUniformMatrix("u_Model", transform.WorldTransform());
-	shader->SetUniformMatrix("u_NormalMatrix", transform.WorldNormalMatrix());
+	SetupShaderForObject(shader, viewProjection, transform);
 	vao->Render();
 }
 
-void BackendHandler::SetupShaderForFrame(const Shader::sptr& shader, const glm::mat4& view, const glm::mat4& projection)
+void BackendHandler::RenderLod(const Shader::sptr& shader, const LodMesh::sptr& mesh, int level, const glm::mat4& viewProjection, const Transform& transform)
+{
+	SetupShaderForObject(shader, viewProjection, transform);
+	mesh->Render(level);
+}
+
+void BackendHandler::RenderInstanced(const Shader::sptr& shader, const VertexArrayObject::sptr& vao, const InstanceBuffer& instances, uint32_t baseInstance, uint32_t instanceCount)
+{
+	shader->SetUniform(U_INSTANCED, true);
+	vao->RenderInstanced(instances, baseInstance, instanceCount);
+}
+
+void BackendHandler::RenderLodInstanced(const Shader::sptr& shader, const LodMesh::sptr& mesh, int level, const InstanceBuffer& instances, uint32_t baseInstance, uint32_t instanceCount)
+{
+	shader->SetUniform(U_INSTANCED, true);
+	mesh->RenderInstanced(level, instances, baseInstance, instanceCount);
+}
+
+void BackendHandler::SetupShaderForObject(const Shader::sptr& shader, const glm::mat4& viewProjection, const Transform& transform)
+{
+	shader->SetUniformMatrix(U_MODEL_VIEW_PROJECTION, viewProjection * transform.WorldTransform());
+	shader->SetUniformMatrix(U_MODEL, transform.WorldTransform());
+	shader->SetUniformMatrix(U_NORMAL_MATRIX, transform.WorldNormalMatrix());
+	shader->SetUniform(U_INSTANCED, false);
+}
+
+void BackendHandler::InitUniformBlocks()
+{
+	// Every shader that declares these blocks will read them from the same binding point, so each block only needs
+	// to be uploaded and bound once instead of being set on every shader
+	Shader::SetUniformBlockBinding("b_Camera", CAMERA_BLOCK_BINDING);
+	Shader::SetUniformBlockBinding("b_Lighting", LIGHTING_BLOCK_BINDING);
+
+	cameraBlock = UniformBuffer::Create();
+	cameraBlock->Update(CameraUniforms());
+	cameraBlock->Bind(CAMERA_BLOCK_BINDING);
+
+	lightingBlock = UniformBuffer::Create();
+	lightingBlock->Update(LightingUniforms());
+	lightingBlock->Bind(LIGHTING_BLOCK_BINDING);
+}
+
+void BackendHandler::ShutdownUniformBlocks()
+{
+	cameraBlock = nullptr;
+	lightingBlock = nullptr;
+}
+
+void BackendHandler::UpdateCameraBlock(const glm::mat4& view, const glm::mat4& projection)
+{
+	CameraUniforms camera;
+	camera.View = view;
+	camera.ViewProjection = projection * view;
+	camera.SkyboxMatrix = projection * glm::mat4(glm::mat3(view));
+	camera.CamPos = glm::inverse(view) * glm::vec4(0, 0, 0, 1);
+	camera.Padding = 0.0f;
+	cameraBlock->Update(camera);
+}
+
+void BackendHandler::UpdateLightingBlock(const LightingUniforms& lighting)
 {
-	shader->Bind();
-	// These are the uniforms that update only once per frame
-	shader->SetUniformMatrix("u_View", view);
-	shader->SetUniformMatrix("u_ViewProjection", projection * view);
-	shader->SetUniformMatrix("u_SkyboxMatrix", projection * glm::mat4(glm::mat3(view)));
-	glm::vec3 camPos = glm::inverse(view) * glm::vec4(0, 0, 0, 1);
-	shader->SetUniform("u_CamPos", camPos);
+	lightingBlock->Update(lighting);
 }
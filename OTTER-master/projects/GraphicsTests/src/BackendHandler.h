@@ -8,7 +8,10 @@
 
 #include <Transform.h>
 #include <VertexArrayObject.h>
+#include <LodMesh.h>
 #include <Shader.h>
+#include <InstanceBuffer.h>
+#include <UniformBuffer.h>
 
 #include <Application.h>
 #include <Camera.h>
@@ -20,6 +23,38 @@
 
 #define LOG_GL_NOTIFICATIONS
 
+// The std140 layout of the b_Camera uniform block that our shaders declare. vec3s take up 16 bytes in a block, so
+// they're followed by padding or a float that fills the gap
+struct CameraUniforms
+{
+	glm::mat4 View;
+	glm::mat4 ViewProjection;
+	glm::mat4 SkyboxMatrix;
+	glm::vec3 CamPos;
+	float     Padding;
+};
+static_assert(sizeof(CameraUniforms) == 208, "CameraUniforms must match the std140 layout of b_Camera");
+
+// The std140 layout of the b_Lighting uniform block that our shaders declare
+struct LightingUniforms
+{
+	glm::vec3 LightPos;
+	float     AttenuationConstant;
+	glm::vec3 LightCol;
+	float     AttenuationLinear;
+	glm::vec3 AmbientCol;
+	float     AttenuationQuadratic;
+	float     AmbientStrength;
+	float     AmbientLightStrength;
+	float     SpecularLightStrength;
+	int       AmbientToggle;
+	int       SpecularToggle;
+	int       LightingOff;
+	int       AmbientAndSpecToggle;
+	int       CustomShaderToggle;
+};
+static_assert(sizeof(LightingUniforms) == 80, "LightingUniforms must match the std140 layout of b_Lighting");
+
 class BackendHandler abstract
 {
 public:
@@ -53,8 +88,28 @@ public:
 
 	//Render our VAO
 	static void RenderVAO(const Shader::sptr& shader, const VertexArrayObject::sptr& vao, const glm::mat4& viewProjection, const Transform& transform);
-	static void SetupShaderForFrame(const Shader::sptr& shader, const glm::mat4& view, const glm::mat4& projection);
+	//Render one level of a LOD mesh
+	static void RenderLod(const Shader::sptr& shader, const LodMesh::sptr& mesh, int level, const glm::mat4& viewProjection, const Transform& transform);
+	//Render several copies of a VAO in one draw, the shader must support instancing
+	static void RenderInstanced(const Shader::sptr& shader, const VertexArrayObject::sptr& vao, const InstanceBuffer& instances, uint32_t baseInstance, uint32_t instanceCount);
+	//Render several copies of one level of a LOD mesh in one draw, the shader must support instancing
+	static void RenderLodInstanced(const Shader::sptr& shader, const LodMesh::sptr& mesh, int level, const InstanceBuffer& instances, uint32_t baseInstance, uint32_t instanceCount);
+	static void SetupShaderForObject(const Shader::sptr& shader, const glm::mat4& viewProjection, const Transform& transform);
+
+	//Uniform blocks shared by all of our shaders, these must be set up before any shaders are linked
+	static void InitUniformBlocks();
+	static void ShutdownUniformBlocks();
+	//Upload the camera for this frame, once for every shader
+	static void UpdateCameraBlock(const glm::mat4& view, const glm::mat4& projection);
+	//Upload the lighting, this only needs to be called when the lighting changes
+	static void UpdateLightingBlock(const LightingUniforms& lighting);
+
+	//The binding points of the shared uniform blocks, Shader::MATERIAL_BLOCK_BINDING is already taken by materials
+	static const GLuint CAMERA_BLOCK_BINDING = 0;
+	static const GLuint LIGHTING_BLOCK_BINDING = 1;
 
 	static GLFWwindow* window;
 	static std::vector<std::function<void()>> imGuiCallbacks;
+	static UniformBuffer::sptr cameraBlock;
+	static UniformBuffer::sptr lightingBlock;
 };
\ No newline at end of file
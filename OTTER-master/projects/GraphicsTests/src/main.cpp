@@ -8,12 +8,18 @@
 #include <Texture2D.h>
 #include <Texture2DData.h>
 #include <MeshBuilder.h>
+#include <GeometryArena.h>
 #include <MeshFactory.h>
 #include <NotObjLoader.h>
 #include <ObjLoader.h>
+#include <MeshRegistry.h>
+#include <AssetLoader.h>
+#include <AssetMemory.h>
 #include <VertexTypes.h>
 #include <ShaderMaterial.h>
 #include <RendererComponent.h>
+#include <Bounds.h>
+#include <RenderQueue.h>
 #include <TextureCubeMap.h>
 #include <TextureCubeMapData.h>
 
@@ -34,6 +40,27 @@ int main() {
 	float minFps, maxFps, avgFps;
 	int selectedVao = 0; // select cube by default
 	std::vector<GameObject> controllables;
+	// The number of triangles drawn from LOD meshes last frame, and how many there would have been at full detail
+	size_t lodTrianglesDrawn = 0, lodTrianglesFull = 0;
+	// The number of renderers that were drawn and skipped by frustum culling last frame
+	size_t objectsDrawn = 0, objectsCulled = 0;
+	bool enableCulling = true;
+	// The renderers that passed culling this frame, reused between frames to avoid allocating
+	std::vector<entt::entity> visibleRenderers;
+	// A run of visible renderers that share a mesh, material and level of detail. If the shader supports it, the
+	// whole run is drawn with one instanced draw, otherwise each batch holds a single renderer
+	struct DrawBatch
+	{
+		size_t   First;
+		uint32_t Count;
+		uint32_t BaseInstance;
+	};
+	std::vector<DrawBatch> drawBatches;
+	// The number of draw calls issued for renderers last frame
+	size_t drawCalls = 0;
+	bool enableInstancing = true;
+	// Sorts the visible renderers each frame, skipping the sort when nothing has changed
+	RenderQueue::sptr renderQueue = RenderQueue::Create();
 
 	BackendHandler::InitAll();
 
@@ -70,24 +97,9 @@ int main() {
 		bool ambient_And_Specular_Toggle = false;
 		bool custom_Shader_Toggle = false;
 
-		// These are our application / scene level uniforms that don't necessarily update
-		// every frame
-		shader->SetUniform("u_LightPos", lightPos);
-		shader->SetUniform("u_LightCol", lightCol);
-		shader->SetUniform("u_AmbientLightStrength", lightAmbientPow);
-		shader->SetUniform("u_SpecularLightStrength", lightSpecularPow);
-		shader->SetUniform("u_AmbientCol", ambientCol);
-		shader->SetUniform("u_AmbientStrength", ambientPow);
-		shader->SetUniform("u_LightAttenuationConstant", 1.0f);
-		shader->SetUniform("u_LightAttenuationLinear", lightLinearFalloff);
-		shader->SetUniform("u_LightAttenuationQuadratic", lightQuadraticFalloff);
-		
-		//set More uniform variables for lighting toggles
-		shader->SetUniform("u_AmbientToggle", (int)ambientToggle);
-		shader->SetUniform("u_SpecularToggle", (int)specularToggle);
-		shader->SetUniform("u_LightingOff", (int)noLightingToggle);
-		shader->SetUniform("u_AmbientAndSpecToggle", (int)ambient_And_Specular_Toggle);
-		shader->SetUniform("u_CustomShaderToggle", (int)custom_Shader_Toggle);
+		// These are our application / scene level uniforms that don't necessarily update every frame. They're shared by
+		// all of our shaders through the lighting uniform block, so we only upload them when one of them changes
+		bool lightingChanged = true;
 		
 		// We'll add some ImGui controls to control our shader
 		BackendHandler::imGuiCallbacks.push_back([&]() {
@@ -99,6 +111,7 @@ int main() {
 				specularToggle = false;
 				ambient_And_Specular_Toggle = false;
 				custom_Shader_Toggle = false;
+				lightingChanged = true;
 			
 			}
 			
@@ -109,6 +122,7 @@ int main() {
 				specularToggle = false;
 				ambient_And_Specular_Toggle = false;
 				custom_Shader_Toggle = false;
+				lightingChanged = true;
 		
 			}
 
@@ -119,6 +133,7 @@ int main() {
 				specularToggle = true;
 				ambient_And_Specular_Toggle = false;
 				custom_Shader_Toggle = false;
+				lightingChanged = true;
 
 			}
 
@@ -129,6 +144,7 @@ int main() {
 				specularToggle = false;
 				ambient_And_Specular_Toggle = true;
 				custom_Shader_Toggle = false;
+				lightingChanged = true;
 			}
 
 			if (ImGui::Checkbox("Ambient + Specular + Toon Shading", &custom_Shader_Toggle))
@@ -138,44 +154,38 @@ int main() {
 				specularToggle = false;
 				ambient_And_Specular_Toggle = false;
 				custom_Shader_Toggle = true;
+				lightingChanged = true;
 			}
 
-			//Re-set the unifrom variables in the shader after Imgui toggles
-			shader->SetUniform("u_AmbientToggle", (int)ambientToggle);
-			shader->SetUniform("u_SpecularToggle", (int)specularToggle);
-			shader->SetUniform("u_LightingOff", (int)noLightingToggle);
-			shader->SetUniform("u_AmbientAndSpecToggle", (int)ambient_And_Specular_Toggle);
-			shader->SetUniform("u_CustomShaderToggle", (int)custom_Shader_Toggle);
-
 
 			if (ImGui::CollapsingHeader("Scene Level Lighting Settings"))
 			{
 				if (ImGui::ColorPicker3("Ambient Color", glm::value_ptr(ambientCol))) {
-					shader->SetUniform("u_AmbientCol", ambientCol);
+					lightingChanged = true;
 				}
 				if (ImGui::SliderFloat("Fixed Ambient Power", &ambientPow, 0.01f, 1.0f)) {
-					shader->SetUniform("u_AmbientStrength", ambientPow);
+					lightingChanged = true;
 				}
 			}
 			if (ImGui::CollapsingHeader("Light Level Lighting Settings"))
 			{
 				if (ImGui::DragFloat3("Light Pos", glm::value_ptr(lightPos), 0.01f, -10.0f, 10.0f)) {
-					shader->SetUniform("u_LightPos", lightPos);
+					lightingChanged = true;
 				}
 				if (ImGui::ColorPicker3("Light Col", glm::value_ptr(lightCol))) {
-					shader->SetUniform("u_LightCol", lightCol);
+					lightingChanged = true;
 				}
 				if (ImGui::SliderFloat("Light Ambient Power", &lightAmbientPow, 0.0f, 1.0f)) {
-					shader->SetUniform("u_AmbientLightStrength", lightAmbientPow);
+					lightingChanged = true;
 				}
 				if (ImGui::SliderFloat("Light Specular Power", &lightSpecularPow, 0.0f, 1.0f)) {
-					shader->SetUniform("u_SpecularLightStrength", lightSpecularPow);
+					lightingChanged = true;
 				}
 				if (ImGui::DragFloat("Light Linear Falloff", &lightLinearFalloff, 0.01f, 0.0f, 1.0f)) {
-					shader->SetUniform("u_LightAttenuationLinear", lightLinearFalloff);
+					lightingChanged = true;
 				}
 				if (ImGui::DragFloat("Light Quadratic Falloff", &lightQuadraticFalloff, 0.01f, 0.0f, 1.0f)) {
-					shader->SetUniform("u_LightAttenuationQuadratic", lightQuadraticFalloff);
+					lightingChanged = true;
 				}
 			}
 
@@ -196,6 +206,23 @@ int main() {
 			}
 			ImGui::PlotLines("FPS", fpsBuffer, 128);
 			ImGui::Text("MIN: %f MAX: %f AVG: %f", minFps, maxFps, avgFps / 128.0f);
+
+			if (ImGui::CollapsingHeader("Level of Detail")) {
+				ImGui::SliderFloat("Max Screen Error", &LodMesh::MaxScreenError, 0.0f, 0.02f, "%.4f");
+				ImGui::SliderFloat("Hysteresis", &LodMesh::Hysteresis, 0.0f, 0.9f);
+				ImGui::Text("LOD triangles: %zu / %zu", lodTrianglesDrawn, lodTrianglesFull);
+			}
+			if (ImGui::CollapsingHeader("Culling")) {
+				ImGui::Checkbox("Frustum Culling", &enableCulling);
+				ImGui::Text("Drawn: %zu Culled: %zu", objectsDrawn, objectsCulled);
+			}
+			if (ImGui::CollapsingHeader("Instancing")) {
+				ImGui::Checkbox("Automatic Instancing", &enableInstancing);
+				ImGui::Text("Draw calls: %zu for %zu objects", drawCalls, objectsDrawn);
+			}
+			if (ImGui::CollapsingHeader("Render Queue")) {
+				ImGui::Text("Sorts: %zu Skipped: %zu", renderQueue->GetStats().Sorts, renderQueue->GetStats().SkippedSorts);
+			}
 			});
 
 		
@@ -207,25 +234,25 @@ int main() {
 		glEnable(GL_CULL_FACE);
 		glDepthFunc(GL_LEQUAL); // New 
 
+		// Optimize meshes for the vertex cache as they load, and log the before and after ACMR
+		AssetLoader::OptimizeMeshes = true;
+
 		#pragma region TEXTURE LOADING
 
 		// Load some textures from files
-		Texture2D::sptr diffuse = Texture2D::LoadFromFile("images/Stone_001_Diffuse.png");
-		Texture2D::sptr diffuse2 = Texture2D::LoadFromFile("images/box.bmp");
-		Texture2D::sptr specular = Texture2D::LoadFromFile("images/Stone_001_Specular.png");
-		Texture2D::sptr reflectivity = Texture2D::LoadFromFile("images/box-reflections.bmp");
+		Texture2D::sptr diffuse = AssetLoader::LoadTexture("images/Stone_001_Diffuse.png");
+		Texture2D::sptr diffuse2 = AssetLoader::LoadTexture("images/box.bmp");
+		Texture2D::sptr specular = AssetLoader::LoadTexture("images/Stone_001_Specular.png");
+		Texture2D::sptr reflectivity = AssetLoader::LoadTexture("images/box-reflections.bmp");
 		//Material Applied to plane
-		Texture2D::sptr metalDiffuse = Texture2D::LoadFromFile("images/Metal.jpg");
+		Texture2D::sptr metalDiffuse = AssetLoader::LoadTexture("images/Metal.jpg");
 		//Material applied to test tube
-		Texture2D::sptr goldDiffuse = Texture2D::LoadFromFile("images/Gold_3.jpg");
+		Texture2D::sptr goldDiffuse = AssetLoader::LoadTexture("images/Gold_3.jpg");
 
 #pragma region Box texture
 	
-		//Loaded in new textures
-		Texture2DData::sptr boxDiffuseMap = Texture2DData::LoadFromFile("images/BoxTexture.png");
 		//Create New texture to be applied to Box.obj
-		Texture2D::sptr boxDiffuse = Texture2D::Create();
-		boxDiffuse->LoadData(boxDiffuseMap);
+		Texture2D::sptr boxDiffuse = AssetLoader::LoadTexture("images/BoxTexture.png");
 		//Create empty texture
 		Texture2DDescription boxDesc = Texture2DDescription();
 		boxDesc.Width = 1;
@@ -237,14 +264,9 @@ int main() {
 #pragma endregion
 
 #pragma region Chicken texture
-		//Loaded in new textures
-		Texture2DData::sptr drumstickDiffuseMap = Texture2DData::LoadFromFile("images/Drumstick UV's.png");
-		Texture2DData::sptr drumstickSpecularMap = Texture2DData::LoadFromFile("images/Drumstick UV's.png");
 		//Create New texture to be applied to Chicken.obj
-		Texture2D::sptr drumstickDiffuse = Texture2D::Create();
-		drumstickDiffuse->LoadData(drumstickDiffuseMap);
-		Texture2D::sptr drumstickSpecular = Texture2D::Create();
-		drumstickSpecular->LoadData(drumstickSpecularMap);
+		Texture2D::sptr drumstickDiffuse = AssetLoader::LoadTexture("images/Drumstick UV's.png");
+		Texture2D::sptr drumstickSpecular = AssetLoader::LoadTexture("images/Drumstick UV's.png");
 
 		//Create empty texture
 		Texture2DDescription drumStickDesc = Texture2DDescription();
@@ -257,11 +279,8 @@ int main() {
 #pragma endregion
 
 #pragma region Door Texture
-		//Loaded in new textures
-		Texture2DData::sptr doorDiffuseMap = Texture2DData::LoadFromFile("images/DoorTexture.png");
 		//Create New texture to be applied to Door.obj
-		Texture2D::sptr doorDiffuse = Texture2D::Create();
-		doorDiffuse->LoadData(doorDiffuseMap);
+		Texture2D::sptr doorDiffuse = AssetLoader::LoadTexture("images/DoorTexture.png");
 		//Create empty texture
 		Texture2DDescription doorDesc = Texture2DDescription();
 		doorDesc.Width = 1;
@@ -273,12 +292,8 @@ int main() {
 
 #pragma region Robot Texture
 		
-		//Loaded in new textures
-		Texture2DData::sptr robotDiffuseMap = Texture2DData::LoadFromFile("images/Robot Texture_3.jpg");
-		Texture2DData::sptr robotSpecularMap = Texture2DData::LoadFromFile("images/Robot Texture_2.png");
 		//Create New texture to be applied to Gun_Bot.obj
-		Texture2D::sptr robotDiffuse = Texture2D::Create();
-		robotDiffuse->LoadData(robotDiffuseMap);
+		Texture2D::sptr robotDiffuse = AssetLoader::LoadTexture("images/Robot Texture_3.jpg");
 		//Create empty texture
 		Texture2DDescription robotDesc = Texture2DDescription();
 		robotDesc.Width = 1;
@@ -350,15 +365,6 @@ int main() {
 		material1->Set("s_Specular", specular);
 		material1->Set("s_Reflectivity", reflectivity); 
 		material1->Set("s_Environment", environmentMap); 
-		material1->Set("u_LightPos", lightPos);
-		material1->Set("u_LightCol", lightCol);
-		material1->Set("u_AmbientLightStrength", lightAmbientPow); 
-		material1->Set("u_SpecularLightStrength", lightSpecularPow); 
-		material1->Set("u_AmbientCol", ambientCol);
-		material1->Set("u_AmbientStrength", ambientPow);
-		material1->Set("u_LightAttenuationConstant", 1.0f);
-		material1->Set("u_LightAttenuationLinear", lightLinearFalloff);
-		material1->Set("u_LightAttenuationQuadratic", lightQuadraticFalloff);
 		material1->Set("u_Shininess", 8.0f);
 		material1->Set("u_TextureMix", 0.5f);
 		material1->Set("u_EnvironmentRotation", glm::mat3(glm::rotate(glm::mat4(1.0f), glm::radians(90.0f), glm::vec3(1, 0, 0))));
@@ -426,7 +432,7 @@ int main() {
 
 		GameObject obj2 = scene->CreateEntity("Box");
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/Box.obj");
+			VertexArrayObject::sptr vao = AssetLoader::LoadObj("models/Box.obj");
 			obj2.emplace<RendererComponent>().SetMesh(vao).SetMaterial(material2);
 			obj2.get<Transform>().SetLocalPosition(-4.0f, -0.5f, -0.4f);
 			obj2.get<Transform>().SetLocalScale(0.1f, 0.1f, 0.1f);
@@ -436,7 +442,7 @@ int main() {
 
 		GameObject obj13 = scene->CreateEntity("Box");
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/Box.obj");
+			VertexArrayObject::sptr vao = AssetLoader::LoadObj("models/Box.obj");
 			obj13.emplace<RendererComponent>().SetMesh(vao).SetMaterial(material2);
 			obj13.get<Transform>().SetLocalPosition(-4.0f, -0.5f, 0.3f);
 			obj13.get<Transform>().SetLocalScale(0.1f, 0.1f, 0.1f);
@@ -446,7 +452,7 @@ int main() {
 
 		GameObject obj14 = scene->CreateEntity("Box");
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/Box.obj");
+			VertexArrayObject::sptr vao = AssetLoader::LoadObj("models/Box.obj");
 			obj14.emplace<RendererComponent>().SetMesh(vao).SetMaterial(material2);
 			obj14.get<Transform>().SetLocalPosition(-3.3f, -1.0f, -0.4f);
 			obj14.get<Transform>().SetLocalScale(0.1f, 0.1f, 0.1f);
@@ -456,7 +462,7 @@ int main() {
 
 		GameObject obj15 = scene->CreateEntity("Box");
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/Box.obj");
+			VertexArrayObject::sptr vao = AssetLoader::LoadObj("models/Box.obj");
 			obj15.emplace<RendererComponent>().SetMesh(vao).SetMaterial(material2);
 			obj15.get<Transform>().SetLocalPosition(-3.3f, -1.0f, 0.3f);
 			obj15.get<Transform>().SetLocalScale(0.1f, 0.1f, 0.1f);
@@ -467,8 +473,8 @@ int main() {
 		
 		GameObject obj3 = scene->CreateEntity("Test Tube");
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/TestTube.obj");
-			obj3.emplace<RendererComponent>().SetMesh(vao).SetMaterial(material7);
+			LodMesh::sptr lods = AssetLoader::LoadObjLods("models/TestTube.obj");
+			obj3.emplace<RendererComponent>().SetMesh(lods).SetMaterial(material7);
 			obj3.get<Transform>().SetLocalPosition(4.0f, -2.5f, -0.8f);
 			obj3.get<Transform>().SetLocalScale(0.5f, 0.5f, 0.5f);
 			obj3.get<Transform>().SetLocalRotation(90.0f, 0.0f, 90.0f);
@@ -477,8 +483,8 @@ int main() {
 
 		GameObject obj4 = scene->CreateEntity("Chicken Model");
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/Drumstick Walk Frame 1.obj");
-			obj4.emplace<RendererComponent>().SetMesh(vao).SetMaterial(material3);
+			LodMesh::sptr lods = AssetLoader::LoadObjLods("models/Drumstick Walk Frame 1.obj", glm::vec4(1.0f), VertexFormat::Packed);
+			obj4.emplace<RendererComponent>().SetMesh(lods).SetMaterial(material3);
 			obj4.get<Transform>().SetLocalPosition(1.3f, 1.0f, -0.8f);
 			obj4.get<Transform>().SetLocalScale(0.2f, 0.2f, 0.2f);
 			obj4.get<Transform>().SetLocalRotation(90.0f, 0.0f, 0.0f);
@@ -495,7 +501,7 @@ int main() {
 		
 		GameObject obj5 = scene->CreateEntity("Door Model");
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/Door-FIXED.obj");
+			VertexArrayObject::sptr vao = AssetLoader::LoadObj("models/Door-FIXED.obj", glm::vec4(1.0f), VertexFormat::Packed);
 			obj5.emplace<RendererComponent>().SetMesh(vao).SetMaterial(material4);
 			obj5.get<Transform>().SetLocalPosition(1.5f, -4.5f, 2.5f);
 			obj5.get<Transform>().SetLocalScale(0.5f, 0.5f, 0.5f);
@@ -505,7 +511,7 @@ int main() {
 
 		GameObject obj6 = scene->CreateEntity("Plane");
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/Simple Plane.obj");
+			VertexArrayObject::sptr vao = AssetLoader::LoadObj("models/Simple Plane.obj");
 			obj6.emplace<RendererComponent>().SetMesh(vao).SetMaterial(material5);
 			obj6.get<Transform>().SetLocalPosition(0.0f, 0.0f, 0.0f);
 			obj6.get<Transform>().SetLocalScale(0.9f, 0.9f, 0.9f);
@@ -515,8 +521,8 @@ int main() {
 
 		GameObject obj8 = scene->CreateEntity("Test Tube");
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/TestTube.obj");
-			obj8.emplace<RendererComponent>().SetMesh(vao).SetMaterial(material7);
+			LodMesh::sptr lods = AssetLoader::LoadObjLods("models/TestTube.obj");
+			obj8.emplace<RendererComponent>().SetMesh(lods).SetMaterial(material7);
 			obj8.get<Transform>().SetLocalPosition(4.0f, 1.0f, -0.8f);
 			obj8.get<Transform>().SetLocalScale(0.5f, 0.5f, 0.5f);
 			obj8.get<Transform>().SetLocalRotation(90.0f, 0.0f, 90.0f);
@@ -525,8 +531,8 @@ int main() {
 
 		GameObject obj9 = scene->CreateEntity("Test Tube");
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/TestTube.obj");
-			obj9.emplace<RendererComponent>().SetMesh(vao).SetMaterial(material7);
+			LodMesh::sptr lods = AssetLoader::LoadObjLods("models/TestTube.obj");
+			obj9.emplace<RendererComponent>().SetMesh(lods).SetMaterial(material7);
 			obj9.get<Transform>().SetLocalPosition(4.0f, 4.0f, -0.8f);
 			obj9.get<Transform>().SetLocalScale(0.5f, 0.5f, 0.5f);
 			obj9.get<Transform>().SetLocalRotation(90.0f, 0.0f, 90.0f);
@@ -535,8 +541,8 @@ int main() {
 
 		GameObject obj10 = scene->CreateEntity("Test Tube");
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/TestTube.obj");
-			obj10.emplace<RendererComponent>().SetMesh(vao).SetMaterial(material7);
+			LodMesh::sptr lods = AssetLoader::LoadObjLods("models/TestTube.obj");
+			obj10.emplace<RendererComponent>().SetMesh(lods).SetMaterial(material7);
 			obj10.get<Transform>().SetLocalPosition(-4.0f, -2.5f, -0.8f);
 			obj10.get<Transform>().SetLocalScale(0.5f, 0.5f, 0.5f);
 			obj10.get<Transform>().SetLocalRotation(90.0f, 0.0f, 90.0f);
@@ -545,8 +551,8 @@ int main() {
 
 		GameObject obj11 = scene->CreateEntity("Test Tube");
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/TestTube.obj");
-			obj11.emplace<RendererComponent>().SetMesh(vao).SetMaterial(material7);
+			LodMesh::sptr lods = AssetLoader::LoadObjLods("models/TestTube.obj");
+			obj11.emplace<RendererComponent>().SetMesh(lods).SetMaterial(material7);
 			obj11.get<Transform>().SetLocalPosition(-4.0f, 1.0f, -0.8f);
 			obj11.get<Transform>().SetLocalScale(0.5f, 0.5f, 0.5f);
 			obj11.get<Transform>().SetLocalRotation(90.0f, 0.0f, 90.0f);
@@ -555,8 +561,8 @@ int main() {
 
 		GameObject obj12 = scene->CreateEntity("Test Tube");
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/TestTube.obj");
-			obj12.emplace<RendererComponent>().SetMesh(vao).SetMaterial(material7);
+			LodMesh::sptr lods = AssetLoader::LoadObjLods("models/TestTube.obj");
+			obj12.emplace<RendererComponent>().SetMesh(lods).SetMaterial(material7);
 			obj12.get<Transform>().SetLocalPosition(-4.0f, 4.0f, -0.8f);
 			obj12.get<Transform>().SetLocalScale(0.5f, 0.5f, 0.5f);
 			obj12.get<Transform>().SetLocalRotation(90.0f, 0.0f, 90.0f);
@@ -565,8 +571,8 @@ int main() {
 
 		GameObject obj16 = scene->CreateEntity("Robot");
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/Gun_Bot.obj");
-			obj16.emplace<RendererComponent>().SetMesh(vao).SetMaterial(material6);
+			LodMesh::sptr lods = AssetLoader::LoadObjLods("models/Gun_Bot.obj");
+			obj16.emplace<RendererComponent>().SetMesh(lods).SetMaterial(material6);
 			obj16.get<Transform>().SetLocalPosition(1.3f, 3.0f, 0.0f);
 			obj16.get<Transform>().SetLocalScale(0.5f, 0.5f, 0.5f);
 			obj16.get<Transform>().SetLocalRotation(90.0f, 0.0f, 90.0f);
@@ -585,6 +591,9 @@ int main() {
 			
 		}
 
+		MeshRegistry::Stats meshStats = MeshRegistry::GetStats();
+		LOG_INFO("Mesh registry: {} hits, {} misses, {} bytes of GPU buffers shared", meshStats.Hits, meshStats.Misses, meshStats.BytesSaved);
+
 		//GameObject obj5 = scene->CreateEntity("cube");
 		//{
 		//	MeshBuilder<VertexPosNormTexCol> builder = MeshBuilder<VertexPosNormTexCol>();
@@ -669,7 +678,8 @@ int main() {
 			
 			GameObject skyboxObj = scene->CreateEntity("skybox");  
 			skyboxObj.get<Transform>().SetLocalPosition(0.0f, 0.0f, 0.0f);
-			skyboxObj.get_or_emplace<RendererComponent>().SetMesh(meshVao).SetMaterial(skyboxMat);
+			// The skybox shader ignores the camera's position, so it's bounds don't mean anything
+			skyboxObj.get_or_emplace<RendererComponent>().SetMesh(meshVao).SetMaterial(skyboxMat).SetCullable(false);
 		}
 		////////////////////////////////////////////////////////////////////////////////////////
 
@@ -711,10 +721,28 @@ int main() {
 		Timing& time = Timing::Instance();
 		time.LastFrame = glfwGetTime();
 
+		bool loggedIndexStats = false;
+
+		// Holds the transforms for every instanced draw in a frame
+		InstanceBuffer::sptr instances = InstanceBuffer::Create();
+
 		///// Game loop /////
 		while (!glfwWindowShouldClose(BackendHandler::window)) {
 			glfwPollEvents();
 
+			// Upload any assets that have finished loading in the background, within our per-frame budget
+			AssetLoader::Pump();
+			// Once everything has loaded, report how much the 16 bit index buffers saved
+			if (!loggedIndexStats && AssetLoader::GetPendingCount() == 0) {
+				GeometryArena::Stats arenaStats = GeometryArena::GetTotalStats();
+				LOG_INFO("16 bit index buffers saved {} bytes", IndexBuffer::GetTotalBytesSaved() + arenaStats.IndexBytesSaved);
+				LOG_INFO("Geometry arenas hold {} meshes, {}/{} vertices and {}/{} index bytes used", arenaStats.Allocations,
+					arenaStats.VerticesUsed, arenaStats.VertexCapacity, arenaStats.IndexBytesUsed, arenaStats.IndexCapacity);
+				// Textures free their pixels once uploaded, so this should show almost everything living on the GPU
+				AssetMemory::LogReport();
+				loggedIndexStats = true;
+			}
+
 			// Update the timing
 			time.CurrentFrame = glfwGetTime();
 			time.DeltaTime = static_cast<float>(time.CurrentFrame - time.LastFrame);
@@ -813,45 +841,138 @@ int main() {
 			glm::mat4 view = glm::inverse(camTransform.LocalTransform());
 			glm::mat4 projection = cameraObject.get<Camera>().GetProjection();
 			glm::mat4 viewProjection = projection * view;
-						
-			// Sort the renderers by shader and material, we will go for a minimizing context switches approach here,
-			// but you could for instance sort front to back to optimize for fill rate if you have intensive fragment shaders
-			renderGroup.sort<RendererComponent>([](const RendererComponent& l, const RendererComponent& r) {
-				// Sort by render layer first, higher numbers get drawn last
-				if (l.Material->RenderLayer < r.Material->RenderLayer) return true;
-				if (l.Material->RenderLayer > r.Material->RenderLayer) return false;
-
-				// Sort by shader pointer next (so materials using the same shader run sequentially where possible)
-				if (l.Material->Shader < r.Material->Shader) return true;
-				if (l.Material->Shader > r.Material->Shader) return false;
-
-				// Sort by material pointer last (so we can minimize switching between materials)
-				if (l.Material < r.Material) return true;
-				if (l.Material > r.Material) return false;
-				
-				return false;
+			glm::vec3 camPos = camTransform.GetLocalPosition();
+
+			// Skip anything that is outside of the camera's view before we spend any time sorting or drawing it.
+			// Meshes that are still loading don't have bounds yet, so we always keep those
+			Frustum frustum(viewProjection);
+			visibleRenderers.clear();
+			objectsCulled = 0;
+			renderGroup.each([&](entt::entity e, RendererComponent& renderer, Transform& transform) {
+				if (enableCulling && renderer.Cullable && renderer.Mesh != nullptr) {
+					const MeshBounds& bounds = renderer.Mesh->GetBounds();
+					if (bounds.IsValid() && !frustum.Intersects(bounds.Transform(transform.WorldTransform()))) {
+						objectsCulled++;
+						return;
+					}
+				}
+				visibleRenderers.push_back(e);
 			});
+			objectsDrawn = visibleRenderers.size();
+
+			// Pick the level of detail for each visible LOD mesh from how big it is on screen. This happens before sorting
+			// so that objects drawing the same level end up next to each other and can be instanced together
+			lodTrianglesDrawn = 0;
+			lodTrianglesFull = 0;
+			for (entt::entity e : visibleRenderers) {
+				RendererComponent& renderer = renderGroup.get<RendererComponent>(e);
+				if (renderer.Lods != nullptr) {
+					float screenSize = renderer.Lods->GetScreenSize(renderGroup.get<Transform>(e).WorldTransform(), camPos, projection);
+					renderer.LodLevel = renderer.Lods->SelectLevel(screenSize, renderer.LodLevel);
+					lodTrianglesDrawn += renderer.Lods->GetTriangleCount(renderer.LodLevel);
+					lodTrianglesFull += renderer.Lods->GetTriangleCount(0);
+				}
+			}
+						
+			// Sort the renderers by render layer, shader, material, mesh and level of detail, so that we minimize context
+			// switches and copies of the same mesh end up next to each other for instancing. Within each of those groups
+			// we draw front to back, so that the depth test can skip fragments of objects that are hidden
+			const float farPlane = cameraObject.get<Camera>().GetFarPlane();
+			renderQueue->Clear();
+			for (entt::entity e : visibleRenderers) {
+				const RendererComponent& renderer = renderGroup.get<RendererComponent>(e);
+				const glm::vec3 position = glm::vec3(renderGroup.get<Transform>(e).WorldTransform()[3]);
+				const uint64_t key = RenderQueue::MakeKey(renderer.Material->RenderLayer, renderer.Material->Shader->GetHandle(), renderer.Material->GetId(),
+					renderer.Mesh != nullptr ? renderer.Mesh->GetHandle() : 0, renderer.LodLevel, glm::distance(camPos, position) / farPlane);
+				renderQueue->Push(key, static_cast<uint32_t>(e));
+			}
+			renderQueue->Sort();
+			const std::vector<RenderQueue::Item>& sortedRenderers = renderQueue->GetSorted();
+			for (size_t ix = 0; ix < sortedRenderers.size(); ix++) {
+				visibleRenderers[ix] = static_cast<entt::entity>(sortedRenderers[ix].Value);
+			}
+
+			// Group the sorted renderers into batches, and collect the transforms of the instanced ones
+			drawBatches.clear();
+			instances->Clear();
+			for (size_t ix = 0; ix < visibleRenderers.size(); ) {
+				const RendererComponent& first = renderGroup.get<RendererComponent>(visibleRenderers[ix]);
+				DrawBatch batch = { ix, 1, 0 };
+				if (enableInstancing && first.Material->Shader->SupportsInstancing()) {
+					while (ix + batch.Count < visibleRenderers.size()) {
+						const RendererComponent& next = renderGroup.get<RendererComponent>(visibleRenderers[ix + batch.Count]);
+						if (next.Material != first.Material || next.Mesh != first.Mesh || next.Lods != first.Lods || next.LodLevel != first.LodLevel) {
+							break;
+						}
+						batch.Count++;
+					}
+					batch.BaseInstance = instances->GetCount();
+					for (uint32_t instance = 0; instance < batch.Count; instance++) {
+						const Transform& transform = renderGroup.get<Transform>(visibleRenderers[ix + instance]);
+						instances->Add(transform.WorldTransform(), transform.WorldNormalMatrix());
+					}
+				}
+				drawBatches.push_back(batch);
+				ix += batch.Count;
+			}
+			instances->Upload();
+			drawCalls = drawBatches.size();
+
+			// Upload the uniform blocks that every shader shares, once for the whole frame
+			BackendHandler::UpdateCameraBlock(view, projection);
+			if (lightingChanged) {
+				LightingUniforms lighting;
+				lighting.LightPos = lightPos;
+				lighting.LightCol = lightCol;
+				lighting.AmbientCol = ambientCol;
+				lighting.AmbientStrength = ambientPow;
+				lighting.AmbientLightStrength = lightAmbientPow;
+				lighting.SpecularLightStrength = lightSpecularPow;
+				lighting.AttenuationConstant = 1.0f;
+				lighting.AttenuationLinear = lightLinearFalloff;
+				lighting.AttenuationQuadratic = lightQuadraticFalloff;
+				lighting.AmbientToggle = ambientToggle;
+				lighting.SpecularToggle = specularToggle;
+				lighting.LightingOff = noLightingToggle;
+				lighting.AmbientAndSpecToggle = ambient_And_Specular_Toggle;
+				lighting.CustomShaderToggle = custom_Shader_Toggle;
+				BackendHandler::UpdateLightingBlock(lighting);
+				lightingChanged = false;
+			}
 
 			// Start by assuming no shader or material is applied
 			Shader::sptr current = nullptr;
 			ShaderMaterial::sptr currentMat = nullptr;
 
-			// Iterate over the render group components and draw them
-			renderGroup.each( [&](entt::entity e, RendererComponent& renderer, Transform& transform) {
-				// If the shader has changed, set up it's uniforms
+			// Iterate over the batches and draw them
+			for (const DrawBatch& batch : drawBatches) {
+				RendererComponent& renderer = renderGroup.get<RendererComponent>(visibleRenderers[batch.First]);
+				Transform& transform = renderGroup.get<Transform>(visibleRenderers[batch.First]);
+				// If the shader has changed, bind it. The per-frame uniforms come from the shared uniform blocks
 				if (current != renderer.Material->Shader) {
 					current = renderer.Material->Shader;
 					current->Bind();
-					BackendHandler::SetupShaderForFrame(current, view, projection);
 				}
 				// If the material has changed, apply it
 				if (currentMat != renderer.Material) {
 					currentMat = renderer.Material;
 					currentMat->Apply();
 				}
-				// Render the mesh
-				BackendHandler::RenderVAO(renderer.Material->Shader, renderer.Mesh, viewProjection, transform);
-			});
+				// Render the mesh, or every copy of it in the batch if it's shader supports instancing
+				if (renderer.Material->Shader->SupportsInstancing() && enableInstancing) {
+					if (renderer.Lods != nullptr) {
+						BackendHandler::RenderLodInstanced(renderer.Material->Shader, renderer.Lods, renderer.LodLevel, *instances, batch.BaseInstance, batch.Count);
+					} else {
+						BackendHandler::RenderInstanced(renderer.Material->Shader, renderer.Mesh, *instances, batch.BaseInstance, batch.Count);
+					}
+				} else if (renderer.Lods != nullptr) {
+					BackendHandler::RenderLod(renderer.Material->Shader, renderer.Lods, renderer.LodLevel, viewProjection, transform);
+				} else {
+					BackendHandler::RenderVAO(renderer.Material->Shader, renderer.Mesh, viewProjection, transform);
+				}
+			}
+			// Meshes in a geometry arena leave the arena's VAO bound between draws, so clear it before anything else draws
+			VertexArrayObject::UnBind();
 
 			// Draw our ImGui content
 			BackendHandler::RenderImGui();
@@ -861,8 +982,12 @@ int main() {
 			time.LastFrame = time.CurrentFrame;
 		}
 
+		// Stop loading any assets that are still in flight
+		AssetLoader::Shutdown();
+
 		// Nullify scene so that we can release references
 		Application::Instance().ActiveScene = nullptr;
+		BackendHandler::ShutdownUniformBlocks();
 		BackendHandler::ShutdownImGui();
 	}	
 
@@ -0,0 +1,97 @@
+// Compares the throughput of the ObjLoader parsing modes on a folder of OBJ models
+// Usage: ObjLoaderBenchmark [model directory] [iterations]
+// This does not need an OpenGL context, since we only parse into MeshBuilders and never bake
+
+#include <Logging.h>
+#include <ObjLoader.h>
+
+#include <cfloat>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <string>
+
+namespace fs = std::filesystem;
+
+/// <summary>
+/// Parses the file the given number of times, returning the fastest time in seconds
+/// </summary>
+double TimeParse(const std::string& file, ObjParseMode mode, int iterations, MeshBuilder<VertexPosNormTexCol>& result) {
+	double best = DBL_MAX;
+	for (int ix = 0; ix < iterations; ix++) {
+		result = MeshBuilder<VertexPosNormTexCol>();
+		auto start = std::chrono::high_resolution_clock::now();
+		ObjLoader::LoadMeshData(file, result, glm::vec4(1.0f), mode);
+		auto end = std::chrono::high_resolution_clock::now();
+		double seconds = std::chrono::duration<double>(end - start).count();
+		best = seconds < best ? seconds : best;
+	}
+	return best;
+}
+
+/// <summary>
+/// Checks whether two mesh builders contain exactly the same vertex and index data
+/// </summary>
+bool IsIdentical(const MeshBuilder<VertexPosNormTexCol>& a, const MeshBuilder<VertexPosNormTexCol>& b) {
+	return a.GetVertexCount() == b.GetVertexCount() &&
+		a.GetIndexCount() == b.GetIndexCount() &&
+		memcmp(a.GetVertexDataPtr(), b.GetVertexDataPtr(), a.GetVertexCount() * sizeof(VertexPosNormTexCol)) == 0 &&
+		memcmp(a.GetIndexDataPtr(), b.GetIndexDataPtr(), a.GetIndexCount() * sizeof(uint32_t)) == 0;
+}
+
+int main(int argc, char** argv) {
+	Logger::Init();
+
+	// By default we'll look at the GraphicsTests models, relative to the output directory (bin/<config>/<project>)
+	fs::path modelDir = argc > 1 ? fs::path(argv[1]) : fs::path("../../../projects/GraphicsTests/res/models");
+	int iterations = argc > 2 ? std::stoi(argv[2]) : 5;
+
+	if (!fs::is_directory(modelDir)) {
+		LOG_ERROR("Model directory \"{}\" does not exist", modelDir.string());
+		Logger::Uninitialize();
+		return 1;
+	}
+
+	const ObjParseMode modes[] = { ObjParseMode::Stream, ObjParseMode::Mapped, ObjParseMode::Parallel };
+	const int modeCount = sizeof(modes) / sizeof(modes[0]);
+	size_t totalBytes = 0;
+	double totalSeconds[modeCount] = { 0.0 };
+	bool allIdentical = true;
+
+	for (const fs::directory_entry& entry : fs::directory_iterator(modelDir)) {
+		if (!entry.is_regular_file() || entry.path().extension() != ".obj") {
+			continue;
+		}
+		const std::string file = entry.path().string();
+		const size_t bytes = static_cast<size_t>(entry.file_size());
+		const double megabytes = bytes / (1024.0 * 1024.0);
+		totalBytes += bytes;
+
+		LOG_INFO("{} ({:.2f} MB)", entry.path().filename().string(), megabytes);
+
+		MeshBuilder<VertexPosNormTexCol> results[modeCount];
+		for (int ix = 0; ix < modeCount; ix++) {
+			double seconds = TimeParse(file, modes[ix], iterations, results[ix]);
+			totalSeconds[ix] += seconds;
+			LOG_INFO("\t{:<8} {:>8.3f} ms {:>8.2f} MB/s ({} verts, {} indices)", ~modes[ix], seconds * 1000.0, megabytes / seconds, results[ix].GetVertexCount(), results[ix].GetIndexCount());
+		}
+
+		// Each mode should produce exactly the same output as the mode before it
+		for (int ix = 1; ix < modeCount; ix++) {
+			if (!IsIdentical(results[ix - 1], results[ix])) {
+				LOG_WARN("\t{} output does not match {} output!", ~modes[ix], ~modes[ix - 1]);
+				allIdentical = false;
+			}
+		}
+	}
+
+	const double totalMegabytes = totalBytes / (1024.0 * 1024.0);
+	LOG_INFO("==== Totals ({:.2f} MB) ====", totalMegabytes);
+	for (int ix = 0; ix < modeCount; ix++) {
+		LOG_INFO("\t{:<8} {:>8.2f} MB/s", ~modes[ix], totalSeconds[ix] > 0.0 ? totalMegabytes / totalSeconds[ix] : 0.0);
+	}
+	LOG_INFO("Outputs identical: {}", allIdentical);
+
+	Logger::Uninitialize();
+	return allIdentical ? 0 : 1;
+}
@@ -0,0 +1,216 @@
+// Compares sorting the render queue with the old comparison sort against RenderQueue's packed keys and radix sort
+// Usage: RenderQueueBenchmark [iterations]
+// This does not need an OpenGL context, the renderables are stand-ins that only hold what the sorts look at
+
+#include <Logging.h>
+#include <RenderQueue.h>
+
+#include <GLM/glm.hpp>
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Stands in for a ShaderMaterial, the old sort compares the layer and the shader and material pointers
+/// </summary>
+struct FakeMaterial
+{
+	int                   RenderLayer;
+	std::shared_ptr<int>  Shader;
+	uint32_t              ShaderId;
+	uint32_t              Id;
+};
+
+/// <summary>
+/// Stands in for a RendererComponent and it's transform
+/// </summary>
+struct FakeRenderer
+{
+	std::shared_ptr<FakeMaterial> Material;
+	uint32_t                      MeshId;
+	int                           LodLevel;
+	glm::vec3                     Position;
+};
+
+/// <summary>
+/// Generates renderables spread over a few layers, shaders, materials and meshes, roughly matching a game scene
+/// </summary>
+std::vector<FakeRenderer> GenerateRenderers(size_t count, std::mt19937& random) {
+	std::vector<std::shared_ptr<int>> shaders;
+	for (int ix = 0; ix < 8; ix++) {
+		shaders.push_back(std::make_shared<int>(ix));
+	}
+	std::vector<std::shared_ptr<FakeMaterial>> materials;
+	for (uint32_t ix = 0; ix < 64; ix++) {
+		std::shared_ptr<FakeMaterial> material = std::make_shared<FakeMaterial>();
+		material->RenderLayer = ix % 16 == 0 ? 100 : 0;
+		material->ShaderId = ix % 8;
+		material->Shader = shaders[material->ShaderId];
+		material->Id = ix + 1;
+		materials.push_back(material);
+	}
+
+	std::uniform_int_distribution<uint32_t> materialDist(0, 63);
+	std::uniform_int_distribution<uint32_t> meshDist(1, 256);
+	std::uniform_int_distribution<int> lodDist(0, 3);
+	std::uniform_real_distribution<float> positionDist(-500.0f, 500.0f);
+	std::vector<FakeRenderer> result(count);
+	for (FakeRenderer& renderer : result) {
+		renderer.Material = materials[materialDist(random)];
+		renderer.MeshId = meshDist(random);
+		renderer.LodLevel = lodDist(random);
+		renderer.Position = glm::vec3(positionDist(random), positionDist(random), positionDist(random));
+	}
+	return result;
+}
+
+/// <summary>
+/// Runs a function the given number of times, returning the fastest time in seconds
+/// </summary>
+template <typename Func>
+double TimeBest(int iterations, Func&& func) {
+	double best = DBL_MAX;
+	for (int ix = 0; ix < iterations; ix++) {
+		auto start = std::chrono::high_resolution_clock::now();
+		func();
+		auto end = std::chrono::high_resolution_clock::now();
+		double seconds = std::chrono::duration<double>(end - start).count();
+		best = seconds < best ? seconds : best;
+	}
+	return best;
+}
+
+/// <summary>
+/// Sorts the renderers the way main.cpp used to, with a comparison sort that compares the layer, then the shader and
+/// material pointers, looking up the renderer for each side of every comparison
+/// </summary>
+void ComparisonSort(const std::vector<FakeRenderer>& renderers, std::vector<uint32_t>& order) {
+	for (uint32_t ix = 0; ix < order.size(); ix++) {
+		order[ix] = ix;
+	}
+	std::sort(order.begin(), order.end(), [&](uint32_t le, uint32_t re) {
+		const FakeRenderer& l = renderers[le];
+		const FakeRenderer& r = renderers[re];
+		if (l.Material->RenderLayer < r.Material->RenderLayer) return true;
+		if (l.Material->RenderLayer > r.Material->RenderLayer) return false;
+		if (l.Material->Shader < r.Material->Shader) return true;
+		if (l.Material->Shader > r.Material->Shader) return false;
+		if (l.Material < r.Material) return true;
+		if (l.Material > r.Material) return false;
+		return false;
+	});
+}
+
+/// <summary>
+/// Packs the sort key for a renderer, the same way main.cpp does
+/// </summary>
+uint64_t GetKey(const FakeRenderer& renderer, const glm::vec3& cameraPos, float farPlane) {
+	return RenderQueue::MakeKey(renderer.Material->RenderLayer, renderer.Material->ShaderId, renderer.Material->Id, renderer.MeshId,
+		renderer.LodLevel, glm::distance(cameraPos, renderer.Position) / farPlane);
+}
+
+/// <summary>
+/// Packs the keys for the renderers and pushes them into the queue
+/// </summary>
+void PushRenderers(RenderQueue& queue, const std::vector<FakeRenderer>& renderers, const glm::vec3& cameraPos, float farPlane) {
+	queue.Clear();
+	for (uint32_t ix = 0; ix < renderers.size(); ix++) {
+		queue.Push(GetKey(renderers[ix], cameraPos, farPlane), ix);
+	}
+}
+
+int main(int argc, char** argv) {
+	Logger::Init();
+
+	int iterations = argc > 1 ? std::stoi(argv[1]) : 5;
+	const float farPlane = 1000.0f;
+	bool allCorrect = true;
+
+	for (size_t count : { 10000, 100000, 1000000 }) {
+		std::mt19937 random(1234);
+		std::vector<FakeRenderer> renderers = GenerateRenderers(count, random);
+		LOG_INFO("{} renderables:", count);
+
+		std::vector<uint32_t> order(count);
+		double seconds = TimeBest(iterations, [&]() { ComparisonSort(renderers, order); });
+		LOG_INFO("\t{:<28} {:>9.3f} ms", "std::sort (comparator)", seconds * 1000.0);
+
+		// Sorting the same keys with std::stable_sort gives us the expected output, and a baseline for the radix sort
+		std::vector<RenderQueue::Item> keys, expected;
+		for (uint32_t ix = 0; ix < count; ix++) {
+			keys.emplace_back(GetKey(renderers[ix], glm::vec3(0.0f), farPlane), ix);
+		}
+		seconds = TimeBest(iterations, [&]() {
+			expected = keys;
+			std::stable_sort(expected.begin(), expected.end(), [](const RenderQueue::Item& l, const RenderQueue::Item& r) { return l.Key < r.Key; });
+		});
+		LOG_INFO("\t{:<28} {:>9.3f} ms", "std::stable_sort (keys)", seconds * 1000.0);
+
+		// Time a full sort by pushing different values each time, so the queue can't skip it
+		RenderQueue queue;
+		queue.Reserve(count);
+		uint32_t frame = 0;
+		seconds = TimeBest(iterations, [&]() {
+			queue.Clear();
+			for (const RenderQueue::Item& item : keys) {
+				queue.Push(item.Key, item.Value + (frame & 1));
+			}
+			queue.Sort();
+			frame++;
+		});
+		LOG_INFO("\t{:<28} {:>9.3f} ms", "RenderQueue (radix sort)", seconds * 1000.0);
+
+		// Check the output of an actual sort against the stable sort
+		PushRenderers(queue, renderers, glm::vec3(0.0f), farPlane);
+		queue.Sort();
+		const std::vector<RenderQueue::Item>& sorted = queue.GetSorted();
+		for (size_t ix = 0; ix < count; ix++) {
+			if (sorted[ix].Key != expected[ix].Key || sorted[ix].Value != expected[ix].Value) {
+				LOG_WARN("\tRadix sort output does not match std::stable_sort at {}!", ix);
+				allCorrect = false;
+				break;
+			}
+		}
+
+		// Nothing changed, so the queue only needs to check that the last order is still sorted
+		seconds = TimeBest(iterations, [&]() {
+			PushRenderers(queue, renderers, glm::vec3(0.0f), farPlane);
+			queue.Sort();
+		});
+		LOG_INFO("\t{:<28} {:>9.3f} ms", "RenderQueue (unchanged)", seconds * 1000.0);
+
+		// Include building the keys, which is what the render loop pays every frame
+		seconds = TimeBest(iterations, [&]() {
+			PushRenderers(queue, renderers, glm::vec3(0.0f), farPlane);
+		});
+		LOG_INFO("\t{:<28} {:>9.3f} ms", "  of which building keys", seconds * 1000.0);
+		LOG_INFO("\tSorts: {} Skipped: {}", queue.GetStats().Sorts, queue.GetStats().SkippedSorts);
+	}
+	LOG_INFO("Outputs correct: {}", allCorrect);
+
+	// Transparent layers have to come out back to front, even when their materials would otherwise group them
+	RenderQueue::SetLayerTransparent(100);
+	RenderQueue queue;
+	queue.Push(RenderQueue::MakeKey(0, 1, 1, 1, 0, 0.9f), 0);
+	queue.Push(RenderQueue::MakeKey(100, 1, 1, 1, 0, 0.2f), 1);
+	queue.Push(RenderQueue::MakeKey(100, 2, 5, 1, 0, 0.8f), 2);
+	queue.Push(RenderQueue::MakeKey(100, 1, 1, 1, 0, 0.5f), 3);
+	queue.Push(RenderQueue::MakeKey(0, 1, 1, 1, 0, 0.1f), 4);
+	queue.Sort();
+	const uint32_t expectedOrder[] = { 4, 0, 2, 3, 1 };
+	bool transparentCorrect = true;
+	for (size_t ix = 0; ix < 5; ix++) {
+		transparentCorrect &= queue.GetSorted()[ix].Value == expectedOrder[ix];
+	}
+	RenderQueue::SetLayerTransparent(100, false);
+	LOG_INFO("Transparent layer sorted back to front: {}", transparentCorrect);
+	allCorrect &= transparentCorrect;
+
+	Logger::Uninitialize();
+	return allCorrect ? 0 : 1;
+}
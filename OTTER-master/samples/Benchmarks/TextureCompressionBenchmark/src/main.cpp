@@ -0,0 +1,378 @@
+// Checks the quality and speed of the BCn block encoders, and that CompressedTextureData::LoadFromFile uses its cache
+// Usage: TextureCompressionBenchmark [image size] [iterations]
+// The image is generated, so we don't need any assets or an OpenGL context. Every encoded level is decoded again
+// with the small reference decoders below and compared against the source. Returns non-zero if the error is higher
+// than expected for any format, or if the cache is not hit or missed when it should be
+
+#include <CompressedTextureData.h>
+#include <Logging.h>
+#include <Texture2DData.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+/// <summary>
+/// Generates a size x size RGBA8 image of smooth gradients with a few hard edges, which is roughly what the
+/// encoders will see in real textures
+/// </summary>
+std::vector<uint8_t> GenerateImage(int size, int seed) {
+	std::vector<uint8_t> result(static_cast<size_t>(size) * size * 4);
+	for (int y = 0; y < size; y++) {
+		for (int x = 0; x < size; x++) {
+			uint8_t* pixel = &result[(static_cast<size_t>(y) * size + x) * 4];
+			const float u = static_cast<float>(x) / size;
+			const float v = static_cast<float>(y) / size;
+			const bool checker = ((x / 32) + (y / 32) + seed) % 2 == 0;
+			pixel[0] = static_cast<uint8_t>(255.0f * u);
+			pixel[1] = static_cast<uint8_t>(127.5f + 127.5f * std::sin((u + v) * 6.0f + seed));
+			pixel[2] = static_cast<uint8_t>(checker ? 200.0f * v : 40.0f);
+			pixel[3] = static_cast<uint8_t>(255.0f * (1.0f - v));
+		}
+	}
+	return result;
+}
+
+/// <summary>
+/// Writes a size x size uncompressed 32 bit TGA file, the pixels are stored as BGRA
+/// </summary>
+void WriteTga(const fs::path& path, int size, const std::vector<uint8_t>& rgba) {
+	uint8_t header[18] = { 0 };
+	header[2] = 2; // Uncompressed true color
+	header[12] = size & 0xFF;
+	header[13] = (size >> 8) & 0xFF;
+	header[14] = size & 0xFF;
+	header[15] = (size >> 8) & 0xFF;
+	header[16] = 32;
+	header[17] = 8; // 8 bits of alpha
+
+	std::vector<uint8_t> bgra = rgba;
+	for (size_t ix = 0; ix < bgra.size(); ix += 4) {
+		std::swap(bgra[ix], bgra[ix + 2]);
+	}
+	std::ofstream file(path, std::ios::binary);
+	file.write(reinterpret_cast<const char*>(header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(bgra.data()), bgra.size());
+}
+
+/// <summary>
+/// Expands a packed 565 color into 8 bits per channel
+/// </summary>
+void Unpack565(uint16_t packed, int result[3]) {
+	const int r = (packed >> 11) & 31;
+	const int g = (packed >> 5) & 63;
+	const int b = packed & 31;
+	result[0] = (r << 3) | (r >> 2);
+	result[1] = (g << 2) | (g >> 4);
+	result[2] = (b << 3) | (b >> 2);
+}
+
+/// <summary>
+/// Decodes the RGB channels of a BC1 block into the 16 RGBA8 texels, leaving alpha alone
+/// </summary>
+void DecodeBC1(const uint8_t* block, uint8_t* rgba) {
+	const uint16_t color0 = block[0] | (block[1] << 8);
+	const uint16_t color1 = block[2] | (block[3] << 8);
+	int palette[4][3];
+	Unpack565(color0, palette[0]);
+	Unpack565(color1, palette[1]);
+	for (int c = 0; c < 3; c++) {
+		if (color0 > color1) {
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		} else {
+			palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+			palette[3][c] = 0;
+		}
+	}
+	const uint32_t indices = block[4] | (block[5] << 8) | (block[6] << 16) | ((uint32_t)block[7] << 24);
+	for (int ix = 0; ix < 16; ix++) {
+		const int index = (indices >> (ix * 2)) & 3;
+		for (int c = 0; c < 3; c++) {
+			rgba[ix * 4 + c] = static_cast<uint8_t>(palette[index][c]);
+		}
+	}
+}
+
+/// <summary>
+/// Decodes a BC4 block into a single channel of the 16 RGBA8 texels
+/// </summary>
+void DecodeBC4(const uint8_t* block, int channel, uint8_t* rgba) {
+	int palette[8];
+	palette[0] = block[0];
+	palette[1] = block[1];
+	if (palette[0] > palette[1]) {
+		for (int ix = 2; ix < 8; ix++) {
+			palette[ix] = ((8 - ix) * palette[0] + (ix - 1) * palette[1]) / 7;
+		}
+	} else {
+		for (int ix = 2; ix < 6; ix++) {
+			palette[ix] = ((6 - ix) * palette[0] + (ix - 1) * palette[1]) / 5;
+		}
+		palette[6] = 0;
+		palette[7] = 255;
+	}
+	uint64_t indices = 0;
+	for (int ix = 0; ix < 6; ix++) {
+		indices |= (uint64_t)block[2 + ix] << (ix * 8);
+	}
+	for (int ix = 0; ix < 16; ix++) {
+		rgba[ix * 4 + channel] = static_cast<uint8_t>(palette[(indices >> (ix * 3)) & 7]);
+	}
+}
+
+/// <summary>
+/// Decodes a BC7 block into the 16 RGBA8 texels, only mode 6 is supported since that is all our encoder writes
+/// </summary>
+/// <returns>False if the block uses any other mode</returns>
+bool DecodeBC7(const uint8_t* block, uint8_t* rgba) {
+	static const int WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+	int position = 0;
+	auto read = [&](int count) {
+		uint32_t result = 0;
+		for (int ix = 0; ix < count; ix++, position++) {
+			result |= ((block[position / 8] >> (position % 8)) & 1u) << ix;
+		}
+		return result;
+	};
+	if (read(7) != (1 << 6)) {
+		return false;
+	}
+	int endpoints[2][4];
+	for (int c = 0; c < 4; c++) {
+		endpoints[0][c] = read(7);
+		endpoints[1][c] = read(7);
+	}
+	const int pBit0 = read(1);
+	const int pBit1 = read(1);
+	for (int c = 0; c < 4; c++) {
+		endpoints[0][c] = (endpoints[0][c] << 1) | pBit0;
+		endpoints[1][c] = (endpoints[1][c] << 1) | pBit1;
+	}
+	for (int ix = 0; ix < 16; ix++) {
+		const int weight = WEIGHTS[read(ix == 0 ? 3 : 4)];
+		for (int c = 0; c < 4; c++) {
+			rgba[ix * 4 + c] = static_cast<uint8_t>(((64 - weight) * endpoints[0][c] + weight * endpoints[1][c] + 32) >> 6);
+		}
+	}
+	return true;
+}
+
+/// <summary>
+/// Decodes a whole level of a compressed texture back into RGBA8. Channels that the format does not store are
+/// left as they are in the source, so that they don't count towards the error
+/// </summary>
+bool DecodeLevel(const CompressedTextureData::MipLevel& level, InternalFormat format, const std::vector<uint8_t>& source, std::vector<uint8_t>& result) {
+	result = source;
+	const uint32_t blocksX = (level.Width + 3) / 4;
+	const uint32_t blocksY = (level.Height + 3) / 4;
+	const size_t blockSize = GetCompressedBlockSize(format);
+	for (uint32_t by = 0; by < blocksY; by++) {
+		for (uint32_t bx = 0; bx < blocksX; bx++) {
+			const uint8_t* block = level.Data.data() + (by * blocksX + bx) * blockSize;
+			uint8_t texels[64];
+			for (int ix = 0; ix < 16; ix++) {
+				const uint32_t x = std::min(bx * 4 + ix % 4, level.Width - 1);
+				const uint32_t y = std::min(by * 4 + ix / 4, level.Height - 1);
+				memcpy(&texels[ix * 4], &source[(static_cast<size_t>(y) * level.Width + x) * 4], 4);
+			}
+			switch (format) {
+			case InternalFormat::BC1:
+				DecodeBC1(block, texels);
+				break;
+			case InternalFormat::BC3:
+				DecodeBC4(block, 3, texels);
+				DecodeBC1(block + 8, texels);
+				break;
+			case InternalFormat::BC5:
+				DecodeBC4(block, 0, texels);
+				DecodeBC4(block + 8, 1, texels);
+				break;
+			case InternalFormat::BC7:
+				if (!DecodeBC7(block, texels)) {
+					return false;
+				}
+				break;
+			default:
+				return false;
+			}
+			for (int ix = 0; ix < 16; ix++) {
+				const uint32_t x = bx * 4 + ix % 4;
+				const uint32_t y = by * 4 + ix / 4;
+				if (x < level.Width && y < level.Height) {
+					memcpy(&result[(static_cast<size_t>(y) * level.Width + x) * 4], &texels[ix * 4], 4);
+				}
+			}
+		}
+	}
+	return true;
+}
+
+/// <summary>
+/// Gets the root mean square error between two RGBA8 images, over all 4 channels
+/// </summary>
+double GetRmse(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b) {
+	double total = 0.0;
+	for (size_t ix = 0; ix < a.size(); ix++) {
+		const double delta = static_cast<double>(a[ix]) - b[ix];
+		total += delta * delta;
+	}
+	return std::sqrt(total / a.size());
+}
+
+/// <summary>
+/// Counts the DDS files in the given directory
+/// </summary>
+size_t CountCacheFiles(const fs::path& directory) {
+	size_t result = 0;
+	if (fs::is_directory(directory)) {
+		for (const fs::directory_entry& entry : fs::directory_iterator(directory)) {
+			result += entry.path().extension() == ".dds" ? 1 : 0;
+		}
+	}
+	return result;
+}
+
+/// <summary>
+/// Checks whether two compressed textures have the same format, size and level data
+/// </summary>
+bool IsIdentical(const CompressedTextureData::sptr& a, const CompressedTextureData::sptr& b) {
+	if (a == nullptr || b == nullptr || a->GetFormat() != b->GetFormat() || a->GetLevelCount() != b->GetLevelCount()) {
+		return false;
+	}
+	for (uint32_t ix = 0; ix < a->GetLevelCount(); ix++) {
+		if (a->GetLevel(ix).Width != b->GetLevel(ix).Width || a->GetLevel(ix).Height != b->GetLevel(ix).Height ||
+			a->GetLevel(ix).Data != b->GetLevel(ix).Data) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/// <summary>
+/// Checks that LoadFromFile misses the cache on the first load, then returns the cached file on the next. To prove
+/// the second load really came from the cache, we replace the cached file with a different image first
+/// </summary>
+bool TestCache(const fs::path& tempDir, int size) {
+	const std::string savedDirectory = CompressedTextureData::CacheDirectory;
+	const bool savedEnabled = CompressedTextureData::CacheEnabled;
+	const fs::path cacheDir = tempDir / "cache";
+	CompressedTextureData::CacheDirectory = cacheDir.string();
+	CompressedTextureData::CacheEnabled = true;
+
+	bool passed = true;
+	const fs::path imagePath = tempDir / "image.tga";
+	WriteTga(imagePath, size, GenerateImage(size, 0));
+
+	CompressedTextureData::sptr first = CompressedTextureData::LoadFromFile(imagePath.string(), InternalFormat::BC1, false);
+	if (first == nullptr || CountCacheFiles(cacheDir) != 1) {
+		LOG_ERROR("The first load did not write a cache entry");
+		passed = false;
+	}
+
+	if (passed) {
+		// Swap the cache entry out for an encoding of a different image, if the next load returns that then it was a hit
+		fs::path cachePath;
+		for (const fs::directory_entry& entry : fs::directory_iterator(cacheDir)) {
+			cachePath = entry.path();
+		}
+		std::vector<uint8_t> other = GenerateImage(size, 1);
+		Texture2DData::sptr otherData = std::make_shared<Texture2DData>(size, size, PixelFormat::RGBA, PixelType::UByte, other.data());
+		CompressedTextureData::sptr marker = CompressedTextureData::Encode(otherData, InternalFormat::BC1, false);
+		marker->SaveToDDS(cachePath.string());
+
+		CompressedTextureData::sptr second = CompressedTextureData::LoadFromFile(imagePath.string(), InternalFormat::BC1, false);
+		if (!IsIdentical(second, marker)) {
+			LOG_ERROR("The second load did not come from the cache");
+			passed = false;
+		}
+		else if (CountCacheFiles(cacheDir) != 1) {
+			LOG_ERROR("The second load wrote a new cache entry");
+			passed = false;
+		}
+	}
+
+	if (passed) {
+		// Changing the source image or the format must give a new key, and so a miss
+		WriteTga(imagePath, size, GenerateImage(size, 2));
+		CompressedTextureData::sptr changed = CompressedTextureData::LoadFromFile(imagePath.string(), InternalFormat::BC1, false);
+		CompressedTextureData::sptr reformatted = CompressedTextureData::LoadFromFile(imagePath.string(), InternalFormat::BC7, false);
+		if (changed == nullptr || reformatted == nullptr || reformatted->GetFormat() != InternalFormat::BC7 || CountCacheFiles(cacheDir) != 3) {
+			LOG_ERROR("Changing the source or format did not miss the cache");
+			passed = false;
+		}
+	}
+
+	LOG_INFO(passed ? "Cache missed and hit as expected" : "Cache test failed!");
+	CompressedTextureData::CacheDirectory = savedDirectory;
+	CompressedTextureData::CacheEnabled = savedEnabled;
+	return passed;
+}
+
+int main(int argc, char** argv) {
+	Logger::Init();
+
+	int size = argc > 1 ? std::stoi(argv[1]) : 512;
+	int iterations = argc > 2 ? std::stoi(argv[2]) : 3;
+
+	// The highest RMSE we accept for each format, over all 4 channels. Only the channels that a format stores are
+	// compared, so these are a bit generous for the formats with fewer channels
+	struct FormatTest {
+		const char*    Name;
+		InternalFormat Format;
+		double         MaxRmse;
+	};
+	const FormatTest formats[] = {
+		{ "BC1", InternalFormat::BC1, 4.0 },
+		{ "BC3", InternalFormat::BC3, 4.0 },
+		{ "BC5", InternalFormat::BC5, 1.5 },
+		{ "BC7", InternalFormat::BC7, 3.0 }
+	};
+
+	std::vector<uint8_t> image = GenerateImage(size, 0);
+	Texture2DData::sptr source = std::make_shared<Texture2DData>(size, size, PixelFormat::RGBA, PixelType::UByte, image.data());
+	bool passed = true;
+
+	for (const FormatTest& test : formats) {
+		double best = DBL_MAX;
+		CompressedTextureData::sptr encoded;
+		for (int ix = 0; ix < iterations; ix++) {
+			auto start = std::chrono::high_resolution_clock::now();
+			encoded = CompressedTextureData::Encode(source, test.Format, false);
+			auto end = std::chrono::high_resolution_clock::now();
+			best = std::min(best, std::chrono::duration<double>(end - start).count());
+		}
+
+		std::vector<uint8_t> decoded;
+		if (!DecodeLevel(encoded->GetLevel(0), test.Format, image, decoded)) {
+			LOG_ERROR("{} produced a block the reference decoder does not understand", test.Name);
+			passed = false;
+			continue;
+		}
+		const double rmse = GetRmse(image, decoded);
+		const double megapixels = static_cast<double>(size) * size / 1000000.0;
+		LOG_INFO("{}  {:>8.2f} MP/s  RMSE {:>6.3f} (max {:.1f})", test.Name, megapixels / best, rmse, test.MaxRmse);
+		if (rmse > test.MaxRmse) {
+			LOG_ERROR("{} error is higher than expected!", test.Name);
+			passed = false;
+		}
+	}
+
+	fs::path tempDir = fs::temp_directory_path() / "TextureCompressionBenchmark";
+	fs::remove_all(tempDir);
+	fs::create_directories(tempDir);
+	passed &= TestCache(tempDir, 64);
+	fs::remove_all(tempDir);
+
+	Logger::Uninitialize();
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,114 @@
+// Checks how many pixel buffers the texture data classes allocate while loading images, and times the loads
+// Usage: TextureLoadBenchmark [image size] [iterations]
+// The images are generated and written as TGA files, so we don't need any assets or an OpenGL context. Returns
+// non-zero if a load makes more copies of the pixel data than expected
+
+#include <Logging.h>
+#include <Texture2DData.h>
+#include <TextureCubeMapData.h>
+
+#include <cfloat>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+/// <summary>
+/// Writes a size x size uncompressed 32 bit TGA file, with a pattern that depends on the seed
+/// </summary>
+void WriteTga(const fs::path& path, int size, int seed) {
+	uint8_t header[18] = { 0 };
+	header[2] = 2; // Uncompressed true color
+	header[12] = size & 0xFF;
+	header[13] = (size >> 8) & 0xFF;
+	header[14] = size & 0xFF;
+	header[15] = (size >> 8) & 0xFF;
+	header[16] = 32;
+	header[17] = 8; // 8 bits of alpha
+
+	std::vector<uint8_t> pixels(static_cast<size_t>(size) * size * 4);
+	for (int y = 0; y < size; y++) {
+		for (int x = 0; x < size; x++) {
+			uint8_t* pixel = &pixels[(static_cast<size_t>(y) * size + x) * 4];
+			pixel[0] = static_cast<uint8_t>(x + seed);
+			pixel[1] = static_cast<uint8_t>(y * 3 + seed);
+			pixel[2] = static_cast<uint8_t>((x ^ y) + seed * 7);
+			pixel[3] = 255;
+		}
+	}
+
+	std::ofstream file(path, std::ios::binary);
+	file.write(reinterpret_cast<const char*>(header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(pixels.data()), pixels.size());
+}
+
+/// <summary>
+/// Runs the load the given number of times, returning the fastest time in seconds. Checks that every load
+/// succeeds and allocates exactly the expected number of buffers
+/// </summary>
+template <typename Load>
+double TimeLoad(const char* name, int iterations, size_t expectedAllocations, size_t expectedBytes, bool& passed, Load load) {
+	double best = DBL_MAX;
+	for (int ix = 0; ix < iterations; ix++) {
+		TextureDataAllocations::Reset();
+		auto start = std::chrono::high_resolution_clock::now();
+		bool loaded = load();
+		auto end = std::chrono::high_resolution_clock::now();
+		double seconds = std::chrono::duration<double>(end - start).count();
+		best = seconds < best ? seconds : best;
+
+		if (!loaded) {
+			LOG_ERROR("{} failed to load", name);
+			passed = false;
+			return best;
+		}
+		if (TextureDataAllocations::GetCount() != expectedAllocations || TextureDataAllocations::GetBytes() != expectedBytes) {
+			LOG_ERROR("{} made {} allocations ({} bytes), expected {} ({} bytes)", name,
+				TextureDataAllocations::GetCount(), TextureDataAllocations::GetBytes(), expectedAllocations, expectedBytes);
+			passed = false;
+			return best;
+		}
+	}
+	LOG_INFO("{:<10} {:>8.3f}ms, {} allocation(s) per load", name, best * 1000.0, expectedAllocations);
+	return best;
+}
+
+int main(int argc, char** argv) {
+	Logger::Init();
+
+	int size = argc > 1 ? std::stoi(argv[1]) : 1024;
+	int iterations = argc > 2 ? std::stoi(argv[2]) : 5;
+
+	fs::path tempDir = fs::temp_directory_path() / "TextureLoadBenchmark";
+	fs::create_directories(tempDir);
+	const fs::path imagePath = tempDir / "image.tga";
+	WriteTga(imagePath, size, 0);
+	const char* faces[6] = { "_pos_x", "_neg_x", "_pos_y", "_neg_y", "_pos_z", "_neg_z" };
+	for (int ix = 0; ix < 6; ix++) {
+		WriteTga(tempDir / (std::string("cube") + faces[ix] + ".tga"), size, ix + 1);
+	}
+
+	const size_t faceBytes = static_cast<size_t>(size) * size * 4;
+	bool passed = true;
+
+	// 2D images adopt STBI's buffer, so we should never allocate our own
+	TimeLoad("Texture2D", iterations, 0, 0, passed, [&]() {
+		Texture2DData::sptr data = Texture2DData::LoadFromFile(imagePath.string());
+		return data != nullptr && data->GetDataSize() == faceBytes;
+	});
+	// Cubemaps allocate a single buffer for all 6 faces, which the faces are decoded straight into
+	TimeLoad("Cubemap", iterations, 1, faceBytes * 6, passed, [&]() {
+		TextureCubeMapData::sptr data = TextureCubeMapData::LoadFromImages((tempDir / "cube.tga").string());
+		return data != nullptr && data->GetDataSize() == faceBytes * 6;
+	});
+
+	fs::remove_all(tempDir);
+	LOG_INFO(passed ? "All loads made the expected number of allocations" : "Some loads made unexpected allocations!");
+
+	Logger::Uninitialize();
+	return passed ? 0 : 1;
+}
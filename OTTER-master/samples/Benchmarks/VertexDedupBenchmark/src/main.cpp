@@ -0,0 +1,184 @@
+// Compares the throughput of vertex de-duplication using the old packed key std::unordered_map against VertexDedupTable
+// Usage: VertexDedupBenchmark [grid size] [iterations]
+// The face data is generated as a grid of triangles, so that we can test very large meshes without needing the files.
+// The generated grid is also written to an OBJ file and loaded with ObjLoader to measure dedup as part of a full import
+
+#include <Logging.h>
+#include <ObjLoader.h>
+#include <VertexDedupTable.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+/// <summary>
+/// Generates the face vertices for a size x size grid of quads, split into triangles. If faceted is true, every
+/// triangle gets its own normal, so that most position/normal combinations are unique
+/// </summary>
+std::vector<glm::ivec3> GenerateFaceVertices(int size, bool faceted) {
+	std::vector<glm::ivec3> result;
+	result.reserve(static_cast<size_t>(size) * size * 6);
+	int face = 0;
+	for (int y = 0; y < size; y++) {
+		for (int x = 0; x < size; x++) {
+			// 1-based position (and UV) indices of the quad corners
+			int a = y * (size + 1) + x + 1;
+			int b = a + 1;
+			int c = a + size + 1;
+			int d = c + 1;
+			int n0 = faceted ? ++face : 1;
+			result.push_back(glm::ivec3(a, a, n0));
+			result.push_back(glm::ivec3(b, b, n0));
+			result.push_back(glm::ivec3(d, d, n0));
+			int n1 = faceted ? ++face : 1;
+			result.push_back(glm::ivec3(a, a, n1));
+			result.push_back(glm::ivec3(d, d, n1));
+			result.push_back(glm::ivec3(c, c, n1));
+		}
+	}
+	return result;
+}
+
+/// <summary>
+/// De-duplicates the face vertices using the 21 bit packed keys and std::unordered_map that ObjLoader used to use
+/// </summary>
+size_t DedupUnorderedMap(const std::vector<glm::ivec3>& faceVertices, std::vector<uint32_t>& indices) {
+	std::unordered_map<uint64_t, uint32_t> map;
+	const uint64_t mask = 0x1FFFFF;
+	uint32_t vertexCount = 0;
+	for (size_t ix = 0; ix < faceVertices.size(); ix++) {
+		const glm::ivec3& v = faceVertices[ix];
+		uint64_t key = ((v.x & mask) << 42) | ((v.y & mask) << 21) | (v.z & mask);
+		auto it = map.find(key);
+		if (it != map.end()) {
+			indices[ix] = it->second;
+		} else {
+			map[key] = vertexCount;
+			indices[ix] = vertexCount++;
+		}
+	}
+	return vertexCount;
+}
+
+/// <summary>
+/// De-duplicates the face vertices using a VertexDedupTable, optionally pre-sized for the given number of unique vertices
+/// </summary>
+size_t DedupFlatTable(const std::vector<glm::ivec3>& faceVertices, std::vector<uint32_t>& indices, size_t reserve) {
+	VertexDedupTable<glm::ivec3> table(reserve);
+	uint32_t vertexCount = 0;
+	for (size_t ix = 0; ix < faceVertices.size(); ix++) {
+		bool inserted;
+		indices[ix] = table.FindOrInsert(faceVertices[ix], vertexCount, inserted);
+		vertexCount += inserted ? 1 : 0;
+	}
+	return vertexCount;
+}
+
+/// <summary>
+/// Runs a dedup function the given number of times, returning the fastest time in seconds
+/// </summary>
+template <typename Func>
+double TimeBest(int iterations, Func&& func) {
+	double best = DBL_MAX;
+	for (int ix = 0; ix < iterations; ix++) {
+		auto start = std::chrono::high_resolution_clock::now();
+		func();
+		auto end = std::chrono::high_resolution_clock::now();
+		double seconds = std::chrono::duration<double>(end - start).count();
+		best = seconds < best ? seconds : best;
+	}
+	return best;
+}
+
+/// <summary>
+/// Writes the grid to an OBJ file, so that we can measure the loader on the same data
+/// </summary>
+void WriteGridObj(const std::string& file, int size, const std::vector<glm::ivec3>& faceVertices, bool faceted) {
+	std::ofstream stream(file, std::ios::binary);
+	for (int y = 0; y <= size; y++) {
+		for (int x = 0; x <= size; x++) {
+			stream << "v " << x << " 0 " << y << "\n";
+			stream << "vt " << x / (float)size << " " << y / (float)size << "\n";
+		}
+	}
+	size_t normalCount = faceted ? faceVertices.size() / 3 : 1;
+	for (size_t ix = 0; ix < normalCount; ix++) {
+		stream << "vn 0 1 0\n";
+	}
+	for (size_t ix = 0; ix < faceVertices.size(); ix += 3) {
+		stream << "f";
+		for (size_t corner = 0; corner < 3; corner++) {
+			const glm::ivec3& v = faceVertices[ix + corner];
+			stream << " " << v.x << "/" << v.y << "/" << v.z;
+		}
+		stream << "\n";
+	}
+}
+
+int main(int argc, char** argv) {
+	Logger::Init();
+
+	// The default of 708 gives just over 1M triangles
+	int size = argc > 1 ? std::stoi(argv[1]) : 708;
+	int iterations = argc > 2 ? std::stoi(argv[2]) : 3;
+	bool allIdentical = true;
+
+	for (bool faceted : { false, true }) {
+		std::vector<glm::ivec3> faceVertices = GenerateFaceVertices(size, faceted);
+		const size_t faceCount = faceVertices.size() / 3;
+		const double millions = faceVertices.size() / 1000000.0;
+		LOG_INFO("{} grid: {} faces, {} face vertices", faceted ? "Faceted" : "Smooth", faceCount, faceVertices.size());
+
+		std::vector<uint32_t> expected(faceVertices.size()), actual(faceVertices.size());
+		size_t expectedCount = 0, actualCount = 0;
+
+		double seconds = TimeBest(iterations, [&]() { expectedCount = DedupUnorderedMap(faceVertices, expected); });
+		LOG_INFO("\t{:<20} {:>8.3f} ms {:>8.2f} M verts/s ({} unique)", "unordered_map", seconds * 1000.0, millions / seconds, expectedCount);
+
+		seconds = TimeBest(iterations, [&]() { actualCount = DedupFlatTable(faceVertices, actual, 0); });
+		LOG_INFO("\t{:<20} {:>8.3f} ms {:>8.2f} M verts/s ({} unique)", "flat (growing)", seconds * 1000.0, millions / seconds, actualCount);
+		if (actualCount != expectedCount || actual != expected) {
+			LOG_WARN("\tflat (growing) output does not match unordered_map output!");
+			allIdentical = false;
+		}
+
+		// Pre-size the same way ObjLoader does, from the largest attribute count capped at the face vertex count
+		const size_t attributeCount = std::max(static_cast<size_t>(size + 1) * (size + 1), faceted ? faceCount : 1);
+		const size_t estimate = std::min(faceVertices.size(), attributeCount);
+		seconds = TimeBest(iterations, [&]() { actualCount = DedupFlatTable(faceVertices, actual, estimate); });
+		LOG_INFO("\t{:<20} {:>8.3f} ms {:>8.2f} M verts/s ({} unique)", "flat (pre-sized)", seconds * 1000.0, millions / seconds, actualCount);
+		if (actualCount != expectedCount || actual != expected) {
+			LOG_WARN("\tflat (pre-sized) output does not match unordered_map output!");
+			allIdentical = false;
+		}
+
+		// Measure the full import, which now de-duplicates using the flat table
+		const std::string file = (fs::temp_directory_path() / "VertexDedupBenchmark.obj").string();
+		WriteGridObj(file, size, faceVertices, faceted);
+		const double megabytes = fs::file_size(file) / (1024.0 * 1024.0);
+		for (ObjParseMode mode : { ObjParseMode::Mapped, ObjParseMode::Parallel }) {
+			MeshBuilder<VertexPosNormTexCol> mesh;
+			seconds = TimeBest(iterations, [&]() {
+				mesh = MeshBuilder<VertexPosNormTexCol>();
+				ObjLoader::LoadMeshData(file, mesh, glm::vec4(1.0f), mode);
+			});
+			LOG_INFO("\tObjLoader {:<10} {:>8.3f} ms {:>8.2f} MB/s ({} verts)", ~mode, seconds * 1000.0, megabytes / seconds, mesh.GetVertexCount());
+			if (mesh.GetVertexCount() != expectedCount) {
+				LOG_WARN("\tObjLoader {} vertex count does not match unordered_map output!", ~mode);
+				allIdentical = false;
+			}
+		}
+		fs::remove(file);
+	}
+	LOG_INFO("Outputs identical: {}", allIdentical);
+
+	Logger::Uninitialize();
+	return allIdentical ? 0 : 1;
+}
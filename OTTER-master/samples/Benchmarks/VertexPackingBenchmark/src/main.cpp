@@ -0,0 +1,139 @@
+// Checks that the packed vertex types stay within the error bounds documented in VertexTypes.h
+// Usage: VertexPackingBenchmark [vertex count] [seed]
+// Every vertex is round-tripped through VertexPosNormTexColPacked and VertexPosNormTexPacked, and the largest error
+// in each attribute is compared against it's bound. Returns non-zero if any bound is exceeded, so it can be run in CI.
+// This does not need an OpenGL context, the packing is done entirely on the CPU
+
+#include <Logging.h>
+#include <VertexTypes.h>
+
+#include <GLM/glm.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+// Slack for float rounding in the pack and unpack functions, and in our own error calculations
+static const float ROUNDING_SLACK = 1.0e-6f;
+
+// The bounds from VertexTypes.h
+static const float NORMAL_BOUND = 1.0f / 1022.0f;
+static const float COLOR_BOUND  = 1.0f / 510.0f;
+
+/// <summary>
+/// Gets the largest error a half float can have for the given UV component. This is 1/4096 in the 0-1 range, or
+/// 1/2048 of the value for larger UVs, since halves have 11 bits of precision
+/// </summary>
+float UvBound(float value) {
+	return std::max(1.0f / 4096.0f, std::abs(value) / 2048.0f);
+}
+
+/// <summary>
+/// Tracks the largest error seen for an attribute, and how many values exceeded their bound
+/// </summary>
+struct ErrorStats {
+	float  MaxError  = 0.0f;
+	float  MaxRatio  = 0.0f; // Largest error as a fraction of it's bound
+	size_t Failures  = 0;
+
+	void Add(float error, float bound) {
+		MaxError = std::max(MaxError, error);
+		MaxRatio = std::max(MaxRatio, error / bound);
+		if (error > bound + ROUNDING_SLACK) {
+			Failures++;
+		}
+	}
+};
+
+/// <summary>
+/// Generates random source vertices. Normals are unit length, UVs mostly lie in the 0-1 range with some tiled UVs
+/// outside of it, and colors include some values outside of 0-1 to test clamping
+/// </summary>
+std::vector<VertexPosNormTexCol> GenerateVertices(size_t count, uint32_t seed) {
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	std::uniform_real_distribution<float> uv01(0.0f, 1.0f);
+	std::uniform_real_distribution<float> uvTiled(-64.0f, 64.0f);
+	std::uniform_real_distribution<float> color(-0.25f, 1.25f);
+
+	std::vector<VertexPosNormTexCol> result;
+	result.reserve(count);
+	for (size_t ix = 0; ix < count; ix++) {
+		glm::vec3 normal;
+		do {
+			normal = glm::vec3(unit(rng), unit(rng), unit(rng));
+		} while (glm::dot(normal, normal) < 1.0e-4f);
+		normal = glm::normalize(normal);
+
+		// Every 8th vertex has a tiled UV, to exercise the relative bound
+		glm::vec2 uv = (ix % 8 == 0) ? glm::vec2(uvTiled(rng), uvTiled(rng)) : glm::vec2(uv01(rng), uv01(rng));
+
+		result.push_back(VertexPosNormTexCol(glm::vec3(unit(rng), unit(rng), unit(rng)) * 100.0f, normal, uv,
+			glm::vec4(color(rng), color(rng), color(rng), color(rng))));
+	}
+	return result;
+}
+
+/// <summary>
+/// Adds the error of a normal and UV round trip, shared by both packed types
+/// </summary>
+void AddNormalAndUvErrors(const VertexPosNormTexCol& source, const VertexPosNormTexCol& unpacked, ErrorStats& normals, ErrorStats& uvs) {
+	for (int c = 0; c < 3; c++) {
+		normals.Add(std::abs(unpacked.Normal[c] - source.Normal[c]), NORMAL_BOUND);
+	}
+	for (int c = 0; c < 2; c++) {
+		uvs.Add(std::abs(unpacked.UV[c] - source.UV[c]), UvBound(source.UV[c]));
+	}
+}
+
+void LogStats(const std::string& name, const ErrorStats& stats, size_t values) {
+	LOG_INFO("\t{:<8} max error {:.7f} ({:>6.2f}% of bound), {} of {} values over", name, stats.MaxError, stats.MaxRatio * 100.0f, stats.Failures, values);
+}
+
+int main(int argc, char** argv) {
+	Logger::Init();
+
+	size_t count = argc > 1 ? std::stoull(argv[1]) : 1000000;
+	uint32_t seed = argc > 2 ? static_cast<uint32_t>(std::stoul(argv[2])) : 1234;
+
+	std::vector<VertexPosNormTexCol> vertices = GenerateVertices(count, seed);
+	LOG_INFO("Round tripping {} vertices (seed {})", count, seed);
+
+	ErrorStats normals, uvs, colors;
+	size_t positionMismatches = 0;
+	auto start = std::chrono::high_resolution_clock::now();
+	for (const VertexPosNormTexCol& source : vertices) {
+		VertexPosNormTexCol unpacked = VertexPosNormTexColPacked(source).Unpack();
+		AddNormalAndUvErrors(source, unpacked, normals, uvs);
+		for (int c = 0; c < 4; c++) {
+			colors.Add(std::abs(unpacked.Color[c] - glm::clamp(source.Color[c], 0.0f, 1.0f)), COLOR_BOUND);
+		}
+		// Positions are stored as full floats, so they should come back exactly
+		positionMismatches += unpacked.Position != source.Position ? 1 : 0;
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+	LOG_INFO("VertexPosNormTexColPacked ({:.3f} ms):", seconds * 1000.0);
+	LOG_INFO("\t{:<8} {} of {} values changed", "Position", positionMismatches, count);
+	LogStats("Normal", normals, count * 3);
+	LogStats("UV", uvs, count * 2);
+	LogStats("Color", colors, count * 4);
+	size_t failures = positionMismatches + normals.Failures + uvs.Failures + colors.Failures;
+
+	ErrorStats normalsNoColor, uvsNoColor;
+	for (const VertexPosNormTexCol& source : vertices) {
+		AddNormalAndUvErrors(source, VertexPosNormTexPacked(source).Unpack(), normalsNoColor, uvsNoColor);
+	}
+	LOG_INFO("VertexPosNormTexPacked:");
+	LogStats("Normal", normalsNoColor, count * 3);
+	LogStats("UV", uvsNoColor, count * 2);
+	failures += normalsNoColor.Failures + uvsNoColor.Failures;
+
+	LOG_INFO("Within bounds: {}", failures == 0);
+
+	Logger::Uninitialize();
+	return failures == 0 ? 0 : 1;
+}
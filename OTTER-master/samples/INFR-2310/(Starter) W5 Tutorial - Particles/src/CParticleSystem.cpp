@@ -65,16 +65,18 @@ namespace nou
 		pos.resize(count);
 		viewPos.resize(count);
 		//We will be passing view-space position to the GPU.
+		//These buffers are updated every frame, so we mark them as dynamic
+		//to have them streamed instead of reallocated on each update.
 		vbos.insert({ Attrib::POSITION,
-					  std::make_unique<VertexBuffer>(3, viewPos) });
+					  std::make_unique<VertexBuffer>(3, viewPos, true) });
 
 		size.resize(count);
 		vbos.insert({ Attrib::SIZE,
-					  std::make_unique<VertexBuffer>(1, size) });
+					  std::make_unique<VertexBuffer>(1, size, true) });
 		
 		color.resize(count);
 		vbos.insert({ Attrib::COLOR,
-					  std::make_unique<VertexBuffer>(4, color) });
+					  std::make_unique<VertexBuffer>(4, color, true) });
 
 		vao = std::make_unique<VertexArray>();
 		vao->SetDrawMode(VertexArray::DrawMode::POINTS);
@@ -111,13 +111,13 @@ namespace nou
 
 	void SkinnedMesh::SetJointInfluences(const std::vector<glm::vec4>& jointInfluences)
 	{
-		m_jointInfluences = jointInfluences;
+		Retain(m_jointInfluences, jointInfluences);
 		SetVBO(Attrib::JOINT_INFLUENCE, 4, jointInfluences);
 	}
 
 	void SkinnedMesh::SetSkinWeights(const std::vector<glm::vec4>& skinWeights)
 	{
-		m_skinWeights = skinWeights;
+		Retain(m_skinWeights, skinWeights);
 		SetVBO(Attrib::SKIN_WEIGHT, 4, skinWeights);
 	}
 }
\ No newline at end of file
@@ -53,22 +53,9 @@ namespace nou
 
 	void CSkinnedMeshRenderer::SetMesh(const SkinnedMesh& mesh)
 	{
-		const VertexBuffer* vbo;
-
-		if ((vbo = mesh.GetVBO(Mesh::Attrib::POSITION)) != nullptr)
-			m_vao->BindAttrib(*vbo, (GLint)Mesh::Attrib::POSITION);
-
-		if ((vbo = mesh.GetVBO(Mesh::Attrib::NORMAL)) != nullptr)
-			m_vao->BindAttrib(*vbo, (GLint)Mesh::Attrib::NORMAL);
-
-		if ((vbo = mesh.GetVBO(Mesh::Attrib::UV)) != nullptr)
-			m_vao->BindAttrib(*vbo, (GLint)Mesh::Attrib::UV);
-
-		if ((vbo = mesh.GetVBO(Mesh::Attrib::JOINT_INFLUENCE)) != nullptr)
-			m_vao->BindAttrib(*vbo, (GLint)Mesh::Attrib::JOINT_INFLUENCE);
-
-		if ((vbo = mesh.GetVBO(Mesh::Attrib::SKIN_WEIGHT)) != nullptr)
-			m_vao->BindAttrib(*vbo, (GLint)Mesh::Attrib::SKIN_WEIGHT);
+		//Binds positions, normals, UVs, joint influences and skin weights,
+		//whether they are in separate buffers or one interleaved buffer.
+		mesh.BindAttribs(*m_vao);
 
 		//This will make a copy of the skeleton data from our base mesh.
 		*m_skeleton = mesh.m_skeleton;
@@ -16,7 +16,7 @@ Helpful reference: https://www.khronos.org/files/gltf20-reference-guide.pdf
 namespace nou::GLTF
 {
 	void LoadSkinnedMesh(const std::string& filename, SkinnedMesh& mesh, 
-						 bool flipUVY)
+						 bool flipUVY, bool interleaved)
 	{
 		auto gltf = std::make_unique<tinygltf::Model>();
 
@@ -32,7 +32,15 @@ namespace nou::GLTF
 		}
 
 		//Step 2: Extract mesh geometry (verts, normals, UVs).
-		result = ExtractGeometry(*gltf, mesh, flipUVY, err, warn);
+		//(If we're interleaving, we hold on to the arrays until we have the skin weights too.)
+		std::vector<glm::vec3> verts, normals;
+		std::vector<glm::vec2> uvs;
+		bool hasNormals = true, hasUVs = true;
+
+		if (interleaved)
+			result = ExtractGeometry(*gltf, verts, uvs, normals, flipUVY, hasNormals, hasUVs, err, warn);
+		else
+			result = ExtractGeometry(*gltf, mesh, flipUVY, err, warn);
 
 		if (!result)
 		{
@@ -52,7 +60,12 @@ namespace nou::GLTF
 		}
 
 		//Step 4: Extract skin weights.
-		result = ExtractSkinWeights(*gltf, mesh, err, warn);
+		std::vector<glm::vec4> influences, weights;
+
+		if (interleaved)
+			result = ExtractSkinWeights(*gltf, influences, weights, err, warn);
+		else
+			result = ExtractSkinWeights(*gltf, mesh, err, warn);
 
 		if (!result)
 		{
@@ -60,6 +73,47 @@ namespace nou::GLTF
 			return;
 		}
 
+		//Step 5: Write every attribute into a single interleaved buffer.
+		if (interleaved && !verts.empty())
+		{
+			Mesh::Layout layout = {};
+			std::array<const float*, Mesh::ATTRIB_COUNT> sources = {};
+
+			layout[(size_t)Mesh::Attrib::POSITION] = 3;
+			sources[(size_t)Mesh::Attrib::POSITION] = &(verts[0].x);
+
+			if (hasNormals)
+			{
+				layout[(size_t)Mesh::Attrib::NORMAL] = 3;
+				sources[(size_t)Mesh::Attrib::NORMAL] = &(normals[0].x);
+			}
+
+			if (hasUVs)
+			{
+				layout[(size_t)Mesh::Attrib::UV] = 2;
+				sources[(size_t)Mesh::Attrib::UV] = &(uvs[0].x);
+			}
+
+			//Skin weights are read per face index for every primitive, just like
+			//our geometry, so there should be one of each per vertex.
+			if (influences.size() != verts.size() || weights.size() != verts.size())
+			{
+				err = "Skin weight count does not match vertex count.";
+				DumpErrorsAndWarnings(filename, err, warn);
+				return;
+			}
+
+			layout[(size_t)Mesh::Attrib::JOINT_INFLUENCE] = 4;
+			sources[(size_t)Mesh::Attrib::JOINT_INFLUENCE] = &(influences[0].x);
+			layout[(size_t)Mesh::Attrib::SKIN_WEIGHT] = 4;
+			sources[(size_t)Mesh::Attrib::SKIN_WEIGHT] = &(weights[0].x);
+
+			mesh.SetInterleaved(Mesh::Interleave(layout, sources, verts.size()), layout);
+			mesh.SetCPUData(verts,
+							hasNormals ? normals : std::vector<glm::vec3>(),
+							hasUVs ? uvs : std::vector<glm::vec2>());
+		}
+
 		DumpErrorsAndWarnings(filename, err, warn);
 
 		printf("Loaded skinned mesh from %s.\n", filename.c_str());
@@ -302,6 +356,22 @@ namespace nou::GLTF
 
 	bool ExtractSkinWeights(const tinygltf::Model& gltf, SkinnedMesh& mesh, 
 						    std::string& err, std::string& warn)
+	{
+		std::vector<glm::vec4> influences;
+		std::vector<glm::vec4> weights;
+
+		if (!ExtractSkinWeights(gltf, influences, weights, err, warn))
+			return false;
+
+		mesh.SetJointInfluences(influences);
+		mesh.SetSkinWeights(weights);
+
+		return true;
+	}
+
+	bool ExtractSkinWeights(const tinygltf::Model& gltf, 
+							std::vector<glm::vec4>& influences, std::vector<glm::vec4>& weights,
+						    std::string& err, std::string& warn)
 	{
 		if (gltf.meshes.size() == 0 || gltf.meshes[0].primitives.size() == 0)
 		{
@@ -309,20 +379,40 @@ namespace nou::GLTF
 			return false;
 		}
 
-		const tinygltf::Primitive& geom = gltf.meshes[0].primitives[0];
+		influences.clear();
+		weights.clear();
+
+		//ExtractGeometry appends every primitive of the mesh, so we do the same
+		//to keep one influence and weight per vertex.
+		const tinygltf::Mesh& meshData = gltf.meshes[0];
+
+		for (size_t i = 0; i < meshData.primitives.size(); ++i)
+		{
+			if (!ProcessSkinWeights(gltf, i, influences, weights, err, warn))
+				return false;
+		}
+
+		return true;
+	}
+
+	bool ProcessSkinWeights(const tinygltf::Model& gltf, size_t geomIndex,
+							std::vector<glm::vec4>& influences, std::vector<glm::vec4>& weights,
+							std::string& err, std::string& warn)
+	{
+		const tinygltf::Primitive& geom = gltf.meshes[0].primitives[geomIndex];
 
 		int influenceID = FindAccessor(geom, "JOINTS_0");
 		int weightID = FindAccessor(geom, "WEIGHTS_0");
 
 		if (influenceID == -1)
 		{
-			err = "No joint influence data present in file.";
+			err = "No joint influence data found in mesh primitive " + std::to_string(geomIndex);
 			return false;
 		}
 
 		if (weightID == -1)
 		{
-			err = "No skin weight data present in file.";
+			err = "No skin weight data found in mesh primitive " + std::to_string(geomIndex);
 			return false;
 		}
 
@@ -358,11 +448,9 @@ namespace nou::GLTF
 			return false;
 		}
 
-		std::vector<glm::vec4> influences;
-		std::vector<glm::vec4> weights;
-
-		influences.resize(faceIndexer.len);
-		weights.resize(faceIndexer.len);
+		size_t offset = influences.size();
+		influences.resize(offset + faceIndexer.len);
+		weights.resize(offset + faceIndexer.len);
 
 		for (size_t i = 0; i < faceIndexer.len; ++i)
 		{
@@ -384,14 +472,11 @@ namespace nou::GLTF
 			//IDENTIFIERS of those nodes. This means we no longer need
 			//to go through our joint lookup to convert the indices - 
 			//they're already following the same convention we use in NOU.
-			influences[i] = glm::vec4(j0, j1, j2, j3);
+			influences[offset + i] = glm::vec4(j0, j1, j2, j3);
 
-			memcpy(&weights[i], &wtGetter.data[face * wtGetter.stride], sizeof(glm::vec4));
+			memcpy(&weights[offset + i], &wtGetter.data[face * wtGetter.stride], sizeof(glm::vec4));
 		}
 
-		mesh.SetJointInfluences(influences);
-		mesh.SetSkinWeights(weights);
-
 		return true;
 	}
 
@@ -37,8 +37,10 @@ namespace nou::GLTF
 	};
 
 	//Load a skinned mesh in base pose, including joint hierarchy and skin weights.
+	//With interleaved set, all five vertex attributes are written into a single
+	//buffer (see Mesh::SetInterleaved).
 	void LoadSkinnedMesh(const std::string& filename, SkinnedMesh& mesh, 
-					     bool flipUVY = true);
+					     bool flipUVY = true, bool interleaved = false);
 	
 	//Grab a joint animation from a glTF file.
 	void LoadAnimation(const std::string& filename, SkeletalAnim& anim);
@@ -57,6 +59,16 @@ namespace nou::GLTF
 	//Extract skin weights (used by LoadSkinnedMesh).
 	bool ExtractSkinWeights(const tinygltf::Model& gltf, SkinnedMesh& mesh, 
 						    std::string& err, std::string& warn);
+
+	//Same as above, but gives back the arrays instead of storing them in the mesh.
+	bool ExtractSkinWeights(const tinygltf::Model& gltf, 
+							std::vector<glm::vec4>& influences, std::vector<glm::vec4>& weights,
+						    std::string& err, std::string& warn);
+
+	//Helper for the above, appends the skin weights of a single primitive.
+	bool ProcessSkinWeights(const tinygltf::Model& gltf, size_t geomIndex,
+							std::vector<glm::vec4>& influences, std::vector<glm::vec4>& weights,
+							std::string& err, std::string& warn);
 	
 	//Extract animation data (used by LoadAnimation).
 	bool ExtractSkeletalAnimation(const tinygltf::Model& gltf, SkeletalAnim& anim,
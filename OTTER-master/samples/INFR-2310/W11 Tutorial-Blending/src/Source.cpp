@@ -53,11 +53,11 @@ int main()
 
 	//Load a basic box mesh for drawing our skeleton.
 	auto boxMesh = std::make_unique<Mesh>();
-	GLTF::LoadMesh("models/box/BoxTextured.gltf", *boxMesh);
+	GLTF::LoadMesh("models/box/BoxTextured.gltf", *boxMesh, true, true);
 
 	//Load our skinned boy mesh (in base pose).
 	auto boiMesh = std::make_unique<SkinnedMesh>();
-	GLTF::LoadSkinnedMesh("models/boi/Base.gltf", *boiMesh);
+	GLTF::LoadSkinnedMesh("models/boi/Base.gltf", *boiMesh, true, true);
 
 	//Load all our animations.
 	auto idleAnim = std::make_unique<SkeletalAnim>();
@@ -48,8 +48,12 @@ namespace nou
 
 	void CSpriteRenderer::SetSize(const glm::vec2& size)
 	{
-		std::vector<glm::vec3> verts;
-		verts.resize(6);
+		//The buffer is dynamic, so after the first call we write
+		//the new corners straight into its streamed storage.
+		if (!m_vboVert)
+			m_vboVert = std::make_unique<VertexBuffer>(3, std::vector<glm::vec3>(6), true);
+
+		glm::vec3* verts = m_vboVert->BeginWrite<glm::vec3>(6);
 
 		//Bottom left, bottom right, top right.
 		verts[0] = glm::vec3(-0.5f * size.x, -0.5f * size.y, 0.0f);
@@ -61,16 +65,15 @@ namespace nou
 		verts[4] = glm::vec3( 0.5f * size.x,  0.5f * size.y, 0.0f);
 		verts[5] = glm::vec3(-0.5f * size.x,  0.5f * size.y, 0.0f);
 
-		if(m_vboVert)
-			m_vboVert->UpdateData(verts);
-		else
-			m_vboVert = std::make_unique<VertexBuffer>(3, verts);
+		m_vboVert->EndWrite();
 	}
 
 	void CSpriteRenderer::SetFrame(const Spritesheet::Frame& frame)
 	{
-		std::vector<glm::vec2> uvs;
-		uvs.resize(6);
+		if (!m_vboUV)
+			m_vboUV = std::make_unique<VertexBuffer>(2, std::vector<glm::vec2>(6), true);
+
+		glm::vec2* uvs = m_vboUV->BeginWrite<glm::vec2>(6);
 
 		//Bottom left, bottom right, top right.
 		uvs[0] = frame.uv[Spritesheet::VertIndex::BOTTOM_LEFT];
@@ -82,9 +85,6 @@ namespace nou
 		uvs[4] = frame.uv[Spritesheet::VertIndex::TOP_RIGHT];
 		uvs[5] = frame.uv[Spritesheet::VertIndex::TOP_LEFT];
 
-		if (m_vboUV)
-			m_vboUV->UpdateData(uvs);
-		else
-			m_vboUV = std::make_unique<VertexBuffer>(2, uvs, true);
+		m_vboUV->EndWrite();
 	}
 }
\ No newline at end of file